@@ -0,0 +1,82 @@
+#pragma once
+
+/**
+ * @brief Benchmark helpers
+ *
+ * Every file in this directory is a standalone console program with its own main(),
+ * it includes the engine the same way as the sample in main/.
+ * Benchmarks which need a device create the application with DeviceBackend::Null,
+ * so they measure cpu-side cost only and run on machines without a gpu.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace Benchmark
+{
+    using Clock = std::chrono::steady_clock;
+
+    inline double SecondsSince(Clock::time_point Start)
+    {
+        return std::chrono::duration<double>(Clock::now() - Start).count();
+    }
+
+    /**
+     * Run Body(ThreadIndex) on NumThreads threads which start at the same time.
+     * @return seconds from the start until the last thread finishes.
+     */
+    inline double RunThreads(unsigned NumThreads, const std::function<void(unsigned ThreadIndex)>& Body)
+    {
+        std::atomic<unsigned> numReady(0);
+        std::atomic<bool> bStart(false);
+        std::vector<std::thread> threads;
+        threads.reserve(NumThreads);
+        for (unsigned i = 0; i < NumThreads; ++i)
+        {
+            threads.emplace_back([&, i]()
+            {
+                numReady.fetch_add(1, std::memory_order_acq_rel);
+                while (!bStart.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+                Body(i);
+            });
+        }
+        while (numReady.load(std::memory_order_acquire) < NumThreads)
+        {
+            std::this_thread::yield();
+        }
+        auto start = Clock::now();
+        bStart.store(true, std::memory_order_release);
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        return SecondsSince(start);
+    }
+
+    /**
+     * Thread counts 1,2,4... up to MaxThreads,MaxThreads is always the last one.
+     */
+    inline std::vector<unsigned> ThreadCounts(unsigned MaxThreads)
+    {
+        std::vector<unsigned> counts;
+        for (unsigned count = 1; count < MaxThreads; count *= 2)
+        {
+            counts.push_back(count);
+        }
+        counts.push_back(MaxThreads);
+        return counts;
+    }
+
+    inline unsigned HardwareThreads()
+    {
+        unsigned numThreads = std::thread::hardware_concurrency();
+        return numThreads > 0 ? numThreads : 1;
+    }
+}
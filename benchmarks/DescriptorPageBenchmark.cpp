@@ -0,0 +1,327 @@
+#include "Benchmark.h"
+#include <NeoEngine/inc/TLSFAllocator.h>
+#include <NeoEngine/inc/Application.h>
+#include <NeoEngine/inc/DescriptorAllocatorPage.h>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+
+/**
+ * Replay of descriptor allocate/free/stale-release traces on a descriptor page.
+ * A trace is made like a streaming scene:persistent views are created at load,a part of them is replaced every frame,
+ * and transient tables are allocated and freed in every frame.Freed ranges are stale until the gpu is done,
+ * so they are given back FramesInFlight frames later.
+ * Core:    the free list of a page,TLSFAllocator against the offset map plus size multimap which the page used before.
+ * Device:  DescriptorAllocatorPage on the null device,freed ranges are retired to the deferred deletion queue
+ *          and released by Application::RunHeadless() when their fences complete.
+ * Usage: DescriptorPageBenchmark [frames] [page size]
+ */
+
+namespace
+{
+    const UINT gs_FramesInFlight = 3;
+
+    enum class TraceEventType : uint8_t
+    {
+        Allocate,
+        Free,
+        EndFrame
+    };
+
+    struct TraceEvent
+    {
+        TraceEventType Type;
+        uint32_t Id;
+        uint32_t NumDescriptors;
+    };
+
+    struct TraceDesc
+    {
+        uint32_t NumFrames = 1000;
+        uint32_t NumPersistent = 2000;
+        uint32_t StreamedPerFrame = 40;
+        uint32_t TransientPerFrame = 300;
+    };
+
+    uint32_t PersistentSize(std::mt19937& Random)
+    {
+        //most views are single descriptors,material tables are a few,and some are big arrays.
+        uint32_t kind = Random() % 100;
+        if (kind < 70) return 1;
+        if (kind < 95) return 2 + Random() % 7;
+        return 16 + Random() % 49;
+    }
+
+    std::vector<TraceEvent> MakeTrace(const TraceDesc& Desc, std::mt19937& Random)
+    {
+        std::vector<TraceEvent> trace;
+        std::vector<uint32_t> persistentIds;
+        uint32_t nextId = 0;
+        for (uint32_t i = 0; i < Desc.NumPersistent; ++i)
+        {
+            trace.push_back({ TraceEventType::Allocate, nextId, PersistentSize(Random) });
+            persistentIds.push_back(nextId++);
+        }
+        for (uint32_t frame = 0; frame < Desc.NumFrames; ++frame)
+        {
+            for (uint32_t i = 0; i < Desc.StreamedPerFrame; ++i)
+            {
+                uint32_t& id = persistentIds[Random() % persistentIds.size()];
+                trace.push_back({ TraceEventType::Free, id, 0 });
+                trace.push_back({ TraceEventType::Allocate, nextId, PersistentSize(Random) });
+                id = nextId++;
+            }
+            uint32_t firstTransient = nextId;
+            for (uint32_t i = 0; i < Desc.TransientPerFrame; ++i)
+            {
+                trace.push_back({ TraceEventType::Allocate, nextId++, static_cast<uint32_t>(1 + Random() % 4) });
+            }
+            for (uint32_t id = firstTransient; id < nextId; ++id)
+            {
+                trace.push_back({ TraceEventType::Free, id, 0 });
+            }
+            trace.push_back({ TraceEventType::EndFrame, 0, 0 });
+        }
+        return trace;
+    }
+
+    uint32_t GetNumIds(const std::vector<TraceEvent>& Trace)
+    {
+        uint32_t numIds = 0;
+        for (const auto& event : Trace)
+        {
+            if (event.Type == TraceEventType::Allocate)
+            {
+                numIds = (std::max)(numIds, event.Id + 1);
+            }
+        }
+        return numIds;
+    }
+
+    //The free list which DescriptorAllocatorPage used before TLSF:free blocks by offset,and by size for best fit.
+    class MapFreeList
+    {
+    public:
+        static const uint64_t InvalidOffset = UINT64_MAX;
+
+        explicit MapFreeList(uint64_t Size) : m_FreeSize(0) { AddFreeBlock(0, Size); }
+
+        uint64_t Allocate(uint64_t Size)
+        {
+            auto sizeIter = m_FreeBlockBySize.lower_bound(Size);
+            if (sizeIter == m_FreeBlockBySize.end())
+            {
+                return InvalidOffset;
+            }
+            uint64_t offset = sizeIter->second->first;
+            uint64_t blockSize = sizeIter->first;
+            m_FreeBlockByOffset.erase(sizeIter->second);
+            m_FreeBlockBySize.erase(sizeIter);
+            m_FreeSize -= blockSize;
+            if (blockSize > Size)
+            {
+                AddFreeBlock(offset + Size, blockSize - Size);
+            }
+            return offset;
+        }
+
+        void Free(uint64_t Offset, uint64_t Size)
+        {
+            auto nextIter = m_FreeBlockByOffset.upper_bound(Offset);
+            if (nextIter != m_FreeBlockByOffset.begin())
+            {
+                auto prevIter = std::prev(nextIter);
+                if (prevIter->first + prevIter->second.Size == Offset)
+                {
+                    Offset = prevIter->first;
+                    Size += prevIter->second.Size;
+                    RemoveFreeBlock(prevIter);
+                }
+            }
+            if (nextIter != m_FreeBlockByOffset.end() && Offset + Size == nextIter->first)
+            {
+                Size += nextIter->second.Size;
+                RemoveFreeBlock(nextIter);
+            }
+            AddFreeBlock(Offset, Size);
+        }
+
+        TLSFStatistics GetStatistics()const
+        {
+            TLSFStatistics statistics;
+            statistics.FreeSize = m_FreeSize;
+            statistics.LargestFreeBlock = m_FreeBlockBySize.empty() ? 0 : m_FreeBlockBySize.rbegin()->first;
+            statistics.NumFreeBlocks = m_FreeBlockByOffset.size();
+            return statistics;
+        }
+    private:
+        struct FreeBlock;
+        using FreeBlockByOffset = std::map<uint64_t, FreeBlock>;
+        using FreeBlockBySize = std::multimap<uint64_t, FreeBlockByOffset::iterator>;
+        struct FreeBlock
+        {
+            uint64_t Size;
+            FreeBlockBySize::iterator SizeIter;
+        };
+
+        void AddFreeBlock(uint64_t Offset, uint64_t Size)
+        {
+            auto offsetIter = m_FreeBlockByOffset.emplace(Offset, FreeBlock{ Size, FreeBlockBySize::iterator() }).first;
+            offsetIter->second.SizeIter = m_FreeBlockBySize.emplace(Size, offsetIter);
+            m_FreeSize += Size;
+        }
+
+        void RemoveFreeBlock(FreeBlockByOffset::iterator OffsetIter)
+        {
+            m_FreeSize -= OffsetIter->second.Size;
+            m_FreeBlockBySize.erase(OffsetIter->second.SizeIter);
+            m_FreeBlockByOffset.erase(OffsetIter);
+        }
+
+        FreeBlockByOffset m_FreeBlockByOffset;
+        FreeBlockBySize m_FreeBlockBySize;
+        uint64_t m_FreeSize;
+    };
+
+    struct ReplayResult
+    {
+        double Seconds = 0.0;
+        size_t NumOperations = 0;
+        size_t NumFailures = 0;
+        TLSFStatistics Statistics;
+    };
+
+    //Replay a trace on a free list,FreeFunc(Offset,Size) gives a range back.
+    template<typename AllocateFunc, typename FreeFunc>
+    ReplayResult ReplayCore(const std::vector<TraceEvent>& Trace, AllocateFunc Allocate, FreeFunc Free)
+    {
+        struct Range
+        {
+            uint64_t Offset;
+            uint32_t Size;
+        };
+        struct StaleRange
+        {
+            Range Block;
+            uint32_t Frame;
+        };
+        std::vector<Range> ranges(GetNumIds(Trace), { UINT64_MAX, 0 });
+        std::vector<StaleRange> staleRanges;
+        size_t firstStale = 0;
+        uint32_t frame = 0;
+
+        ReplayResult result;
+        auto start = Benchmark::Clock::now();
+        for (const auto& event : Trace)
+        {
+            switch (event.Type)
+            {
+            case TraceEventType::Allocate:
+                ranges[event.Id] = { Allocate(event.NumDescriptors), event.NumDescriptors };
+                result.NumFailures += ranges[event.Id].Offset == UINT64_MAX ? 1 : 0;
+                ++result.NumOperations;
+                break;
+            case TraceEventType::Free:
+                if (ranges[event.Id].Offset != UINT64_MAX)
+                {
+                    staleRanges.push_back({ ranges[event.Id], frame });
+                }
+                break;
+            case TraceEventType::EndFrame:
+                ++frame;
+                while (firstStale < staleRanges.size() && staleRanges[firstStale].Frame + gs_FramesInFlight <= frame)
+                {
+                    Free(staleRanges[firstStale].Block.Offset, staleRanges[firstStale].Block.Size);
+                    ++firstStale;
+                    ++result.NumOperations;
+                }
+                break;
+            }
+        }
+        result.Seconds = Benchmark::SecondsSince(start);
+        return result;
+    }
+
+    ReplayResult ReplayDevice(const std::vector<TraceEvent>& Trace, UINT PageSize)
+    {
+        auto pPage = std::make_shared<DescriptorAllocatorPage>(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, PageSize);
+        std::vector<DescriptorAllocation> allocations(GetNumIds(Trace));
+        UINT64 numFrames = 0;
+        for (const auto& event : Trace)
+        {
+            numFrames += event.Type == TraceEventType::EndFrame ? 1 : 0;
+        }
+
+        ReplayResult result;
+        size_t eventIndex = 0;
+        auto start = Benchmark::Clock::now();
+        Application::GetApp()->RunHeadless(numFrames, [&](const UpdateEventArgs&, const RenderEventArgs&)
+        {
+            for (; eventIndex < Trace.size() && Trace[eventIndex].Type != TraceEventType::EndFrame; ++eventIndex)
+            {
+                const auto& event = Trace[eventIndex];
+                if (event.Type == TraceEventType::Allocate)
+                {
+                    allocations[event.Id] = pPage->Allocate(event.NumDescriptors);
+                    result.NumFailures += allocations[event.Id].IsNull() ? 1 : 0;
+                }
+                else
+                {
+                    //the range is retired to the deferred deletion queue.
+                    allocations[event.Id] = DescriptorAllocation();
+                }
+                ++result.NumOperations;
+            }
+            ++eventIndex;
+        });
+        result.Seconds = Benchmark::SecondsSince(start);
+        result.Statistics = pPage->GetStatistics();
+        return result;
+    }
+
+    void PrintResult(const char* pName, const ReplayResult& Result)
+    {
+        std::printf("%-10s %10.1f ns/op %8zu failed %10.3f fragmentation %8llu free blocks %8llu largest free\n",
+            pName, Result.Seconds * 1e9 / Result.NumOperations, Result.NumFailures, Result.Statistics.Fragmentation(),
+            static_cast<unsigned long long>(Result.Statistics.NumFreeBlocks),
+            static_cast<unsigned long long>(Result.Statistics.LargestFreeBlock));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    TraceDesc traceDesc;
+    traceDesc.NumFrames = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : traceDesc.NumFrames;
+    UINT pageSize = argc > 2 ? static_cast<UINT>(std::stoul(argv[2])) : 16384;
+
+    std::mt19937 random(12345);
+    auto trace = MakeTrace(traceDesc, random);
+    std::printf("== %zu events,%u frames,page of %u descriptors\n", trace.size(), traceDesc.NumFrames, pageSize);
+
+    {
+        TLSFAllocator allocator(pageSize);
+        auto result = ReplayCore(trace,
+            [&](uint64_t Size) { return allocator.Allocate(Size); },
+            [&](uint64_t Offset, uint64_t) { allocator.Free(Offset); });
+        result.Statistics = allocator.GetStatistics();
+        PrintResult("tlsf", result);
+    }
+    {
+        MapFreeList freeList(pageSize);
+        auto result = ReplayCore(trace,
+            [&](uint64_t Size) { return freeList.Allocate(Size); },
+            [&](uint64_t Offset, uint64_t Size) { freeList.Free(Offset, Size); });
+        result.Statistics = freeList.GetStatistics();
+        PrintResult("map", result);
+    }
+
+    Application::Create(nullptr, DeviceBackend::Null);
+    PrintResult("page", ReplayDevice(trace, pageSize));
+    Application::Destory();
+
+    return 0;
+}
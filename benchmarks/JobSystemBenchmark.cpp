@@ -0,0 +1,176 @@
+#include "Benchmark.h"
+#include <NeoEngine/inc/JobSystem.h>
+#include <NeoEngine/inc/Application.h>
+#include <NeoEngine/inc/CommandQueue.h>
+#include <NeoEngine/inc/CommandList.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <memory>
+#include <string>
+
+/**
+ * Core scaling of JobSystem::ParallelFor from 1 core to all hardware threads.
+ * Culling:   bounding spheres are tested against six frustum planes,this is pure cpu work like Window::Update.
+ * Recording: every range records draws into its own command list on the null device and executes it,
+ *            like parallel recording in Window::Render,so it includes dynamic upload,descriptor and submit cost.
+ * One core runs the loop on the calling thread without a job system,N cores use a job system with N-1 workers.
+ * Usage: JobSystemBenchmark [objects] [frames]
+ */
+
+namespace
+{
+    struct Sphere
+    {
+        float Center[3];
+        float Radius;
+    };
+
+    struct Plane
+    {
+        float Normal[3];
+        float Distance;
+    };
+
+    struct DynamicVertex
+    {
+        float Position[3];
+        float Color[4];
+    };
+
+    void MakeScene(size_t NumObjects, std::vector<Sphere>& Spheres, Plane (&Planes)[6])
+    {
+        Spheres.resize(NumObjects);
+        for (size_t i = 0; i < NumObjects; ++i)
+        {
+            float x = static_cast<float>(i % 101) - 50.0f;
+            float y = static_cast<float>((i / 101) % 101) - 50.0f;
+            float z = static_cast<float>(i % 997) * 0.5f;
+            Spheres[i] = { { x, y, z }, 0.5f + static_cast<float>(i % 7) * 0.25f };
+        }
+        //a 90 degree frustum looking down +z,from near plane 1 to far plane 400.
+        const float s = std::sqrt(0.5f);
+        Plane planes[6] =
+        {
+            { {  s, 0.0f, s }, 0.0f }, { { -s, 0.0f, s }, 0.0f },
+            { { 0.0f,  s, s }, 0.0f }, { { 0.0f, -s, s }, 0.0f },
+            { { 0.0f, 0.0f, 1.0f }, -1.0f }, { { 0.0f, 0.0f, -1.0f }, 400.0f }
+        };
+        std::copy(std::begin(planes), std::end(planes), std::begin(Planes));
+    }
+
+    void Cull(const Sphere* pSpheres, const Plane (&Planes)[6], UINT8* pVisibility, size_t Begin, size_t End)
+    {
+        for (size_t i = Begin; i < End; ++i)
+        {
+            const Sphere& sphere = pSpheres[i];
+            bool visible = true;
+            for (const Plane& plane : Planes)
+            {
+                float distance = plane.Normal[0] * sphere.Center[0] + plane.Normal[1] * sphere.Center[1] +
+                    plane.Normal[2] * sphere.Center[2] + plane.Distance;
+                visible = visible && distance >= -sphere.Radius;
+            }
+            pVisibility[i] = visible ? 1 : 0;
+        }
+    }
+
+    void Record(const std::vector<DynamicVertex>& Vertices, size_t Begin, size_t End)
+    {
+        auto directQueue = Application::GetApp()->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
+        auto commandList = directQueue->GetCommandList();
+        commandList->SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        for (size_t i = Begin; i < End; ++i)
+        {
+            commandList->SetDynamicVertexBuffer(0, static_cast<UINT>(Vertices.size()), sizeof(DynamicVertex), Vertices.data());
+            commandList->Draw(static_cast<UINT>(Vertices.size()), 1, 0, 0);
+        }
+        directQueue->ExecuteCommandList(commandList);
+    }
+
+    //Run Func over [0,Count) with the job system,or on the calling thread if there is none.
+    void ParallelFor(JobSystem* pJobSystem, size_t Count, size_t GrainSize, const std::function<void(size_t, size_t)>& Func)
+    {
+        if (pJobSystem)
+        {
+            pJobSystem->ParallelFor(Count, GrainSize, Func);
+        }
+        else
+        {
+            Func(0, Count);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t numObjects = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    UINT64 numFrames = argc > 2 ? std::stoull(argv[2]) : 100;
+    //objects of one recorded command list
+    const size_t recordGrainSize = 256;
+    const size_t numRecordedObjects = (std::min<size_t>)(numObjects, 64 * 1024);
+
+    std::vector<Sphere> spheres;
+    Plane planes[6];
+    MakeScene(numObjects, spheres, planes);
+    std::vector<UINT8> visibility(numObjects);
+    std::vector<DynamicVertex> vertices(3, { { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } });
+
+    Application::Create(nullptr, DeviceBackend::Null);
+    {
+        auto pApp = Application::GetApp();
+
+        std::printf("%6s %14s %10s %14s %10s %12s %14s\n", "cores", "cull(ms)", "speedup", "record(ms)", "speedup", "stolen jobs", "waiter sleeps");
+        double cullBaseline = 0.0;
+        double recordBaseline = 0.0;
+        for (unsigned numCores : Benchmark::ThreadCounts(Benchmark::HardwareThreads()))
+        {
+            std::unique_ptr<JobSystem> pJobSystem;
+            if (numCores > 1)
+            {
+                pJobSystem = std::make_unique<JobSystem>(numCores - 1);
+            }
+
+            auto start = Benchmark::Clock::now();
+            for (UINT64 frame = 0; frame < numFrames; ++frame)
+            {
+                ParallelFor(pJobSystem.get(), numObjects, 4096, [&](size_t Begin, size_t End)
+                {
+                    Cull(spheres.data(), planes, visibility.data(), Begin, End);
+                });
+            }
+            double cullMs = Benchmark::SecondsSince(start) * 1e3 / numFrames;
+
+            start = Benchmark::Clock::now();
+            pApp->RunHeadless(numFrames, [&](const UpdateEventArgs&, const RenderEventArgs&)
+            {
+                ParallelFor(pJobSystem.get(), numRecordedObjects, recordGrainSize, [&](size_t Begin, size_t End)
+                {
+                    //one core records the same command lists as N cores,so the results are comparable.
+                    for (size_t begin = Begin; begin < End; begin += recordGrainSize)
+                    {
+                        Record(vertices, begin, (std::min)(begin + recordGrainSize, End));
+                    }
+                });
+            });
+            double recordMs = Benchmark::SecondsSince(start) * 1e3 / numFrames;
+
+            if (numCores == 1)
+            {
+                cullBaseline = cullMs;
+                recordBaseline = recordMs;
+            }
+            JobSystemStatistics statistics;
+            if (pJobSystem)
+            {
+                statistics = pJobSystem->GetStatistics();
+            }
+            std::printf("%6u %14.3f %9.2fx %14.3f %9.2fx %12zu %14zu\n", numCores,
+                cullMs, cullBaseline / cullMs, recordMs, recordBaseline / recordMs, statistics.JobsStolen, statistics.WaiterSleeps);
+        }
+    }
+    Application::Destory();
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "Benchmark.h"
+#include <NeoEngine/inc/LockFreeQueue.h>
+#include <NeoEngine/inc/ThreadSafeQueue.h>
+
+#include <memory>
+#include <string>
+
+/**
+ * Contention of LockFreeQueue against ThreadSafeQueue with 1 to 32 recording threads.
+ * Every recording thread follows CommandQueue:it takes a command list from the available queue(or makes one),
+ * and pushes it to the in-flight queue.One recycling thread moves lists from in-flight back to available,
+ * like the in-flight thread of CommandQueue.Lists are shared_ptrs,so pushes and pops move them as the engine does.
+ * Usage: QueueBenchmark [lists per thread]
+ */
+
+namespace
+{
+    struct FakeCommandList
+    {
+        uint64_t FenceValue = 0;
+    };
+    using CommandListPtr = std::shared_ptr<FakeCommandList>;
+
+    template<typename QueueType>
+    double Run(unsigned NumThreads, size_t ListsPerThread, QueueType& AvailableLists, QueueType& InFlightLists)
+    {
+        std::atomic<unsigned> numRecording(NumThreads);
+        //the recycling thread runs until all recording threads are done and in-flight queue is drained.
+        std::thread recycleThread([&]()
+        {
+            CommandListPtr commandList;
+            while (numRecording.load(std::memory_order_acquire) > 0 || !InFlightLists.Empty())
+            {
+                if (InFlightLists.TryPop(commandList))
+                {
+                    AvailableLists.Push(std::move(commandList));
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        double seconds = Benchmark::RunThreads(NumThreads, [&](unsigned)
+        {
+            for (size_t i = 0; i < ListsPerThread; ++i)
+            {
+                CommandListPtr commandList;
+                if (AvailableLists.Empty() || !AvailableLists.TryPop(commandList))
+                {
+                    commandList = std::make_shared<FakeCommandList>();
+                }
+                commandList->FenceValue = i;
+                InFlightLists.Push(std::move(commandList));
+            }
+            numRecording.fetch_sub(1, std::memory_order_acq_rel);
+        });
+        recycleThread.join();
+        return seconds;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t listsPerThread = argc > 1 ? std::stoull(argv[1]) : 200000;
+
+    std::printf("%8s %18s %18s %10s %14s %14s\n", "threads", "mutex(Mops/s)", "lockfree(Mops/s)", "speedup", "push retries", "pop retries");
+    for (unsigned numThreads : Benchmark::ThreadCounts(32))
+    {
+        double totalOps = static_cast<double>(numThreads) * listsPerThread;
+
+        ThreadSafeQueue<CommandListPtr> lockedAvailable;
+        ThreadSafeQueue<CommandListPtr> lockedInFlight;
+        auto locked = Run(numThreads, listsPerThread, lockedAvailable, lockedInFlight);
+
+        LockFreeQueue<CommandListPtr> lockFreeAvailable;
+        LockFreeQueue<CommandListPtr> lockFreeInFlight;
+        auto lockFree = Run(numThreads, listsPerThread, lockFreeAvailable, lockFreeInFlight);
+
+        auto availableStatistics = lockFreeAvailable.GetStatistics();
+        auto inFlightStatistics = lockFreeInFlight.GetStatistics();
+        std::printf("%8u %18.2f %18.2f %9.2fx %14zu %14zu\n", numThreads,
+            totalOps / locked * 1e-6,
+            totalOps / lockFree * 1e-6,
+            locked / lockFree,
+            availableStatistics.PushRetries + inFlightStatistics.PushRetries,
+            availableStatistics.PopRetries + inFlightStatistics.PopRetries);
+    }
+    return 0;
+}
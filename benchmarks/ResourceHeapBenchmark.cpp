@@ -0,0 +1,182 @@
+#include "Benchmark.h"
+#include <NeoEngine/inc/TLSFAllocator.h>
+#include <NeoEngine/inc/Application.h>
+#include <NeoEngine/inc/ResourceHeapAllocator.h>
+#include <NeoEngine/inc/d3dx12.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+
+/**
+ * Placed resources against committed resources.
+ * Core:    TLSFAllocator alone,without a device.A load phase allocates the buffers of a scene,
+ *          then a streaming phase frees and allocates random buffers,and fragmentation is printed after each phase.
+ * Device:  the same buffers are created on the null device by ResourceHeapAllocator and by CreateCommittedResource,
+ *          the null device does not back them with memory,so only the cpu cost of creation is measured.
+ * Buffer sizes are log-uniform from 256 bytes to 1MB,like vertex and index buffers of a big scene.
+ * Usage: ResourceHeapBenchmark [buffers] [streaming operations]
+ */
+
+namespace
+{
+    const uint64_t gs_HeapSize = 64ull * 1024 * 1024;
+    const uint64_t gs_PlacementAlignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+    std::vector<uint64_t> MakeBufferSizes(size_t NumBuffers, std::mt19937& Random)
+    {
+        std::uniform_real_distribution<double> logSize(8.0, 20.0);
+        std::vector<uint64_t> sizes(NumBuffers);
+        for (auto& size : sizes)
+        {
+            size = static_cast<uint64_t>(std::exp2(logSize(Random)));
+        }
+        return sizes;
+    }
+
+    void PrintStatistics(const char* pPhase, double Seconds, size_t NumOperations, const TLSFStatistics& Statistics)
+    {
+        std::printf("%-10s %10.1f ns/op %8.1f MB used %8.1f MB free %10.3f fragmentation %8llu free blocks\n",
+            pPhase, Seconds * 1e9 / NumOperations,
+            Statistics.UsedSize / (1024.0 * 1024.0), Statistics.FreeSize / (1024.0 * 1024.0),
+            Statistics.Fragmentation(), static_cast<unsigned long long>(Statistics.NumFreeBlocks));
+    }
+
+    //Heaps of one tier,like ResourceHeapAllocator::AllocateRange() but without a device.
+    struct CoreHeaps
+    {
+        std::vector<std::unique_ptr<TLSFAllocator>> Heaps;
+
+        bool Allocate(uint64_t Size, size_t& HeapIndex, uint64_t& Offset)
+        {
+            for (HeapIndex = 0; HeapIndex < Heaps.size(); ++HeapIndex)
+            {
+                Offset = Heaps[HeapIndex]->Allocate(Size, gs_PlacementAlignment);
+                if (Offset != TLSFAllocator::InvalidOffset)
+                {
+                    return true;
+                }
+            }
+            Heaps.push_back(std::make_unique<TLSFAllocator>(gs_HeapSize, gs_PlacementAlignment));
+            Offset = Heaps.back()->Allocate(Size, gs_PlacementAlignment);
+            return Offset != TLSFAllocator::InvalidOffset;
+        }
+
+        TLSFStatistics GetStatistics()const
+        {
+            TLSFStatistics total;
+            for (const auto& pHeap : Heaps)
+            {
+                auto statistics = pHeap->GetStatistics();
+                total.TotalSize += statistics.TotalSize;
+                total.UsedSize += statistics.UsedSize;
+                total.FreeSize += statistics.FreeSize;
+                total.LargestFreeBlock = (std::max)(total.LargestFreeBlock, statistics.LargestFreeBlock);
+                total.NumAllocations += statistics.NumAllocations;
+                total.NumFreeBlocks += statistics.NumFreeBlocks;
+            }
+            return total;
+        }
+    };
+
+    void RunCore(const std::vector<uint64_t>& Sizes, size_t NumStreamingOperations, std::mt19937& Random)
+    {
+        struct Allocation
+        {
+            size_t HeapIndex;
+            uint64_t Offset;
+            bool bValid;
+        };
+        CoreHeaps heaps;
+        std::vector<Allocation> allocations(Sizes.size());
+
+        auto start = Benchmark::Clock::now();
+        for (size_t i = 0; i < Sizes.size(); ++i)
+        {
+            auto& allocation = allocations[i];
+            allocation.bValid = heaps.Allocate(Sizes[i], allocation.HeapIndex, allocation.Offset);
+        }
+        PrintStatistics("load", Benchmark::SecondsSince(start), Sizes.size(), heaps.GetStatistics());
+
+        //streaming:a random buffer is freed and one of another random size is allocated in its place.
+        std::uniform_int_distribution<size_t> pick(0, Sizes.size() - 1);
+        start = Benchmark::Clock::now();
+        for (size_t i = 0; i < NumStreamingOperations; ++i)
+        {
+            auto& allocation = allocations[pick(Random)];
+            if (allocation.bValid)
+            {
+                heaps.Heaps[allocation.HeapIndex]->Free(allocation.Offset);
+            }
+            allocation.bValid = heaps.Allocate(Sizes[pick(Random)], allocation.HeapIndex, allocation.Offset);
+        }
+        PrintStatistics("streaming", Benchmark::SecondsSince(start), NumStreamingOperations * 2, heaps.GetStatistics());
+        std::printf("%zu heaps of %llu MB\n", heaps.Heaps.size(), static_cast<unsigned long long>(gs_HeapSize >> 20));
+    }
+
+    void RunDevice(const std::vector<uint64_t>& Sizes)
+    {
+        auto device = Application::GetApp()->GetDevice();
+        auto pHeapAllocator = Application::GetApp()->GetResourceHeapAllocator();
+        std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> resources;
+        resources.reserve(Sizes.size());
+
+        auto start = Benchmark::Clock::now();
+        for (auto size : Sizes)
+        {
+            resources.push_back(pHeapAllocator->CreateResource(CD3DX12_RESOURCE_DESC::Buffer(size), D3D12_RESOURCE_STATE_COMMON));
+        }
+        double placedSeconds = Benchmark::SecondsSince(start);
+        auto statistics = pHeapAllocator->GetStatistics();
+        start = Benchmark::Clock::now();
+        resources.clear();
+        double placedReleaseSeconds = Benchmark::SecondsSince(start);
+
+        CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+        start = Benchmark::Clock::now();
+        for (auto size : Sizes)
+        {
+            auto desc = CD3DX12_RESOURCE_DESC::Buffer(size);
+            Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+            ThrowIfFailed(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc,
+                D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&resource)));
+            resources.push_back(resource);
+        }
+        double committedSeconds = Benchmark::SecondsSince(start);
+        start = Benchmark::Clock::now();
+        resources.clear();
+        double committedReleaseSeconds = Benchmark::SecondsSince(start);
+
+        auto bufferTier = statistics.Tiers[static_cast<int>(ResourceHeapTier::Buffer)];
+        std::printf("placed    %10.1f ns/create %10.1f ns/release %4u heaps %10.3f fragmentation %6llu committed fallbacks\n",
+            placedSeconds * 1e9 / Sizes.size(), placedReleaseSeconds * 1e9 / Sizes.size(),
+            statistics.NumHeaps[static_cast<int>(ResourceHeapTier::Buffer)], bufferTier.Fragmentation(),
+            static_cast<unsigned long long>(statistics.NumCommittedResources));
+        std::printf("committed %10.1f ns/create %10.1f ns/release\n",
+            committedSeconds * 1e9 / Sizes.size(), committedReleaseSeconds * 1e9 / Sizes.size());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t numBuffers = argc > 1 ? std::stoull(argv[1]) : 10000;
+    size_t numStreamingOperations = argc > 2 ? std::stoull(argv[2]) : 200000;
+
+    std::mt19937 random(12345);
+    auto sizes = MakeBufferSizes(numBuffers, random);
+
+    std::printf("== TLSF core,%zu buffers\n", numBuffers);
+    RunCore(sizes, numStreamingOperations, random);
+
+    //only cpu-side cost is measured,so resources are not backed by memory.
+    NullDeviceDesc nullDesc;
+    nullDesc.BackResourceMemory = false;
+    Application::Create(nullptr, DeviceBackend::Null, nullDesc);
+    std::printf("== Null device,%zu buffers\n", numBuffers);
+    RunDevice(sizes);
+    Application::Destory();
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "Benchmark.h"
+#include <NeoEngine/inc/Application.h>
+#include <NeoEngine/inc/CommandQueue.h>
+#include <NeoEngine/inc/CommandList.h>
+#include <NeoEngine/inc/Texture.h>
+#include <NeoEngine/inc/ResourceStateTracker.h>
+#include <NeoEngine/inc/d3dx12.h>
+
+#include <memory>
+#include <string>
+
+/**
+ * Multi-threaded submission to the direct queue from 1 to 32 threads on the null device.
+ * Every thread records command lists with transitions of render targets and executes them,
+ * so each submission resolves pending barriers against global resource states.
+ * Shared:  all threads transition the same textures,so slots of global states are contended.
+ * Private: every thread transitions its own textures,so only the submit mutex of the queue is shared,
+ *          it only covers resolving states,ExecuteCommandLists and Signal are issued in turn outside of it.
+ * Usage: SubmitBenchmark [lists per thread] [barriers per list]
+ */
+
+namespace
+{
+    const unsigned gs_MaxThreads = 32;
+    const size_t gs_NumSharedTextures = 64;
+    const size_t gs_TexturesPerThread = 8;
+
+    std::vector<std::unique_ptr<Texture>> MakeTextures(size_t NumTextures)
+    {
+        auto desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 256, 256, 1, 1, 1, 0,
+            D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+        D3D12_CLEAR_VALUE clearValue = {};
+        clearValue.Format = desc.Format;
+        std::vector<std::unique_ptr<Texture>> textures;
+        for (size_t i = 0; i < NumTextures; ++i)
+        {
+            textures.push_back(std::make_unique<Texture>(&desc, &clearValue, TextureUsage::RenderTargetTexture,
+                L"Submit Texture " + std::to_wstring(i)));
+        }
+        return textures;
+    }
+
+    //PickTexture(ThreadIndex,Barrier) picks the texture of a barrier.
+    template<typename PickFunc>
+    double Run(unsigned NumThreads, size_t ListsPerThread, size_t BarriersPerList, PickFunc PickTexture)
+    {
+        auto directQueue = Application::GetApp()->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
+        double seconds = Benchmark::RunThreads(NumThreads, [&](unsigned ThreadIndex)
+        {
+            for (size_t i = 0; i < ListsPerThread; ++i)
+            {
+                auto commandList = directQueue->GetCommandList();
+                auto state = (i & 1) ? D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE : D3D12_RESOURCE_STATE_RENDER_TARGET;
+                for (size_t barrier = 0; barrier < BarriersPerList; ++barrier)
+                {
+                    commandList->BarrierTransition(PickTexture(ThreadIndex, i * BarriersPerList + barrier), state);
+                }
+                directQueue->ExecuteCommandList(commandList);
+            }
+        });
+        directQueue->Flush();
+        return seconds;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t listsPerThread = argc > 1 ? std::stoull(argv[1]) : 2000;
+    size_t barriersPerList = argc > 2 ? std::stoull(argv[2]) : 8;
+
+    Application::Create(nullptr, DeviceBackend::Null);
+    {
+        auto sharedTextures = MakeTextures(gs_NumSharedTextures);
+        auto privateTextures = MakeTextures(gs_MaxThreads * gs_TexturesPerThread);
+
+        std::printf("%8s %20s %20s %18s\n", "threads", "shared(lists/s)", "private(lists/s)", "contended locks");
+        for (unsigned numThreads : Benchmark::ThreadCounts(gs_MaxThreads))
+        {
+            double totalLists = static_cast<double>(numThreads) * listsPerThread;
+
+            auto contendedBefore = ResourceStateTracker::GetStatistics().NumContendedStateLocks;
+            auto shared = Run(numThreads, listsPerThread, barriersPerList, [&](unsigned ThreadIndex, size_t Barrier)
+            {
+                return sharedTextures[(ThreadIndex * 7 + Barrier) % gs_NumSharedTextures].get();
+            });
+            auto contended = ResourceStateTracker::GetStatistics().NumContendedStateLocks - contendedBefore;
+
+            auto exclusive = Run(numThreads, listsPerThread, barriersPerList, [&](unsigned ThreadIndex, size_t Barrier)
+            {
+                return privateTextures[ThreadIndex * gs_TexturesPerThread + Barrier % gs_TexturesPerThread].get();
+            });
+
+            std::printf("%8u %20.0f %20.0f %18llu\n", numThreads,
+                totalLists / shared, totalLists / exclusive, static_cast<unsigned long long>(contended));
+        }
+    }
+    Application::Destory();
+
+    return 0;
+}
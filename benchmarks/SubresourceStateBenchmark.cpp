@@ -0,0 +1,137 @@
+#include "Benchmark.h"
+#include <NeoEngine/inc/Application.h>
+#include <NeoEngine/inc/CommandQueue.h>
+#include <NeoEngine/inc/CommandList.h>
+#include <NeoEngine/inc/Texture.h>
+#include <NeoEngine/inc/ResourceStateTracker.h>
+#include <NeoEngine/inc/d3dx12.h>
+
+#include <memory>
+#include <string>
+
+/**
+ * Per-subresource transitions through ResourceStateTracker on the null device.
+ * Mips:     12-mip textures are walked like GenerateMips,every mip is read and the next one is written,
+ *           then the whole texture goes back to PIXEL_SHADER_RESOURCE.
+ * Cascades: 8-slice shadow cascade arrays are rendered slice by slice,then sampled as a whole.
+ * Cubes:    a 24-slice array of 4 point light cubes.
+ * All of them have more subresources than the inline states,so their split states are on heap.
+ * Split subresource states fold back to a uniform state when the whole resource is transitioned,and the heap storage is freed.
+ * Usage: SubresourceStateBenchmark [frames] [textures]
+ */
+
+namespace
+{
+    const UINT16 gs_NumMips = 12;
+    const UINT16 gs_NumCascades = 8;
+    const UINT16 gs_NumCubeSlices = 24;
+
+    using TextureList = std::vector<std::unique_ptr<Texture>>;
+
+    TextureList MakeTextures(size_t NumTextures, const D3D12_RESOURCE_DESC& Desc, const D3D12_CLEAR_VALUE* pClearValue,
+        TextureUsage Usage, const std::wstring& Name)
+    {
+        TextureList textures;
+        for (size_t i = 0; i < NumTextures; ++i)
+        {
+            textures.push_back(std::make_unique<Texture>(&Desc, pClearValue, Usage, Name + std::to_wstring(i)));
+        }
+        return textures;
+    }
+
+    UINT WalkMips(CommandList& List, const Texture* pTexture)
+    {
+        for (UINT mip = 1; mip < gs_NumMips; ++mip)
+        {
+            List.BarrierTransition(pTexture, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, mip - 1);
+            List.BarrierTransition(pTexture, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, mip);
+        }
+        List.BarrierTransition(pTexture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        return (gs_NumMips - 1) * 2 + 1;
+    }
+
+    UINT WalkSlices(CommandList& List, const Texture* pTexture, UINT16 NumSlices)
+    {
+        for (UINT slice = 0; slice < NumSlices; ++slice)
+        {
+            List.BarrierTransition(pTexture, D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12CalcSubresource(0, slice, 0, 1, NumSlices));
+        }
+        List.BarrierTransition(pTexture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        return NumSlices + 1;
+    }
+
+    //Walk(CommandList,Texture) records the transitions of a texture and returns how many there are.
+    template<typename WalkFunc>
+    void Run(const char* pName, UINT64 NumFrames, const TextureList& Textures, WalkFunc Walk)
+    {
+        auto directQueue = Application::GetApp()->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
+        auto statisticsBefore = ResourceStateTracker::GetStatistics();
+        uint64_t numTransitions = 0;
+
+        auto start = Benchmark::Clock::now();
+        Application::GetApp()->RunHeadless(NumFrames, [&](const UpdateEventArgs&, const RenderEventArgs&)
+        {
+            auto commandList = directQueue->GetCommandList();
+            for (const auto& pTexture : Textures)
+            {
+                numTransitions += Walk(*commandList, pTexture.get());
+            }
+            directQueue->ExecuteCommandList(commandList);
+        });
+        double seconds = Benchmark::SecondsSince(start);
+
+        auto statistics = ResourceStateTracker::GetStatistics();
+        auto frameStatistics = ResourceStateTracker::GetFrameStatistics();
+        std::printf("%-10s %10.1f ns/transition %8llu requested %8llu issued %8llu merged %10llu splits %8llu heap splits\n",
+            pName, seconds * 1e9 / numTransitions,
+            static_cast<unsigned long long>(frameStatistics.NumRequestedBarriers),
+            static_cast<unsigned long long>(frameStatistics.NumIssuedBarriers),
+            static_cast<unsigned long long>(frameStatistics.NumMergedBarriers),
+            static_cast<unsigned long long>(statistics.NumSplitStates - statisticsBefore.NumSplitStates),
+            static_cast<unsigned long long>(statistics.NumHeapSplitStates - statisticsBefore.NumHeapSplitStates));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    UINT64 numFrames = argc > 1 ? std::stoull(argv[1]) : 1000;
+    size_t numTextures = argc > 2 ? std::stoull(argv[2]) : 16;
+
+    //only states are tracked,so resources are not backed by memory.
+    NullDeviceDesc nullDesc;
+    nullDesc.BackResourceMemory = false;
+    Application::Create(nullptr, DeviceBackend::Null, nullDesc);
+    {
+        auto mipDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 2048, 2048, 1, gs_NumMips, 1, 0,
+            D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        auto cascadeDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D32_FLOAT, 2048, 2048, gs_NumCascades, 1, 1, 0,
+            D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
+        auto cubeDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D32_FLOAT, 1024, 1024, gs_NumCubeSlices, 1, 1, 0,
+            D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
+        D3D12_CLEAR_VALUE depthClearValue = {};
+        depthClearValue.Format = DXGI_FORMAT_D32_FLOAT;
+        depthClearValue.DepthStencil.Depth = 1.0f;
+
+        auto mipTextures = MakeTextures(numTextures, mipDesc, nullptr, TextureUsage::Diffuse, L"Mip Texture ");
+        auto cascadeTextures = MakeTextures(numTextures, cascadeDesc, &depthClearValue, TextureUsage::Depth, L"Cascade Texture ");
+        auto cubeTextures = MakeTextures(numTextures, cubeDesc, &depthClearValue, TextureUsage::Depth, L"Cube Texture ");
+
+        std::printf("== %llu frames,%zu textures of each kind,barrier counts are of the last frame\n",
+            static_cast<unsigned long long>(numFrames), numTextures);
+        Run("mips", numFrames, mipTextures, [](CommandList& List, const Texture* pTexture)
+        {
+            return WalkMips(List, pTexture);
+        });
+        Run("cascades", numFrames, cascadeTextures, [](CommandList& List, const Texture* pTexture)
+        {
+            return WalkSlices(List, pTexture, gs_NumCascades);
+        });
+        Run("cubes", numFrames, cubeTextures, [](CommandList& List, const Texture* pTexture)
+        {
+            return WalkSlices(List, pTexture, gs_NumCubeSlices);
+        });
+    }
+    Application::Destory();
+
+    return 0;
+}
@@ -1,16 +1,23 @@
 #pragma once
 
 #include "DescriptorAllocation.h"
+#include "NullDevice.h"
+#include "Events.h"
+#include "Platform.h"
 #include <memory>
-#include <dxgi1_6.h>
+#include <functional>
 #include <unordered_map>
-#include <wrl.h>
-#include <d3d12.h>
 
+#if defined(_WIN32)
+#include <dxgi1_6.h>
 
 #pragma comment(lib,"d3dcompiler.lib")
 #pragma comment(lib,"D3D12.lib")
 #pragma comment(lib,"dxgi.lib")
+#else
+//there are neither windows nor module instances,headless runs pass nullptr.
+typedef void* HINSTANCE;
+#endif
 
 //forward-declaration
 class Window;
@@ -18,14 +25,48 @@ class Game;
 class GameTimer;
 class CommandQueue;
 class DescriptorAllocator;
+class JobSystem;
+class UploadRingBuffer;
+class ResourceHeapAllocator;
+class DeferredDeletionQueue;
+class BindlessDescriptorHeap;
+class ViewCache;
+
+/**
+ * Kinds of engine-wide null descriptor tables,see Application::GetNullDescriptors().
+ */
+enum class NullDescriptorType
+{
+    Texture2D,
+    Texture2DArray,
+    TextureCube,
+    RWTexture2D,
+    NumTypes
+};
+
+/**
+ * Which kind of d3d12 device the application runs on.
+ * Null device runs everything on cpu and has no window,it is for headless runs and measurements.
+ */
+enum class DeviceBackend
+{
+    Hardware,
+    Warp,
+    Null
+};
 
 class Application
 {
 public:
+    //the number of descriptors in every null descriptor table.
+    static const UINT MaxNullDescriptors = 128;
+    //the number of frames which a headless run keeps in flight,the same as back buffers of a window.
+    static const UINT HeadlessFramesInFlight = 3;
     /**
      * Create an application
+     * @param NullDesc: only used when Backend is DeviceBackend::Null
      */
-    static void Create(HINSTANCE hinstance);
+    static void Create(HINSTANCE hinstance, DeviceBackend Backend = DeviceBackend::Hardware, const NullDeviceDesc& NullDesc = NullDeviceDesc());
     /**
      * Get a static pointer of application to use member functions.
      */
@@ -36,8 +77,6 @@ public:
     static void Destory();
     /**
      * Get current total frame of this app.
-     * This function is used to release stale descriptors after relevant frame has been completed.
-     * But here is a question is: Why we use frame to release stale descriptors instead of fencevalue?
      */
     static UINT64 GetFrameCount()
     {
@@ -48,7 +87,8 @@ public:
      * This function is just for simple demo.
      * If you want some descriptors , for more efficient, you should use AllocateDescriptors() method.
      */
-    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE Type,UINT NumDescriptors);
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE Type,UINT NumDescriptors,
+        D3D12_DESCRIPTOR_HEAP_FLAGS Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE);
     /**
      * Get descriptor size
      */
@@ -65,6 +105,10 @@ public:
      * Get D3D12 Device
      */
     Microsoft::WRL::ComPtr<ID3D12Device2> GetDevice()const;
+    /**
+     * Get the kind of device which is used by this application
+     */
+    DeviceBackend GetDeviceBackend()const;
     /**
      * Get a struct commandqueue to record or execute commands and create swapchain.
      * We create three different command queue for possible usage.
@@ -73,6 +117,44 @@ public:
      * D3D12_COMMAND_LIST_TYPE_DIRECT : a command queue for copy,dispath or draw command.
      */
     std::shared_ptr<CommandQueue> GetCommandQueue(D3D12_COMMAND_LIST_TYPE Type = D3D12_COMMAND_LIST_TYPE_DIRECT);
+    /**
+     * Get the job system which is shared by the whole engine.
+     */
+    JobSystem* GetJobSystem()const;
+    /**
+     * Get the upload ring buffer which dynamic data of all command lists are allocated from.
+     */
+    UploadRingBuffer* GetUploadRingBuffer()const;
+    /**
+     * Get the allocator which places default heap buffers and textures in shared heaps.
+     */
+    ResourceHeapAllocator* GetResourceHeapAllocator()const;
+    /**
+     * Get the queue which resources and descriptors are retired to when they are released.
+     * It is null before command queues are created,then released objects can be destroyed at once.
+     */
+    DeferredDeletionQueue* GetDeferredDeletionQueue()const;
+    /**
+     * Turn on bindless mode.All cbv,srv and uav tables of command lists are allocated from one big shader visible heap then,
+     * and resources can get persistent indices in it by Resource::GetBindlessIndex().
+     * It must be called before any command list or pass is created.
+     * @return false if the device does not support unbounded descriptor tables(resource binding tier 2).
+     */
+    bool EnableBindlessDescriptors();
+    /**
+     * Get the shader visible heap of bindless mode,it is null if bindless mode is off.
+     */
+    BindlessDescriptorHeap* GetBindlessDescriptorHeap()const;
+    /**
+     * Get the cache of views and samplers which is shared by all resources.
+     */
+    ViewCache* GetViewCache()const;
+    /**
+     * Get a table of MaxNullDescriptors null descriptors,which is shared by all passes and models.
+     * Stage it by DynamicDescriptorHeap::StageNullDescriptors() for slots which are not used.
+     */
+    D3D12_CPU_DESCRIPTOR_HANDLE GetNullDescriptors(NullDescriptorType Type)const;
+#if defined(_WIN32)
     /**
      * Create rendering window for application
      */
@@ -102,6 +184,15 @@ public:
      * @return message Wparam --int type
      */
     int Run(std::shared_ptr<Game> pGame);
+#endif
+    /**
+     * Run frames without a window or message loop,it is the entry of headless runs on the null device.
+     * Every frame calls Frame to update and record,then the direct queue is signaled and the frame is ended.
+     * Like Window::Present(),it waits for the frame which is HeadlessFramesInFlight frames before.
+     * @param NumFrames: how many frames to run
+     * @param Frame: records and executes command lists of a frame
+     */
+    void RunHeadless(UINT64 NumFrames, const std::function<void(const UpdateEventArgs&, const RenderEventArgs&)>& Frame);
     /**
      * Get application timer
      */
@@ -119,15 +210,22 @@ public:
      */
     DXGI_SAMPLE_DESC CheckMultipleSampleQulityLevels(DXGI_FORMAT format, UINT numSamples, D3D12_MULTISAMPLE_QUALITY_LEVEL_FLAGS flags = D3D12_MULTISAMPLE_QUALITY_LEVELS_FLAG_NONE)const;
     /**
-     * Release all stale descriptor in descirptoralloctor
-     * This function will be called after relevant frame has been completed in Window::Present()
+     * Per-frame tick,it seals,drains and trims the per-frame systems whether or not a window exists.
+     * It is called at the end of every frame by Window::Present() and RunHeadless(),all command lists of the frame are executed then.
      */
-    void ReleaseStaleDescriptors(UINT64 frame);
+    void EndFrame();
+    /**
+     * Release retired resources and descriptors which the gpu is done with.
+     * EndFrame() calls it every frame,call it with bFlushed after the command queues are flushed.
+     * @param bFlushed: true if all command queues are flushed,then everything which is retired is released.
+     */
+    void ReleaseRetiredObjects(bool bFlushed = false);
 
     static UINT m_MultiSampleCount;
 protected:
-    Application(HINSTANCE hinstance);
+    Application(HINSTANCE hinstance, DeviceBackend Backend, const NullDeviceDesc& NullDesc);
     ~Application();
+#if defined(_WIN32)
     /**
      * Get desired adapter to create d3d12 device.
      */
@@ -140,27 +238,48 @@ protected:
      * Check if hardware supports G-sync
      */
     bool CheckSupportTearing();
+#endif
     /**
      * 
      */
     void Initialize();
+    /**
+     * Create null descriptor tables,their formats are not important.
+     */
+    void CreateNullDescriptors();
 private:
+#if defined(_WIN32)
     friend LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
+#endif
 
     HINSTANCE m_hinstance;
+    DeviceBackend m_DeviceBackend;
+    NullDeviceDesc m_NullDeviceDesc;
     bool m_bUseWarp;
     bool m_bSupportTearing;
     bool m_bIsAppPaused;
 
     std::shared_ptr<GameTimer> m_pTimer;
+    std::unique_ptr<JobSystem> m_pJobSystem;
     static UINT64 m_FrameCount;
 
     Microsoft::WRL::ComPtr<ID3D12Device2> m_d3d12Device;
+#if defined(_WIN32)
     Microsoft::WRL::ComPtr<IDXGIAdapter4> m_dxgiAdapter;
+#endif
 
+    //command lists retire their chunks when they are destroyed,so it must be destroyed after command queues.
+    std::unique_ptr<UploadRingBuffer> m_pUploadRingBuffer;
+    std::unique_ptr<ResourceHeapAllocator> m_pResourceHeapAllocator;
+    //It keeps command queues alive until all retired objects are released,and descriptor allocators retire to it when they are destroyed.
+    std::unique_ptr<DeferredDeletionQueue> m_pDeferredDeletionQueue;
     std::shared_ptr<CommandQueue> m_DirectCommandQueue;
     std::shared_ptr<CommandQueue> m_CopyCommandQueue;
     std::shared_ptr<CommandQueue> m_ComputeCommandQueue;
+    std::unique_ptr<BindlessDescriptorHeap> m_pBindlessDescriptorHeap;
 
     std::unique_ptr<DescriptorAllocator> m_DescriptorAllocator[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+    DescriptorAllocation m_NullDescriptors[static_cast<int>(NullDescriptorType::NumTypes)];
+    //its descriptors are from allocators and bindless heap above,so it must be destroyed first.
+    std::shared_ptr<ViewCache> m_pViewCache;
 };
\ No newline at end of file
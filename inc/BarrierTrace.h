@@ -0,0 +1,125 @@
+#pragma once
+
+/**
+ * @brief Barrier Trace
+ *
+ * A capture of every barrier which commandlists ask ResourceStateTracker for,in a compact binary form,
+ * so we can see how many barriers a frame issues and which code asks for them.
+ * Events of a commandlist are kept by its tracker while it is recorded,and they are appended to the trace when
+ * the command queue closes it.So the trace is in the order that queues resolve states,and recording threads do not share a lock.
+ * A resource is written with its desc and global state when it is seen at first time,and events only refer to its id,
+ * so a trace can be replayed without the resources(see BarrierTraceReplayer).
+ * Note:commandlists which are being recorded when the capture begins are captured partly.
+ *
+ * Layout:magic(u32),version(u32),then events.Every event starts with its type(u8),and fields follow in little endian:
+ *  Resource:          id(u32),desc(dimension u32,alignment u64,width u64,height u32,depth or array size u16,mip levels u16,
+ *                     format u32,sample count u32,sample quality u32,layout u32,flags u32),
+ *                     number of subresource states(u32,0 means uniform),then one state(u32) or a state(u32) for each subresource.
+ *  RemoveResource:    id(u32)
+ *  CommandList:       commandlist type(u8),events of the commandlist follow until Close.
+ *  Transition:        id(u32),subresource(u32),state after(u32),call site(u64)
+ *  BeginTransition:   same as Transition
+ *  UavBarrier:        id(u32),call site(u64)
+ *  AliasBarrier:      id before(u32),id after(u32),call site(u64)
+ *  Flush,EndSplitBarriers,Close:nothing
+ *  Execute:           commandlist type(u8),commandlists of this type which are closed since last Execute are executed.
+ * Id 0 is a null resource,which means any resource for uav and aliasing barriers.
+ * A call site is the return address in the code which calls a barrier function of CommandList,
+ * it can be resolved with symbols of the same build.
+ */
+
+#include "Platform.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+//The return address of current function,which is the call site of a barrier function of CommandList.
+#define BARRIER_TRACE_CALL_SITE() _ReturnAddress()
+#else
+#define BARRIER_TRACE_CALL_SITE() __builtin_return_address(0)
+#endif
+
+enum class BarrierTraceEventType : uint8_t
+{
+    Resource,
+    RemoveResource,
+    CommandList,
+    Transition,
+    BeginTransition,
+    UavBarrier,
+    AliasBarrier,
+    //valid barriers are flushed to the commandlist,there may be gpu work after it.
+    Flush,
+    //all split barriers are ended before the commandlist is closed.
+    EndSplitBarriers,
+    //pending barriers are resolved and final states are committed.
+    Close,
+    Execute
+};
+
+/**
+ * An event which is kept by a tracker until its commandlist is closed.
+ */
+struct BarrierTraceEvent
+{
+    BarrierTraceEventType Type;
+    UINT Subresource;
+    D3D12_RESOURCE_STATES StateAfter;
+    //the resource before of an aliasing barrier.
+    ID3D12Resource* pResource;
+    ID3D12Resource* pResourceAfter;
+    const void* pCallSite;
+};
+
+class BarrierTrace
+{
+public:
+    static const uint32_t Magic = 0x43525442;//"BTRC"
+    static const uint32_t Version = 1;
+
+    /**
+     * Start capturing,the trace of last capture is dropped.
+     */
+    static void BeginCapture();
+    /**
+     * Stop capturing.
+     * @return the trace.
+     */
+    static std::vector<uint8_t> EndCapture();
+    static bool IsCapturing() { return ms_IsCapturing.load(std::memory_order_relaxed); }
+
+    static bool SaveToFile(const std::vector<uint8_t>& Trace, const std::string& FileName);
+    static bool LoadFromFile(const std::string& FileName, std::vector<uint8_t>& Trace);
+
+    /**
+     * These are called by ResourceStateTracker and CommandQueue,they do nothing when it is not capturing.
+     */
+    static void RecordResource(ID3D12Resource* pResource, D3D12_RESOURCE_STATES State);
+    static void RecordRemoveResource(ID3D12Resource* pResource);
+    static void RecordCommandList(D3D12_COMMAND_LIST_TYPE Type, const std::vector<BarrierTraceEvent>& Events);
+    static void RecordExecute(D3D12_COMMAND_LIST_TYPE Type);
+private:
+    template<typename T>
+    static void Write(T Value)
+    {
+        const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(&Value);
+        ms_Trace.insert(ms_Trace.end(), pBytes, pBytes + sizeof(T));
+    }
+    /**
+     * Get the id of a resource,a Resource event is written if it is seen at first time.
+     * The trace must be locked.
+     */
+    static uint32_t GetResourceId(ID3D12Resource* pResource);
+    static void WriteResource(uint32_t Id, ID3D12Resource* pResource, D3D12_RESOURCE_STATES State, const std::vector<D3D12_RESOURCE_STATES>& States);
+
+    static std::atomic<bool> ms_IsCapturing;
+    static std::mutex ms_Mutex;
+    static std::vector<uint8_t> ms_Trace;
+    static std::unordered_map<ID3D12Resource*, uint32_t> ms_ResourceIds;
+    static uint32_t ms_NextResourceId;
+};
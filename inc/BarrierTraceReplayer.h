@@ -0,0 +1,125 @@
+#pragma once
+
+/**
+ * @brief Barrier Trace Replayer
+ *
+ * Replays a barrier trace(see BarrierTrace) through ResourceStateTracker on a null device,so the barriers of a captured frame
+ * can be checked and the tracker can be measured without a gpu or the scene.
+ * Resources are created again from their descs without memory,and every commandlist of the trace is recorded by a tracker
+ * of its type,closed and committed in the order of the trace,just like CommandQueue does.
+ *
+ * Barriers which the tracker issues are checked against the states that the gpu really sees:
+ * every transition must start from the state which the subresource is in,or from COMMON when the runtime can promote it,
+ * and at the end of a commandlist every subresource must be in the state which was asked for at last.
+ * Only the tracker calls are timed,so the throughput does not include parsing and checking.
+ * Note:global states are shared by all trackers,so nothing else should use ResourceStateTracker while a trace is replayed.
+ */
+
+#include "Platform.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ResourceStateTracker.h"
+
+struct BarrierTraceReplayResult
+{
+    //false if the trace is not a barrier trace or it is cut off.
+    bool IsValid = false;
+    uint64_t NumResources = 0;
+    uint64_t NumCommandLists = 0;
+    //Barriers which are asked for by commandlists,and barriers which the tracker records,including pending barriers.
+    uint64_t NumRequestedBarriers = 0;
+    uint64_t NumIssuedBarriers = 0;
+    uint64_t NumPendingBarriers = 0;
+    //Transitions whose state before is wrong,and subresources which are not in the state asked for at the end of a commandlist.
+    uint64_t NumStateErrors = 0;
+    //Messages of the first errors.
+    std::vector<std::string> Errors;
+    //Time spent in ResourceStateTracker.
+    double TrackerSeconds = 0.0;
+
+    struct CallSite
+    {
+        uint64_t Address;
+        uint64_t NumRequestedBarriers;
+    };
+    //Call sites which ask for most barriers,in descending order.
+    std::vector<CallSite> TopCallSites;
+
+    double BarriersPerSecond()const { return TrackerSeconds > 0.0 ? NumRequestedBarriers / TrackerSeconds : 0.0; }
+};
+
+class BarrierTraceReplayer
+{
+public:
+    static const size_t MaxErrors = 16;
+    static const size_t MaxTopCallSites = 16;
+
+    //@param:pDevice the device which creates resources of the trace,a null device without resource memory is created if it is null.
+    explicit BarrierTraceReplayer(Microsoft::WRL::ComPtr<ID3D12Device> pDevice = nullptr);
+    ~BarrierTraceReplayer();
+
+    BarrierTraceReplayer(const BarrierTraceReplayer& copy) = delete;
+    BarrierTraceReplayer& operator=(const BarrierTraceReplayer& other) = delete;
+
+    BarrierTraceReplayResult Replay(const std::vector<uint8_t>& Trace);
+private:
+    //Reads fields of the trace,it returns false when the trace is cut off.
+    class Reader
+    {
+    public:
+        explicit Reader(const std::vector<uint8_t>& Trace) : m_Trace(Trace), m_Offset(0) {}
+        template<typename T>
+        bool Read(T& Value)
+        {
+            if (m_Offset + sizeof(T) > m_Trace.size())
+            {
+                return false;
+            }
+            std::memcpy(&Value, m_Trace.data() + m_Offset, sizeof(T));
+            m_Offset += sizeof(T);
+            return true;
+        }
+        bool IsEnd()const { return m_Offset == m_Trace.size(); }
+    private:
+        const std::vector<uint8_t>& m_Trace;
+        size_t m_Offset;
+    };
+
+    //The states which the gpu really sees.
+    struct ShadowResource
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> pResource;
+        bool DecaysToCommon = false;
+        std::vector<D3D12_RESOURCE_STATES> States;
+    };
+
+    bool ReadResource(Reader& reader, BarrierTraceReplayResult& Result);
+    bool ReadCommandList(Reader& reader, BarrierTraceReplayResult& Result);
+    ID3D12Resource* GetResource(uint32_t Id)const;
+
+    //Apply issued barriers to shadow states,the state before of every transition is checked.
+    void ApplyBarriers(const std::vector<D3D12_RESOURCE_BARRIER>& Barriers, D3D12_COMMAND_LIST_TYPE Type, BarrierTraceReplayResult& Result);
+    //Check if the runtime promotes a subresource from COMMON to State.
+    static bool CanPromote(const ShadowResource& Resource, D3D12_RESOURCE_STATES State);
+    void AddError(BarrierTraceReplayResult& Result, const char* pMessage, uint32_t Id, UINT Subresource,
+        D3D12_RESOURCE_STATES Expected, D3D12_RESOURCE_STATES Actual);
+    void Clear();
+
+    Microsoft::WRL::ComPtr<ID3D12Device> m_pDevice;
+    std::unordered_map<uint32_t, ShadowResource> m_Resources;
+    std::unordered_map<ID3D12Resource*, uint32_t> m_ResourceIds;
+    //Containers below are indexed by D3D12_COMMAND_LIST_TYPE,bundles are not used.
+    static const size_t NumCommandListTypes = D3D12_COMMAND_LIST_TYPE_COPY + 1;
+    //one tracker for each commandlist type,like commandlists of a queue.
+    std::unique_ptr<ResourceStateTracker> m_Trackers[NumCommandListTypes];
+    //global states which decay when commandlists of a type are executed.
+    std::vector<std::shared_ptr<GlobalResourceState>> m_DecayedStates[NumCommandListTypes];
+    //shadow resources which are used by commandlists of a type since last execution.
+    std::vector<uint32_t> m_UsedResources[NumCommandListTypes];
+    std::unordered_map<uint64_t, uint64_t> m_CallSites;
+};
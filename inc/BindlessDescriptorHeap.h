@@ -0,0 +1,64 @@
+#pragma once
+
+/**
+ * @brief Bindless Descriptor Heap
+ *
+ * In bindless mode,one big shader visible cbv/srv/uav heap is bound by every command list,
+ * and resources put their views in it once,so shaders index views by persistent indices which are passed by root constants,
+ * instead of copying descriptors into a new table before every draw.
+ * Root signatures bind the whole heap by a table whose ranges are unbounded and start from offset 0(see RootSignature),
+ * then the index of a view is its offset in the heap.
+ * Tables which are still staged by DynamicDescriptorHeap are allocated from this heap too,
+ * since only one cbv/srv/uav heap can be bound at a time.
+ * Descriptors are freed through the deferred deletion queue like other descriptors.
+ */
+
+#include "DescriptorAllocation.h"
+#include "TLSFAllocator.h"
+
+#include "Platform.h"
+#include <memory>
+
+class DescriptorAllocatorPage;
+
+class BindlessDescriptorHeap
+{
+public:
+    /**
+     * @param NumDescriptors: the size of the heap,resource binding tier 2 allows 1000000 descriptors at most.
+     */
+    explicit BindlessDescriptorHeap(UINT NumDescriptors = 1 << 17);
+    ~BindlessDescriptorHeap();
+
+    BindlessDescriptorHeap(const BindlessDescriptorHeap& copy) = delete;
+    BindlessDescriptorHeap& operator=(const BindlessDescriptorHeap& other) = delete;
+
+    /**
+     * Allocate consistent descriptors in the shader visible heap.
+     * Throw std::bad_alloc if the heap is full.
+     */
+    DescriptorAllocation Allocate(UINT NumDescriptors = 1);
+    /**
+     * Get the index of a descriptor which is allocated from this heap,shaders use it to index the bindless table.
+     */
+    UINT GetIndex(D3D12_CPU_DESCRIPTOR_HANDLE Descriptor)const;
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGpuDescriptorHandle(D3D12_CPU_DESCRIPTOR_HANDLE Descriptor)const;
+    /**
+     * The gpu handle of the first descriptor,which is the base of bindless tables.
+     */
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHeapStart()const { return m_GpuHeapStart; }
+
+    ID3D12DescriptorHeap* GetD3D12DescriptorHeap()const;
+    UINT GetNumDescriptors()const { return m_NumDescriptors; }
+    /**
+     * Get fragmentation statistics of the heap,sizes are in descriptors.
+     */
+    TLSFStatistics GetStatistics();
+private:
+    std::shared_ptr<DescriptorAllocatorPage> m_pPage;
+
+    UINT m_NumDescriptors;
+    UINT m_DescriptorIncrementSize;
+    D3D12_CPU_DESCRIPTOR_HANDLE m_CpuHeapStart;
+    D3D12_GPU_DESCRIPTOR_HANDLE m_GpuHeapStart;
+};
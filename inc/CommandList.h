@@ -6,7 +6,8 @@
 #include "d3dx12.h"
 #include "Scene.h"
 #include "Environment.h"
-#include <wrl.h>
+#include "CommandQueue.h"
+#include "Platform.h"
 #include <memory>
 #include <vector>
 #include <unordered_map>
@@ -40,6 +41,14 @@ public:
      * Transiton a resource to proper state before executing command
      */
     void BarrierTransition(const Resource* pResource, D3D12_RESOURCE_STATES StateAfter,UINT subResource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, bool IsFlushBarrier = false);
+    /**
+     * Begin a transition as a split barrier,as soon as the resource is not used by commands any more.
+     * It is ended by next barrier of this resource(e.g. BarrierTransition() to the same state),or when this commandlist is closed.
+     * So other commands are recorded between begin and end,and gpu can do the transition when it is running them.
+     * Note: the resource must NOT be used between begin and end.
+     * @see: https://learn.microsoft.com/en-us/windows/win32/direct3d12/using-resource-barriers-to-synchronize-resource-states-in-direct3d-12#split-barriers
+     */
+    void BarrierTransitionBegin(const Resource* pResource, D3D12_RESOURCE_STATES StateAfter, UINT subResource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
     /**
      * A barrier for alias,this is useful for ID3D12Device::CreatePlacedResource() or ID3D12Device::CreateReservedResource()
      * @param: pResourceBefore and pResourceAfter can both be nullptr,which means any placed or reserved resource could cause alisaing.
@@ -226,9 +235,26 @@ public:
     //
     void Dispatch(UINT NumGroupX, UINT NumGroupY, UINT NumGroupZ);
 
+    /**
+     * Generate mips of a texture.Direct and compute commandlists generate mips in place,after former commands.
+     * A copy commandlist can not dispatch,so it collects textures,and the copy queue generates mips of all textures
+     * in an execution with one compute commandlist after the copies.
+     */
     void GenerateMipMaps(Texture* pTexture);
 
-    std::shared_ptr<CommandList> GetGenerateMipsCommandList()const { return m_pComputeCommandList; };
+    const std::vector<Texture*>& GetGenerateMipsTextures()const { return m_GenerateMipsTextures; };
+    /**
+     * Add a timeline point of other queue which this command list depends on,
+     * the queue only waits for this point before this command list is executed.
+     */
+    void AddDependency(const QueueTimelinePoint& Dependency);
+
+    const std::vector<QueueTimelinePoint>& GetDependencies()const { return m_Dependencies; };
+    /**
+     * Get the copy command list which records uploads of this command list,it is null if nothing is uploaded.
+     * CommandQueue executes it on the copy queue before this command list.
+     */
+    std::shared_ptr<CommandList> GetUploadCommandList()const { return m_pCopyCommandList; };
 
     /************************************************************************/
     /*Fllowing functions are ready for other interior classes to use        */
@@ -237,14 +263,24 @@ public:
     /**
      * This is Close is for CommandQueue to use.
      * Before the command queue to execute,we need to flush all pending resource state.
-     * If pending resource state is not empty.We need a new commandlist to insert resource barrier before current commandlist.
-     * @param : pendingCommandList: a new commandlist to execute pending resource barrier.
-     * @return : If the pending resource barrier is not empty,return TRUE otherwise FALSE.
+     * If pending resource state is not empty.We need a barrier commandlist to insert resource barrier before current commandlist.
+     * @param : PendingBarriers: pending resource barriers are appended to it,command queue records them into a barrier commandlist.
+     * @param : CommittedResources: resources whose final state are committed to global resource state are inserted to it.
+     * @param : pFence,FenceValue: the fence which the queue signals after this commandlist,resources used by copy or compute commandlist
+     * wait for it on other queues.
+     * @param : DecayedStates: global states of resources which decay to COMMON after ExecuteCommandLists() are appended to it.
+     * @return : the number of pending resource barriers of this commandlist.
+     */
+    UINT Close(std::vector<D3D12_RESOURCE_BARRIER>& PendingBarriers, std::unordered_set<ID3D12Resource*>& CommittedResources,
+        ID3D12Fence* pFence, UINT64 FenceValue, std::vector<std::shared_ptr<GlobalResourceState>>& DecayedStates);
+    /**
+     * Wait for copy queue fences of uploaded resources which are used by this commandlist.
+     * This is for CommandQueue to use after Close(PendingBarriers,CommittedResources,pFence,FenceValue,DecayedStates) and before executing this commandlist.
      */
-    bool Close(CommandList& pendingCommandList);
+    void FlushQueueWaits(ID3D12CommandQueue* pCommandQueue);
     /**
      * Just to close current commandlist
-     * This is useful for pending commandlist 
+     * This is useful for barrier commandlist 
      */
     void Close();
     /**
@@ -269,6 +305,9 @@ protected:
     //Flush all non-pending resource barrier.
     void FlushResourceBarrier();
 
+    //Keep an object alive until this command list finishes.
+    //Resources retire their d3d12 resources to the deferred deletion queue when they are released,
+    //so only temporary objects which are released before the command list is executed need it.
     void AddObjectTracker(Microsoft::WRL::ComPtr<ID3D12Object> object);
 
     void AddResourceTracker(const Resource* pResource);
@@ -287,12 +326,20 @@ protected:
     void GenerateMips_BGR(Texture* pTexture);
 
     void GenerateMips_SRGB(Texture* pTexture);
+    /**
+     * Get the copy command list for uploading,create it from copy queue if it does not exist.
+     */
+    std::shared_ptr<CommandList> RequestUploadCommandList();
 private:
     D3D12_COMMAND_LIST_TYPE m_d3d12CommandListType;
     Microsoft::WRL::ComPtr<ID3D12CommandAllocator>     m_d3d12CommandAlloctor;
     Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> m_d3d12GraphicsCommandList2;
-    //a reserved compute command list for generating mips
-    std::shared_ptr<CommandList> m_pComputeCommandList;
+    //textures which need to generate mips by compute queue
+    std::vector<Texture*> m_GenerateMipsTextures;
+    //timeline points of other queues which this command list waits for
+    std::vector<QueueTimelinePoint> m_Dependencies;
+    //a copy command list for uploading vertex,index buffers and textures,so they do not wait for rendering.
+    std::shared_ptr<CommandList> m_pCopyCommandList;
     std::unique_ptr<GenerateMips> m_pGenerateMips;
     std::unique_ptr<GenerateSAT> m_pGenerateSAT;
 
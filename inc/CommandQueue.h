@@ -1,7 +1,6 @@
 #pragma once
 
-#include <d3d12.h>//d3d12 objects
-#include <wrl.h>  //COM interface
+#include "Platform.h"
 
 #include <cstdint>//uint64_t
 #include <queue>  //std::queue
@@ -55,18 +54,36 @@
 //    CommandListQueue     m_d3d12CommandListQueue;
 //};
 
-#include "ThreadSafeQueue.h"
-
-#include <d3d12.h>              // For ID3D12CommandQueue, ID3D12Device2, and ID3D12Fence
-#include <wrl.h>                // For Microsoft::WRL::ComPtr
+#include "LockFreeQueue.h"
+#include "FenceEvent.h"
 
 #include <atomic>               // For std::atomic_bool
 #include <cstdint>              // For uint64_t
 #include <condition_variable>   // For std::condition_variable.
+#include <mutex>                // For std::mutex
 
 
 
 class CommandList;
+class CommandQueue;
+
+// A point on the timeline of a command queue.
+// It is reached when the fence of the queue reaches the fence value, so other queues
+// can wait for exactly the submission which produces their inputs instead of the latest one.
+struct QueueTimelinePoint
+{
+    CommandQueue* pCommandQueue = nullptr;
+    uint64_t FenceValue = 0;
+};
+
+// Counters of the in-flight command list thread.
+struct InFlightStatistics
+{
+    uint64_t RecycledCommandLists = 0;  // Command lists which are reset and made available again.
+    uint64_t RecycleBatches = 0;        // Times the thread woke up and recycled at least one command list.
+    uint64_t FenceWaits = 0;            // Times the thread slept on the fence event.
+    uint64_t BarrierCommandLists = 0;   // Command lists executed only for pending barriers.
+};
 
 class CommandQueue
 {
@@ -77,43 +94,82 @@ public:
     // Get an available command list from the command queue.
     std::shared_ptr<CommandList> GetCommandList();
 
-    // Execute a command list.
-    // Returns the fence value to wait for for this command list.
-    uint64_t ExecuteCommandList(std::shared_ptr<CommandList> commandList);
-    uint64_t ExecuteCommandLists(const std::vector<std::shared_ptr<CommandList> >& commandLists);
+    // Execute a command list after the dependencies and the dependencies of the command list (see CommandList::AddDependency()).
+    // Returns the timeline point to wait for for this command list.
+    QueueTimelinePoint ExecuteCommandList(std::shared_ptr<CommandList> commandList,
+        const std::vector<QueueTimelinePoint>& dependencies = {});
+    QueueTimelinePoint ExecuteCommandLists(const std::vector<std::shared_ptr<CommandList> >& commandLists,
+        const std::vector<QueueTimelinePoint>& dependencies = {});
 
     uint64_t Signal();
     bool IsFenceComplete(uint64_t fenceValue);
+    // The fence value of the last submission to the queue and the value which the gpu has reached.
+    // A submission may still be issuing its command lists on another thread,but its fence value is signaled soon.
+    uint64_t GetSignaledFenceValue() const;
+    uint64_t GetCompletedFenceValue() const;
     void WaitForFenceValue(uint64_t fenceValue);
     void Flush();
 
-    // Wait for another command queue to finish.
-    void Wait(const CommandQueue& other);
+    // Wait on the gpu for a timeline point of another command queue.
+    // Nothing is waited for if the point is on this queue or has been reached.
+    void Wait(const QueueTimelinePoint& point);
 
     Microsoft::WRL::ComPtr<ID3D12CommandQueue> GetD3D12CommandQueue() const;
 
+    // Contention counters of the in-flight and available command list queues.
+    LockFreeQueueStatistics GetInFlightQueueStatistics() const;
+    LockFreeQueueStatistics GetAvailableQueueStatistics() const;
+    InFlightStatistics GetInFlightStatistics() const;
+
 private:
+    // Get a command list from the barrier command list pool to record pending barriers.
+    std::shared_ptr<CommandList> GetBarrierCommandList();
+
     // Free any command lists that are finished processing on the command queue.
     void ProccessInFlightCommandLists();
 
+    // Wait until submissions before the fence value have been executed and signaled on the d3d12 queue.
+    void WaitForSubmitTurn(uint64_t fenceValue);
+    // Signal the fence value on the d3d12 queue and let the next submission go.
+    void EndSubmitTurn(uint64_t fenceValue);
+
     // Keep track of command allocators that are "in-flight"
     // The first member is the fence value to wait for, the second is the 
-    // a shared pointer to the "in-flight" command list.
-    using CommandListEntry = std::tuple<uint64_t, std::shared_ptr<CommandList> >;
+    // a shared pointer to the "in-flight" command list, the third is true for a barrier command list.
+    using CommandListEntry = std::tuple<uint64_t, std::shared_ptr<CommandList>, bool >;
 
     D3D12_COMMAND_LIST_TYPE                         m_CommandListType;
     Microsoft::WRL::ComPtr<ID3D12CommandQueue>      m_d3d12CommandQueue;
     Microsoft::WRL::ComPtr<ID3D12Fence>             m_d3d12Fence;
     std::atomic_uint64_t                            m_FenceValue;
+    // Submissions reserve their fence values and resolve resource states in order under this mutex.
+    std::mutex                                      m_SubmitMutex;
+    // ExecuteCommandLists and Signal of submissions are issued in the order of their fence values
+    // without the submit mutex,so resolving states of the next submission overlaps them.
+    std::atomic_uint64_t                            m_SubmittedFenceValue;
+    std::mutex                                      m_SubmitTurnMutex;
+    std::condition_variable                         m_SubmitTurnCV;
+
+    LockFreeQueue<CommandListEntry>                 m_InFlightCommandLists;
+    LockFreeQueue<std::shared_ptr<CommandList> >    m_AvailableCommandLists;
+    LockFreeQueue<std::shared_ptr<CommandList> >    m_AvailableBarrierCommandLists;
 
-    ThreadSafeQueue<CommandListEntry>               m_InFlightCommandLists;
-    ThreadSafeQueue<std::shared_ptr<CommandList> >  m_AvailableCommandLists;
+    // Number of command lists which are executed but not recycled yet.
+    std::atomic_size_t                              m_NumInFlightCommandLists;
 
     // A thread to process in-flight command lists.
+    // It sleeps on the condition variable when nothing is in flight and on m_FenceEvent
+    // when it waits for the gpu, the event is created once and reused for every wait.
     std::thread m_ProcessInFlightCommandListsThread;
     std::atomic_bool m_bProcessInFlightCommandLists;
     std::mutex m_ProcessInFlightCommandListsThreadMutex;
     std::condition_variable m_ProcessInFlightCommandListsThreadCV;
+    FenceEvent m_FenceEvent;
+
+    std::atomic_uint64_t m_NumRecycledCommandLists;
+    std::atomic_uint64_t m_NumRecycleBatches;
+    std::atomic_uint64_t m_NumFenceWaits;
+    std::atomic_uint64_t m_NumBarrierCommandLists;
 };
 
 
@@ -0,0 +1,102 @@
+#pragma once
+
+/**
+ * @brief Deferred Deletion Queue
+ *
+ * Objects which may still be used by the gpu are retired to this queue once when they are released,
+ * instead of being referenced by every command list which uses them.
+ * Retired objects are put in a pending batch,and Seal() keys the batch by the fence values which
+ * have been signaled on every command queue,so the batch covers all work which is submitted before sealing.
+ * A batch is released when the fences of all command queues reach its key.
+ * Note:a command list which uses a retired object must be executed before the batch is sealed,
+ * which is at the end of the frame(see Window::Present()).
+ *
+ * Besides COM objects,descriptor ranges are retired here too,so they are freed exactly when the gpu is done with them.
+ */
+
+#include "Platform.h"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class CommandQueue;
+class DescriptorAllocatorPage;
+
+struct DeferredDeletionStatistics
+{
+    // Objects and descriptor ranges which are retired but not released yet.
+    uint64_t NumPendingObjects = 0;
+    uint64_t NumPendingDescriptorRanges = 0;
+    // Sealed batches which wait for the gpu.
+    uint64_t NumBatches = 0;
+};
+
+class DeferredDeletionQueue
+{
+public:
+    static const int NumCommandQueues = 3;
+
+    /**
+     * @param CommandQueues: the queues whose fences are waited for,they are kept alive by this queue.
+     */
+    explicit DeferredDeletionQueue(const std::shared_ptr<CommandQueue> (&CommandQueues)[NumCommandQueues]);
+    ~DeferredDeletionQueue();
+
+    DeferredDeletionQueue(const DeferredDeletionQueue& copy) = delete;
+    DeferredDeletionQueue& operator=(const DeferredDeletionQueue& other) = delete;
+
+    /**
+     * Retire an object,the reference is released when the gpu is done with it.
+     */
+    void Retire(Microsoft::WRL::ComPtr<IUnknown> pObject);
+    /**
+     * Retire a range of descriptors,it is given back to the page when the gpu is done with it.
+     */
+    void Retire(std::shared_ptr<DescriptorAllocatorPage> pPage, UINT Offset, UINT NumDescriptors);
+    /**
+     * Key all pending objects by the fence values which are signaled on command queues now.
+     */
+    void Seal();
+    /**
+     * Release all sealed batches which are finished on all command queues.
+     * @return the number of released objects and descriptor ranges.
+     */
+    size_t ReleaseCompleted();
+    /**
+     * Release everything at once,including pending objects.
+     * Only call it when all command queues are flushed and no open command list uses retired objects.
+     */
+    void ReleaseAll();
+
+    DeferredDeletionStatistics GetStatistics()const;
+private:
+    struct Entry
+    {
+        Microsoft::WRL::ComPtr<IUnknown> pObject;
+        std::shared_ptr<DescriptorAllocatorPage> pDescriptorPage;
+        UINT DescriptorOffset = 0;
+        UINT NumDescriptors = 0;
+    };
+
+    struct Batch
+    {
+        uint64_t FenceValues[NumCommandQueues];
+        std::vector<Entry> Entries;
+    };
+
+    static void Release(std::vector<Entry>& Entries);
+
+    static const size_t MaxFreeEntryVectors = 4;
+
+    std::shared_ptr<CommandQueue> m_CommandQueues[NumCommandQueues];
+
+    mutable std::mutex m_Mutex;
+    std::vector<Entry> m_PendingEntries;
+    std::deque<Batch> m_Batches;
+    uint64_t m_NumObjects;
+    uint64_t m_NumDescriptorRanges;
+    //released batches give their vectors back,so retiring does not allocate in steady state.
+    std::vector<std::vector<Entry>> m_FreeEntryVectors;
+};
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <memory>
-#include <d3d12.h>
+#include "Platform.h"
 
 //The DescriptorAllocation class is wrapper class which is responsible for handling specific descirptors in a descriptor heap.
 //Every time when we need descriptors in CPU,we will get a DescriptorAllocation object which contains a consistent descriptors.
@@ -3,12 +3,12 @@
 // This DescriptorAlloctor class is responsible for managing all DescriptorHeap page ,allocate ,free a block of
 // CPU descriptors wrapped in DescriptorAllocation
 #include "DescriptorAllocation.h"
-#include <wrl.h>
-#include <d3d12.h> 
+#include "Platform.h"
 #include <memory>
 #include <vector>
 #include <set>
 #include <mutex>
+#include <atomic>
 
 
 
@@ -23,28 +23,62 @@ public:
 
     /** 
     * Get a block of consistent descriptors in descriptor page.
+    * Single descriptor is taken from the magazine of calling thread,which does not lock anything.
     * @para: the descriptors which you need.
     * @return: descriptoralloction which wraps enough descriptors.
     */
     DescriptorAllocation Allocate(UINT NumDescriptors);
 
     /**
-     * Releasing all descriptors which are not used anymore.
-     * We can not do this until all descriptors which is referenced in current command queue are executed.
+     * Make pages which have free handles available again.
+     * Retired descriptors are given back to pages by deferred deletion queue,so it is called after that.
      */
-    void ReleaseStaleDescriptorAlloction(UINT64 CurrentFrame);
+    void UpdateAvailablePages();
 
 protected:
-    std::shared_ptr<DescriptorAllocatorPage> GetNewDescriptorAlloctorPage(UINT NumDescriptors);
+    std::shared_ptr<DescriptorAllocatorPage> GetNewDescriptorAlloctorPage(UINT NumDescriptors, UINT SizeClass);
 private:
+    //Pages are bucketed by size class of allocations,so single descriptors and big ranges do not fragment same pages.
+    //class 0 is single descriptor,class n is (2^(n-1),2^n] descriptors,and the last class holds all bigger ranges.
+    static const UINT NumSizeClasses = 8;
+    //the number of descriptors which a magazine takes from pages at once.
+    static const UINT MagazineSize = 32;
+
+    //Single descriptors which are owned by one thread.
+    struct Magazine
+    {
+        std::vector<DescriptorAllocation> Descriptors;
+    };
+
+    static UINT GetSizeClass(UINT NumDescriptors);
+    /**
+     * Get the magazine of calling thread,it is created at first time.
+     */
+    Magazine& GetThreadMagazine();
+    /**
+     * Fill a magazine from pages of class 0.
+     */
+    void RefillMagazine(Magazine& magazine);
+    /**
+     * Allocate from pages of a size class,a new page is created if no page has enough room.
+     */
+    DescriptorAllocation AllocateFromPages(UINT NumDescriptors, UINT SizeClass);
+
     using DescriptorHeapPool = std::vector<std::shared_ptr<DescriptorAllocatorPage>>;
 
     D3D12_DESCRIPTOR_HEAP_TYPE m_DescriptorHeapType;
     UINT m_NumDescriptorsPerHeap;
+    //used by thread local caches to find magazines of this allocator
+    UINT64 m_AllocatorId;
+    static std::atomic<UINT64> ms_NextAllocatorId;
 
     DescriptorHeapPool m_HeapPool;
+    std::vector<UINT> m_HeapSizeClass;
+
+    std::set<DescriptorHeapPool::size_type> m_AvailableHeapIndex[NumSizeClasses];
 
-    std::set<DescriptorHeapPool::size_type> m_AvailableHeapIndex;
+    //magazines of all threads,they are destroyed with the allocator.
+    std::vector<std::unique_ptr<Magazine>> m_Magazines;
 
     //---------------------------------
     std::mutex m_AllocationMutex;
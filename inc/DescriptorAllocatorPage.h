@@ -2,11 +2,11 @@
 
 
 #include "DescriptorAllocation.h"
-#include <d3d12.h>
-#include <map>
-#include <wrl.h>
-#include <queue>
+#include "TLSFAllocator.h"
+#include "Platform.h"
+#include <atomic>
 #include <mutex>
+#include <vector>
 
 
 
@@ -18,7 +18,8 @@
 class DescriptorAllocatorPage : public std::enable_shared_from_this<DescriptorAllocatorPage>
 {
 public:
-    DescriptorAllocatorPage(D3D12_DESCRIPTOR_HEAP_TYPE DescriptorType, UINT NumDescriptors);
+    DescriptorAllocatorPage(D3D12_DESCRIPTOR_HEAP_TYPE DescriptorType, UINT NumDescriptors,
+        D3D12_DESCRIPTOR_HEAP_FLAGS Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE);
     virtual ~DescriptorAllocatorPage();
 
     /**
@@ -27,10 +28,10 @@ public:
     bool HasSapce(UINT NumDescriptors);
     /**
      * Free allocation which is not used.
-     * We do not free them directly.But push then into a queue which contains all stale descriptors
-     * After a frame is completed, we use RsleaseStaleDescriptors() to safely reuse them.
+     * We do not free them directly,since the gpu may still use them.
+     * They are retired to the deferred deletion queue and are released by ReleaseDescriptors() when the gpu is done.
      */
-    void Free(DescriptorAllocation&& descirptorAllocation, UINT64 frame);
+    void Free(DescriptorAllocation&& descirptorAllocation);
     /**
      * Allocate consistent descriptors from one page.
      * @para Descriptors number which you need
@@ -38,96 +39,60 @@ public:
      */
     DescriptorAllocation Allocate(UINT NumDescriptors); 
     /**
-     * Releasing all stale descriptors in one page.
-     * Note: releasing descriptors can not be executed 
-     * until the command queue of current frame does not use these descriptors anymore.
+     * Allocate at most NumAllocations single descriptors under one lock,and append them to @param:Allocations.
+     * @return the number of descriptors which are allocated.
      */
-    void ReleaseStaleDescriptors(UINT CurrentFrame);
+    UINT AllocateSingles(UINT NumAllocations, std::vector<DescriptorAllocation>& Allocations);
+    /**
+     * Give retired descriptors back to the page.
+     * Note: it is called by deferred deletion queue after the command queues do not use these descriptors anymore.
+     */
+    void ReleaseDescriptors(UINT Offset, UINT NumDescriptors);
 
     /**
      * Free handles numbers in this page
      */
     UINT FreeNumHandle()const;
+    /**
+     * Get fragmentation statistics of this page,sizes are in descriptors.
+     */
+    TLSFStatistics GetStatistics();
+    /**
+     * Get the descriptor heap of this page.
+     */
+    ID3D12DescriptorHeap* GetD3D12DescriptorHeap()const { return m_DescriptorHeap.Get(); }
+    /**
+     * Get how many times descriptors of a type are released by non shader visible pages.
+     * A descriptor handle can only be reused for another view after it is released,
+     * so caches which are keyed by handles are valid while the epoch does not change.
+     */
+    static uint64_t GetReleaseEpoch(D3D12_DESCRIPTOR_HEAP_TYPE Type);
 protected:
     /**
      * Release descriptors which are not used.At same time.
      * if free block is neighbour,merge them to a bigger free block.
      */
     void ReleaseBlock(UINT Offset,UINT NumDescriptors);
-    /**
-     * Add a new free block into containers.
-     */
-    void AddNewFreeBlock(UINT Offset,UINT Size);
     /**
      * Compute a specific descriptor offset in descriptor heap
      */
     UINT ComputeOffset(D3D12_CPU_DESCRIPTOR_HANDLE Descriptor);
 private:
-    struct FreeHandleInfo;
-    using BlockOffset = UINT;
-    using BlockSize = UINT;
-    //When we allocate desriptors, descriptors fragment in descriptor heap is a very normal phenomenon.
-    //So we use FreeBlockByOffset and FreeBlockBySize to achieve fastly and efficiently allocate descriptors.
-    //-----------------------------------------------------------------------------------------------------
-    //|<--block1->|<--fragment--->|<----block2------->|<--fragment--->|<-------block3-------->|
-    //-----------------------------------------------------------------------------------------
-    //| 0 | 1 | 2 | 3 | 4 | 5 | 6 | 7 | 8 | 9 | 10| 11| 12| 13| 14| 15| 16| 17| 18| 19| 20| 21| <----- Descriptor Heap
-    //-----------------------------------------------------------------------------------------
-    //
-    //
-    //-----------------           
-    //| offset | size |           
-    //|---------------|   <------FreeBlockByOffset
-    //| iter to Size  |    
-    //|---------------|   
-    //
-    //
-    //-----------------           
-    //|     size      |           
-    //|---------------|   <------FreeBlockBySize
-    //| iter to Offset|    
-    //|---------------|
-    //
-    using FreeBlockByOffset = std::map<BlockOffset, FreeHandleInfo>;
-    using FreeBlockBySize = std::multimap<BlockSize, FreeBlockByOffset::iterator>;
-
-    struct FreeHandleInfo
-    {
-        UINT Size;
-        FreeBlockBySize::iterator FreeBlockBySizeIt;
-
-        FreeHandleInfo(UINT size) : Size(size) {};
-    };
-
-    struct StaleHandleInfo
-    {
-        StaleHandleInfo(BlockOffset _offset, BlockSize _size, UINT _frame)
-            : Offset(_offset)
-            , Size(_size)
-            , Frame(_frame) {};
-
-        //the offset of first handle of stale block in descriptor heap
-        BlockOffset Offset;
-        //the size of stale block in descriptor heap
-        BlockSize   Size;
-        //current frame counter;
-        UINT        Frame;
-    };
-
-    std::queue<StaleHandleInfo> m_StaleDescriptorQueue;
-
     UINT m_CurrentFreeNumHandle;
-
-    FreeBlockByOffset m_FreeBlockByOffset;
-    FreeBlockBySize   m_FreeBlockBySize;
+    //When we allocate desriptors, descriptors fragment in descriptor heap is a very normal phenomenon.
+    //Free blocks are kept by a TLSF allocator,so allocating and releasing are O(1) and do not allocate memory.
+    TLSFAllocator m_FreeBlocks;
 
     D3D12_CPU_DESCRIPTOR_HANDLE m_BaseDescriptorCpuHandle;
     UINT m_DescriptorIncrementSize;
     D3D12_DESCRIPTOR_HEAP_TYPE m_DescriptorHeapType;
+    bool m_IsShaderVisible;
 
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_DescriptorHeap;
 
     //-------------------------------------------------
     std::mutex m_AllocationMutex;
     //-------------------------------------------------
+
+    static std::atomic<uint64_t> ms_ReleaseEpoch[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
 };
\ No newline at end of file
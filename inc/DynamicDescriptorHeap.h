@@ -1,23 +1,61 @@
 #pragma once
 
 #include "d3dx12.h"
-#include <wrl.h>
+#include "Platform.h"
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <queue>
+#include <vector>
+#include <unordered_map>
 #include <functional>
 
+#include "DescriptorAllocation.h"
+
 class RootSignature;
 class CommandList;
 
+/**
+ * Hit rate of descriptor table cache,which are summed over all dynamic descriptor heaps.
+ */
+struct DescriptorTableCacheStatistics
+{
+    uint64_t NumHits = 0;
+    uint64_t NumMisses = 0;
+    //Descriptors which are copied to gpu heaps,and which are not copied since the table is cached.
+    uint64_t NumDescriptorsCopied = 0;
+    uint64_t NumDescriptorsReused = 0;
+
+    float HitRate()const
+    {
+        return NumHits + NumMisses == 0 ? 0.0f : static_cast<float>(NumHits) / static_cast<float>(NumHits + NumMisses);
+    }
+};
+
+//Committed tables are cached by the content of staged descriptors,so a table which is staged again
+//binds the gpu handle which was copied before instead of copying descriptors again.
+//The gpu heap which holds cached tables is kept when the commandlist is reset,so tables are reused in next frames too,
+//and a cached table lives MaxCachedFrames resets at most if it is not used.
+//The cache is cleared when the gpu heap is full,or when any cpu descriptor of this heap type is released,
+//since a released handle may hold another view later(see DescriptorAllocatorPage::GetReleaseEpoch()).
 class DynamicDescriptorHeap
 {
 public:
+    static const uint64_t MaxCachedFrames = 3;
+
     DynamicDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE HeapType, UINT HeapSize = 1024);
     ~DynamicDescriptorHeap();
 
     void ParseRootSignature(const RootSignature& rootSignature);
 
     void StageDescriptors(const D3D12_CPU_DESCRIPTOR_HANDLE BaseDescriptorHandle, UINT ParameterIndex, UINT Offset, UINT DescriptorsNum);
+    /**
+     * Fill a table with null descriptors from Offset to its end.
+     * Only slots which are staged by StageDescriptors() since last filling are written,so a caller can stage
+     * just the slots it uses and call this,instead of staging the whole table every time.
+     * @param NullDescriptorHandle: a table of null descriptors,see Application::GetNullDescriptors().
+     */
+    void StageNullDescriptors(const D3D12_CPU_DESCRIPTOR_HANDLE NullDescriptorHandle, UINT ParameterIndex, UINT Offset);
 
     //Commit descriptor to commandlist graphics draw.
     void CommittedStagedDescriptorsForDraw(CommandList& commandList);
@@ -28,6 +66,10 @@ public:
     D3D12_GPU_DESCRIPTOR_HANDLE CopySingleDescriptor(CommandList& commandList, D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptor);
 
     void Reset();
+    /**
+     * Get statistics of table cache,which are gathered when dynamic descriptor heaps are reset.
+     */
+    static DescriptorTableCacheStatistics GetTableCacheStatistics();
 
 protected:
     //We should not invoke this function directly instead of invoking 
@@ -36,10 +78,20 @@ protected:
     //Get a descriptorheap from available descriptorheap,if available descriptorheap is empty then create a new one.
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> RequestDescriptorHeap();
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap();
+    //Move staging to a new descriptor heap and bind it to commandlist.
+    //In bindless mode,cbv_srv_uav tables are staged in a block of bindless heap instead,since only one heap can be bound.
+    void RequestNewDescriptorSpace(CommandList& commandList);
     //Compute descriptors number in each descriptor table.
     UINT ComputeStageDescriptorNum();
+    //Bind cached tables for staged tables whose descriptors are same,and remove them from stage mask.
+    void CommitCachedTables(CommandList& commandList, const std::function<void(ID3D12GraphicsCommandList2*, UINT, D3D12_GPU_DESCRIPTOR_HANDLE)>& setFun);
+    size_t HashTable(UINT RootIndex)const;
+    //Clear the cache if some cpu descriptors are released since last check.
+    void ValidateTableCache();
 private:
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_CurrentGpuDescriptorHeap;
+    //The heap which current tables are copied to,it is the bindless heap in bindless mode.
+    ID3D12DescriptorHeap* m_pCurrentDescriptorHeap;
 
     UINT m_DescriptorHeapSize;
 
@@ -53,15 +105,19 @@ private:
         {
             BaseDescriptor = nullptr;
             DescriptorsNum = 0;
+            NumNonNullDescriptors = 0;
         }
 
         D3D12_CPU_DESCRIPTOR_HANDLE* BaseDescriptor;
         UINT DescriptorsNum;
+        //Slots after it hold null descriptors which are staged by StageNullDescriptors().
+        UINT NumNonNullDescriptors;
 
         void Reset()
         {
             BaseDescriptor = nullptr;
             DescriptorsNum = 0;
+            NumNonNullDescriptors = 0;
         }
     };
 
@@ -100,6 +156,8 @@ private:
 
     DescriptorHeapPool m_AllDescriptorHeapPool;
     DescriptorHeapPool m_AvailDescriptorHeapPool;
+    //Blocks of bindless heap which are used by this commandlist,they are retired when commandlist is reset.
+    std::vector<DescriptorAllocation> m_BindlessBlocks;
 
     UINT m_CurrentFreeNumHandle;
 
@@ -107,5 +165,23 @@ private:
 
     UINT m_DescriptorTableBitMask;
     UINT m_StageDescriptorTableBitMask;
+
+    struct CachedTable
+    {
+        D3D12_GPU_DESCRIPTOR_HANDLE GpuDescriptorHandle;
+        uint64_t LastUsedFrame;
+        //Descriptors are compared when hashes are same,so a collision never binds a wrong table.
+        std::vector<SIZE_T> Descriptors;
+    };
+    //Only tables in current gpu heap are cached.
+    std::unordered_map<size_t, CachedTable> m_TableCache;
+    uint64_t m_FrameIndex;
+    uint64_t m_TableCacheEpoch;
+    DescriptorTableCacheStatistics m_TableCacheStatistics;
+
+    static std::atomic<uint64_t> ms_NumTableCacheHits;
+    static std::atomic<uint64_t> ms_NumTableCacheMisses;
+    static std::atomic<uint64_t> ms_NumDescriptorsCopied;
+    static std::atomic<uint64_t> ms_NumDescriptorsReused;
 };
 
@@ -1,7 +1,6 @@
 #pragma once
 #include <memory>
-#include <wrl.h>
-#include <d3d12.h>
+#include "Platform.h"
 #include <unordered_map>
 #include <string>
 
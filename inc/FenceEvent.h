@@ -0,0 +1,45 @@
+#pragma once
+
+/**
+ * @brief Fence Event
+ *
+ * An auto-reset event which is passed to ID3D12Fence::SetEventOnCompletion().
+ * Waiting threads block on it until a fence signals it,then it is reset by the wake-up.
+ * On windows it is a kernel event,so any device can signal it.
+ * On other platforms the handle points to a mutex and a condition variable,only the null device signals it then.
+ * CommandQueue and NullDevice use it instead of calling win32 event functions,so they do not depend on the platform.
+ */
+
+#include "Platform.h"
+
+class FenceEvent
+{
+public:
+    FenceEvent();
+    ~FenceEvent();
+
+    FenceEvent(const FenceEvent&) = delete;
+    FenceEvent& operator=(const FenceEvent&) = delete;
+
+    /**
+     * Get the handle which is passed to a fence.
+     */
+    HANDLE GetHandle()const
+    {
+        return m_hEvent;
+    }
+    /**
+     * Wake up one waiting thread,or the next one which waits if nobody is waiting.
+     */
+    void Set();
+    /**
+     * Block until the event is set.
+     */
+    void Wait();
+    /**
+     * Set an event by its handle,this is called by fences when they reach the value.
+     */
+    static void Set(HANDLE hEvent);
+private:
+    HANDLE m_hEvent;
+};
@@ -2,7 +2,7 @@
 
 #include <DirectXMath.h>
 #include <memory>
-#include <wrl.h>
+#include "Platform.h"
 #include "d3dx12.h"
 #include "DescriptorAllocation.h"
 
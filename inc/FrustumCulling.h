@@ -1,5 +1,6 @@
 #pragma once
 #include <DirectXCollision.h>
+#include <vector>
 
 #include "ModelLoader.h"
 #include "Camera.h"
@@ -20,6 +21,11 @@ public:
     void BindFrustumCamera(const Camera* camera);
     //Bind a model and use meshes in this model to test if this mesh will be culled.
     void BindModelCulled(const Model* pModel);
+    //Test meshes of a model without writing Mesh::m_IsCulled,so several threads can cull same model at same time.
+    //MeshVisibility[i] is non-zero if i-th mesh is visible.
+    void GetModelVisibility(const Model* pModel, std::vector<UINT8>& MeshVisibility)const;
+    //Test meshes of several models on job threads.MeshVisibilities[i] is the visibility of Models[i],it is empty for a null model.
+    void GetModelsVisibility(const std::vector<const Model*>& Models, std::vector<std::vector<UINT8>>& MeshVisibilities)const;
     //Get a mesh cull state.
     //NOTE:you MUST make sure that this mesh is in binded model!
     bool IsCull(const ModelSpace::Mesh* pMesh);
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <memory>
-#include <wrl.h>
+#include "Platform.h"
 #include "d3dx12.h"
 #include <DirectXMath.h>
 
@@ -1,5 +1,6 @@
 #pragma once
-#include <wrl.h>
+#include "Platform.h"
+#include <cstdint>
 
 class GameTimer
 {
@@ -7,17 +8,20 @@ private:
     double mSecondsPerCount = 0.0;
     double mDeltaTime = 0.0;
 
-    __int64 mBaseTime = 0;
-    __int64 mCurrTime = 0;
-    __int64 mPrevTime = 0;
-    __int64 mStopTime = 0;
-    __int64 mPausedTime = 0;
+    int64_t mBaseTime = 0;
+    int64_t mCurrTime = 0;
+    int64_t mPrevTime = 0;
+    int64_t mStopTime = 0;
+    int64_t mPausedTime = 0;
     bool mStopped = false;
+
+    // Performance counter of windows,or a steady clock in nanoseconds on other platforms.
+    static int64_t QueryCount();
+    static int64_t QueryCountsPerSecond();
 public:
     GameTimer()
     {
-        __int64 CountPerSecond;
-        QueryPerformanceFrequency((LARGE_INTEGER*)&CountPerSecond);
+        int64_t CountPerSecond = QueryCountsPerSecond();
         mSecondsPerCount = 1.0f / CountPerSecond;
     }
     ~GameTimer() {};
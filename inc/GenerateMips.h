@@ -1,7 +1,6 @@
 #pragma once
 
-#include <wrl.h>
-#include <d3d12.h>
+#include "Platform.h"
 #include <DirectXMath.h>
 
 #include "DescriptorAllocation.h"
@@ -39,12 +38,8 @@ public:
     const RootSignature* GetRootSignature()const { return m_ComputeRootSignature.get(); }
 
     Microsoft::WRL::ComPtr<ID3D12PipelineState> GetPipelineState()const { return m_d3d12ComputePipelineState; }
-
-    D3D12_CPU_DESCRIPTOR_HANDLE GetDefaultUAV()const { return m_DefaultUAV.GetDescriptorHandle(); }
 private:
     std::unique_ptr<RootSignature> m_ComputeRootSignature;
 
     Microsoft::WRL::ComPtr<ID3D12PipelineState> m_d3d12ComputePipelineState;
-    //
-    DescriptorAllocation m_DefaultUAV;
 };
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <wrl.h>
+#include "Platform.h"
 #include <memory>
 
 #include "d3dx12.h"
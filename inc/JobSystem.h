@@ -0,0 +1,177 @@
+#pragma once
+
+/**
+ * @brief Job System
+ *
+ * A work-stealing task scheduler which is shared by the whole engine.
+ * Every worker thread owns a deque,it pushes and pops its own jobs at the back,
+ * idle workers steal jobs from the front of other deques.
+ * A thread which waits for a JobCounter executes jobs while waiting,so jobs can schedule and wait for other jobs,
+ * it only sleeps when there is no job it can execute.
+ * Jobs which must run on the main thread (win32 calls,window and swap chain) are scheduled with JobAffinity::MainThread,
+ * they are executed by ExecuteMainThreadJobs() or by Wait() on the main thread.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ThreadSafeQueue.h"
+
+class JobSystem;
+
+enum class JobAffinity
+{
+    AnyThread,
+    MainThread
+};
+
+/**
+ * Count unfinished jobs which are scheduled with this counter.
+ * A counter is also a dependency,jobs scheduled by JobSystem::ScheduleAfter() start when it reaches zero.
+ * Note:A counter MUST outlive its jobs,call JobSystem::Wait() before destroying it.
+ */
+class JobCounter
+{
+public:
+    JobCounter() : m_Count(0) {}
+
+    JobCounter(const JobCounter& copy) = delete;
+    JobCounter& operator=(const JobCounter& other) = delete;
+    /**
+     * Check if all jobs of this counter have finished.
+     * This is only a snapshot,use JobSystem::Wait() to wait for jobs.
+     */
+    bool IsDone()const { return m_Count.load(std::memory_order_acquire) == 0; }
+private:
+    friend class JobSystem;
+
+    struct Job
+    {
+        std::function<void()> Func;
+        JobCounter* pCounter = nullptr;
+        JobAffinity Affinity = JobAffinity::AnyThread;
+    };
+
+    std::atomic<int> m_Count;
+    //protect zero transition and jobs which are waiting for this counter
+    std::mutex m_Mutex;
+    std::vector<Job> m_Dependents;
+};
+
+/**
+ * Counters of job system.All of them are accumulated since the job system was created or last ResetStatistics().
+ */
+struct JobSystemStatistics
+{
+    size_t JobsExecuted = 0;
+    size_t JobsStolen = 0;
+    size_t MainThreadJobs = 0;
+    size_t DeferredJobs = 0;
+    size_t WorkerSleeps = 0;
+    size_t WaiterSleeps = 0;
+};
+
+class JobSystem
+{
+public:
+    /**
+     * Create a job system on current thread,this thread is seen as the main thread.
+     * @param NumWorkers: the number of worker threads,zero means one less than the number of hardware threads,
+     * since the main thread also executes jobs when it waits.
+     */
+    explicit JobSystem(size_t NumWorkers = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem& copy) = delete;
+    JobSystem& operator=(const JobSystem& other) = delete;
+    /**
+     * Schedule a job.
+     * @param pCounter: the counter is increased now and decreased when the job finishes,it can be null.
+     */
+    void Schedule(std::function<void()> Func, JobCounter* pCounter = nullptr, JobAffinity Affinity = JobAffinity::AnyThread);
+    /**
+     * Schedule a job which starts after all jobs of @param:Dependency have finished.
+     * @param:pCounter is increased now,so waiting for it also waits for the dependency.
+     */
+    void ScheduleAfter(JobCounter& Dependency, std::function<void()> Func, JobCounter* pCounter = nullptr, JobAffinity Affinity = JobAffinity::AnyThread);
+    /**
+     * Split [0,Count) into ranges of @param:GrainSize and call Func(Begin,End) for each range on job threads.
+     * The calling thread executes the first range and then helps with others until all ranges are done.
+     * A zero GrainSize splits the range evenly over all workers and the calling thread.
+     */
+    void ParallelFor(size_t Count, size_t GrainSize, const std::function<void(size_t Begin, size_t End)>& Func);
+    /**
+     * Wait until all jobs of the counter have finished.The calling thread executes other jobs while waiting.
+     * On the main thread,main thread jobs are executed as well.
+     * When there is no job to execute,the thread sleeps until the counter reaches zero or a new job is scheduled.
+     */
+    void Wait(JobCounter& Counter);
+    /**
+     * Execute jobs which are scheduled with JobAffinity::MainThread.
+     * It MUST be called on the main thread,Application::Run() calls it every loop.
+     */
+    void ExecuteMainThreadJobs();
+
+    bool IsMainThread()const { return std::this_thread::get_id() == m_MainThreadId; }
+    /**
+     * Get the number of worker threads,not including the main thread.
+     */
+    size_t GetNumWorkers()const { return m_Workers.size(); }
+
+    JobSystemStatistics GetStatistics()const;
+
+    void ResetStatistics();
+private:
+    using Job = JobCounter::Job;
+
+    struct alignas(64) WorkerQueue
+    {
+        std::mutex Mutex;
+        std::deque<Job> Jobs;
+    };
+
+    void WorkerThread(size_t WorkerIndex);
+    /**
+     * Push a job whose counter has been increased to a deque or main thread queue.
+     */
+    void Push(Job job);
+    /**
+     * Pop a job from own deque,or steal one from other deques.
+     */
+    bool Pop(Job& job);
+    void Execute(Job& job);
+    /**
+     * Decrease the counter of a finished job,and push jobs depending on it if it reaches zero.
+     */
+    void FinishJob(JobCounter* pCounter);
+
+    std::thread::id m_MainThreadId;
+
+    std::vector<std::thread> m_Workers;
+    std::vector<std::unique_ptr<WorkerQueue>> m_WorkerQueues;
+    ThreadSafeQueue<Job> m_MainThreadJobs;
+    //the queue where next job from a non-worker thread goes.
+    std::atomic<size_t> m_NextQueue;
+
+    std::atomic<size_t> m_NumQueuedJobs;
+    std::atomic<size_t> m_NumSleepingWorkers;
+    //threads which sleep in Wait(),they share the wake condition with workers.
+    std::atomic<size_t> m_NumSleepingWaiters;
+    std::atomic_bool m_bStop;
+    std::mutex m_WakeMutex;
+    std::condition_variable m_WakeCondition;
+
+    std::atomic<size_t> m_JobsExecuted;
+    std::atomic<size_t> m_JobsStolen;
+    std::atomic<size_t> m_MainThreadJobsExecuted;
+    std::atomic<size_t> m_DeferredJobs;
+    std::atomic<size_t> m_WorkerSleeps;
+    std::atomic<size_t> m_WaiterSleeps;
+};
@@ -0,0 +1,293 @@
+#pragma once
+
+/**
+ * @brief Lock Free Queue
+ *
+ * A multi-producer multi-consumer queue with the same interface as ThreadSafeQueue.
+ * Values live in a bounded ring (Dmitry Vyukov's MPMC ring buffer),every cell has a sequence number
+ * so producers and consumers only race on one atomic index each and never take a lock.
+ * When the ring is full,Push() falls back to a locked overflow list,so the queue as a whole is unbounded.
+ * Once the overflow list is in use,new values go to it until consumers drain it,
+ * that keeps the values of one producer in order.
+ * Use TryPush() instead of Push() if the queue should stay bounded.
+ */
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Contention counters of a LockFreeQueue.
+ * Retries are failed compare-exchanges,they only grow when several threads hit the same end of the queue.
+ */
+struct LockFreeQueueStatistics
+{
+    size_t PushRetries = 0;
+    size_t PopRetries = 0;
+    size_t OverflowPushes = 0;
+};
+
+template<typename T>
+class LockFreeQueue
+{
+public:
+    /**
+     * @param Capacity: the size of lock free ring,it is rounded up to a power of two.
+     */
+    explicit LockFreeQueue(size_t Capacity = 1024);
+    ~LockFreeQueue();
+
+    LockFreeQueue(const LockFreeQueue& copy) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue& other) = delete;
+
+    /**
+     * Push a value into the back of the queue.
+     * This never fails,if the ring is full the value goes to the overflow list.
+     */
+    void Push(T value);
+
+    /**
+     * Try to push a value into the ring only.
+     * @returns false if the ring is full,value is not moved in this case.
+     */
+    bool TryPush(T& value);
+
+    /**
+     * Try to pop a value from the front of the queue.
+     * The value is moved out of the queue.
+     * @returns false if the queue is empty.
+     */
+    bool TryPop(T& value);
+
+    /**
+     * Check to see if there are any items in the queue.
+     * The result is only a snapshot when other threads are pushing or popping.
+     */
+    bool Empty() const;
+
+    /**
+     * Retrieve the number of items in the queue.
+     * The result is only a snapshot when other threads are pushing or popping.
+     */
+    size_t Size() const;
+
+    /**
+     * Get contention counters since the queue was created.
+     */
+    LockFreeQueueStatistics GetStatistics() const;
+
+private:
+    using SequenceType = std::atomic<size_t>;
+
+    struct Cell
+    {
+        SequenceType Sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type Storage;
+    };
+
+    bool TryPushRing(T& value);
+    bool TryPopRing(T& value);
+
+    static const size_t CacheLineSize = 64;
+
+    Cell*  m_Cells;
+    size_t m_Mask;
+
+    //Producers and consumers live on different cache lines
+    alignas(CacheLineSize) std::atomic<size_t> m_EnqueuePos;
+    alignas(CacheLineSize) std::atomic<size_t> m_DequeuePos;
+
+    alignas(CacheLineSize) std::atomic<size_t> m_OverflowSize;
+    std::queue<T> m_Overflow;
+    mutable std::mutex m_OverflowMutex;
+
+    std::atomic<size_t> m_PushRetries;
+    std::atomic<size_t> m_PopRetries;
+    std::atomic<size_t> m_OverflowPushes;
+};
+
+template<typename T>
+LockFreeQueue<T>::LockFreeQueue(size_t Capacity)
+    : m_EnqueuePos(0)
+    , m_DequeuePos(0)
+    , m_OverflowSize(0)
+    , m_PushRetries(0)
+    , m_PopRetries(0)
+    , m_OverflowPushes(0)
+{
+    size_t capacity = 2;
+    while (capacity < Capacity)
+    {
+        capacity <<= 1;
+    }
+    m_Mask = capacity - 1;
+
+    m_Cells = static_cast<Cell*>(::operator new(sizeof(Cell) * capacity));
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        new (&m_Cells[i].Sequence) SequenceType(i);
+    }
+}
+
+template<typename T>
+LockFreeQueue<T>::~LockFreeQueue()
+{
+    //destroy values which are still in the ring
+    T value;
+    while (TryPopRing(value))
+    {
+    }
+    for (size_t i = 0; i <= m_Mask; ++i)
+    {
+        m_Cells[i].Sequence.~SequenceType();
+    }
+    ::operator delete(m_Cells);
+}
+
+template<typename T>
+void LockFreeQueue<T>::Push(T value)
+{
+    if (m_OverflowSize.load(std::memory_order_acquire) == 0 && TryPushRing(value))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_OverflowMutex);
+    m_Overflow.push(std::move(value));
+    m_OverflowSize.fetch_add(1, std::memory_order_release);
+    m_OverflowPushes.fetch_add(1, std::memory_order_relaxed);
+}
+
+template<typename T>
+bool LockFreeQueue<T>::TryPush(T& value)
+{
+    return TryPushRing(value);
+}
+
+template<typename T>
+bool LockFreeQueue<T>::TryPop(T& value)
+{
+    if (TryPopRing(value))
+    {
+        return true;
+    }
+    if (m_OverflowSize.load(std::memory_order_acquire) == 0)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_OverflowMutex);
+    if (m_Overflow.empty())
+    {
+        return false;
+    }
+    value = std::move(m_Overflow.front());
+    m_Overflow.pop();
+    m_OverflowSize.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+template<typename T>
+bool LockFreeQueue<T>::Empty() const
+{
+    return Size() == 0;
+}
+
+template<typename T>
+size_t LockFreeQueue<T>::Size() const
+{
+    size_t dequeuePos = m_DequeuePos.load(std::memory_order_acquire);
+    size_t enqueuePos = m_EnqueuePos.load(std::memory_order_acquire);
+    //a consumer may move the dequeue position between two loads
+    size_t ringSize = enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+    return ringSize + m_OverflowSize.load(std::memory_order_acquire);
+}
+
+template<typename T>
+LockFreeQueueStatistics LockFreeQueue<T>::GetStatistics() const
+{
+    LockFreeQueueStatistics statistics;
+    statistics.PushRetries = m_PushRetries.load(std::memory_order_relaxed);
+    statistics.PopRetries = m_PopRetries.load(std::memory_order_relaxed);
+    statistics.OverflowPushes = m_OverflowPushes.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+template<typename T>
+bool LockFreeQueue<T>::TryPushRing(T& value)
+{
+    Cell* cell = nullptr;
+    size_t pos = m_EnqueuePos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        cell = &m_Cells[pos & m_Mask];
+        size_t sequence = cell->Sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0)
+        {
+            //the cell is free,try to claim it
+            if (m_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+            m_PushRetries.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (diff < 0)
+        {
+            //the cell still holds a value of last lap,the ring is full
+            return false;
+        }
+        else
+        {
+            //another producer has claimed this cell
+            pos = m_EnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    new (&cell->Storage) T(std::move(value));
+    cell->Sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+template<typename T>
+bool LockFreeQueue<T>::TryPopRing(T& value)
+{
+    Cell* cell = nullptr;
+    size_t pos = m_DequeuePos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        cell = &m_Cells[pos & m_Mask];
+        size_t sequence = cell->Sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0)
+        {
+            if (m_DequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+            m_PopRetries.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (diff < 0)
+        {
+            //the cell has not been written,the ring is empty
+            return false;
+        }
+        else
+        {
+            pos = m_DequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    T* pValue = reinterpret_cast<T*>(&cell->Storage);
+    value = std::move(*pValue);
+    pValue->~T();
+    //mark the cell free for the producer of next lap
+    cell->Sequence.store(pos + m_Mask + 1, std::memory_order_release);
+    return true;
+}
@@ -34,9 +34,7 @@
 #include "IndexBuffer.h"
 
 #include <DirectXMath.h>
-#include <d3d12.h>
-
-#include <wrl.h>
+#include "Platform.h"
 
 #include <memory> // For std::unique_ptr
 #include <vector>
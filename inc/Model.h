@@ -92,9 +92,9 @@ public:
     const std::vector<std::unique_ptr<Texture>>& GetTextures(TextureUsage Usage)const { return m_pTexture[Usage]; }
 
     const std::vector<MeshConstant>& GetMeshConstants()const { return m_MeshConstants; }
-
-    const DescriptorAllocation& GetDefaultSrvDescriptors(TextureUsage Usage)const { return m_DefaultSRV[Usage]; }
 protected:
+    //Import meshes,materials and AABB from file.It does not record any command,so several models can be imported at same time.
+    void ImportModel(const std::string& FilePath);
     //
     void LoadModelTexture(std::shared_ptr<CommandList> commandList);
     //
@@ -118,7 +118,6 @@ private:
     std::unique_ptr<VertexBuffer> m_pVertexBuffer;
     std::unique_ptr<IndexBuffer> m_pIndexBuffer;
 
+    //Unused slots of texture tables are filled by null descriptors of application(see Application::GetNullDescriptors()).
     std::vector<std::unique_ptr<Texture>> m_pTexture[TextureUsage::NumTextureUsage];
-    //Some default srv for DirectX happy.
-    DescriptorAllocation m_DefaultSRV[TextureUsage::NumTextureUsage];
 };
\ No newline at end of file
@@ -2,7 +2,7 @@
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
-#include <wrl.h>
+#include "Platform.h"
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Platform.h"
+#include <chrono>
+
+
+// NullDevice is a cpu stand-in for ID3D12Device2.
+// It implements the d3d12 interfaces which the engine touches (device, command queue, command allocator,
+// graphics command list, fence, resource, heap, descriptor heap, root signature and pipeline state) in plain memory.
+// So that CommandQueue,CommandList,DescriptorAllocator,DynamicDescriptorHeap and UploadBuffer can run without a gpu.
+//
+// What the null device really does:
+//  - resources and heaps own cpu memory (lazily allocated), Map() returns a real pointer.
+//  - descriptor heaps are plain arrays, Create*View() writes a small record and CopyDescriptors() is a memcpy.
+//  - command lists record packets into the memory of their command allocator.
+//  - command queue replays copy packets (memcpy) and counts draws,dispatches and barriers.
+//  - fences complete when the queue reaches the signal, optionally after a fixed latency.
+// What it does not do: shaders are never run and render targets are never written.
+
+struct NullDeviceDesc
+{
+    //The time between a queue signal and the moment the cpu can see the fence value.
+    //Zero means that a fence completes as soon as the queue reaches the signal.
+    std::chrono::microseconds FenceLatency = std::chrono::microseconds(0);
+    //If false,only upload/readback resources get cpu memory and copies to default heaps are just counted.
+    //This is useful when we only want to measure cpu-side overhead with big scenes.
+    bool BackResourceMemory = true;
+};
+
+//Counters of null device.All of them are accumulated since device creation or last ResetStatistics().
+struct NullDeviceStatistics
+{
+    UINT64 ResourcesCreated = 0;
+    UINT64 HeapsCreated = 0;
+    UINT64 DescriptorHeapsCreated = 0;
+    UINT64 DescriptorsWritten = 0;
+    UINT64 DescriptorsCopied = 0;
+    UINT64 CommandListsExecuted = 0;
+    UINT64 CommandsRecorded = 0;
+    UINT64 RecordedBytes = 0;
+    UINT64 ResourceBarriers = 0;
+    UINT64 Draws = 0;
+    UINT64 Dispatches = 0;
+    UINT64 Copies = 0;
+    UINT64 BytesCopied = 0;
+    UINT64 FenceSignals = 0;
+    UINT64 FenceWaits = 0;
+};
+
+class NullDevice
+{
+public:
+    //Create a null device.The returned device can be used everywhere a hardware device is used.
+    static Microsoft::WRL::ComPtr<ID3D12Device2> Create(const NullDeviceDesc& Desc = NullDeviceDesc());
+    //Check if a device is created by NullDevice::Create().
+    static bool IsNullDevice(ID3D12Device* pDevice);
+    //Get counters of a null device.If the device is not a null device,all counters are zero.
+    static NullDeviceStatistics GetStatistics(ID3D12Device* pDevice);
+
+    static void ResetStatistics(ID3D12Device* pDevice);
+};
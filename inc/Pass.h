@@ -1,7 +1,7 @@
 #pragma once
 
 #include <memory>
-#include <wrl.h>
+#include "Platform.h"
 #include "d3dx12.h"
 #include <DirectXMath.h>
 #include <vector>
@@ -35,8 +35,17 @@ class ShadowPass
 public:
     ShadowPass();
     virtual ~ShadowPass() {};
-
+    /**
+     * Record shadows of all lights.Transition of every shadow map to pixel shader resource is begun after it is rendered,
+     * and it is ended when the shadow map is bound by the pass which reads it(e.g. ForwardRendering) or the command list is closed.
+     */
     void ExecutePass(std::shared_ptr<CommandList> commandList);
+    /**
+     * Record shadow of every light on its own command list,and lights are recorded by jobs of the job system at same time.
+     * The command lists are appended to @param:commandLists in the same order as ExecutePass() records lights,
+     * so they can be executed together with other command lists of this frame.
+     */
+    void ExecutePassParallel(std::vector<std::shared_ptr<CommandList>>& commandLists);
 
     const std::vector<LightConstants> GetLightConstants()const;
     /**
@@ -46,19 +55,17 @@ public:
     std::vector<const Texture*> GetPointShadows()const;
 
     void SetShadowPassState(bool State) { m_ShadowPassState = State; }
-
-    const DescriptorAllocation& GetDirectionAndSpotDefaultSrvDescriptors()const { return m_DirectionalAndSpotDefaultSrv; }
-    const DescriptorAllocation& GetPointDefaultSrvDescriptors()const { return m_PointDefaultSrv; }
 private:
     /**
      * Get a special type light's shadow.If this light has no shadow or shadow pass state is off,then will return empty vector.
      */
     std::vector<const Texture*> GetShadows(LightType Type)const;
+    /**
+     * Get all lights which need to render shadow,the sequence is direction -> spot -> point.
+     */
+    std::vector<Light*> GetShadowLights()const;
 
     bool m_ShadowPassState;
-
-    DescriptorAllocation m_DirectionalAndSpotDefaultSrv;
-    DescriptorAllocation m_PointDefaultSrv;
 };
 
 /************************************************************************/
@@ -96,6 +103,12 @@ public:
 
     const std::vector<const Model*>& GetInputModels()const { return m_pInputMoedels; }
 protected:
+    /**
+     * Set view port,scissor rect,render targets,pipeline state and root signature of this pass.
+     * Every command list which records draws of this pass need to call it,since these states are not inherited between command lists.
+     */
+    void SetPassState(std::shared_ptr<CommandList> commandList);
+
     std::shared_ptr<RenderTarget> m_pRenderTarget;
 
     std::shared_ptr<RootSignature> m_pRootSignature;
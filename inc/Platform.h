@@ -0,0 +1,39 @@
+#pragma once
+
+/**
+ * @brief Platform
+ *
+ * Every engine header gets d3d12 interfaces and ComPtr from this file.
+ * On windows they come from the windows sdk.
+ * On other platforms they come from DirectX-Headers,which only the null device can run on.
+ * It also provides the few msvc helpers which the engine uses everywhere.
+ */
+
+#if defined(_WIN32)
+#include <d3d12.h>
+#include <wrl.h>
+#else
+//DirectX-Headers provide the d3d12 interfaces and ComPtr on other platforms.
+#include <wsl/winadapter.h>
+#include <directx/d3d12.h>
+#include <wsl/wrladapter.h>
+#endif
+
+#if !defined(_MSC_VER)
+#include <cstddef>
+
+#ifndef _countof
+#define _countof(Array) (sizeof(Array) / sizeof((Array)[0]))
+#endif
+
+//The same as the msvc intrinsic,it returns 0 if Mask is 0 and Index is not written then.
+inline unsigned char _BitScanForward(DWORD* Index, DWORD Mask)
+{
+    if (Mask == 0)
+    {
+        return 0;
+    }
+    *Index = static_cast<DWORD>(__builtin_ctz(Mask));
+    return 1;
+}
+#endif
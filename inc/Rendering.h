@@ -52,6 +52,15 @@ public:
      * update something you wish,you can use the second parameter.
      */
     virtual void UpdatePass(const UpdateEventArgs& Args, std::function<void()> UpdateFunc = {})override;
+    /**
+     * Execute this pass with default resource func,but record it with jobs of the job system.
+     * Shadow of each light gets its own command list,and input models are split into @param:NumCommandLists ranges,
+     * each range is recorded on its own command list.
+     * @param:commandList is closed and executed together with all these command lists in a deterministic order,
+     * and this function returns a new command list with render targets and pass state set,
+     * commands which follow this pass should be recorded on it.
+     */
+    std::shared_ptr<CommandList> ExecutePassParallel(std::shared_ptr<CommandList> commandList, UINT NumCommandLists);
 
     void SetShadowState(bool State) { m_pForwardShdaowPass->SetShadowPassState(State); };
 private:
@@ -73,6 +82,17 @@ private:
         PointLightShadowTexture,                //a table for point light shadow.
         NumRootParameters
     };
+    //Root parameters in bindless mode,the first four parameters are same as RenderingRootParameter.
+    //Textures are not staged in tables,shaders index bindless tables by indices in root constants and StructuredTextureIndices.
+    enum BindlessRenderingRootParameter
+    {
+        StructuredTextureIndices = RenderingRootParameter::StructuredMaterials + 1,   //a srv for bindless indices of model textures.
+        BindlessConstants,                      //root constants for ForwardRenderingBindlessConstants.
+        BindlessTexture2DTable,                 //a bindless table for all Texture2D.
+        BindlessTexture2DArrayTable,            //a bindless table for all Texture2DArray,such as directional and spot light shadow.
+        BindlessTextureCubeTable,               //a bindless table for all TextureCube,such as point light shadow.
+        NumBindlessRootParameters
+    };
 
     struct ForwardRenderingPassConstants
     {
@@ -93,9 +113,29 @@ private:
         FLOAT             TotalTime;
         DirectX::XMFLOAT4 AmbientLight = { 0.3f,0.3f,0.3f,1.0f };
     };
+    struct ForwardRenderingBindlessConstants
+    {
+        //Textures of usage i are in StructuredTextureIndices[TextureIndexOffsets[i],TextureIndexOffsets[i + 1]).
+        UINT TextureIndexOffsets[TextureUsage::NumTextureUsage + 1];
+        //UINT_MAX means there is no shadow.
+        UINT DirectionAndSpotShadowIndices[m_MaxDirectionAndSpotLightShadowNum];
+        UINT PointShadowIndices[m_MaxPointLightShadowNum];
+    };
 private:
+    /**
+     * Set textures of a model and shadows by bindless indices instead of descriptor tables.
+     */
+    void SetBindlessResources(std::shared_ptr<CommandList> commandList, const Model* pModel);
+    /**
+     * Record all draws of a model.It only reads pass and model,so it can be called on several threads at same time.
+     * @param:MeshVisibility is the result of frustum culling for meshes of this model.
+     */
+    void RecordModel(std::shared_ptr<CommandList> commandList, const Model* pModel, const std::vector<UINT8>& MeshVisibility);
+
     ForwardRenderingPassConstants m_ForwardPassConstants;
     ForwardPassType m_ForwardType;
+    //It is decided when the pass is created,since root signature and shaders are different.
+    bool m_IsBindless;
 
     std::unique_ptr<ShadowPass> m_pForwardShdaowPass;
 };
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "d3dx12.h"
-#include <wrl.h>
+#include "Platform.h"
 #include <memory>
 #include <string>
 
+struct GlobalResourceState;
+
 //a wrapper class which includes ID3D12Resource() interface.
 //Otherwise this class is also a Buffer or Texture base class
 
@@ -33,15 +35,30 @@ public:
     virtual D3D12_CPU_DESCRIPTOR_HANDLE GetShaderResourceView(const D3D12_SHADER_RESOURCE_VIEW_DESC* SrvDesc = nullptr)const = 0;
 
     virtual D3D12_CPU_DESCRIPTOR_HANDLE GetUnorderedAccessView(const D3D12_UNORDERED_ACCESS_VIEW_DESC* UavDesc = nullptr)const = 0;
+    /**
+     * Get the index of a shader resource view in the bindless heap,shaders of bindless mode index their views by it.
+     * The view is copied to the heap once for every view desc by the view cache of application,
+     * and the index is kept until the d3d12 resource is destroyed.
+     */
+    UINT GetBindlessIndex(const D3D12_SHADER_RESOURCE_VIEW_DESC* SrvDesc = nullptr)const;
 
     virtual void Reset();
 
     void SetName(const std::wstring& ResourceName);
 
     const D3D12_CLEAR_VALUE* GetClearValue()const { return m_d3d12ClearValue.get(); }
+    /**
+     * Get the handle of global state of the d3d12 resource,so trackers need not to look it up.
+     * It is null if the d3d12 resource is added to ResourceStateTracker after it is set to this resource.
+     */
+    const std::shared_ptr<GlobalResourceState>& GetGlobalResourceState()const { return m_pGlobalState; }
 
 protected:
+    //The gpu may still use the d3d12 resource,so it is retired to the deferred deletion queue instead of being released at once.
+    void RetireD3D12Resource();
+
     Microsoft::WRL::ComPtr<ID3D12Resource> m_d3d12Resource;
     std::unique_ptr<D3D12_CLEAR_VALUE> m_d3d12ClearValue;
     std::wstring m_ResourceName;
+    std::shared_ptr<GlobalResourceState> m_pGlobalState;
 };
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+/**
+ * @brief Resource Heap Allocator
+ *
+ * Default heap resources are created as placed resources in a few big heaps instead of one committed resource each,
+ * so that creating a buffer or a texture does not cost a kernel allocation.
+ * Resources are put in two tiers of heaps(buffers and non render target textures),
+ * since heaps of resource heap tier 1 can only hold one kind of resources.Ranges in a heap are managed by TLSFAllocator.
+ * The range of a placed resource is freed when the last reference of its ID3D12Resource is released,
+ * so placed resources can be shared by ComPtr just like committed resources.
+ * Resources which are bigger than half of a heap or need MSAA alignment are still committed resources.
+ * Render targets and depth stencils are committed resources too,a placed one would have to be cleared,discarded or
+ * copied to before any other use,since its range may hold data of a released resource.
+ */
+
+#include "Platform.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "d3dUtil.h"
+#include "TLSFAllocator.h"
+
+enum class ResourceHeapTier
+{
+    Buffer = 0,
+    NonRenderTargetTexture,
+    NumTiers
+};
+
+struct ResourceHeapStatistics
+{
+    // Statistics of all heaps in a tier are summed,except LargestFreeBlock is the largest one of them.
+    TLSFStatistics Tiers[static_cast<int>(ResourceHeapTier::NumTiers)];
+    UINT NumHeaps[static_cast<int>(ResourceHeapTier::NumTiers)] = {};
+    // Resources which are created as committed resources since they can not be placed,render targets and depth stencils included.
+    UINT64 NumCommittedResources = 0;
+};
+
+class ResourceHeapAllocator
+{
+public:
+    /**
+     * @param HeapSize: the size of every heap.
+     */
+    explicit ResourceHeapAllocator(UINT64 HeapSize = _MB(64));
+    ~ResourceHeapAllocator();
+
+    ResourceHeapAllocator(const ResourceHeapAllocator& copy) = delete;
+    ResourceHeapAllocator& operator=(const ResourceHeapAllocator& other) = delete;
+
+    /**
+     * Create a resource in default heap.
+     * It has the same parameters as ID3D12Device::CreateCommittedResource() with D3D12_HEAP_TYPE_DEFAULT.
+     */
+    Microsoft::WRL::ComPtr<ID3D12Resource> CreateResource(
+        const D3D12_RESOURCE_DESC& Desc,
+        D3D12_RESOURCE_STATES InitialState,
+        const D3D12_CLEAR_VALUE* pClearValue = nullptr);
+
+    ResourceHeapStatistics GetStatistics()const;
+private:
+    struct Heap;
+    class PlacedRange;
+
+    /**
+     * @return NumTiers if the resource is never placed.
+     */
+    static ResourceHeapTier GetTier(const D3D12_RESOURCE_DESC& Desc);
+    /**
+     * Allocate a range from heaps of a tier,a new heap is created if no heap has enough room.
+     */
+    std::shared_ptr<Heap> AllocateRange(ResourceHeapTier Tier, UINT64 Size, UINT64 Alignment, UINT64& Offset);
+
+    UINT64 m_HeapSize;
+
+    mutable std::mutex m_Mutex;
+    std::vector<std::shared_ptr<Heap>> m_Heaps[static_cast<int>(ResourceHeapTier::NumTiers)];
+    UINT64 m_NumCommittedResources;
+};
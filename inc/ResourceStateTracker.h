@@ -3,91 +3,226 @@
 
 
 #include "d3dx12.h"
+#include "BarrierTrace.h"
+#include <assert.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <mutex>
 
 
 class CommandList;
 class Resource;
+//The global state of a resource,it is shared by all trackers and has its own lock.
+//Resource keeps a handle of it,so trackers need not to look it up(see Resource::GetGlobalResourceState()).
+struct GlobalResourceState;
+
+/**
+ * Contention of global resource states,which is summed over all trackers.
+ */
+struct ResourceStateTrackerStatistics
+{
+    uint64_t NumGlobalStates = 0;
+    //Lookups by ID3D12Resource,which are needed when a barrier is not from a Resource with a handle.
+    uint64_t NumLookups = 0;
+    uint64_t NumStateLocks = 0;
+    //Locks of global states which are held by another thread at that time.
+    uint64_t NumContendedStateLocks = 0;
+    //Uniform states which are split into subresource states,and the ones which need heap storage.
+    uint64_t NumSplitStates = 0;
+    uint64_t NumHeapSplitStates = 0;
+};
+
+/**
+ * Barrier counts of a frame,which are summed over all trackers.
+ */
+struct BarrierStatistics
+{
+    //Barriers which are asked for by commandlists,before optimization.
+    uint64_t NumRequestedBarriers = 0;
+    //Barriers which are recorded into commandlists,including pending barriers.
+    uint64_t NumIssuedBarriers = 0;
+    //Transitions which are merged into an earlier transition of the same subresource in a batch,
+    //or removed with it because the state goes back(A->B->A).
+    uint64_t NumMergedBarriers = 0;
+    //Transitions which are not needed since the resource is in a combined read state already.
+    uint64_t NumCombinedReadBarriers = 0;
+    //Transitions from COMMON which are not needed since the runtime promotes the resource implicitly.
+    uint64_t NumPromotedBarriers = 0;
+    //Split barriers whose begin and end are in different batches.
+    uint64_t NumSplitBarriers = 0;
+};
 
 class ResourceStateTracker
 {
 public:
-    ResourceStateTracker();
+    //@param:Type the type of command list which owns this tracker.
+    //Resources in COMMON are promoted implicitly on first use,and some of them decay to COMMON after ExecuteCommandLists(),
+    //the tracker models both so that the barriers which the runtime does are not recorded:
+    //1.Buffers and simultaneous-access textures are promoted to any state,and decay on any queue.
+    //2.Other textures are promoted to COPY_DEST or COPY_SOURCE by a copy command list,and decay since they are used on copy queue.
+    explicit ResourceStateTracker(D3D12_COMMAND_LIST_TYPE Type = D3D12_COMMAND_LIST_TYPE_DIRECT);
     ~ResourceStateTracker();
 
     //Commite a barrier to interior structure.This function will automaticaaly check
     //the StateBefore and StateAfter of barrier.
     void ResourceBarrier(const D3D12_RESOURCE_BARRIER& barrier);
     //A transition wrapper function,this function will invoke ResourceBarrier() function.
-    void TransitionResource(ID3D12Resource* pResource, D3D12_RESOURCE_STATES StateAfter, UINT subResource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
-    void TransitionResource(const Resource* pResource, D3D12_RESOURCE_STATES StateAfter, UINT subResource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+    //@param:pCallSite the code which asks for the barrier,it is only kept by barrier trace(see BarrierTrace).
+    void TransitionResource(ID3D12Resource* pResource, D3D12_RESOURCE_STATES StateAfter, UINT subResource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+        const void* pCallSite = nullptr);
+    void TransitionResource(const Resource* pResource, D3D12_RESOURCE_STATES StateAfter, UINT subResource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+        const void* pCallSite = nullptr);
     //A alias barrier wrapper function, this function will invoke ResourceBarrier() function.
     //@param: default parameters both are nullptr which indicates any resource in descriptor heap is alias.
-    void AliasBarrier(const Resource* pResourceBefore = nullptr, const Resource* pResourceAfter = nullptr);
+    void AliasBarrier(const Resource* pResourceBefore = nullptr, const Resource* pResourceAfter = nullptr, const void* pCallSite = nullptr);
     //A Uav barrier wrapper function,this function will invoke ResourceBarrier() function.
     //@param: default paramters is default whichi indicates that any Uav will use barrier.
-    void UavBarrier(const Resource* pResource = nullptr);
-    //Flush all valid resource barrier to commandlist
-    //
+    void UavBarrier(const Resource* pResource = nullptr, const void* pCallSite = nullptr);
+    //Begin a transition as a split barrier,it is ended by next barrier of this resource or Close() of commandlist.
+    //The resource must NOT be used by gpu until the transition is ended.
+    //If the state of the resource is not known by this commandlist yet,it is a normal transition.
+    void BeginTransitionResource(ID3D12Resource* pResource, D3D12_RESOURCE_STATES StateAfter, UINT subResource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+        const void* pCallSite = nullptr);
+    void BeginTransitionResource(const Resource* pResource, D3D12_RESOURCE_STATES StateAfter, UINT subResource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+        const void* pCallSite = nullptr);
+    //End all split barriers,it is called before the commandlist is closed.
+    void EndSplitBarriers();
+    //Flush all valid resource barrier to commandlist.
+    //The batch is optimized at first(see OptimizeBarriers()).
     void FlushValidResourceBarrier(CommandList& commandList);
+    //Flush all valid resource barrier to a vector instead of a commandlist,e.g. when a barrier trace is replayed.
+    //@return:the number of barriers which are appended.
+    UINT FlushValidResourceBarrier(std::vector<D3D12_RESOURCE_BARRIER>& Barriers);
     //Flush pengding resource barrier,this will check if other commandlists change resource state
-    //If the state has been changed.We will use a commandlist to insert resource barrier into the middle of
-    //other two commandlist.
-    UINT FlushPendingResourceBarrier(CommandList& commandList);
+    //If the state has been changed.The barriers are appended to @param:PendingBarriers,and command queue
+    //inserts them into the middle of other two commandlist.
+    //Only global states of resources used by this commandlist are locked,one at a time.
+    //@return:the number of barriers which are appended.
+    UINT FlushPendingResourceBarrier(std::vector<D3D12_RESOURCE_BARRIER>& PendingBarriers);
     //Update global resource state for next commandlist or next frame.
-    void CommitFinalResourceState();
-    
-    static void Lock();
+    //@param:CommittedResources resources whose state is updated are inserted into it.
+    //@param:pFence,FenceValue the fence which is signaled after this commandlist,resources used by copy or compute commandlist
+    //can not be used by other queues until it is completed.
+    //@param:DecayedStates global states of resources which decay to COMMON are appended to it,
+    //they decay after the whole ExecuteCommandLists() instead of this commandlist(see DecayResourceStates()).
+    void CommitFinalResourceState(std::unordered_set<ID3D12Resource*>& CommittedResources, ID3D12Fence* pFence, UINT64 FenceValue,
+        std::vector<std::shared_ptr<GlobalResourceState>>& DecayedStates);
+    //Let resources decay to COMMON after ExecuteCommandLists(),the vector is cleared.
+    static void DecayResourceStates(std::vector<std::shared_ptr<GlobalResourceState>>& DecayedStates);
+    //Let a queue wait for copy or compute queue fences of resources which are flushed by FlushPendingResourceBarrier().
+    //A queue only waits once for a fence,and resources whose fence is completed need not to wait.
+    void FlushQueueWaits(ID3D12CommandQueue* pCommandQueue);
 
-    static void UnLock();
     //Reset all local barrier container to empty.
     void Reset();
     //Add a resource state to global resource state containers.
     //As long as a new resource is created, we must use this function to record resource state.
-    static void AddGlobalResourceState(ID3D12Resource* pResource,D3D12_RESOURCE_STATES State);
+    //If the resource has a global state already,the state is reset and the same handle is returned.
+    //@return:the handle of global state,which Resource keeps.
+    static std::shared_ptr<GlobalResourceState> AddGlobalResourceState(ID3D12Resource* pResource,D3D12_RESOURCE_STATES State);
+    //Find the global state of a resource,it returns null if the resource is not added.
+    static std::shared_ptr<GlobalResourceState> FindGlobalResourceState(ID3D12Resource* pResource);
     //Remove a resource state from global resource state containers.
     //As long as a resource is destroyed, we must use this function to erase resource state.
     static void RemoveGlobalResourceState(ID3D12Resource* pResource);
 
+    static ResourceStateTrackerStatistics GetStatistics();
+    //Finish barrier statistics of current frame,it is called once a frame on main thread by Application::EndFrame().
+    static void EndFrame();
+    //Get barrier statistics of last finished frame.
+    static BarrierStatistics GetFrameStatistics();
+    //In validation mode,every barrier which is elided by implicit promotion is logged to debugger output.
+    static void SetValidation(bool Enable);
+    static bool IsValidation();
+
 protected:
 
 private:
+    friend struct GlobalResourceState;
+    friend class BarrierTrace;
+    friend class BarrierTraceReplayer;
+
+    //Commit a barrier whose global state may be known already.
+    void ResourceBarrier(const D3D12_RESOURCE_BARRIER& barrier, const std::shared_ptr<GlobalResourceState>& pGlobalState, const void* pCallSite);
+    void BeginTransitionResource(ID3D12Resource* pResource, D3D12_RESOURCE_STATES StateAfter, UINT subResource,
+        const std::shared_ptr<GlobalResourceState>& pGlobalState, const void* pCallSite);
+    //End split barriers of a resource,or all split barriers if pResource is null.
+    void EndSplitBarriers(ID3D12Resource* pResource);
+    //Keep a barrier for barrier trace until the commandlist is closed.
+    void RecordTraceEvent(BarrierTraceEventType Type, const D3D12_RESOURCE_BARRIER* pBarrier = nullptr, const void* pCallSite = nullptr);
+    //Check if a barrier can be omitted since the resource is implicitly promoted from COMMON.
+    //@param:DecaysToCommon if the resource is a buffer or a simultaneous-access texture.
+    bool IsImplicitPromotion(D3D12_RESOURCE_STATES StateBefore, D3D12_RESOURCE_STATES StateAfter, bool DecaysToCommon)const;
+    //Count a barrier which is elided by implicit promotion,and log it in validation mode.
+    void ElidePromotedBarrier(const D3D12_RESOURCE_BARRIER& barrier);
+    //Find the copy or compute queue fence of a resource which will be used by this commandlist.
+    //The global state must be locked.
+    void AddQueueWait(GlobalResourceState& GlobalState);
+    //Get the state which a transition from StateBefore to StateAfter really goes to.
+    //On direct commandlist,read states are combined,so going back to a former read state needs no barrier.
+    D3D12_RESOURCE_STATES CombineReadStates(D3D12_RESOURCE_STATES StateBefore, D3D12_RESOURCE_STATES StateAfter)const;
+    //Merge and remove transitions in a batch,there is no gpu work between barriers of a batch.
+    //Back-to-back transitions of the same subresource are merged into one,the ones which go back to the state before are removed,
+    //and a split barrier whose end is in the same batch becomes a normal barrier.
+    void OptimizeBarriers(std::vector<D3D12_RESOURCE_BARRIER>& Barriers);
+    //Add barrier counts of this tracker to counts of current frame.
+    void CommitBarrierStatistics();
+
+    //States of all subresources of a resource.
+    //Most resources have all subresources in one state,so subresource states are only split when a subresource is transitioned alone,
+    //and they become uniform again when all subresources are in one state.
+    //There is one of it for every resource in every commandlist and in global states,so it is kept at 16 bytes:
+    //split states share the storage of a heap pointer,they are inline only if they fit in it(e.g. depth and stencil planes).
     struct ResourceState
     {
-        explicit ResourceState(D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON)
-            : State(state) {};
+        //the state of a subresource which is not used by a commandlist yet,it is resolved by a pending barrier.
+        static const D3D12_RESOURCE_STATES UnknownState = static_cast<D3D12_RESOURCE_STATES>(-1);
+        static const UINT MaxInlineSubResources = sizeof(void*) / sizeof(D3D12_RESOURCE_STATES);
 
+        explicit ResourceState(D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON)
+            : State(state), NumSubResources(0), pHeapStates(nullptr) {};
+        ResourceState(const ResourceState& other);
+        ResourceState(ResourceState&& other) noexcept;
+        ResourceState& operator=(const ResourceState& other);
+        ResourceState& operator=(ResourceState&& other) noexcept;
+        ~ResourceState() { MakeUniform(State); }
 
-        void SetResourceState(UINT subResource, D3D12_RESOURCE_STATES state)
-        {
-            if (subResource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
-            {
-                State = state;
-                subResourceState.clear();
-            }
-            else
-            {
-                subResourceState[subResource] = state;
-            }
-        }
-        
+        bool IsUniform()const { return NumSubResources == 0; }
+        //@param:pResource it is used to get the number of subresources when states are split.
+        void SetResourceState(UINT subResource, D3D12_RESOURCE_STATES state, ID3D12Resource* pResource);
+        //The state of all subresources can only be got when states are uniform.
         D3D12_RESOURCE_STATES GetSubResourceState(UINT subResource)const
         {
-            D3D12_RESOURCE_STATES state = State;
-            auto pos = subResourceState.find(subResource);
-            if (pos != subResourceState.end())
-            {
-                state = pos->second;
-            }
-            return state;
+            assert((IsUniform() || subResource < NumSubResources) && "Error!Subresource is out of range or states are not uniform!");
+            return IsUniform() ? State : GetStates()[subResource];
         }
+        //Merge states which are known by other into this one,unknown states of other are skipped.
+        void Merge(const ResourceState& other);
+
+        D3D12_RESOURCE_STATES* GetStates() { return NumSubResources <= MaxInlineSubResources ? InlineStates : pHeapStates; }
+        const D3D12_RESOURCE_STATES* GetStates()const { return NumSubResources <= MaxInlineSubResources ? InlineStates : pHeapStates; }
 
+        //Split the uniform state into a state for each subresource.
+        void Split(UINT numSubResources);
+        //Go back to uniform if all subresources are in one state.
+        void TryMakeUniform();
+        //Put all subresources in state,and free split states.
+        void MakeUniform(D3D12_RESOURCE_STATES state);
 
+        //the state of all subresources if states are uniform.
         D3D12_RESOURCE_STATES State;
-        //if subresource state is empty,that means all subresources have same state.
-        std::unordered_map<UINT, D3D12_RESOURCE_STATES> subResourceState;
+        //0 means states are uniform.
+        UINT NumSubResources;
+        //only valid when states are split,which one is used depends on NumSubResources.
+        union
+        {
+            D3D12_RESOURCE_STATES InlineStates[MaxInlineSubResources];
+            D3D12_RESOURCE_STATES* pHeapStates;
+        };
     };
     //a pending resource barrier vector container.
     //This variable will be used to verify if need to add a barrier between two commandlist
@@ -96,11 +231,56 @@ private:
     //a valid resource barrier which means these barrier can commite to commandlist directly.
     //We need to reset this variable after every flush
     std::vector<D3D12_RESOURCE_BARRIER> m_ValidResourceBarrier;
+    struct LocalResourceState
+    {
+        ResourceState State;
+        //It is found once when the resource is used by this commandlist at first time.
+        std::shared_ptr<GlobalResourceState> pGlobalState;
+        //buffers and simultaneous-access textures,they are promoted to any state and decay on any queue.
+        bool DecaysToCommon = false;
+    };
     //a local resource state container which will be used to track resource state.
-    std::unordered_map<ID3D12Resource*, ResourceState> m_FinalResourceState;
-    //a global resource state container which stores all resources states.
-    static std::unordered_map<ID3D12Resource*, ResourceState> m_GlobalResourceState;
-    //some static variable to control thread.
-    static std::mutex ms_GlobalMutex;
-    static bool m_IsLock;
+    std::unordered_map<ID3D12Resource*, LocalResourceState> m_FinalResourceState;
+    //the type of commandlist which owns this tracker
+    D3D12_COMMAND_LIST_TYPE m_CommandListType;
+    //the max fence value to wait for each queue fence.
+    std::unordered_map<ID3D12Fence*, UINT64> m_QueueWaits;
+    //end barriers of split barriers which have begun.
+    std::vector<D3D12_RESOURCE_BARRIER> m_SplitBarriers;
+    //the last transition of each resource in the batch which is optimized,it is kept to avoid allocating.
+    std::unordered_map<ID3D12Resource*, size_t> m_LastTransitions;
+    //Counts are gathered here,so recording barriers does not touch atomics.
+    BarrierStatistics m_BarrierStatistics;
+    //events of barrier trace,they are appended to the trace when the commandlist is closed.
+    std::vector<BarrierTraceEvent> m_TraceEvents;
+
+    //Get the global state of a resource for barrier trace,States is empty if all subresources are in State.
+    static void SnapshotGlobalResourceState(ID3D12Resource* pResource, D3D12_RESOURCE_STATES& State, std::vector<D3D12_RESOURCE_STATES>& States);
+    //Set the global state of a resource when a barrier trace is replayed.
+    static void RestoreGlobalResourceState(ID3D12Resource* pResource, D3D12_RESOURCE_STATES State, const std::vector<D3D12_RESOURCE_STATES>& States);
+
+    struct QueueFence
+    {
+        ID3D12Fence* pFence;
+        UINT64 FenceValue;
+        //a bit for each commandlist type which has waited for this fence,including the queue which signals it.
+        UINT WaitedQueues;
+    };
+
+    static std::atomic<uint64_t> ms_NumGlobalStates;
+    static std::atomic<uint64_t> ms_NumLookups;
+    static std::atomic<uint64_t> ms_NumStateLocks;
+    static std::atomic<uint64_t> ms_NumContendedStateLocks;
+    static std::atomic<uint64_t> ms_NumSplitStates;
+    static std::atomic<uint64_t> ms_NumHeapSplitStates;
+
+    static std::atomic<uint64_t> ms_NumRequestedBarriers;
+    static std::atomic<uint64_t> ms_NumIssuedBarriers;
+    static std::atomic<uint64_t> ms_NumMergedBarriers;
+    static std::atomic<uint64_t> ms_NumCombinedReadBarriers;
+    static std::atomic<uint64_t> ms_NumPromotedBarriers;
+    static std::atomic<uint64_t> ms_NumSplitBarriers;
+    static std::mutex ms_FrameStatisticsMutex;
+    static BarrierStatistics ms_FrameStatistics;
+    static std::atomic<bool> ms_IsValidation;
 };
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "d3dx12.h"
-#include <wrl.h>
+#include "Platform.h"
 #include <assert.h>
 
 
@@ -13,6 +13,8 @@
 // The DynamicDescriptorHeap class will need this class object to manage descriptors in CPU to GPU.
 
 //Note:For safety,the descirptor table index in root parameters should not exceed 32 better.
+//A table whose ranges are all unbounded(UINT_MAX descriptors) and start from offset 0 is a bindless table,
+//it is not staged by DynamicDescriptorHeap,the commandlist binds it to the start of bindless heap instead(see BindlessDescriptorHeap).
 class RootSignature
 {
 public:
@@ -41,6 +43,8 @@ public:
     //---------------------------------
     //D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER
     UINT GetDescriptorTableBitMask(D3D12_DESCRIPTOR_HEAP_TYPE type)const;
+    //Bit mask for bindless tables,which are not in the masks of GetDescriptorTableBitMask().
+    UINT GetBindlessTableBitMask()const { return m_BindlessTableBitMask; }
     //@return: A rootsignature desc which stores all descriptors infomation.
     //The return value shoule be reference or pointer.
     const D3D12_ROOT_SIGNATURE_DESC1& GetRootSignatureDesc1()const { return m_d3d12RootSigDesc1; }
@@ -54,6 +58,8 @@ private:
     UINT m_CbvSrvUavDescriptorTableBitMask;
     //Bit mask for sampler descriptor table.
     UINT m_SamplerTableBitMask;
+    //Bit mask for bindless table.
+    UINT m_BindlessTableBitMask;
     //Descriptor number in different table.
     UINT m_NumDescriptorsPerTable[32];
 
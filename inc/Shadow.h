@@ -1,6 +1,6 @@
 #pragma once
 
-#include <d3d12.h>
+#include "Platform.h"
 #include <memory>
 #include <array>
 
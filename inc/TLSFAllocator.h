@@ -0,0 +1,130 @@
+#pragma once
+
+/**
+ * @brief TLSF(two-level segregated fit) allocator
+ *
+ * It only manages offsets in a range of [0,Size),and it does not know what the range is,
+ * so it can be used by gpu heaps,descriptor heaps or anything else,and it can be tested without a device.
+ * Free blocks are kept in lists by size classes.The first level of a class is the highest bit of size,
+ * the second level splits every first level into 2^SecondLevelBits parts,and two bitmaps mark which lists are not empty.
+ * So both Allocate() and Free() cost O(1),and neighbour free blocks are merged at once when a block is freed.
+ * Block headers are kept in an array indexed by offset,which is created with the allocator,
+ * so Allocate() and Free() never allocate memory.
+ * It is NOT thread safe.
+ */
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Fragmentation statistics of a TLSF allocator.
+ */
+struct TLSFStatistics
+{
+    uint64_t TotalSize = 0;
+    uint64_t UsedSize = 0;
+    uint64_t FreeSize = 0;
+    uint64_t LargestFreeBlock = 0;
+    uint64_t NumAllocations = 0;
+    uint64_t NumFreeBlocks = 0;
+    /**
+     * 0 means all free space is one block,and it comes close to 1 when free space is split into many small blocks.
+     */
+    float Fragmentation()const
+    {
+        return FreeSize == 0 ? 0.0f : 1.0f - static_cast<float>(LargestFreeBlock) / static_cast<float>(FreeSize);
+    }
+};
+
+class TLSFAllocator
+{
+public:
+    static const uint64_t InvalidOffset = UINT64_MAX;
+
+    /**
+     * @param Size: the size of the range.
+     * @param MinBlockSize: all offsets and sizes are rounded up to it,and one block header is created for every MinBlockSize bytes.
+     */
+    explicit TLSFAllocator(uint64_t Size, uint64_t MinBlockSize = 1);
+    ~TLSFAllocator();
+
+    TLSFAllocator(const TLSFAllocator& copy) = delete;
+    TLSFAllocator& operator=(const TLSFAllocator& other) = delete;
+
+    /**
+     * Allocate a range.
+     * @param Alignment: MUST be a power of 2.
+     * @return the offset of the range,or InvalidOffset if there is no free block which is big enough.
+     */
+    uint64_t Allocate(uint64_t Size, uint64_t Alignment = 1);
+    /**
+     * Check if Allocate(Size) can succeed without moving anything.
+     */
+    bool HasSpace(uint64_t Size)const;
+    /**
+     * Free a range by the offset which Allocate() returned.
+     */
+    void Free(uint64_t Offset);
+    /**
+     * Free everything.
+     */
+    void Reset();
+
+    bool IsEmpty()const { return m_UsedSize == 0; }
+    uint64_t GetSize()const { return m_Size; }
+    uint64_t GetFreeSize()const { return m_Size - m_UsedSize; }
+
+    TLSFStatistics GetStatistics()const;
+private:
+    static const uint32_t SecondLevelBits = 4;
+    static const uint32_t SecondLevelCount = 1u << SecondLevelBits;
+    //sizes smaller than this are all in first level 0,and are split linearly by second level.
+    static const uint64_t SmallBlockSize = 1ull << SecondLevelBits;
+    static const uint32_t FirstLevelCount = 64 - SecondLevelBits + 1;
+
+    //Only headers at the start of a block are valid,others are not used.
+    struct Block
+    {
+        uint64_t Offset;
+        uint64_t Size;
+        //neighbours in the range
+        Block* pPrevPhysical;
+        //neighbours in a free list
+        Block* pPrevFree;
+        Block* pNextFree;
+        bool bFree;
+        bool bAllocated;
+    };
+
+    static void Mapping(uint64_t Size, uint32_t& FirstLevel, uint32_t& SecondLevel);
+    /**
+     * Find a non-empty free list whose blocks are at least as big as the class of (FirstLevel,SecondLevel).
+     */
+    Block* FindSuitableBlock(uint32_t& FirstLevel, uint32_t& SecondLevel)const;
+
+    void InsertFreeBlock(Block* pBlock);
+    void RemoveFreeBlock(Block* pBlock);
+    /**
+     * Cut the first Size bytes of a block,the rest becomes a new free block.
+     */
+    void SplitBlock(Block* pBlock, uint64_t Size);
+    /**
+     * Merge a block with next physical block,the next block is released.
+     */
+    void MergeWithNext(Block* pBlock);
+
+    Block* GetBlock(uint64_t Offset);
+    Block* GetNextPhysical(Block* pBlock);
+
+    uint64_t m_Size;
+    uint64_t m_MinBlockSize;
+    uint64_t m_UsedSize;
+    uint64_t m_NumAllocations;
+
+    uint64_t m_FirstLevelBitmap;
+    uint32_t m_SecondLevelBitmap[FirstLevelCount];
+    Block* m_FreeLists[FirstLevelCount][SecondLevelCount];
+
+    //one header for every MinBlockSize bytes
+    std::vector<Block> m_Blocks;
+};
@@ -59,19 +59,10 @@ public:
 
 protected:
     void CreateView();
-
-    DescriptorAllocation CreateShaderResourceView(const D3D12_SHADER_RESOURCE_VIEW_DESC* SrvDesc = nullptr)const;
-    DescriptorAllocation CreateUnorderedAccessView(const D3D12_UNORDERED_ACCESS_VIEW_DESC* UavDesc = nullptr)const;
 private:
     TextureUsage m_TextureUsage;
     //Descriptor for a texture which may be rendertarget or depthstencil.
     bool m_IsRenderTarget;
     bool m_IsDepthStencil;
     DescriptorAllocation m_DescriptorAllocation;
-
-    mutable std::unordered_map<UINT,DescriptorAllocation> m_ShaderResourceViewMap;
-    mutable std::unordered_map<UINT,DescriptorAllocation> m_UnorderedAccessViewMap;
-
-    mutable std::mutex m_ShderResourceViewsMutex;
-    mutable std::mutex m_UnorderedAccessViewMutex;
 };
\ No newline at end of file
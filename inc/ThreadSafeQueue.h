@@ -69,7 +69,7 @@ bool ThreadSafeQueue<T>::TryPop(T& value)
     if (m_Queue.empty())
         return false;
 
-    value = m_Queue.front();
+    value = std::move(m_Queue.front());
     m_Queue.pop();
 
     return true;
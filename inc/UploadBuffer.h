@@ -31,12 +31,12 @@
  */
 
 
-#include <wrl.h>
-#include <d3d12.h>
+#include "Platform.h"
 #include <memory>
-#include <deque>
+#include <vector>
 
 #include "d3dUtil.h"
+#include "UploadRingBuffer.h"
 
 class UploadBuffer
 {
@@ -46,23 +46,21 @@ public:
     {
         void* CPU;
         D3D12_GPU_VIRTUAL_ADDRESS GPU;
+        // The upload resource and the offset in it,for copying from this allocation on gpu.
+        ID3D12Resource* Resource;
+        UINT64 Offset;
     };
 
     /**
-     * @param pageSize The size to use to allocate new pages in GPU memory.
+     * Memory is allocated from chunks of the upload ring buffer of the application.
      */
-    explicit UploadBuffer(size_t pageSize = _2MB);
+    UploadBuffer();
 
     virtual ~UploadBuffer();
 
-    /**
-     * The maximum size of an allocation is the size of a single page.
-     */
-    size_t GetPageSize() const { return m_PageSize;  }
-
     /**
      * Allocate memory in an Upload heap.
-     * An allocation must not exceed the size of a page.
+     * An allocation which is larger than a chunk of the ring buffer gets its own upload buffer.
      * Use a memcpy or similar method to copy the 
      * buffer data to CPU pointer in the Allocation structure returned from 
      * this function.
@@ -70,58 +68,18 @@ public:
     Allocation Allocate(size_t sizeInBytes, size_t alignment);
 
     /**
-     * Release all allocated pages. This should only be done when the command list
+     * Retire all chunks and release all spills. This should only be done when the command list
      * is finished executing on the CommandQueue.
      */
     void Reset();
 
 private:
-    // A single page for the allocator.
-    struct Page
-    {
-        Page(size_t sizeInBytes);
-        ~Page();
-
-        // Check to see if the page has room to satisfy the requested
-        // allocation.
-        bool HasSpace(size_t sizeInBytes, size_t alignment ) const;
-        
-        // Allocate memory from the page.
-        // Throws std::bad_alloc if the the allocation size is larger
-        // that the page size or the size of the allocation exceeds the 
-        // remaining space in the page.
-        Allocation Allocate(size_t sizeInBytes, size_t alignment);
-
-        // Reset the page for reuse.
-        void Reset();
-
-    private:
-
-        Microsoft::WRL::ComPtr<ID3D12Resource> m_d3d12Resource;
-
-        // Base pointer.
-        void* m_CPUPtr;
-        D3D12_GPU_VIRTUAL_ADDRESS m_GPUPtr;
-
-        // Allocated page size.
-        size_t m_PageSize;
-        // Current allocation offset in bytes.
-        size_t m_Offset;
-    };
-
-    // A pool of memory pages.
-    using PagePool = std::deque< std::shared_ptr<Page> >;
-
-    // Request a page from the pool of available pages
-    // or create a new page if there are no available pages.
-    std::shared_ptr<Page> RequestPage();
-
-    PagePool m_PagePool;
-    PagePool m_AvailablePages;
-
-    std::shared_ptr<Page> m_CurrentPage;
+    UploadRingBuffer* m_pRingBuffer;
 
-    // The size of each page of memory.
-    size_t m_PageSize;
+    // Chunks used since last reset,the last one is current chunk.
+    std::vector<UploadRingBuffer::Chunk> m_Chunks;
+    std::vector<UploadRingBuffer::Spill> m_Spills;
 
-};
\ No newline at end of file
+    // Current allocation offset in current chunk.
+    size_t m_Offset;
+};
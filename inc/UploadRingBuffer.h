@@ -0,0 +1,145 @@
+#pragma once
+
+/**
+ * @brief Upload Ring Buffer
+ *
+ * A ring allocator which is shared by all command lists.It is backed by a few large persistently-mapped upload heaps,
+ * every heap is split into chunks,and UploadBuffer of a command list allocates its dynamic data from its chunks.
+ * A chunk is retired when the command list is reset,which only happens after the fence of the command list has completed.
+ * Chunks are reused in the order they are allocated,so a retired chunk waits for all older chunks of the same heap.
+ * An allocation which is larger than a chunk gets its own upload buffer(a spill).Spills are rounded up to a power of 2,
+ * and they are kept in a pool after the command list retires them,so that loading scenes does not create and destroy upload heaps.
+ * Heaps are created when all heaps are full,and empty heaps over the high-water mark of recent frames are released,
+ * so are spills which have not been reused for TrimInterval frames.
+ */
+
+#include "Platform.h"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "d3dUtil.h"
+
+/**
+ * Counters of upload ring buffer in one frame.
+ */
+struct UploadRingBufferStatistics
+{
+    size_t BytesUsed = 0;           // Bytes of all allocations.
+    size_t BytesWasted = 0;         // Bytes lost to alignment and to the unused end of chunks.
+    size_t Spills = 0;              // Allocations which are larger than a chunk.
+    size_t SpillsReused = 0;        // Spills which are taken from the pool.
+    size_t SpillBytes = 0;
+    size_t PooledSpillBytes = 0;    // Bytes of spills which wait in the pool.
+    size_t ChunksRequested = 0;
+    size_t HighWaterChunks = 0;     // The max number of chunks in flight.
+    size_t NumHeaps = 0;
+};
+
+class UploadRingBuffer
+{
+public:
+    // A part of an upload heap which is used by only one command list.
+    struct Chunk
+    {
+        uint8_t* CPU = nullptr;
+        D3D12_GPU_VIRTUAL_ADDRESS GPU = 0;
+        ID3D12Resource* pResource = nullptr;
+        // Offset of the chunk in pResource.
+        UINT64 Offset = 0;
+        size_t HeapIndex = 0;
+        size_t ChunkIndex = 0;
+    };
+    // An upload buffer for one big allocation.
+    struct Spill
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+        void* CPU = nullptr;
+        D3D12_GPU_VIRTUAL_ADDRESS GPU = 0;
+        size_t Size = 0;
+    };
+
+    /**
+     * @param HeapSize: the size of every upload heap.
+     * @param ChunkSize: the size of a chunk,it MUST divide HeapSize.
+     * @param TrimInterval: the number of frames between two trims.
+     */
+    explicit UploadRingBuffer(size_t HeapSize = _MB(16), size_t ChunkSize = _KB(256), UINT TrimInterval = 120);
+    ~UploadRingBuffer();
+
+    UploadRingBuffer(const UploadRingBuffer& copy) = delete;
+    UploadRingBuffer& operator=(const UploadRingBuffer& other) = delete;
+
+    size_t GetChunkSize()const { return m_ChunkSize; }
+    /**
+     * Get a chunk from the ring,a new heap is created if all heaps are full.
+     */
+    Chunk RequestChunk();
+    /**
+     * Give a chunk back.This MUST be called after the commands using this chunk have finished on gpu.
+     */
+    void RetireChunk(const Chunk& chunk);
+    /**
+     * Get an upload buffer for an allocation which is larger than a chunk,from the pool or a new one.
+     */
+    Spill AllocateSpill(size_t SizeInBytes);
+    /**
+     * Give a spill back to the pool.This MUST be called after the commands using this spill have finished on gpu.
+     */
+    void RetireSpill(const Spill& spill);
+    /**
+     * Record bytes used and wasted by allocations from chunks.
+     */
+    void AddUsage(size_t BytesUsed, size_t BytesWasted);
+    /**
+     * Finish statistics of current frame and release empty heaps every TrimInterval frames.
+     * It is called once a frame on main thread by Application::EndFrame().
+     */
+    void EndFrame();
+    /**
+     * Get statistics of last finished frame.
+     */
+    UploadRingBufferStatistics GetFrameStatistics()const;
+private:
+    struct Heap
+    {
+        explicit Heap(size_t HeapSize, size_t NumChunks);
+        ~Heap();
+
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_d3d12Resource;
+        uint8_t* m_CPUPtr;
+        D3D12_GPU_VIRTUAL_ADDRESS m_GPUPtr;
+        //Chunks in [m_Tail,m_Tail+m_NumOccupied) are in use or retired but wait for older chunks.
+        size_t m_Head;
+        size_t m_Tail;
+        size_t m_NumOccupied;
+        std::vector<bool> m_Retired;
+    };
+
+    size_t m_HeapSize;
+    size_t m_ChunkSize;
+    size_t m_NumChunksPerHeap;
+    UINT m_TrimInterval;
+    UINT m_NumFramesSinceTrim;
+
+    mutable std::mutex m_Mutex;
+    std::vector<std::unique_ptr<Heap>> m_Heaps;
+    size_t m_NumOccupiedChunks;
+    //retired spills by size,with the frame they are retired
+    std::multimap<size_t, std::pair<Spill, UINT64>> m_PooledSpills;
+    size_t m_PooledSpillBytes;
+    UINT64 m_FrameIndex;
+    //the max number of chunks in flight since last trim
+    size_t m_TrimHighWaterChunks;
+
+    std::atomic<size_t> m_BytesUsed;
+    std::atomic<size_t> m_BytesWasted;
+    std::atomic<size_t> m_Spills;
+    std::atomic<size_t> m_SpillsReused;
+    std::atomic<size_t> m_SpillBytes;
+    size_t m_ChunksRequested;
+    size_t m_FrameHighWaterChunks;
+    UploadRingBufferStatistics m_FrameStatistics;
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+/**
+ * @brief View Cache
+ *
+ * A cache of cpu descriptors for views and samplers,which is shared by all resources.
+ * Views are keyed by the full (ID3D12Resource,view type,view desc),and samplers are keyed by the full D3D12_SAMPLER_DESC.
+ * Keys are compared byte by byte when hashes are same,so a collision never returns a wrong view.
+ *
+ * All views of a resource are in one shard,and every shard has fixed buckets of singly linked nodes.
+ * Nodes are never changed after they are published,so lookups only walk the chain without any lock.
+ * Inserting and evicting lock the shard,and an unlinked node is freed only when no reader is in the shard.
+ * Views of a resource are evicted when the ID3D12Resource itself is destroyed,by an object which is attached to it as private data,
+ * so copies of a Texture share views,and a view never outlives its resource.
+ */
+
+#include "DescriptorAllocation.h"
+
+#include "Platform.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+enum class ViewType : uint32_t
+{
+    ShaderResource,
+    UnorderedAccess,
+    //a copy of shader resource view in bindless heap(see BindlessDescriptorHeap).
+    BindlessShaderResource,
+    Sampler
+};
+
+struct ViewCacheStatistics
+{
+    uint64_t NumHits = 0;
+    uint64_t NumMisses = 0;
+    uint64_t NumEvictions = 0;
+    //Views and samplers which are in the cache now.
+    uint64_t NumViews = 0;
+};
+
+class ViewCache : public std::enable_shared_from_this<ViewCache>
+{
+public:
+    ViewCache();
+    ~ViewCache();
+
+    ViewCache(const ViewCache& copy) = delete;
+    ViewCache& operator=(const ViewCache& other) = delete;
+
+    /**
+     * Get a shader resource view of a resource,the view is created when it is not in the cache.
+     * @param pDesc: null means the default view of the resource.
+     */
+    D3D12_CPU_DESCRIPTOR_HANDLE GetShaderResourceView(ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc = nullptr);
+    D3D12_CPU_DESCRIPTOR_HANDLE GetUnorderedAccessView(ID3D12Resource* pResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc = nullptr);
+    /**
+     * Get a shader resource view in bindless heap,it is only valid in bindless mode.
+     * @return the handle in bindless heap,its index is BindlessDescriptorHeap::GetIndex().
+     */
+    D3D12_CPU_DESCRIPTOR_HANDLE GetBindlessShaderResourceView(ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc = nullptr);
+    /**
+     * Get a sampler in a non shader visible sampler heap,it lives until the cache is destroyed.
+     */
+    D3D12_CPU_DESCRIPTOR_HANDLE GetSampler(const D3D12_SAMPLER_DESC& Desc);
+    /**
+     * Remove all views of a resource.
+     * It is called when the resource is destroyed,the descriptors are retired to deferred deletion queue.
+     */
+    void Evict(ID3D12Resource* pResource);
+
+    ViewCacheStatistics GetStatistics()const;
+private:
+    static const size_t NumShards = 64;
+    static const size_t NumBucketsPerShard = 256;
+    static const size_t SrvDescSize = sizeof(D3D12_SHADER_RESOURCE_VIEW_DESC);
+    static const size_t UavDescSize = sizeof(D3D12_UNORDERED_ACCESS_VIEW_DESC);
+    static const size_t SamplerDescSize = sizeof(D3D12_SAMPLER_DESC);
+    static const size_t MaxDescSize = SrvDescSize > UavDescSize ?
+        (SrvDescSize > SamplerDescSize ? SrvDescSize : SamplerDescSize) :
+        (UavDescSize > SamplerDescSize ? UavDescSize : SamplerDescSize);
+
+    struct Key
+    {
+        ID3D12Resource* pResource;
+        ViewType Type;
+        UINT HasDesc;
+        //the desc with zeroed padding,so keys can be compared by memcmp.
+        uint8_t Desc[MaxDescSize];
+    };
+
+    struct Node
+    {
+        std::atomic<Node*> pNext;
+        size_t Hash;
+        Key NodeKey;
+        DescriptorAllocation Descriptor;
+    };
+
+    struct alignas(64) Shard
+    {
+        std::atomic<Node*> Buckets[NumBucketsPerShard];
+        //readers which are walking chains of this shard.
+        std::atomic<uint32_t> NumReaders;
+        //for inserting and evicting.
+        std::mutex Mutex;
+        //unlinked nodes which may still be read.
+        std::vector<Node*> RetiredNodes;
+    };
+
+    static Key MakeKey(ID3D12Resource* pResource, ViewType Type, const void* pDesc, size_t DescSize);
+    static size_t HashKey(const Key& key);
+    Shard& GetShard(const Key& key);
+
+    /**
+     * Find a view without locking.
+     * @return false if the view is not in the cache.
+     */
+    bool Find(const Key& key, size_t Hash, D3D12_CPU_DESCRIPTOR_HANDLE& Handle);
+    /**
+     * Insert a view which is created outside the lock.
+     * If the same key is inserted by another thread already,the new descriptor is dropped and the old one is returned.
+     */
+    D3D12_CPU_DESCRIPTOR_HANDLE Insert(const Key& key, size_t Hash, DescriptorAllocation&& Descriptor);
+    /**
+     * Make sure that the views are evicted when the resource is destroyed.
+     */
+    void AttachEvictor(ID3D12Resource* pResource);
+    /**
+     * Free retired nodes of a shard if no reader is in it,the shard must be locked.
+     */
+    void FreeRetiredNodes(Shard& shard);
+
+    Shard m_Shards[NumShards];
+    std::mutex m_EvictorMutex;
+
+    std::atomic<uint64_t> m_NumHits;
+    std::atomic<uint64_t> m_NumMisses;
+    std::atomic<uint64_t> m_NumEvictions;
+    std::atomic<uint64_t> m_NumViews;
+};
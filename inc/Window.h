@@ -6,8 +6,7 @@
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
-#include <wrl.h>
-#include <d3d12.h>
+#include "Platform.h"
 #include "d3dx12.h"
 #include <dxgi1_5.h>
 #include <string>
@@ -23,6 +22,10 @@ class Window
 {
 public:
     const static int m_BackBufferCount = 3;
+    //Upper limit of frames in flight,fence values are kept in a ring of this size.
+    //It is not more than backbuffer count,since the swap chain blocks Present() by itself when all backbuffers are queued,
+    //so more frames would only wait there instead of in Present() of Window.
+    const static UINT m_MaxFramesInFlight = m_BackBufferCount;
     /**
      * Show window
      */
@@ -64,6 +67,14 @@ public:
      * @return the current backbuffer index
      */
     UINT Present(const Texture* pTexture);
+    /**
+     * Set how many frames cpu can record ahead of gpu,from 1 to backbuffer count(m_MaxFramesInFlight).
+     * One frame means cpu waits for every frame in Present(),it has lowest latency.
+     * More frames let cpu record next frame while gpu is executing this one,it has higher throughput.
+     * The default is same as backbuffer count.
+     */
+    void SetFramesInFlight(UINT NumFramesInFlight);
+    UINT GetFramesInFlight()const;
     /**
      * Get current backbuffer index
      */
@@ -158,8 +169,11 @@ private:
     Microsoft::WRL::ComPtr<IDXGISwapChain4> m_dxgiSwapChain;
     std::unique_ptr<Texture> m_BackBufferTextures[m_BackBufferCount];
 
-    UINT64 m_FenceValue[m_BackBufferCount];
-    UINT64 m_FrameCount[m_BackBufferCount];
+    //Fence value of each frame slot.
+    //Upload pages and dynamic descriptor heaps belong to command lists,they are recycled when their fence completes.
+    UINT64 m_FenceValue[m_MaxFramesInFlight];
+    UINT m_NumFramesInFlight;
+    UINT m_CurrentFrameSlot;
 
     int m_CurrentBackBufferIndex;
 
@@ -1,18 +1,20 @@
 #pragma once
 
+#if defined(_WIN32)
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
 
 #include <windows.h>
-#include <wrl.h>
-#include <string>
 #include <dxgi1_6.h>
-#include <d3d12.h>
+#include <d3dcompiler.h>
+#endif
+#include "Platform.h"
+#include <string>
+#include <cstring>
 #include "d3dx12.h"
 #include <DirectXCollision.h>
 #include <unordered_map>
-#include <d3dcompiler.h>
 
 #include "Events.h"
 
@@ -57,6 +59,7 @@ enum TextureUsage
 /* Some inline helper functions                                         */
 /************************************************************************/
 
+#if defined(_WIN32)
 inline void d3dSetDebugName(IDXGIObject* obj, const char* name)
 {
     if (obj)
@@ -64,28 +67,35 @@ inline void d3dSetDebugName(IDXGIObject* obj, const char* name)
         obj->SetPrivateData(WKPDID_D3DDebugObjectName, lstrlenA(name), name);
     }
 }
+#endif
 inline void d3dSetDebugName(ID3D12Device* obj, const char* name)
 {
     if (obj)
     {
-        obj->SetPrivateData(WKPDID_D3DDebugObjectName, lstrlenA(name), name);
+        obj->SetPrivateData(WKPDID_D3DDebugObjectName, static_cast<UINT>(std::strlen(name)), name);
     }
 }
 inline void d3dSetDebugName(ID3D12DeviceChild* obj, const char* name)
 {
     if (obj)
     {
-        obj->SetPrivateData(WKPDID_D3DDebugObjectName, lstrlenA(name), name);
+        obj->SetPrivateData(WKPDID_D3DDebugObjectName, static_cast<UINT>(std::strlen(name)), name);
     }
 }
 
 inline std::wstring AnsiToWString(const std::string& str)
 {
+#if defined(_WIN32)
     WCHAR buffer[512];
     ::MultiByteToWideChar(CP_ACP, 0, str.c_str(), -1, buffer, 512);
     return std::wstring(buffer);
+#else
+    //file names and messages of the engine are ascii.
+    return std::wstring(str.begin(), str.end());
+#endif
 }
 
+#if defined(_WIN32)
 // Convert the message ID into a MouseButton ID
 inline MouseButtonEventArgs::MouseButton DecodeMouseButton(UINT messageID)
 {
@@ -117,6 +127,7 @@ inline MouseButtonEventArgs::MouseButton DecodeMouseButton(UINT messageID)
 
     return mouseButton;
 }
+#endif
 
 class d3dUtil
 {
@@ -12,7 +12,7 @@
 #ifndef __D3DX12_H__
 #define __D3DX12_H__
 
-#include "d3d12.h"
+#include "Platform.h"
 
 #if defined( __cplusplus )
 
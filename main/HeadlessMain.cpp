@@ -0,0 +1,88 @@
+#include <NeoEngine/inc/Application.h>
+#include <NeoEngine/inc/CommandQueue.h>
+#include <NeoEngine/inc/CommandList.h>
+#include <NeoEngine/inc/Texture.h>
+#include <NeoEngine/inc/VertexBuffer.h>
+#include <NeoEngine/inc/ResourceStateTracker.h>
+#include <NeoEngine/inc/UploadRingBuffer.h>
+#include <NeoEngine/inc/d3dx12.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/**
+ * Headless entry point,it is built as a console program besides the windowed sample.
+ * The engine runs on the null device without a window,so cpu-side cost of recording,
+ * barrier tracking and submitting can be measured on machines without a gpu.
+ * Usage: HeadlessMain [number of frames]
+ */
+
+struct HeadlessVertex
+{
+    float Position[3];
+    float Color[4];
+};
+
+int main(int argc, char** argv)
+{
+    UINT64 numFrames = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000;
+
+    Application::Create(nullptr, DeviceBackend::Null);
+    {
+        auto pApp = Application::GetApp();
+
+        auto colorDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 1920, 1080, 1, 1, 1, 0,
+            D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+        D3D12_CLEAR_VALUE clearValue = {};
+        clearValue.Format = colorDesc.Format;
+        Texture colorTexture(&colorDesc, &clearValue, TextureUsage::RenderTargetTexture, L"Headless Color Texture");
+
+        std::vector<HeadlessVertex> vertices(3 * 1024);
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            vertices[i] = { { static_cast<float>(i % 3), static_cast<float>(i / 3), 0.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } };
+        }
+        VertexBuffer vertexBuffer(L"Headless Vertex Buffer");
+        {
+            auto uploadQueue = pApp->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
+            auto uploadCommandList = uploadQueue->GetCommandList();
+            uploadCommandList->CopyVertexBuffer(&vertexBuffer, vertices);
+            uploadQueue->ExecuteCommandList(uploadCommandList);
+            uploadQueue->Flush();
+        }
+
+        auto directQueue = pApp->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
+        pApp->RunHeadless(numFrames, [&](const UpdateEventArgs& UpdateArgs, const RenderEventArgs& RenderArgs)
+        {
+            auto commandList = directQueue->GetCommandList();
+            const float clearColor[4] = { 0.0f, 0.0f, static_cast<float>(RenderArgs.TotalTime), 1.0f };
+            commandList->ClearRenderTargetTexture(&colorTexture, clearColor);
+            commandList->SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+            commandList->SetVertexBuffer(0, &vertexBuffer);
+            commandList->Draw(static_cast<UINT>(vertices.size()), 1, 0, 0);
+            //dynamic vertices are allocated from the upload ring every frame.
+            commandList->SetDynamicVertexBuffer(0, 3, sizeof(HeadlessVertex), vertices.data());
+            commandList->Draw(3, 1, 0, 0);
+            commandList->BarrierTransition(&colorTexture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+            directQueue->ExecuteCommandList(commandList);
+        });
+
+        auto deviceStatistics = NullDevice::GetStatistics(pApp->GetDevice().Get());
+        auto ringStatistics = pApp->GetUploadRingBuffer()->GetFrameStatistics();
+        auto barrierStatistics = ResourceStateTracker::GetFrameStatistics();
+        std::printf("Frames:                  %llu\n", static_cast<unsigned long long>(Application::GetFrameCount()));
+        std::printf("Command lists executed:  %llu\n", static_cast<unsigned long long>(deviceStatistics.CommandListsExecuted));
+        std::printf("Commands recorded:       %llu\n", static_cast<unsigned long long>(deviceStatistics.CommandsRecorded));
+        std::printf("Draws:                   %llu\n", static_cast<unsigned long long>(deviceStatistics.Draws));
+        std::printf("Resource barriers:       %llu\n", static_cast<unsigned long long>(deviceStatistics.ResourceBarriers));
+        std::printf("Fence signals:           %llu\n", static_cast<unsigned long long>(deviceStatistics.FenceSignals));
+        std::printf("Last frame upload bytes: %llu\n", static_cast<unsigned long long>(ringStatistics.BytesUsed));
+        std::printf("Last frame barriers:     %llu issued,%llu requested\n",
+            static_cast<unsigned long long>(barrierStatistics.NumIssuedBarriers),
+            static_cast<unsigned long long>(barrierStatistics.NumRequestedBarriers));
+    }
+    Application::Destory();
+
+    return 0;
+}
@@ -12,6 +12,7 @@
 #include <NeoEngine/inc/Window.h>
 #include <NeoEngine/inc/imgui.h>
 #include <NeoEngine/inc/Filter.h>
+#include <NeoEngine/inc/JobSystem.h>
 
 
 static void OnGUI();
@@ -97,7 +98,7 @@ bool Scenes::LoadContent()
     m_pForwardRendering->SetPassInput(Scene::GetScene()->GetTypedModels());
 
     auto fence = commandQueue->ExecuteCommandList(commandList);
-    commandQueue->WaitForFenceValue(fence);
+    commandQueue->WaitForFenceValue(fence.FenceValue);
 
     return true;
 }
@@ -130,7 +131,16 @@ void Scenes::Render(const RenderEventArgs& RenderArgs)
     auto commandQueue = Application::GetApp()->GetCommandQueue();
     auto commandList = commandQueue->GetCommandList();
 
-    m_pForwardRendering->ExecutePass(commandList);
+    //Record forward pass on one command list per job thread,main thread also records one.
+    UINT numRecordingThreads = static_cast<UINT>(Application::GetApp()->GetJobSystem()->GetNumWorkers()) + 1;
+    if (numRecordingThreads > 1)
+    {
+        commandList = m_pForwardRendering->ExecutePassParallel(commandList, numRecordingThreads);
+    }
+    else
+    {
+        m_pForwardRendering->ExecutePass(commandList);
+    }
     //Render Environment
     //Environment::GetEnvironment()->RenderEnvironment(commandList);
     //m_pCamera2->RenderCameraFrustum(commandList, m_pCamera.get());
@@ -1,10 +1,25 @@
 #include "Application.h"
-#include "Window.h"
 #include "CommandQueue.h"
-#include "Game.h"
 #include "GameTimer.h"
 #include "d3dUtil.h"
 #include "DescriptorAllocator.h"
+#include "JobSystem.h"
+#include "UploadRingBuffer.h"
+#include "ResourceStateTracker.h"
+#include "ResourceHeapAllocator.h"
+#include "DeferredDeletionQueue.h"
+#include "BindlessDescriptorHeap.h"
+#include "ViewCache.h"
+
+static Application* m_SingleApp = nullptr;
+
+UINT Application::m_MultiSampleCount = 4;
+//
+UINT64 Application::m_FrameCount = 0;
+
+#if defined(_WIN32)
+#include "Window.h"
+#include "Game.h"
 #include "imgui_impl_win32.h"
 
 const std::wstring g_WindowClassName = L"DirectX12";
@@ -19,16 +34,11 @@ using WindowNameMap = std::unordered_map<std::wstring, WindowPtr>;
  */
 static WindowMap gs_Windows;
 static WindowNameMap gs_WindowsByName;
-static Application* m_SingleApp = nullptr;
 static bool gb_IsDxRuntimeReady = false;
 
-UINT Application::m_MultiSampleCount = 4;
-
 //We should set window callback function in Application since callback function will
 //frequently use global variables.
 static LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
-//
-UINT64 Application::m_FrameCount = 0;
 
 /**
  * A helper struct to create window.
@@ -38,13 +48,22 @@ struct MakeWindow : public Window
 	MakeWindow(HWND hwnd, const std::wstring& windowName, int width, int height, bool vsync)
 		:Window(hwnd, windowName, width, height, vsync) {};
 };
+#endif
 
-Application::Application(HINSTANCE hinstance) : 
+Application::Application(HINSTANCE hinstance, DeviceBackend Backend, const NullDeviceDesc& NullDesc) : 
     m_hinstance(hinstance),
-    m_bUseWarp(FALSE),
+    m_DeviceBackend(Backend),
+    m_NullDeviceDesc(NullDesc),
+    m_bUseWarp(Backend == DeviceBackend::Warp),
     m_bIsAppPaused(FALSE),
     m_bSupportTearing(FALSE)
 {
+    //null device has neither debug layer nor window
+    if (m_DeviceBackend == DeviceBackend::Null)
+    {
+        return;
+    }
+#if defined(_WIN32)
 	SetThreadDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
 	//Enable d3d12 debug layer
 #ifdef _DEBUG
@@ -71,22 +90,47 @@ Application::Application(HINSTANCE hinstance) :
     {
         ::MessageBox(nullptr, L"Register Window Failed", L"ERROR", MB_OK | MB_ICONERROR);
     }
+#else
+    assert(false && "Error!Only null device can run without windows!");
+#endif
 }
 
 void Application::Initialize()
 {
-    m_dxgiAdapter = GetAdapter();
-    if (m_dxgiAdapter)
+    //Application is created on main thread,so job system takes this thread as main thread.
+    m_pJobSystem = std::make_unique<JobSystem>();
+
+    if (m_DeviceBackend == DeviceBackend::Null)
+    {
+        m_d3d12Device = NullDevice::Create(m_NullDeviceDesc);
+    }
+#if defined(_WIN32)
+    else
     {
-        m_d3d12Device = CreateDevice(m_dxgiAdapter);
+        m_dxgiAdapter = GetAdapter();
+        if (m_dxgiAdapter)
+        {
+            m_d3d12Device = CreateDevice(m_dxgiAdapter);
+        }
     }
+#endif
     if (m_d3d12Device)
     {
+        m_pUploadRingBuffer = std::make_unique<UploadRingBuffer>();
+        m_pResourceHeapAllocator = std::make_unique<ResourceHeapAllocator>();
+
         m_DirectCommandQueue = std::make_shared<CommandQueue>(D3D12_COMMAND_LIST_TYPE_DIRECT);
         m_ComputeCommandQueue = std::make_shared<CommandQueue>(D3D12_COMMAND_LIST_TYPE_COMPUTE);
         m_CopyCommandQueue = std::make_shared<CommandQueue>(D3D12_COMMAND_LIST_TYPE_COPY);
+        std::shared_ptr<CommandQueue> commandQueues[DeferredDeletionQueue::NumCommandQueues] =
+        {
+            m_DirectCommandQueue, m_ComputeCommandQueue, m_CopyCommandQueue
+        };
+        m_pDeferredDeletionQueue = std::make_unique<DeferredDeletionQueue>(commandQueues);
 
-        m_bSupportTearing = CheckSupportTearing();
+#if defined(_WIN32)
+        m_bSupportTearing = m_DeviceBackend != DeviceBackend::Null && CheckSupportTearing();
+#endif
         m_pTimer = std::make_shared<GameTimer>();
     }
 
@@ -94,18 +138,80 @@ void Application::Initialize()
     {
         m_DescriptorAllocator[i] = std::make_unique<DescriptorAllocator>(static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(i));
     }
+    CreateNullDescriptors();
+    m_pViewCache = std::make_shared<ViewCache>();
+}
+
+void Application::CreateNullDescriptors()
+{
+    for (int type = 0; type < static_cast<int>(NullDescriptorType::NumTypes); ++type)
+    {
+        m_NullDescriptors[type] = AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, MaxNullDescriptors);
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC SrvDesc = {};
+        SrvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        SrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        D3D12_UNORDERED_ACCESS_VIEW_DESC UavDesc = {};
+        UavDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        switch (static_cast<NullDescriptorType>(type))
+        {
+        case NullDescriptorType::Texture2D:
+            SrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+            SrvDesc.Texture2D.MipLevels = 1;
+            break;
+        case NullDescriptorType::Texture2DArray:
+            SrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+            SrvDesc.Texture2DArray.MipLevels = 1;
+            SrvDesc.Texture2DArray.ArraySize = 1;
+            break;
+        case NullDescriptorType::TextureCube:
+            SrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+            SrvDesc.TextureCube.MipLevels = 1;
+            break;
+        case NullDescriptorType::RWTexture2D:
+            UavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+            break;
+        default:
+            assert(FALSE && "Error!Unexpected null descriptor type!");
+            break;
+        }
+
+        for (UINT i = 0; i < MaxNullDescriptors; ++i)
+        {
+            if (static_cast<NullDescriptorType>(type) == NullDescriptorType::RWTexture2D)
+            {
+                m_d3d12Device->CreateUnorderedAccessView(nullptr, nullptr, &UavDesc, m_NullDescriptors[type].GetDescriptorHandle(i));
+            }
+            else
+            {
+                m_d3d12Device->CreateShaderResourceView(nullptr, &SrvDesc, m_NullDescriptors[type].GetDescriptorHandle(i));
+            }
+        }
+    }
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE Application::GetNullDescriptors(NullDescriptorType Type)const
+{
+    assert(Type < NullDescriptorType::NumTypes && "Error!Unexpected null descriptor type!");
+    return m_NullDescriptors[static_cast<int>(Type)].GetDescriptorHandle();
 }
 
 Application::~Application()
 {
+	//Jobs may still record or execute commands,so finish them before flush.
+	m_pJobSystem.reset();
 	Flush();
+	if (m_pDeferredDeletionQueue)
+	{
+		ReleaseRetiredObjects(true);
+	}
 }
 
-void Application::Create(HINSTANCE hinstance)
+void Application::Create(HINSTANCE hinstance, DeviceBackend Backend, const NullDeviceDesc& NullDesc)
 {
 	if (m_SingleApp == nullptr)
 	{
-		m_SingleApp = new Application(hinstance);
+		m_SingleApp = new Application(hinstance, Backend, NullDesc);
         m_SingleApp->Initialize();
 	}
 }
@@ -117,8 +223,10 @@ void Application::Destory()
 		/**
 		 * Point 1.
 		 */
+#if defined(_WIN32)
 		assert(gs_Windows.empty() && gs_WindowsByName.empty() &&
 			"All windows should be destroyed before destroy the application instance");
+#endif
 		delete m_SingleApp;
 		m_SingleApp = nullptr;
 	}
@@ -130,11 +238,12 @@ Application* Application::GetApp()
 	return m_SingleApp;
 }
 
-Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> Application::CreateDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE Type,UINT NumDescriptors)
+Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> Application::CreateDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE Type,UINT NumDescriptors,
+    D3D12_DESCRIPTOR_HEAP_FLAGS Flags /* = D3D12_DESCRIPTOR_HEAP_FLAG_NONE */)
 {
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> descriptorHeap;
 	D3D12_DESCRIPTOR_HEAP_DESC heapDesc;
-	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	heapDesc.Flags = Flags;
 	heapDesc.NodeMask = 0;
 	heapDesc.NumDescriptors = NumDescriptors;
 	heapDesc.Type = Type;
@@ -148,6 +257,56 @@ Microsoft::WRL::ComPtr<ID3D12Device2> Application::GetDevice()const
 	return m_d3d12Device;
 }
 
+DeviceBackend Application::GetDeviceBackend()const
+{
+    return m_DeviceBackend;
+}
+
+JobSystem* Application::GetJobSystem()const
+{
+    return m_pJobSystem.get();
+}
+
+UploadRingBuffer* Application::GetUploadRingBuffer()const
+{
+    return m_pUploadRingBuffer.get();
+}
+
+ResourceHeapAllocator* Application::GetResourceHeapAllocator()const
+{
+    return m_pResourceHeapAllocator.get();
+}
+
+DeferredDeletionQueue* Application::GetDeferredDeletionQueue()const
+{
+    return m_pDeferredDeletionQueue.get();
+}
+
+bool Application::EnableBindlessDescriptors()
+{
+    if (!m_pBindlessDescriptorHeap)
+    {
+        D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+        if (FAILED(m_d3d12Device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))) ||
+            options.ResourceBindingTier < D3D12_RESOURCE_BINDING_TIER_2)
+        {
+            return false;
+        }
+        m_pBindlessDescriptorHeap = std::make_unique<BindlessDescriptorHeap>();
+    }
+    return true;
+}
+
+BindlessDescriptorHeap* Application::GetBindlessDescriptorHeap()const
+{
+    return m_pBindlessDescriptorHeap.get();
+}
+
+ViewCache* Application::GetViewCache()const
+{
+    return m_pViewCache.get();
+}
+
 UINT Application::GetDescriptorIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE Type)
 {
 	return m_d3d12Device->GetDescriptorHandleIncrementSize(Type);
@@ -189,6 +348,7 @@ std::shared_ptr<CommandQueue> Application::GetCommandQueue(D3D12_COMMAND_LIST_TY
 	return commandqueue;
 }
 
+#if defined(_WIN32)
 Microsoft::WRL::ComPtr<IDXGIAdapter4> Application::GetAdapter()
 {
 	UINT createFactoryFlag = 0;
@@ -289,6 +449,7 @@ bool Application::CheckSupportTearing()
 
 std::shared_ptr<Window> Application::CreateRenderWindow(const std::wstring& windowName, int clientWidth, int clientHeight,bool vsync)
 {
+    assert(m_DeviceBackend != DeviceBackend::Null && "Error!Null device can not present to a window");
 	//Check if the window has been created.
 	WindowNameMap::iterator pos = gs_WindowsByName.find(windowName);
 	if (pos != gs_WindowsByName.end())
@@ -380,6 +541,8 @@ int Application::Run(std::shared_ptr<Game> pGame)
 			::TranslateMessage(&msg);
 			::DispatchMessage(&msg);
 		}
+		//Jobs which need win32 calls are executed here.
+		m_pJobSystem->ExecuteMainThreadJobs();
 	}
 
 	//We start to destroy all resources from here
@@ -389,6 +552,34 @@ int Application::Run(std::shared_ptr<Game> pGame)
 
 	return (int)msg.wParam;
 }
+#endif
+
+void Application::RunHeadless(UINT64 NumFrames, const std::function<void(const UpdateEventArgs&, const RenderEventArgs&)>& Frame)
+{
+    m_pTimer->Reset();
+
+    uint64_t fenceValues[HeadlessFramesInFlight] = {};
+    for (UINT64 frame = 0; frame < NumFrames; ++frame)
+    {
+        m_pTimer->Tick();
+        ++m_FrameCount;
+        UpdateEventArgs UpdateArgs(m_pTimer->DeltaTime(), m_pTimer->TotalTime());
+        RenderEventArgs RenderArgs(m_pTimer->DeltaTime(), m_pTimer->TotalTime());
+        Frame(UpdateArgs, RenderArgs);
+        //there is no message loop,so jobs which are posted to main thread are executed here.
+        m_pJobSystem->ExecuteMainThreadJobs();
+
+        //the same pacing as Window::Present(),but without a swap chain.
+        UINT slot = static_cast<UINT>(frame % HeadlessFramesInFlight);
+        fenceValues[slot] = m_DirectCommandQueue->Signal();
+        m_DirectCommandQueue->WaitForFenceValue(fenceValues[(slot + 1) % HeadlessFramesInFlight]);
+
+        EndFrame();
+    }
+
+    Flush();
+    ReleaseRetiredObjects(true);
+}
 
 std::shared_ptr<GameTimer> Application::GetTimer()const
 {
@@ -405,6 +596,7 @@ bool Application::GetAppPausedState()const
 	return m_bIsAppPaused;
 }
 
+#if defined(_WIN32)
 static void RemoveWindow(HWND hwnd)
 {
     WindowMap::iterator iter = gs_Windows.find(hwnd);
@@ -641,6 +833,7 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM l
 
     return 0;
 }
+#endif
 
 DXGI_SAMPLE_DESC Application::CheckMultipleSampleQulityLevels(DXGI_FORMAT format, UINT numSamples, D3D12_MULTISAMPLE_QUALITY_LEVEL_FLAGS flags)const
 {
@@ -665,10 +858,32 @@ DXGI_SAMPLE_DESC Application::CheckMultipleSampleQulityLevels(DXGI_FORMAT format
     return sampleDesc;
 }
 
-void Application::ReleaseStaleDescriptors(UINT64 frame)
+void Application::EndFrame()
+{
+    //objects which are retired in this frame are keyed by the fences which are just signaled,
+    //and objects whose fences are completed are released.
+    ReleaseRetiredObjects();
+    //finish upload statistics of this frame and trim empty upload heaps.
+    m_pUploadRingBuffer->EndFrame();
+    //finish barrier statistics of this frame.
+    ResourceStateTracker::EndFrame();
+}
+
+void Application::ReleaseRetiredObjects(bool bFlushed /* = false */)
 {
+    if (bFlushed)
+    {
+        m_pDeferredDeletionQueue->ReleaseAll();
+    }
+    else
+    {
+        //objects which are retired in this frame are keyed by the fences which are just signaled.
+        m_pDeferredDeletionQueue->Seal();
+        m_pDeferredDeletionQueue->ReleaseCompleted();
+    }
+    //descriptors may be given back to pages which are not available.
     for (int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
     {
-        m_DescriptorAllocator[i]->ReleaseStaleDescriptorAlloction(frame);
+        m_DescriptorAllocator[i]->UpdateAvailablePages();
     }
 }
\ No newline at end of file
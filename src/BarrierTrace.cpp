@@ -0,0 +1,206 @@
+#include "BarrierTrace.h"
+#include "ResourceStateTracker.h"
+
+#include <fstream>
+
+std::atomic<bool> BarrierTrace::ms_IsCapturing(false);
+std::mutex BarrierTrace::ms_Mutex;
+std::vector<uint8_t> BarrierTrace::ms_Trace;
+std::unordered_map<ID3D12Resource*, uint32_t> BarrierTrace::ms_ResourceIds;
+uint32_t BarrierTrace::ms_NextResourceId = 1;
+
+void BarrierTrace::BeginCapture()
+{
+    std::lock_guard<std::mutex> lock(ms_Mutex);
+    ms_Trace.clear();
+    ms_ResourceIds.clear();
+    ms_NextResourceId = 1;
+    Write(Magic);
+    Write(Version);
+    ms_IsCapturing.store(true, std::memory_order_relaxed);
+}
+
+std::vector<uint8_t> BarrierTrace::EndCapture()
+{
+    std::lock_guard<std::mutex> lock(ms_Mutex);
+    ms_IsCapturing.store(false, std::memory_order_relaxed);
+    ms_ResourceIds.clear();
+    std::vector<uint8_t> trace;
+    trace.swap(ms_Trace);
+    return trace;
+}
+
+bool BarrierTrace::SaveToFile(const std::vector<uint8_t>& Trace, const std::string& FileName)
+{
+    std::ofstream file(FileName, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(Trace.data()), static_cast<std::streamsize>(Trace.size()));
+    return file.good();
+}
+
+bool BarrierTrace::LoadFromFile(const std::string& FileName, std::vector<uint8_t>& Trace)
+{
+    std::ifstream file(FileName, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        return false;
+    }
+    std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    Trace.resize(static_cast<size_t>(size));
+    return size == 0 || file.read(reinterpret_cast<char*>(Trace.data()), size).good();
+}
+
+void BarrierTrace::RecordResource(ID3D12Resource* pResource, D3D12_RESOURCE_STATES State)
+{
+    if (!IsCapturing() || !pResource)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(ms_Mutex);
+    //it is checked again,since the capture may end while waiting for the lock.
+    if (!IsCapturing())
+    {
+        return;
+    }
+    //A resource which is added again gets its state reset,so it is written again with the same id.
+    auto& id = ms_ResourceIds[pResource];
+    if (id == 0)
+    {
+        id = ms_NextResourceId++;
+    }
+    WriteResource(id, pResource, State, std::vector<D3D12_RESOURCE_STATES>());
+}
+
+void BarrierTrace::RecordRemoveResource(ID3D12Resource* pResource)
+{
+    if (!IsCapturing() || !pResource)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(ms_Mutex);
+    auto posIter = ms_ResourceIds.find(pResource);
+    if (!IsCapturing() || posIter == ms_ResourceIds.end())
+    {
+        return;
+    }
+    Write(BarrierTraceEventType::RemoveResource);
+    Write(posIter->second);
+    //the address may be reused by a new resource,which gets a new id.
+    ms_ResourceIds.erase(posIter);
+}
+
+void BarrierTrace::RecordCommandList(D3D12_COMMAND_LIST_TYPE Type, const std::vector<BarrierTraceEvent>& Events)
+{
+    if (!IsCapturing() || Events.empty())
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(ms_Mutex);
+    if (!IsCapturing())
+    {
+        return;
+    }
+    //Resources which are seen at first time are written before the commandlist,so ids are resolved at first.
+    std::vector<uint32_t> ids;
+    ids.reserve(Events.size() * 2);
+    for (const auto& event : Events)
+    {
+        ids.push_back(GetResourceId(event.pResource));
+        ids.push_back(GetResourceId(event.pResourceAfter));
+    }
+
+    Write(BarrierTraceEventType::CommandList);
+    Write(static_cast<uint8_t>(Type));
+    for (size_t i = 0; i < Events.size(); ++i)
+    {
+        const auto& event = Events[i];
+        Write(event.Type);
+        switch (event.Type)
+        {
+        case BarrierTraceEventType::Transition:
+        case BarrierTraceEventType::BeginTransition:
+            Write(ids[i * 2]);
+            Write(static_cast<uint32_t>(event.Subresource));
+            Write(static_cast<uint32_t>(event.StateAfter));
+            Write(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(event.pCallSite)));
+            break;
+        case BarrierTraceEventType::UavBarrier:
+            Write(ids[i * 2]);
+            Write(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(event.pCallSite)));
+            break;
+        case BarrierTraceEventType::AliasBarrier:
+            Write(ids[i * 2]);
+            Write(ids[i * 2 + 1]);
+            Write(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(event.pCallSite)));
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void BarrierTrace::RecordExecute(D3D12_COMMAND_LIST_TYPE Type)
+{
+    if (!IsCapturing())
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(ms_Mutex);
+    if (!IsCapturing())
+    {
+        return;
+    }
+    Write(BarrierTraceEventType::Execute);
+    Write(static_cast<uint8_t>(Type));
+}
+
+uint32_t BarrierTrace::GetResourceId(ID3D12Resource* pResource)
+{
+    if (!pResource)
+    {
+        return 0;
+    }
+    auto& id = ms_ResourceIds[pResource];
+    if (id == 0)
+    {
+        //the resource is created before the capture,its state now is the state before this commandlist.
+        id = ms_NextResourceId++;
+        D3D12_RESOURCE_STATES state;
+        std::vector<D3D12_RESOURCE_STATES> states;
+        ResourceStateTracker::SnapshotGlobalResourceState(pResource, state, states);
+        WriteResource(id, pResource, state, states);
+    }
+    return id;
+}
+
+void BarrierTrace::WriteResource(uint32_t Id, ID3D12Resource* pResource, D3D12_RESOURCE_STATES State, const std::vector<D3D12_RESOURCE_STATES>& States)
+{
+    auto desc = pResource->GetDesc();
+    Write(BarrierTraceEventType::Resource);
+    Write(Id);
+    //fields are written one by one,so the layout does not depend on padding of the struct.
+    Write(static_cast<uint32_t>(desc.Dimension));
+    Write(static_cast<uint64_t>(desc.Alignment));
+    Write(static_cast<uint64_t>(desc.Width));
+    Write(static_cast<uint32_t>(desc.Height));
+    Write(static_cast<uint16_t>(desc.DepthOrArraySize));
+    Write(static_cast<uint16_t>(desc.MipLevels));
+    Write(static_cast<uint32_t>(desc.Format));
+    Write(static_cast<uint32_t>(desc.SampleDesc.Count));
+    Write(static_cast<uint32_t>(desc.SampleDesc.Quality));
+    Write(static_cast<uint32_t>(desc.Layout));
+    Write(static_cast<uint32_t>(desc.Flags));
+    Write(static_cast<uint32_t>(States.size()));
+    if (States.empty())
+    {
+        Write(static_cast<uint32_t>(State));
+    }
+    for (auto state : States)
+    {
+        Write(static_cast<uint32_t>(state));
+    }
+}
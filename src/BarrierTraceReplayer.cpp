@@ -0,0 +1,500 @@
+#include "BarrierTraceReplayer.h"
+#include "BarrierTrace.h"
+#include "NullDevice.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <unordered_set>
+
+namespace
+{
+    const UINT gs_UnrequestedState = static_cast<UINT>(-1);
+
+    //states which only read the resource,the tracker combines them on direct commandlist.
+    const D3D12_RESOURCE_STATES gs_ReadStates = D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER
+        | D3D12_RESOURCE_STATE_INDEX_BUFFER
+        | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE
+        | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
+        | D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT
+        | D3D12_RESOURCE_STATE_COPY_SOURCE
+        | D3D12_RESOURCE_STATE_DEPTH_READ
+        | D3D12_RESOURCE_STATE_RESOLVE_SOURCE;
+
+    bool IsReadState(D3D12_RESOURCE_STATES State)
+    {
+        return State != D3D12_RESOURCE_STATE_COMMON && (State & ~gs_ReadStates) == 0;
+    }
+
+    bool IsValidCommandListType(uint8_t Type)
+    {
+        return Type == D3D12_COMMAND_LIST_TYPE_DIRECT || Type == D3D12_COMMAND_LIST_TYPE_COMPUTE || Type == D3D12_COMMAND_LIST_TYPE_COPY;
+    }
+
+    //Time calls of the tracker.
+    class TrackerTimer
+    {
+    public:
+        explicit TrackerTimer(double& Seconds)
+            : m_Seconds(Seconds), m_Start(std::chrono::high_resolution_clock::now())
+        {}
+        ~TrackerTimer()
+        {
+            m_Seconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - m_Start).count();
+        }
+    private:
+        double& m_Seconds;
+        std::chrono::high_resolution_clock::time_point m_Start;
+    };
+}
+
+BarrierTraceReplayer::BarrierTraceReplayer(Microsoft::WRL::ComPtr<ID3D12Device> pDevice /* = nullptr */)
+    : m_pDevice(pDevice)
+{
+    if (!m_pDevice)
+    {
+        //resources of a trace are never read or written,so they need no memory.
+        NullDeviceDesc desc;
+        desc.BackResourceMemory = false;
+        m_pDevice = NullDevice::Create(desc);
+    }
+    m_Trackers[D3D12_COMMAND_LIST_TYPE_DIRECT] = std::make_unique<ResourceStateTracker>(D3D12_COMMAND_LIST_TYPE_DIRECT);
+    m_Trackers[D3D12_COMMAND_LIST_TYPE_COMPUTE] = std::make_unique<ResourceStateTracker>(D3D12_COMMAND_LIST_TYPE_COMPUTE);
+    m_Trackers[D3D12_COMMAND_LIST_TYPE_COPY] = std::make_unique<ResourceStateTracker>(D3D12_COMMAND_LIST_TYPE_COPY);
+}
+
+BarrierTraceReplayer::~BarrierTraceReplayer()
+{
+    Clear();
+}
+
+BarrierTraceReplayResult BarrierTraceReplayer::Replay(const std::vector<uint8_t>& Trace)
+{
+    assert(!BarrierTrace::IsCapturing() && "Error!A barrier trace can not be replayed while capturing!");
+    BarrierTraceReplayResult result;
+    Clear();
+
+    Reader reader(Trace);
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    bool isValid = reader.Read(magic) && reader.Read(version) && magic == BarrierTrace::Magic && version == BarrierTrace::Version;
+    while (isValid && !reader.IsEnd())
+    {
+        BarrierTraceEventType type;
+        if (!reader.Read(type))
+        {
+            isValid = false;
+            break;
+        }
+        switch (type)
+        {
+        case BarrierTraceEventType::Resource:
+            isValid = ReadResource(reader, result);
+            break;
+        case BarrierTraceEventType::RemoveResource:
+        {
+            uint32_t id;
+            isValid = reader.Read(id);
+            auto posIter = m_Resources.find(id);
+            if (isValid && posIter != m_Resources.end())
+            {
+                ID3D12Resource* pResource = posIter->second.pResource.Get();
+                ResourceStateTracker::RemoveGlobalResourceState(pResource);
+                m_ResourceIds.erase(pResource);
+                m_Resources.erase(posIter);
+            }
+            break;
+        }
+        case BarrierTraceEventType::CommandList:
+            isValid = ReadCommandList(reader, result);
+            break;
+        case BarrierTraceEventType::Execute:
+        {
+            uint8_t commandListType;
+            isValid = reader.Read(commandListType) && IsValidCommandListType(commandListType);
+            if (!isValid)
+            {
+                break;
+            }
+            {
+                TrackerTimer timer(result.TrackerSeconds);
+                ResourceStateTracker::DecayResourceStates(m_DecayedStates[commandListType]);
+            }
+            //resources used on copy queue,buffers and simultaneous-access textures decay to COMMON.
+            auto& usedResources = m_UsedResources[commandListType];
+            for (auto id : usedResources)
+            {
+                auto posIter = m_Resources.find(id);
+                if (posIter != m_Resources.end()
+                    && (commandListType == D3D12_COMMAND_LIST_TYPE_COPY || posIter->second.DecaysToCommon))
+                {
+                    auto& states = posIter->second.States;
+                    std::fill(states.begin(), states.end(), D3D12_RESOURCE_STATE_COMMON);
+                }
+            }
+            usedResources.clear();
+            break;
+        }
+        default:
+            isValid = false;
+            break;
+        }
+    }
+    result.IsValid = isValid;
+
+    result.TopCallSites.reserve(m_CallSites.size());
+    for (const auto& callSite : m_CallSites)
+    {
+        result.TopCallSites.push_back(BarrierTraceReplayResult::CallSite{ callSite.first, callSite.second });
+    }
+    std::sort(result.TopCallSites.begin(), result.TopCallSites.end(),
+        [](const BarrierTraceReplayResult::CallSite& a, const BarrierTraceReplayResult::CallSite& b)
+    {
+        return a.NumRequestedBarriers > b.NumRequestedBarriers;
+    });
+    if (result.TopCallSites.size() > MaxTopCallSites)
+    {
+        result.TopCallSites.resize(MaxTopCallSites);
+    }
+
+    Clear();
+    return result;
+}
+
+bool BarrierTraceReplayer::ReadResource(Reader& reader, BarrierTraceReplayResult& Result)
+{
+    uint32_t id, dimension, height, format, sampleCount, sampleQuality, layout, flags, numStates;
+    uint64_t alignment, width;
+    uint16_t depthOrArraySize, mipLevels;
+    if (!reader.Read(id) || !reader.Read(dimension) || !reader.Read(alignment) || !reader.Read(width) || !reader.Read(height)
+        || !reader.Read(depthOrArraySize) || !reader.Read(mipLevels) || !reader.Read(format) || !reader.Read(sampleCount)
+        || !reader.Read(sampleQuality) || !reader.Read(layout) || !reader.Read(flags) || !reader.Read(numStates))
+    {
+        return false;
+    }
+    if (numStates > D3D12_REQ_SUBRESOURCES)
+    {
+        return false;
+    }
+    std::vector<D3D12_RESOURCE_STATES> states((std::max)(numStates, 1u));
+    for (auto& state : states)
+    {
+        uint32_t value;
+        if (!reader.Read(value))
+        {
+            return false;
+        }
+        state = static_cast<D3D12_RESOURCE_STATES>(value);
+    }
+
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = static_cast<D3D12_RESOURCE_DIMENSION>(dimension);
+    desc.Alignment = alignment;
+    desc.Width = width;
+    desc.Height = height;
+    desc.DepthOrArraySize = depthOrArraySize;
+    desc.MipLevels = mipLevels;
+    desc.Format = static_cast<DXGI_FORMAT>(format);
+    desc.SampleDesc.Count = sampleCount;
+    desc.SampleDesc.Quality = sampleQuality;
+    desc.Layout = static_cast<D3D12_TEXTURE_LAYOUT>(layout);
+    desc.Flags = static_cast<D3D12_RESOURCE_FLAGS>(flags);
+
+    //A resource which is added again with the same id gets a new state,so it is created again.
+    auto posIter = m_Resources.find(id);
+    if (posIter != m_Resources.end())
+    {
+        ResourceStateTracker::RemoveGlobalResourceState(posIter->second.pResource.Get());
+        m_ResourceIds.erase(posIter->second.pResource.Get());
+        m_Resources.erase(posIter);
+    }
+
+    ShadowResource shadowResource;
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+    if (FAILED(m_pDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COMMON, nullptr,
+        IID_PPV_ARGS(&shadowResource.pResource))))
+    {
+        return false;
+    }
+    ID3D12Resource* pResource = shadowResource.pResource.Get();
+    shadowResource.DecaysToCommon = desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER
+        || (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS) != 0;
+    UINT numSubResources = desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER ? 1 : CD3DX12_RESOURCE_DESC(desc).Subresources(m_pDevice.Get());
+    //subresource states must match the resource which is created again.
+    if (numStates != 0 && numStates != numSubResources)
+    {
+        return false;
+    }
+    shadowResource.States.assign(numSubResources, states[0]);
+    if (numStates == 0)
+    {
+        states.clear();
+    }
+    else
+    {
+        shadowResource.States = states;
+    }
+
+    ResourceStateTracker::RestoreGlobalResourceState(pResource, shadowResource.States[0], states);
+    m_ResourceIds[pResource] = id;
+    m_Resources.emplace(id, std::move(shadowResource));
+    ++Result.NumResources;
+    return true;
+}
+
+bool BarrierTraceReplayer::ReadCommandList(Reader& reader, BarrierTraceReplayResult& Result)
+{
+    uint8_t type;
+    if (!reader.Read(type) || !IsValidCommandListType(type))
+    {
+        return false;
+    }
+    auto commandListType = static_cast<D3D12_COMMAND_LIST_TYPE>(type);
+    auto& tracker = *m_Trackers[type];
+    std::vector<D3D12_RESOURCE_BARRIER> validBarriers;
+    std::vector<D3D12_RESOURCE_BARRIER> pendingBarriers;
+    //the last state which is asked for each subresource.
+    std::unordered_map<uint32_t, std::vector<UINT>> requestedStates;
+
+    for (;;)
+    {
+        BarrierTraceEventType eventType;
+        if (!reader.Read(eventType))
+        {
+            return false;
+        }
+        switch (eventType)
+        {
+        case BarrierTraceEventType::Transition:
+        case BarrierTraceEventType::BeginTransition:
+        {
+            uint32_t id, subResource, stateAfter;
+            uint64_t callSite;
+            if (!reader.Read(id) || !reader.Read(subResource) || !reader.Read(stateAfter) || !reader.Read(callSite))
+            {
+                return false;
+            }
+            auto posIter = m_Resources.find(id);
+            if (posIter == m_Resources.end())
+            {
+                return false;
+            }
+            auto& shadowResource = posIter->second;
+            auto numSubResources = static_cast<UINT>(shadowResource.States.size());
+            if (subResource != D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES && subResource >= numSubResources)
+            {
+                return false;
+            }
+            {
+                TrackerTimer timer(Result.TrackerSeconds);
+                if (eventType == BarrierTraceEventType::Transition)
+                {
+                    tracker.TransitionResource(shadowResource.pResource.Get(), static_cast<D3D12_RESOURCE_STATES>(stateAfter), subResource);
+                }
+                else
+                {
+                    tracker.BeginTransitionResource(shadowResource.pResource.Get(), static_cast<D3D12_RESOURCE_STATES>(stateAfter), subResource);
+                }
+            }
+            auto& requested = requestedStates[id];
+            if (requested.empty())
+            {
+                requested.assign(numSubResources, gs_UnrequestedState);
+            }
+            if (subResource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+            {
+                std::fill(requested.begin(), requested.end(), stateAfter);
+            }
+            else
+            {
+                requested[subResource] = stateAfter;
+            }
+            ++Result.NumRequestedBarriers;
+            ++m_CallSites[callSite];
+            break;
+        }
+        case BarrierTraceEventType::UavBarrier:
+        {
+            uint32_t id;
+            uint64_t callSite;
+            if (!reader.Read(id) || !reader.Read(callSite))
+            {
+                return false;
+            }
+            {
+                TrackerTimer timer(Result.TrackerSeconds);
+                tracker.ResourceBarrier(CD3DX12_RESOURCE_BARRIER::UAV(GetResource(id)));
+            }
+            ++Result.NumRequestedBarriers;
+            ++m_CallSites[callSite];
+            break;
+        }
+        case BarrierTraceEventType::AliasBarrier:
+        {
+            uint32_t idBefore, idAfter;
+            uint64_t callSite;
+            if (!reader.Read(idBefore) || !reader.Read(idAfter) || !reader.Read(callSite))
+            {
+                return false;
+            }
+            {
+                TrackerTimer timer(Result.TrackerSeconds);
+                tracker.ResourceBarrier(CD3DX12_RESOURCE_BARRIER::Aliasing(GetResource(idBefore), GetResource(idAfter)));
+            }
+            ++Result.NumRequestedBarriers;
+            ++m_CallSites[callSite];
+            break;
+        }
+        case BarrierTraceEventType::Flush:
+        {
+            TrackerTimer timer(Result.TrackerSeconds);
+            tracker.FlushValidResourceBarrier(validBarriers);
+            break;
+        }
+        case BarrierTraceEventType::EndSplitBarriers:
+        {
+            TrackerTimer timer(Result.TrackerSeconds);
+            tracker.EndSplitBarriers();
+            break;
+        }
+        case BarrierTraceEventType::Close:
+        {
+            {
+                TrackerTimer timer(Result.TrackerSeconds);
+                //same steps with CommandList::Close().
+                tracker.EndSplitBarriers();
+                tracker.FlushValidResourceBarrier(validBarriers);
+                tracker.FlushPendingResourceBarrier(pendingBarriers);
+                std::unordered_set<ID3D12Resource*> committedResources;
+                tracker.CommitFinalResourceState(committedResources, nullptr, 0, m_DecayedStates[type]);
+                tracker.Reset();
+            }
+            ++Result.NumCommandLists;
+            Result.NumIssuedBarriers += validBarriers.size() + pendingBarriers.size();
+            Result.NumPendingBarriers += pendingBarriers.size();
+
+            //pending barriers are recorded into a barrier commandlist which runs before this one.
+            ApplyBarriers(pendingBarriers, commandListType, Result);
+            ApplyBarriers(validBarriers, commandListType, Result);
+
+            for (const auto& requested : requestedStates)
+            {
+                auto& shadowResource = m_Resources[requested.first];
+                m_UsedResources[type].push_back(requested.first);
+                for (UINT subResource = 0; subResource < requested.second.size(); ++subResource)
+                {
+                    if (requested.second[subResource] == gs_UnrequestedState)
+                    {
+                        continue;
+                    }
+                    auto expected = static_cast<D3D12_RESOURCE_STATES>(requested.second[subResource]);
+                    auto actual = shadowResource.States[subResource];
+                    //the tracker may leave a subresource in a combined read state,or let the runtime promote it.
+                    bool isExpected = actual == expected
+                        || (IsReadState(expected) && IsReadState(actual) && (actual & expected) == expected)
+                        || (actual == D3D12_RESOURCE_STATE_COMMON && CanPromote(shadowResource, expected));
+                    if (!isExpected)
+                    {
+                        AddError(Result, "the subresource is not in the state asked for at the end of commandlist", requested.first, subResource,
+                            expected, actual);
+                    }
+                }
+            }
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+}
+
+ID3D12Resource* BarrierTraceReplayer::GetResource(uint32_t Id)const
+{
+    auto posIter = m_Resources.find(Id);
+    return posIter != m_Resources.end() ? posIter->second.pResource.Get() : nullptr;
+}
+
+void BarrierTraceReplayer::ApplyBarriers(const std::vector<D3D12_RESOURCE_BARRIER>& Barriers, D3D12_COMMAND_LIST_TYPE Type, BarrierTraceReplayResult& Result)
+{
+    for (const auto& barrier : Barriers)
+    {
+        if (barrier.Type != D3D12_RESOURCE_BARRIER_TYPE_TRANSITION)
+        {
+            continue;
+        }
+        const auto& transition = barrier.Transition;
+        auto idIter = m_ResourceIds.find(transition.pResource);
+        if (idIter == m_ResourceIds.end())
+        {
+            continue;
+        }
+        auto& shadowResource = m_Resources[idIter->second];
+        m_UsedResources[Type].push_back(idIter->second);
+        //the state is changed when a split barrier begins,the end only finishes it.
+        if (barrier.Flags == D3D12_RESOURCE_BARRIER_FLAG_END_ONLY)
+        {
+            continue;
+        }
+        auto numSubResources = static_cast<UINT>(shadowResource.States.size());
+        UINT firstSubResource = transition.Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES ? 0 : transition.Subresource;
+        UINT lastSubResource = transition.Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES ? numSubResources : transition.Subresource + 1;
+        for (UINT subResource = firstSubResource; subResource < lastSubResource && subResource < numSubResources; ++subResource)
+        {
+            auto& state = shadowResource.States[subResource];
+            if (transition.StateBefore != state
+                && !(state == D3D12_RESOURCE_STATE_COMMON && CanPromote(shadowResource, transition.StateBefore)))
+            {
+                AddError(Result, "the state before of a transition is wrong", idIter->second, subResource, state, transition.StateBefore);
+            }
+            state = transition.StateAfter;
+        }
+    }
+}
+
+bool BarrierTraceReplayer::CanPromote(const ShadowResource& Resource, D3D12_RESOURCE_STATES State)
+{
+    if (Resource.DecaysToCommon)
+    {
+        return true;
+    }
+    //other textures are only promoted to shader resource and copy source states,or to copy dest.
+    const D3D12_RESOURCE_STATES readStates = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE
+        | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
+        | D3D12_RESOURCE_STATE_COPY_SOURCE;
+    return (State != D3D12_RESOURCE_STATE_COMMON && (State & ~readStates) == 0) || State == D3D12_RESOURCE_STATE_COPY_DEST;
+}
+
+void BarrierTraceReplayer::AddError(BarrierTraceReplayResult& Result, const char* pMessage, uint32_t Id, UINT Subresource,
+    D3D12_RESOURCE_STATES Expected, D3D12_RESOURCE_STATES Actual)
+{
+    ++Result.NumStateErrors;
+    if (Result.Errors.size() < MaxErrors)
+    {
+        char error[256];
+        std::snprintf(error, sizeof(error), "commandlist %llu,resource %u,subresource %u:%s(expected 0x%X,actual 0x%X).",
+            static_cast<unsigned long long>(Result.NumCommandLists), Id, Subresource, pMessage,
+            static_cast<UINT>(Expected), static_cast<UINT>(Actual));
+        Result.Errors.push_back(error);
+    }
+}
+
+void BarrierTraceReplayer::Clear()
+{
+    for (size_t type = 0; type < NumCommandListTypes; ++type)
+    {
+        if (m_Trackers[type])
+        {
+            m_Trackers[type]->Reset();
+        }
+        m_DecayedStates[type].clear();
+        m_UsedResources[type].clear();
+    }
+    for (const auto& resource : m_Resources)
+    {
+        ResourceStateTracker::RemoveGlobalResourceState(resource.second.pResource.Get());
+    }
+    m_Resources.clear();
+    m_ResourceIds.clear();
+    m_CallSites.clear();
+}
@@ -0,0 +1,53 @@
+#include "BindlessDescriptorHeap.h"
+#include "DescriptorAllocatorPage.h"
+#include "Application.h"
+#include "d3dx12.h"
+
+#include <cassert>
+#include <new>
+
+BindlessDescriptorHeap::BindlessDescriptorHeap(UINT NumDescriptors /* = 1 << 17 */)
+    : m_pPage(std::make_shared<DescriptorAllocatorPage>(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, NumDescriptors, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE))
+    , m_NumDescriptors(NumDescriptors)
+    , m_DescriptorIncrementSize(Application::GetApp()->GetDescriptorIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV))
+{
+    m_CpuHeapStart = m_pPage->GetD3D12DescriptorHeap()->GetCPUDescriptorHandleForHeapStart();
+    m_GpuHeapStart = m_pPage->GetD3D12DescriptorHeap()->GetGPUDescriptorHandleForHeapStart();
+}
+
+BindlessDescriptorHeap::~BindlessDescriptorHeap()
+{}
+
+DescriptorAllocation BindlessDescriptorHeap::Allocate(UINT NumDescriptors /* = 1 */)
+{
+    auto allocation = m_pPage->Allocate(NumDescriptors);
+    //there is no other heap to fall back to,since all command lists bind this heap.
+    if (allocation.IsNull())
+    {
+        throw std::bad_alloc();
+    }
+    return allocation;
+}
+
+UINT BindlessDescriptorHeap::GetIndex(D3D12_CPU_DESCRIPTOR_HANDLE Descriptor)const
+{
+    assert(Descriptor.ptr >= m_CpuHeapStart.ptr && "Error!The descriptor is not allocated from bindless heap!");
+    UINT index = static_cast<UINT>((Descriptor.ptr - m_CpuHeapStart.ptr) / m_DescriptorIncrementSize);
+    assert(index < m_NumDescriptors && "Error!The descriptor is not allocated from bindless heap!");
+    return index;
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE BindlessDescriptorHeap::GetGpuDescriptorHandle(D3D12_CPU_DESCRIPTOR_HANDLE Descriptor)const
+{
+    return CD3DX12_GPU_DESCRIPTOR_HANDLE(m_GpuHeapStart, GetIndex(Descriptor), m_DescriptorIncrementSize);
+}
+
+ID3D12DescriptorHeap* BindlessDescriptorHeap::GetD3D12DescriptorHeap()const
+{
+    return m_pPage->GetD3D12DescriptorHeap();
+}
+
+TLSFStatistics BindlessDescriptorHeap::GetStatistics()
+{
+    return m_pPage->GetStatistics();
+}
@@ -13,12 +13,17 @@
 #include "Model.h"
 #include "Scene.h"
 #include "Environment.h"
-#include "DDSTextureLoader.h"
 #include "FrustumCulling.h"
 #include "GenerateSAT.h"
 #include "Pass.h"
+#include "CommandQueue.h"
+#include "BindlessDescriptorHeap.h"
+#include "ViewCache.h"
+#include "ResourceHeapAllocator.h"
 
+#include <algorithm>
 #include <filesystem>
+#include <stdexcept>
 #include <DirectXTex.h>
 
 std::unordered_map<std::wstring, Texture*> CommandList::m_TextureResourceMap;
@@ -28,14 +33,21 @@ std::mutex CommandList::ms_TextureCacheMutex;
 CommandList::CommandList(D3D12_COMMAND_LIST_TYPE Type)
     :m_d3d12GraphicsCommandList2(nullptr)
     , m_d3d12CommandListType(Type)
-    , m_pResourceStateTracker(std::make_unique<ResourceStateTracker>())
+    , m_pResourceStateTracker(std::make_unique<ResourceStateTracker>(Type))
     , m_pDynamicUploadBuffer(std::make_unique<UploadBuffer>())
     , m_d3d12RootSignature(nullptr)
     , m_d3d12PipelineState(nullptr)
 {
     for (int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
     {
-        m_pDynamicDescriptorHeap[i] = std::make_unique<DynamicDescriptorHeap>(static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(i));
+        //Committed cbv_srv_uav tables are cached in their heap across frames,so a bigger heap keeps more of them.
+        //In bindless mode the heap is a block of bindless heap,which is shared by all commandlists.
+        UINT heapSize = 1024;
+        if (i == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV && !Application::GetApp()->GetBindlessDescriptorHeap())
+        {
+            heapSize = 8192;
+        }
+        m_pDynamicDescriptorHeap[i] = std::make_unique<DynamicDescriptorHeap>(static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(i), heapSize);
         m_pCurrentDescriptorHeap[i] = nullptr;
     }
 
@@ -46,8 +58,8 @@ CommandList::CommandList(D3D12_COMMAND_LIST_TYPE Type)
     //ThrowIfFailed(m_d3d12GraphicsCommandList2->Close());
     //Since we will use this commandlist immediately,so we do not Close() this commandlist.
 
-    //here we just initialize compute commandlist to nullptr.
-    m_pComputeCommandList = nullptr;
+    //here we just initialize copy commandlist to nullptr.
+    m_pCopyCommandList = nullptr;
     m_pGenerateMips = nullptr;
 }
 
@@ -59,7 +71,7 @@ void CommandList::BarrierTransition(const Resource* pResource, D3D12_RESOURCE_ST
 {
     if (pResource)
     {
-        m_pResourceStateTracker->TransitionResource(pResource, StateAfter, subResource);
+        m_pResourceStateTracker->TransitionResource(pResource, StateAfter, subResource, BARRIER_TRACE_CALL_SITE());
     }
 
     if (IsFlushBarrier)
@@ -68,10 +80,15 @@ void CommandList::BarrierTransition(const Resource* pResource, D3D12_RESOURCE_ST
     }
 }
 
+void CommandList::BarrierTransitionBegin(const Resource* pResource, D3D12_RESOURCE_STATES StateAfter, UINT subResource /* = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES */)
+{
+    m_pResourceStateTracker->BeginTransitionResource(pResource, StateAfter, subResource, BARRIER_TRACE_CALL_SITE());
+}
+
 void CommandList::BarrierAlias(const Resource* pResourceBefore, const Resource* pResourceAfter, bool IsFlushBarrier /* = false */)
 {
     //Since ResourceStateTracker will check pResourceBefore and pResourceAfter,so we need not to check here. 
-    m_pResourceStateTracker->AliasBarrier(pResourceBefore, pResourceAfter);
+    m_pResourceStateTracker->AliasBarrier(pResourceBefore, pResourceAfter, BARRIER_TRACE_CALL_SITE());
 
     if (IsFlushBarrier)
     {
@@ -82,7 +99,7 @@ void CommandList::BarrierAlias(const Resource* pResourceBefore, const Resource*
 void CommandList::BarrierUAV(const Resource* pResource, bool IsFlushBarrier /* = false */)
 {
     //Since ResourceStateTracker will check pResource,so we need not to check here. 
-    m_pResourceStateTracker->UavBarrier(pResource);
+    m_pResourceStateTracker->UavBarrier(pResource, BARRIER_TRACE_CALL_SITE());
 
     if (IsFlushBarrier)
     {
@@ -124,10 +141,6 @@ void CommandList::CopyResource( Resource* pDstResource,const Resource* pSrcResou
         FlushResourceBarrier();
         //then we start to copy
         m_d3d12GraphicsCommandList2->CopyResource(pDstResource->GetD3D12Resource().Get(), pSrcResource->GetD3D12Resource().Get());
-
-        //add resources to tracker
-        AddResourceTracker(pDstResource);
-        AddResourceTracker(pSrcResource);
     }
 }
 
@@ -139,28 +152,14 @@ void CommandList::CopyTextureSubResource(const Texture* pResource, UINT firstSub
         FlushResourceBarrier();
 
         auto dstResource = pResource->GetD3D12Resource();
-        auto device = Application::GetApp()->GetDevice();
-
-        Microsoft::WRL::ComPtr<ID3D12Resource> intermediateResource;
 
         UINT64 requiredBufferSize = GetRequiredIntermediateSize(dstResource.Get(), firstSubResource, numSubResources);
+        //intermediate data lives in the upload ring buffer until this command list retires,
+        //and small copies of one command list are packed next to each other.
+        auto intermediate = m_pDynamicUploadBuffer->Allocate(requiredBufferSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
 
-        ThrowIfFailed(device->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(requiredBufferSize),
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&intermediateResource)));
-
-        ResourceStateTracker::AddGlobalResourceState(intermediateResource.Get(), D3D12_RESOURCE_STATE_GENERIC_READ);
-        FlushResourceBarrier();
-        
-        UpdateSubresources(m_d3d12GraphicsCommandList2.Get(), dstResource.Get(), intermediateResource.Get(), 0, firstSubResource,
+        UpdateSubresources(m_d3d12GraphicsCommandList2.Get(), dstResource.Get(), intermediate.Resource, intermediate.Offset, firstSubResource,
             numSubResources, pSubResourceData);
-
-        AddObjectTracker(dstResource);
-        AddObjectTracker(intermediateResource);
     }
 }
 
@@ -173,9 +172,6 @@ void CommandList::ResolveSubResource(Resource* pDstResource, const Resource* pSr
 
     m_d3d12GraphicsCommandList2->ResolveSubresource(
         pDstResource->GetD3D12Resource().Get(), DstSubResource, pSrcResource->GetD3D12Resource().Get(), SrcSubResource, pDstResource->GetD3D12ResourceDesc().Format);
-
-    AddResourceTracker(pDstResource);
-    AddResourceTracker(pSrcResource);
 }
 
 void CommandList::SetGraphicsDynamicConstantBuffer(UINT rootParameterIndex,UINT SizeInByte , const void* pMappedData)
@@ -273,7 +269,6 @@ void CommandList::SetShaderResourceView(
             offsetInTable,
             1);
     }
-    AddResourceTracker(pResource);
 }
 
 void CommandList::SetUnorderedAccessView(
@@ -311,10 +306,10 @@ void CommandList::SetSamplers( UINT rootParameterIndex,UINT offsetInTable ,const
 {
     if (pSamplerDesc)
     {
-        auto allocation = Application::GetApp()->AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, 1);
-        Application::GetApp()->GetDevice()->CreateSampler(pSamplerDesc, allocation.GetDescriptorHandle());
+        //same descs share one sampler,so staged sampler tables can be reused by the table cache too.
+        auto handle = Application::GetApp()->GetViewCache()->GetSampler(*pSamplerDesc);
 
-        m_pDynamicDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER]->StageDescriptors(allocation.GetDescriptorHandle(), rootParameterIndex, offsetInTable, 1);
+        m_pDynamicDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER]->StageDescriptors(handle, rootParameterIndex, offsetInTable, 1);
     }
 }
 
@@ -370,6 +365,21 @@ void CommandList::SetGraphicsRootSignature(const RootSignature* pRootSignature)
             }
 
             m_d3d12GraphicsCommandList2->SetGraphicsRootSignature(pRootSignature->GetRootSignature().Get());
+            //Bindless tables always point to the start of bindless heap,so they are bound only once with root signature.
+            UINT bindlessTableMask = pRootSignature->GetBindlessTableBitMask();
+            if (bindlessTableMask)
+            {
+                auto pBindlessHeap = Application::GetApp()->GetBindlessDescriptorHeap();
+                assert(pBindlessHeap && "Error!The root signature has bindless table,but bindless mode is off!");
+                SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, pBindlessHeap->GetD3D12DescriptorHeap());
+
+                DWORD rootIndex = 0;
+                while (_BitScanForward(&rootIndex, bindlessTableMask))
+                {
+                    m_d3d12GraphicsCommandList2->SetGraphicsRootDescriptorTable(rootIndex, pBindlessHeap->GetGpuHeapStart());
+                    bindlessTableMask ^= (1 << rootIndex);
+                }
+            }
 
             AddObjectTracker(m_d3d12RootSignature);
         }
@@ -391,6 +401,21 @@ void CommandList::SetComputeRootSignature(const RootSignature* pComputeRootSigna
             }
 
             m_d3d12GraphicsCommandList2->SetComputeRootSignature(pComputeRootSignature->GetRootSignature().Get());
+            //Bindless tables always point to the start of bindless heap,so they are bound only once with root signature.
+            UINT bindlessTableMask = pComputeRootSignature->GetBindlessTableBitMask();
+            if (bindlessTableMask)
+            {
+                auto pBindlessHeap = Application::GetApp()->GetBindlessDescriptorHeap();
+                assert(pBindlessHeap && "Error!The root signature has bindless table,but bindless mode is off!");
+                SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, pBindlessHeap->GetD3D12DescriptorHeap());
+
+                DWORD rootIndex = 0;
+                while (_BitScanForward(&rootIndex, bindlessTableMask))
+                {
+                    m_d3d12GraphicsCommandList2->SetComputeRootDescriptorTable(rootIndex, pBindlessHeap->GetGpuHeapStart());
+                    bindlessTableMask ^= (1 << rootIndex);
+                }
+            }
 
             AddObjectTracker(m_d3d12RootSignature);
         }
@@ -421,8 +446,8 @@ void CommandList::SetD3D12PipelineState(Microsoft::WRL::ComPtr<ID3D12PipelineSta
         {
             m_d3d12PipelineState = pipelineState;
             m_d3d12GraphicsCommandList2->SetPipelineState(m_d3d12PipelineState.Get());
+            AddObjectTracker(pipelineState);
         }
-        AddObjectTracker(pipelineState);
     }
 }
 
@@ -434,8 +459,6 @@ void CommandList::ClearRenderTargetTexture(const Texture* pTexture, const float
         BarrierTransition(pTexture, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, isFlushBarrier);
 
         m_d3d12GraphicsCommandList2->ClearRenderTargetView(pTexture->GetRenderTargetView(), ClearColor, 0, nullptr);
-
-        AddResourceTracker(pTexture);
     }
 }
 
@@ -447,8 +470,6 @@ void CommandList::ClearDepthStencilTexture(const Texture* pTexture, D3D12_CLEAR_
         BarrierTransition(pTexture, D3D12_RESOURCE_STATE_DEPTH_WRITE);
 
         m_d3d12GraphicsCommandList2->ClearDepthStencilView(pTexture->GetDepthStencilView(), Flags, depth, stencil, 0, nullptr);
-
-        AddResourceTracker(pTexture);
     }
 }
 
@@ -483,107 +504,101 @@ void CommandList::LoadTextureFromFile(Texture* pTexture, const std::wstring& fil
         //    pTexture->SetTextureUsage(textureUsage);
         //    pTexture->SetName(filename);
         //}
-        //else
-        if(!IsCubeMap)
+        std::filesystem::path filepath(filename);
+        if (!std::filesystem::exists(filepath))
         {
-            std::filesystem::path filepath(filename);
-            if (!std::filesystem::exists(filepath))
-            {
-                throw std::exception("This texture can not be found under this file load.");
-            }
-
-            DirectX::TexMetadata metadata;
-            DirectX::ScratchImage scratchImage;
-            if (filepath.extension() == ".dds")
-            {
-                ThrowIfFailed(DirectX::LoadFromDDSFile(filename.c_str(), DirectX::DDS_FLAGS_FORCE_RGB, &metadata, scratchImage));
-            }
-            else if (filepath.extension() == ".tga")
-            {
-                ThrowIfFailed(DirectX::LoadFromTGAFile(filename.c_str(), &metadata, scratchImage));
-            }
-            else if (filepath.extension() == ".hdr")
-            {
-                ThrowIfFailed(DirectX::LoadFromHDRFile(filename.c_str(), &metadata, scratchImage));
-            }
-            else
-            {
-                ThrowIfFailed(DirectX::LoadFromWICFile(filename.c_str(), DirectX::WIC_FLAGS_FORCE_RGB, &metadata, scratchImage));
-            }
-
-            DXGI_FORMAT format = metadata.format;
-            if (textureUsage == TextureUsage::Diffuse)
-            {
-                format = DirectX::MakeSRGB(format);
-            }
-            D3D12_RESOURCE_DESC texDesc = {};
-
-            switch (metadata.dimension)
-            {
-            case DirectX::TEX_DIMENSION_TEXTURE1D:
-                texDesc = CD3DX12_RESOURCE_DESC::Tex1D(format, (UINT64)metadata.width, (UINT16)metadata.arraySize);
-                break;
-            case DirectX::TEX_DIMENSION_TEXTURE2D:
-                texDesc = CD3DX12_RESOURCE_DESC::Tex2D(format, (UINT64)metadata.width, (UINT)metadata.height, (UINT16)metadata.arraySize);
-                break;
-            case DirectX::TEX_DIMENSION_TEXTURE3D:
-                texDesc = CD3DX12_RESOURCE_DESC::Tex3D(format, (UINT64)metadata.width, (UINT)metadata.height, (UINT16)metadata.depth);
-                break;
-            }
+            throw std::runtime_error("This texture can not be found under this file load.");
+        }
 
-            Microsoft::WRL::ComPtr<ID3D12Resource> textureResource;
-            auto device = Application::GetApp()->GetDevice();
-
-            ThrowIfFailed(device->CreateCommittedResource(
-                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-                D3D12_HEAP_FLAG_NONE,
-                &texDesc,
-                D3D12_RESOURCE_STATE_COMMON,
-                nullptr,
-                IID_PPV_ARGS(&textureResource)));
-            //Add new d3d12 resource to global resource state tracker for managing resource state.
-            ResourceStateTracker::AddGlobalResourceState(textureResource.Get(), D3D12_RESOURCE_STATE_COMMON);
-            //set texture configuration information
-            pTexture->SetD3D12Resource(textureResource);
-            pTexture->SetName(filename);
-            pTexture->SetTextureUsage(textureUsage);
-            //set subresourcedata vector of this texture.
-            std::vector<D3D12_SUBRESOURCE_DATA> subResourceData(scratchImage.GetImageCount());
-            const DirectX::Image* image = scratchImage.GetImages();
-            for (size_t i = 0; i < subResourceData.size(); ++i)
-            {
-                subResourceData[i].pData = image[i].pixels;
-                subResourceData[i].RowPitch = image[i].rowPitch;
-                subResourceData[i].SlicePitch = image[i].slicePitch;
-            }
-            //Copy pixel information to Texture default heap.
-            CopyTextureSubResource(pTexture, 0, (UINT)subResourceData.size(), subResourceData.data());
-            //Here we need to check if generate mipmaps for this texture
-            if (subResourceData.size() < textureResource->GetDesc().MipLevels)
-            {
-                GenerateMipMaps(pTexture);
-            }
-            //Update global texture map
-            m_TextureResourceMap[filename] = pTexture;
-            //-----------------------------------------
-            std::lock_guard<std::mutex> lock(ms_TextureCacheMutex);
-            //------------------------------------------
+        DirectX::TexMetadata metadata;
+        DirectX::ScratchImage scratchImage;
+        //cube maps are only stored in dds files,they keep their formats and mips.
+        if (IsCubeMap)
+        {
+            assert(filepath.extension() == ".dds" && "Error!Cube maps must be dds files!");
+            ThrowIfFailed(DirectX::LoadFromDDSFile(filename.c_str(), DirectX::DDS_FLAGS_NONE, &metadata, scratchImage));
+            assert(metadata.IsCubemap() && "Error!This dds file is not a cube map!");
+        }
+        else if (filepath.extension() == ".dds")
+        {
+            ThrowIfFailed(DirectX::LoadFromDDSFile(filename.c_str(), DirectX::DDS_FLAGS_FORCE_RGB, &metadata, scratchImage));
+        }
+        else if (filepath.extension() == ".tga")
+        {
+            ThrowIfFailed(DirectX::LoadFromTGAFile(filename.c_str(), &metadata, scratchImage));
+        }
+        else if (filepath.extension() == ".hdr")
+        {
+            ThrowIfFailed(DirectX::LoadFromHDRFile(filename.c_str(), &metadata, scratchImage));
         }
         else
         {
-            Microsoft::WRL::ComPtr<ID3D12Resource> textureResource;
-            Microsoft::WRL::ComPtr<ID3D12Resource> uploadResource;
+#if defined(_WIN32)
+            ThrowIfFailed(DirectX::LoadFromWICFile(filename.c_str(), DirectX::WIC_FLAGS_FORCE_RGB, &metadata, scratchImage));
+#else
+            throw std::runtime_error("Only dds,tga and hdr textures can be loaded without wic.");
+#endif
+        }
 
-            ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(Application::GetApp()->GetDevice().Get(),
-                m_d3d12GraphicsCommandList2.Get(), filename.c_str(), textureResource, uploadResource));
+        DXGI_FORMAT format = metadata.format;
+        if (textureUsage == TextureUsage::Diffuse)
+        {
+            format = DirectX::MakeSRGB(format);
+        }
+        D3D12_RESOURCE_DESC texDesc = {};
 
-            pTexture->SetD3D12Resource(textureResource);
-            pTexture->SetName(filename);
-            pTexture->SetTextureUsage(textureUsage);
+        switch (metadata.dimension)
+        {
+        case DirectX::TEX_DIMENSION_TEXTURE1D:
+            texDesc = CD3DX12_RESOURCE_DESC::Tex1D(format, (UINT64)metadata.width, (UINT16)metadata.arraySize);
+            break;
+        case DirectX::TEX_DIMENSION_TEXTURE2D:
+            texDesc = CD3DX12_RESOURCE_DESC::Tex2D(format, (UINT64)metadata.width, (UINT)metadata.height, (UINT16)metadata.arraySize,
+                IsCubeMap ? (UINT16)metadata.mipLevels : 0);
+            break;
+        case DirectX::TEX_DIMENSION_TEXTURE3D:
+            texDesc = CD3DX12_RESOURCE_DESC::Tex3D(format, (UINT64)metadata.width, (UINT)metadata.height, (UINT16)metadata.depth);
+            break;
+        }
 
-            AddObjectTracker(textureResource);
-            AddObjectTracker(uploadResource);
+        auto textureResource = Application::GetApp()->GetResourceHeapAllocator()->CreateResource(
+            texDesc,
+            D3D12_RESOURCE_STATE_COMMON);
+        //Add new d3d12 resource to global resource state tracker for managing resource state.
+        ResourceStateTracker::AddGlobalResourceState(textureResource.Get(), D3D12_RESOURCE_STATE_COMMON);
+        //set texture configuration information
+        pTexture->SetD3D12Resource(textureResource);
+        pTexture->SetName(filename);
+        pTexture->SetTextureUsage(textureUsage);
+        //set subresourcedata vector of this texture.
+        std::vector<D3D12_SUBRESOURCE_DATA> subResourceData(scratchImage.GetImageCount());
+        const DirectX::Image* image = scratchImage.GetImages();
+        for (size_t i = 0; i < subResourceData.size(); ++i)
+        {
+            subResourceData[i].pData = image[i].pixels;
+            subResourceData[i].RowPitch = image[i].rowPitch;
+            subResourceData[i].SlicePitch = image[i].slicePitch;
+        }
+        //Copy pixel information to Texture default heap.
+        //A new texture is uploaded on copy queue,commandlists wait for the copy only when they use this texture.
+        if (m_d3d12CommandListType != D3D12_COMMAND_LIST_TYPE_COPY)
+        {
+            RequestUploadCommandList()->CopyTextureSubResource(pTexture, 0, (UINT)subResourceData.size(), subResourceData.data());
+        }
+        else
+        {
+            CopyTextureSubResource(pTexture, 0, (UINT)subResourceData.size(), subResourceData.data());
+        }
+        //Here we need to check if generate mipmaps for this texture
+        if (subResourceData.size() < textureResource->GetDesc().MipLevels)
+        {
+            GenerateMipMaps(pTexture);
         }
+        //Update global texture map
+        m_TextureResourceMap[filename] = pTexture;
+        //-----------------------------------------
+        std::lock_guard<std::mutex> lock(ms_TextureCacheMutex);
+        //------------------------------------------
     }
 }
 
@@ -592,10 +607,18 @@ void CommandList::SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE heapType, ID3D12D
     if (m_pCurrentDescriptorHeap[heapType] != descriptorHeap)
     {
         m_pCurrentDescriptorHeap[heapType] = descriptorHeap;
-        //then we reset descriptor heap
-        ID3D12DescriptorHeap* heap[] = { descriptorHeap };
+        //SetDescriptorHeaps() unbinds heaps which are not in the array,so all current heaps are set together.
+        ID3D12DescriptorHeap* heaps[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+        UINT numHeaps = 0;
+        for (int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
+        {
+            if (m_pCurrentDescriptorHeap[i])
+            {
+                heaps[numHeaps++] = m_pCurrentDescriptorHeap[i];
+            }
+        }
 
-        m_d3d12GraphicsCommandList2->SetDescriptorHeaps(_countof(heap), heap);
+        m_d3d12GraphicsCommandList2->SetDescriptorHeaps(numHeaps, heaps);
     }
 }
 
@@ -603,37 +626,27 @@ void CommandList::CopyBuffer(Buffer* buffer, UINT bufferSize, UINT elementByteSi
 {
     if (buffer && pBufferData)
     {
-        Microsoft::WRL::ComPtr<ID3D12Resource> defaultBuffer;
-        Microsoft::WRL::ComPtr<ID3D12Resource> intermediateBuffer;
-        auto device = Application::GetApp()->GetDevice();
-        ThrowIfFailed(device->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(bufferSize * elementByteSize),
-            D3D12_RESOURCE_STATE_COPY_DEST,
-            nullptr,
-            IID_PPV_ARGS(&defaultBuffer)));
-        ThrowIfFailed(device->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(bufferSize * elementByteSize),
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&intermediateBuffer)));
-
-        ResourceStateTracker::AddGlobalResourceState(defaultBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
-        ResourceStateTracker::AddGlobalResourceState(intermediateBuffer.Get(), D3D12_RESOURCE_STATE_GENERIC_READ);
-        FlushResourceBarrier();
+        //Buffers are uploaded on copy queue,commandlists wait for the copy only when they use this buffer.
+        if (m_d3d12CommandListType != D3D12_COMMAND_LIST_TYPE_COPY)
+        {
+            RequestUploadCommandList()->CopyBuffer(buffer, bufferSize, elementByteSize, pBufferData);
+            return;
+        }
 
-        D3D12_SUBRESOURCE_DATA subResource = { };
-        subResource.pData = pBufferData;
-        subResource.RowPitch = bufferSize * elementByteSize;
-        subResource.SlicePitch = subResource.RowPitch;
+        UINT64 byteSize = (UINT64)bufferSize * elementByteSize;
+        auto defaultBuffer = Application::GetApp()->GetResourceHeapAllocator()->CreateResource(
+            CD3DX12_RESOURCE_DESC::Buffer(byteSize),
+            D3D12_RESOURCE_STATE_COMMON);
 
-        UpdateSubresources(m_d3d12GraphicsCommandList2.Get(), defaultBuffer.Get(), intermediateBuffer.Get(), 0, 0, 1, &subResource);
+        ResourceStateTracker::AddGlobalResourceState(defaultBuffer.Get(), D3D12_RESOURCE_STATE_COMMON);
+        //the buffer is promoted from COMMON to COPY_DEST by copy queue,so no barrier is really recorded.
+        m_pResourceStateTracker->TransitionResource(defaultBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+        FlushResourceBarrier();
 
-        AddObjectTracker(defaultBuffer);
-        AddObjectTracker(intermediateBuffer);
+        //buffers uploaded by this command list are packed into the upload ring buffer,so no upload heap is created for them.
+        auto intermediate = m_pDynamicUploadBuffer->Allocate(byteSize, D3D12_RAW_UAV_SRV_BYTE_ALIGNMENT);
+        memcpy(intermediate.CPU, pBufferData, byteSize);
+        m_d3d12GraphicsCommandList2->CopyBufferRegion(defaultBuffer.Get(), 0, intermediate.Resource, intermediate.Offset, byteSize);
 
         buffer->SetD3D12Resource(defaultBuffer,nullptr);
         buffer->CreateView(bufferSize, elementByteSize);
@@ -664,8 +677,6 @@ void CommandList::SetVertexBuffer(UINT slot,const VertexBuffer* pVertexBuffer)
         BarrierTransition(pVertexBuffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
 
         m_d3d12GraphicsCommandList2->IASetVertexBuffers(slot, 1, &pVertexBuffer->GetVerterBufferView());
-
-        AddResourceTracker(pVertexBuffer);
     }
 }
 
@@ -676,26 +687,32 @@ void CommandList::SetIndexBuffer(const IndexBuffer* pIndexBuffer)
         BarrierTransition(pIndexBuffer, D3D12_RESOURCE_STATE_INDEX_BUFFER);
 
         m_d3d12GraphicsCommandList2->IASetIndexBuffer(&pIndexBuffer->GetIndexBufferView());
-
-        AddResourceTracker(pIndexBuffer);
     }
 }
 
-bool CommandList::Close(CommandList& pendingCommandList)
+UINT CommandList::Close(std::vector<D3D12_RESOURCE_BARRIER>& PendingBarriers, std::unordered_set<ID3D12Resource*>& CommittedResources,
+    ID3D12Fence* pFence, UINT64 FenceValue, std::vector<std::shared_ptr<GlobalResourceState>>& DecayedStates)
 {
+    m_pResourceStateTracker->EndSplitBarriers();
     FlushResourceBarrier();
     ThrowIfFailed(m_d3d12GraphicsCommandList2->Close());
 
-    UINT numPendingBarrier = m_pResourceStateTracker->FlushPendingResourceBarrier(pendingCommandList);
+    UINT numPendingBarrier = m_pResourceStateTracker->FlushPendingResourceBarrier(PendingBarriers);
 
     //Remember to commit final resource state to Global resource state.
-    m_pResourceStateTracker->CommitFinalResourceState();
+    m_pResourceStateTracker->CommitFinalResourceState(CommittedResources, pFence, FenceValue, DecayedStates);
 
-    return numPendingBarrier > 0;
+    return numPendingBarrier;
+}
+
+void CommandList::FlushQueueWaits(ID3D12CommandQueue* pCommandQueue)
+{
+    m_pResourceStateTracker->FlushQueueWaits(pCommandQueue);
 }
 
 void CommandList::Close()
 {
+    m_pResourceStateTracker->EndSplitBarriers();
     FlushResourceBarrier();
     ThrowIfFailed(m_d3d12GraphicsCommandList2->Close());
 }
@@ -718,7 +735,9 @@ void CommandList::Reset()
     m_d3d12PipelineState.Reset();
     m_d3d12RootSignature.Reset();
 
-    m_pComputeCommandList.reset();
+    m_GenerateMipsTextures.clear();
+    m_Dependencies.clear();
+    m_pCopyCommandList.reset();
     m_pGenerateMips.reset();
 }
 
@@ -736,8 +755,6 @@ void CommandList::SetRenderTargets(const RenderTarget& RenderTargets)
         {
             BarrierTransition(&texture, D3D12_RESOURCE_STATE_RENDER_TARGET);
             hRtv.push_back(texture.GetRenderTargetView());
-
-            AddResourceTracker(&texture);
         }
     }
     assert(numRtv == hRtv.size() && "Render Target Numbers Mismatching");
@@ -748,25 +765,42 @@ void CommandList::SetRenderTargets(const RenderTarget& RenderTargets)
     {
         BarrierTransition(&depth, D3D12_RESOURCE_STATE_DEPTH_WRITE);
         hDsv = depth.GetDepthStencilView();
-
-        AddResourceTracker(&depth);
     }
     CD3DX12_CPU_DESCRIPTOR_HANDLE* p_hDsv = (hDsv.ptr != 0) ? &hDsv : nullptr;
 
     m_d3d12GraphicsCommandList2->OMSetRenderTargets(numRtv, hRtv.data(), FALSE, p_hDsv);
 }
 
+void CommandList::AddDependency(const QueueTimelinePoint& Dependency)
+{
+    if (Dependency.pCommandQueue)
+    {
+        m_Dependencies.push_back(Dependency);
+    }
+}
+
+std::shared_ptr<CommandList> CommandList::RequestUploadCommandList()
+{
+    assert(m_d3d12CommandListType != D3D12_COMMAND_LIST_TYPE_COPY && "Error!Copy commandlist uploads by itself!");
+    if (!m_pCopyCommandList)
+    {
+        m_pCopyCommandList = Application::GetApp()->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY)->GetCommandList();
+    }
+    return m_pCopyCommandList;
+}
+
 void CommandList::GenerateMipMaps(Texture* pTexture)
 {
     if (pTexture)
     {
+        //Copy commandlists can not dispatch,their textures are collected and generated by one compute commandlist
+        //after all copy commandlists of an execution.
         if (m_d3d12CommandListType == D3D12_COMMAND_LIST_TYPE_COPY)
         {
-            if (!m_pComputeCommandList)
+            if (std::find(m_GenerateMipsTextures.begin(), m_GenerateMipsTextures.end(), pTexture) == m_GenerateMipsTextures.end())
             {
-                m_pComputeCommandList = std::make_shared<CommandList>(D3D12_COMMAND_LIST_TYPE_COMPUTE);
+                m_GenerateMipsTextures.push_back(pTexture);
             }
-            m_pComputeCommandList->GenerateMipMaps(pTexture);
             return;
         }
 
@@ -828,25 +862,19 @@ void CommandList::GenerateMipMaps(Texture* pTexture)
 void CommandList::GenerateMips_UAV(Texture* pTexture)
 {
     auto textureDesc = pTexture->GetD3D12ResourceDesc();
-    auto device = Application::GetApp()->GetDevice();
 
     Texture stagingTexture(*pTexture);
     //If this texture does not allow unordered access,we need to recreate a copy resource to generate mips.
     if ((textureDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS) == 0)
     {
-        Microsoft::WRL::ComPtr<ID3D12Resource> stageResource;
         auto stageDesc = textureDesc;
         stageDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
         //since this new texture could never be render target or depth stencil resource,so we cancel these bit mask to optimize.
         stageDesc.Flags &= ~(D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
 
-        ThrowIfFailed(device->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-            D3D12_HEAP_FLAG_NONE,
-            &stageDesc,
-            D3D12_RESOURCE_STATE_COPY_DEST,
-            nullptr,
-            IID_PPV_ARGS(&stageResource)));
+        auto stageResource = Application::GetApp()->GetResourceHeapAllocator()->CreateResource(
+            stageDesc,
+            D3D12_RESOURCE_STATE_COPY_DEST);
 
         ResourceStateTracker::AddGlobalResourceState(stageResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
 
@@ -913,10 +941,8 @@ void CommandList::GenerateMips_UAV(Texture* pTexture)
             SetUnorderedAccessView(GenerateMipsRoot::Mips, i, &stagingTexture, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, SrcMip + i + 1, 1, &uavDesc);
         }
         //If the mipCount is less than 4 ,we need to fill null uav to shader for unused resource,this way make DirectX12 happy.
-        if (mipCount < 4)
-        {
-            m_pDynamicDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]->StageDescriptors(m_pGenerateMips->GetDefaultUAV(), GenerateMipsRoot::Mips, mipCount, 4 - mipCount);
-        }
+        m_pDynamicDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]->StageNullDescriptors(
+            Application::GetApp()->GetNullDescriptors(NullDescriptorType::RWTexture2D), GenerateMipsRoot::Mips, mipCount);
 
         Dispatch(ceil(DstWidth / 8.0f), ceil(DstHeight / 8.0f), 1);
         //Since we need to read texture in shaders after generating mips,so we must set barrier for uav to make sure that
@@ -997,7 +1023,6 @@ void CommandList::GenerateMips_BGR(Texture* pTexture)
     AddObjectTracker(textureHeap);
     AddResourceTracker(&uavTexture);
     AddResourceTracker(&aliasTexture);
-    AddResourceTracker(pTexture);
 }
 
 void CommandList::GenerateMips_SRGB(Texture* pTexture)
@@ -1057,7 +1082,6 @@ void CommandList::GenerateMips_SRGB(Texture* pTexture)
     AddObjectTracker(texHeap);
     AddResourceTracker(&uavTexture);
     AddResourceTracker(&aliasTexture);
-    AddResourceTracker(pTexture);
 }
 
 //void CommandList::DrawModel(const Model* pModel, std::function<void()> SetAdditonalResourceFunc /* = */ )
@@ -1176,9 +1200,20 @@ void CommandList::RenderShadow(const ShadowBase* pShadow,UINT PassIndex)
     SetD3D12PipelineState(pShadow->GetPipelineState());
     SetGraphicsRootSignature(pShadow->GetRootSignature());
 
+    std::vector<const Model*> models;
     for (const auto& modelmap : Scene::GetScene()->m_SceneModelsMap)
     {
-        auto model = modelmap.second.get();
+        models.push_back(modelmap.second.get());
+    }
+    //here we execute frustum culling.
+    //shadows of different lights may be recorded at same time,so we don't touch Mesh::m_IsCulled.
+    std::vector<std::vector<UINT8>> meshVisibilities;
+    pShadow->GetFrustumCullinger()->GetModelsVisibility(models, meshVisibilities);
+
+    for (size_t modelIndex = 0; modelIndex < models.size(); ++modelIndex)
+    {
+        auto model = models[modelIndex];
+        const auto& meshVisibility = meshVisibilities[modelIndex];
         SetVertexBuffer(0, model->m_pVertexBuffer.get());
         SetIndexBuffer(model->m_pIndexBuffer.get());
         SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -1189,21 +1224,15 @@ void CommandList::RenderShadow(const ShadowBase* pShadow,UINT PassIndex)
         {
             SetShaderResourceView(ShadowRootParameter::ShadowAlphaTexture, i, model->m_pTexture[TextureUsage::Diffuse][i].get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
         }
-        if (model->m_pTexture[TextureUsage::Diffuse].size() < m_MaxTextureNum)
-        {
-            m_pDynamicDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]->StageDescriptors(
-                model->m_DefaultSRV[TextureUsage::Diffuse].GetDescriptorHandle(),
-                ShadowRootParameter::ShadowAlphaTexture,
-                model->m_pTexture[TextureUsage::Diffuse].size(),
-                m_MaxTextureNum - model->m_pTexture[TextureUsage::Diffuse].size());
-        }
-        //here we execute frustum culling.
-        pShadow->GetFrustumCullinger()->BindModelCulled(model);
-        
-        auto meshes = model->m_ModelLoader->Meshes();
+        m_pDynamicDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]->StageNullDescriptors(
+            Application::GetApp()->GetNullDescriptors(NullDescriptorType::Texture2D),
+            ShadowRootParameter::ShadowAlphaTexture,
+            static_cast<UINT>(model->m_pTexture[TextureUsage::Diffuse].size()));
+
+        const auto& meshes = model->m_ModelLoader->Meshes();
         for (size_t i = 0; i < meshes.size() ; ++i)
         {
-            if (meshes[i].m_IsCulled == false)
+            if (meshVisibility[i])
             {
                 SetGraphicsDynamicConstantBuffer(ShadowRootParameter::ShadowConstantBuffer, model->m_MeshConstants[i]);
                 DrawIndexed(meshes[i].mIndices.size(), 1, meshes[i].mIndexOffset, meshes[i].mVertexOffset, 0);
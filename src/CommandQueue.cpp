@@ -148,10 +148,55 @@
 #include "CommandList.h"
 #include "ResourceStateTracker.h"
 
+#include <algorithm>
+#include <unordered_set>
+
+namespace
+{
+    // One reusable event per thread for WaitForFenceValue().
+    // Creating and closing a kernel event on every wait is not free.
+    static thread_local FenceEvent gs_FenceWaitEvent;
+
+    // Generate mips of textures collected by all copy command lists of an execution with one compute command list.
+    // The compute queue waits for uploads of these textures,and other queues wait for it when they use these textures.
+    void ExecuteGenerateMips(const std::vector<std::shared_ptr<CommandList> >& commandLists)
+    {
+        std::vector<Texture*> textures;
+        for (const auto& commandList : commandLists)
+        {
+            for (auto pTexture : commandList->GetGenerateMipsTextures())
+            {
+                if (std::find(textures.begin(), textures.end(), pTexture) == textures.end())
+                {
+                    textures.push_back(pTexture);
+                }
+            }
+        }
+        if (textures.empty())
+        {
+            return;
+        }
+
+        auto computeQueue = Application::GetApp()->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COMPUTE);
+        auto generateMipsCommandList = computeQueue->GetCommandList();
+        for (auto pTexture : textures)
+        {
+            generateMipsCommandList->GenerateMipMaps(pTexture);
+        }
+        computeQueue->ExecuteCommandList(generateMipsCommandList);
+    }
+}
+
 CommandQueue::CommandQueue(D3D12_COMMAND_LIST_TYPE type)
     : m_FenceValue(0)
+    , m_SubmittedFenceValue(0)
     , m_CommandListType(type)
+    , m_NumInFlightCommandLists(0)
     , m_bProcessInFlightCommandLists(true)
+    , m_NumRecycledCommandLists(0)
+    , m_NumRecycleBatches(0)
+    , m_NumFenceWaits(0)
+    , m_NumBarrierCommandLists(0)
 {
     auto device = Application::GetApp()->GetDevice();
 
@@ -182,41 +227,80 @@ CommandQueue::CommandQueue(D3D12_COMMAND_LIST_TYPE type)
 
 CommandQueue::~CommandQueue()
 {
-    m_bProcessInFlightCommandLists = false;
+    {
+        std::lock_guard<std::mutex> lock(m_ProcessInFlightCommandListsThreadMutex);
+        m_bProcessInFlightCommandLists = false;
+    }
+    m_ProcessInFlightCommandListsThreadCV.notify_all();
+    // Wake the thread up if it is waiting for the fence.
+    m_FenceEvent.Set();
     m_ProcessInFlightCommandListsThread.join();
 }
 
 uint64_t CommandQueue::Signal()
 {
-    uint64_t fenceValue = ++m_FenceValue;
-    m_d3d12CommandQueue->Signal(m_d3d12Fence.Get(), fenceValue);
+    uint64_t fenceValue = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_SubmitMutex);
+        fenceValue = ++m_FenceValue;
+    }
+    WaitForSubmitTurn(fenceValue);
+    EndSubmitTurn(fenceValue);
     return fenceValue;
 }
 
+void CommandQueue::WaitForSubmitTurn(uint64_t fenceValue)
+{
+    // Most of the time the submission before has been issued already.
+    if (m_SubmittedFenceValue.load(std::memory_order_acquire) + 1 == fenceValue)
+    {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m_SubmitTurnMutex);
+    m_SubmitTurnCV.wait(lock, [&]() { return m_SubmittedFenceValue.load(std::memory_order_acquire) + 1 == fenceValue; });
+}
+
+void CommandQueue::EndSubmitTurn(uint64_t fenceValue)
+{
+    m_d3d12CommandQueue->Signal(m_d3d12Fence.Get(), fenceValue);
+    {
+        // Take the mutex so a submission can not miss the notification
+        // between checking its turn and going to sleep.
+        std::lock_guard<std::mutex> lock(m_SubmitTurnMutex);
+        m_SubmittedFenceValue.store(fenceValue, std::memory_order_release);
+    }
+    m_SubmitTurnCV.notify_all();
+}
+
 bool CommandQueue::IsFenceComplete(uint64_t fenceValue)
 {
     return m_d3d12Fence->GetCompletedValue() >= fenceValue;
 }
 
+uint64_t CommandQueue::GetSignaledFenceValue() const
+{
+    return m_FenceValue;
+}
+
+uint64_t CommandQueue::GetCompletedFenceValue() const
+{
+    return m_d3d12Fence->GetCompletedValue();
+}
+
 void CommandQueue::WaitForFenceValue(uint64_t fenceValue)
 {
     if (!IsFenceComplete(fenceValue))
     {
-        auto event = ::CreateEvent(NULL, FALSE, FALSE, NULL);
-        assert(event && "Failed to create fence event handle.");
-
-        // Is this function thread safe?
-        m_d3d12Fence->SetEventOnCompletion(fenceValue, event);
-        ::WaitForSingleObject(event, DWORD_MAX);
-
-        ::CloseHandle(event);
+        // The event belongs to the calling thread, so several threads can wait at the same time.
+        m_d3d12Fence->SetEventOnCompletion(fenceValue, gs_FenceWaitEvent.GetHandle());
+        gs_FenceWaitEvent.Wait();
     }
 }
 
 void CommandQueue::Flush()
 {
     std::unique_lock<std::mutex> lock(m_ProcessInFlightCommandListsThreadMutex);
-    m_ProcessInFlightCommandListsThreadCV.wait(lock, [this] { return m_InFlightCommandLists.Empty(); });
+    m_ProcessInFlightCommandListsThreadCV.wait(lock, [this] { return m_NumInFlightCommandLists == 0; });
 
     // In case the command queue was signaled directly 
     // using the CommandQueue::Signal method then the 
@@ -229,14 +313,24 @@ std::shared_ptr<CommandList> CommandQueue::GetCommandList()
 {
     std::shared_ptr<CommandList> commandList;
 
-    // If there is a command list on the queue.
-    if (!m_AvailableCommandLists.Empty())
+    // If there is no command list on the queue, create a new command list.
+    // Only one TryPop() here, an Empty() check before it would be a second trip to the queue.
+    if (!m_AvailableCommandLists.TryPop(commandList))
     {
-        m_AvailableCommandLists.TryPop(commandList);
+        commandList = std::make_shared<CommandList>(m_CommandListType);
     }
-    else
+
+    return commandList;
+}
+
+std::shared_ptr<CommandList> CommandQueue::GetBarrierCommandList()
+{
+    std::shared_ptr<CommandList> commandList;
+
+    // Barrier command lists only record barriers,they have their own queue so
+    // they are not mixed with command lists which are handed out by GetCommandList().
+    if (!m_AvailableBarrierCommandLists.TryPop(commandList))
     {
-        // Otherwise create a new command list.
         commandList = std::make_shared<CommandList>(m_CommandListType);
     }
 
@@ -244,80 +338,162 @@ std::shared_ptr<CommandList> CommandQueue::GetCommandList()
 }
 
 // Execute a command list.
-// Returns the fence value to wait for for this command list.
-uint64_t CommandQueue::ExecuteCommandList(std::shared_ptr<CommandList> commandList)
+// Returns the timeline point to wait for for this command list.
+QueueTimelinePoint CommandQueue::ExecuteCommandList(std::shared_ptr<CommandList> commandList, const std::vector<QueueTimelinePoint>& dependencies)
 {
-    return ExecuteCommandLists(std::vector<std::shared_ptr<CommandList> >({ commandList }));
+    return ExecuteCommandLists(std::vector<std::shared_ptr<CommandList> >({ commandList }), dependencies);
 }
 
-uint64_t CommandQueue::ExecuteCommandLists(const std::vector<std::shared_ptr<CommandList> >& commandLists)
+QueueTimelinePoint CommandQueue::ExecuteCommandLists(const std::vector<std::shared_ptr<CommandList> >& commandLists, const std::vector<QueueTimelinePoint>& dependencies)
 {
-    ResourceStateTracker::Lock();
+    // Only wait for the submissions which produce inputs of these command lists.
+    for (const auto& dependency : dependencies)
+    {
+        Wait(dependency);
+    }
+    for (const auto& commandList : commandLists)
+    {
+        for (const auto& dependency : commandList->GetDependencies())
+        {
+            Wait(dependency);
+        }
+    }
+
+    // Upload command lists are executed on the copy queue before these command lists as one batch.
+    // This queue does not wait for the whole copy queue, it only waits when an uploaded resource is used.
+    std::vector<std::shared_ptr<CommandList> > uploadCommandLists;
+    for (const auto& commandList : commandLists)
+    {
+        auto uploadCommandList = commandList->GetUploadCommandList();
+        if (uploadCommandList)
+        {
+            uploadCommandLists.push_back(uploadCommandList);
+        }
+    }
+    if (!uploadCommandLists.empty())
+    {
+        Application::GetApp()->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY)->ExecuteCommandLists(uploadCommandLists);
+    }
+    // States are resolved in the order of fence values,and command lists are executed in the same order
+    // (see WaitForSubmitTurn()), so the states which are resolved by a submission are the states that the gpu sees
+    // when it runs. Global resource states are locked one at a time while they are resolved in Close(),
+    // no lock is shared with other queues.
+    std::unique_lock<std::mutex> submitLock(m_SubmitMutex);
+    // The fence value is reserved now,it is signaled after these command lists.
+    uint64_t fenceValue = ++m_FenceValue;
 
     // Command lists that need to put back on the command list queue.
     std::vector<std::shared_ptr<CommandList> > toBeQueued;
-    toBeQueued.reserve(commandLists.size() * 2);        // 2x since each command list will have a pending command list.
-
-    // Generate mips command lists.
-    std::vector<std::shared_ptr<CommandList> > generateMipsCommandLists;
-    generateMipsCommandLists.reserve(commandLists.size());
+    toBeQueued.reserve(commandLists.size());
+    // Barrier command lists that need to put back on the barrier command list queue.
+    std::vector<std::shared_ptr<CommandList> > barrierCommandLists;
 
     // Command lists that need to be executed.
     std::vector<ID3D12CommandList*> d3d12CommandLists;
-    d3d12CommandLists.reserve(commandLists.size() * 2); // 2x since each command list will have a pending command list.
-
-    for (auto commandList : commandLists)
+    d3d12CommandLists.reserve(commandLists.size() + 1);
+
+    // Pending barriers of all command lists are recorded into one barrier command list in front of them.
+    // Only when a command list has a pending barrier of a resource which is used by the command lists
+    // after the barrier command list,we need another barrier command list in front of it.
+    std::vector<D3D12_RESOURCE_BARRIER> pendingBarriers;
+    std::unordered_set<ID3D12Resource*> barrierResources;
+    std::unordered_set<ID3D12Resource*> committedResources;
+    // Resources which decay to COMMON when these command lists have been executed.
+    std::vector<std::shared_ptr<GlobalResourceState> > decayedStates;
+    size_t barrierPosition = 0;
+
+    auto flushPendingBarriers = [&]()
     {
-        auto pendingCommandList = GetCommandList();
-        bool hasPendingBarriers = commandList->Close(*pendingCommandList);
-        pendingCommandList->Close();
-        // If there are no pending barriers on the pending command list, there is no reason to 
+        // If there are no pending barriers, there is no reason to
         // execute an empty command list on the command queue.
-        if (hasPendingBarriers)
+        if (!pendingBarriers.empty())
         {
-            d3d12CommandLists.push_back(pendingCommandList->GetGraphicsCommandList2().Get());
+            auto barrierCommandList = GetBarrierCommandList();
+            barrierCommandList->GetGraphicsCommandList2()->ResourceBarrier(static_cast<UINT>(pendingBarriers.size()), pendingBarriers.data());
+            barrierCommandList->Close();
+            d3d12CommandLists.insert(d3d12CommandLists.begin() + barrierPosition, barrierCommandList->GetGraphicsCommandList2().Get());
+            barrierCommandLists.push_back(barrierCommandList);
+            pendingBarriers.clear();
         }
-        d3d12CommandLists.push_back(commandList->GetGraphicsCommandList2().Get());
-
-        toBeQueued.push_back(pendingCommandList);
-        toBeQueued.push_back(commandList);
+        barrierResources.clear();
+        barrierPosition = d3d12CommandLists.size();
+    };
 
-        auto generateMipsCommandList = commandList->GetGenerateMipsCommandList();
-        if (generateMipsCommandList)
+    for (auto commandList : commandLists)
+    {
+        size_t firstBarrier = pendingBarriers.size();
+        committedResources.clear();
+        commandList->Close(pendingBarriers, committedResources, m_d3d12Fence.Get(), fenceValue, decayedStates);
+        for (size_t i = firstBarrier; i < pendingBarriers.size(); ++i)
         {
-            generateMipsCommandLists.push_back(generateMipsCommandList);
+            if (barrierResources.count(pendingBarriers[i].Transition.pResource))
+            {
+                // The barriers of this command list start a new barrier command list.
+                std::vector<D3D12_RESOURCE_BARRIER> barriers(pendingBarriers.begin() + firstBarrier, pendingBarriers.end());
+                pendingBarriers.resize(firstBarrier);
+                flushPendingBarriers();
+                pendingBarriers = std::move(barriers);
+                break;
+            }
         }
-    }
+        barrierResources.insert(committedResources.begin(), committedResources.end());
 
-    UINT numCommandLists = static_cast<UINT>(d3d12CommandLists.size());
-    m_d3d12CommandQueue->ExecuteCommandLists(numCommandLists, d3d12CommandLists.data());
+        d3d12CommandLists.push_back(commandList->GetGraphicsCommandList2().Get());
+        toBeQueued.push_back(commandList);
+    }
+    flushPendingBarriers();
 
+    // Decay happens after the whole ExecuteCommandLists(),so the next submission to this queue sees it.
+    // The next submission is resolved after it and executed after these command lists.
+    ResourceStateTracker::DecayResourceStates(decayedStates);
+    BarrierTrace::RecordExecute(m_CommandListType);
 
-    uint64_t fenceValue = Signal();
+    submitLock.unlock();
 
-    ResourceStateTracker::UnLock();
+    WaitForSubmitTurn(fenceValue);
+    // Wait for the copy queue if command lists use resources which are still being uploaded.
+    for (const auto& commandList : commandLists)
+    {
+        commandList->FlushQueueWaits(m_d3d12CommandQueue.Get());
+    }
+    UINT numCommandLists = static_cast<UINT>(d3d12CommandLists.size());
+    m_d3d12CommandQueue->ExecuteCommandLists(numCommandLists, d3d12CommandLists.data());
+    EndSubmitTurn(fenceValue);
 
     // Queue command lists for reuse.
-    for (auto commandList : toBeQueued)
+    m_NumInFlightCommandLists += toBeQueued.size() + barrierCommandLists.size();
+    m_NumBarrierCommandLists += barrierCommandLists.size();
+    for (auto& commandList : toBeQueued)
+    {
+        m_InFlightCommandLists.Push({ fenceValue, std::move(commandList), false });
+    }
+    for (auto& commandList : barrierCommandLists)
     {
-        m_InFlightCommandLists.Push({ fenceValue, commandList });
+        m_InFlightCommandLists.Push({ fenceValue, std::move(commandList), true });
     }
+    {
+        // Take the mutex so the in-flight thread can not miss the notification
+        // between checking the queue and going to sleep.
+        std::lock_guard<std::mutex> lock(m_ProcessInFlightCommandListsThreadMutex);
+    }
+    m_ProcessInFlightCommandListsThreadCV.notify_all();
 
-    // If there are any command lists that generate mips then execute those
-    // after the initial resource command lists have finished.
-    if (generateMipsCommandLists.size() > 0)
+    // Textures written by copy command lists generate mips after the copy.
+    if (m_CommandListType == D3D12_COMMAND_LIST_TYPE_COPY)
     {
-        auto computeQueue = Application::GetApp()->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COMPUTE);
-        computeQueue->Wait(*this);
-        computeQueue->ExecuteCommandLists(generateMipsCommandLists);
+        ExecuteGenerateMips(commandLists);
     }
 
-    return fenceValue;
+    return { this, fenceValue };
 }
 
-void CommandQueue::Wait(const CommandQueue& other)
+void CommandQueue::Wait(const QueueTimelinePoint& point)
 {
-    m_d3d12CommandQueue->Wait(other.m_d3d12Fence.Get(), other.m_FenceValue);
+    // A queue executes in order, it never waits for itself.
+    if (point.pCommandQueue && point.pCommandQueue != this && !point.pCommandQueue->IsFenceComplete(point.FenceValue))
+    {
+        m_d3d12CommandQueue->Wait(point.pCommandQueue->m_d3d12Fence.Get(), point.FenceValue);
+    }
 }
 
 Microsoft::WRL::ComPtr<ID3D12CommandQueue> CommandQueue::GetD3D12CommandQueue() const
@@ -325,29 +501,95 @@ Microsoft::WRL::ComPtr<ID3D12CommandQueue> CommandQueue::GetD3D12CommandQueue()
     return m_d3d12CommandQueue;
 }
 
+LockFreeQueueStatistics CommandQueue::GetInFlightQueueStatistics() const
+{
+    return m_InFlightCommandLists.GetStatistics();
+}
+
+LockFreeQueueStatistics CommandQueue::GetAvailableQueueStatistics() const
+{
+    return m_AvailableCommandLists.GetStatistics();
+}
+
+InFlightStatistics CommandQueue::GetInFlightStatistics() const
+{
+    InFlightStatistics statistics;
+    statistics.RecycledCommandLists = m_NumRecycledCommandLists;
+    statistics.RecycleBatches = m_NumRecycleBatches;
+    statistics.FenceWaits = m_NumFenceWaits;
+    statistics.BarrierCommandLists = m_NumBarrierCommandLists;
+    return statistics;
+}
+
 void CommandQueue::ProccessInFlightCommandLists()
 {
-    std::unique_lock<std::mutex> lock(m_ProcessInFlightCommandListsThreadMutex, std::defer_lock);
+    // Command lists which are taken from the in-flight queue but whose fence has not completed.
+    std::vector<CommandListEntry> inFlightCommandLists;
 
     while (m_bProcessInFlightCommandLists)
     {
-        CommandListEntry commandListEntry;
+        {
+            // Sleep until some command lists are executed.
+            std::unique_lock<std::mutex> lock(m_ProcessInFlightCommandListsThreadMutex);
+            m_ProcessInFlightCommandListsThreadCV.wait(lock, [this, &inFlightCommandLists]
+                {
+                    return !m_bProcessInFlightCommandLists || !inFlightCommandLists.empty() || !m_InFlightCommandLists.Empty();
+                });
+        }
+        if (!m_bProcessInFlightCommandLists)
+        {
+            break;
+        }
 
-        lock.lock();
+        CommandListEntry commandListEntry;
         while (m_InFlightCommandLists.TryPop(commandListEntry))
         {
-            auto fenceValue = std::get<0>(commandListEntry);
-            auto commandList = std::get<1>(commandListEntry);
+            inFlightCommandLists.push_back(std::move(commandListEntry));
+        }
+        if (inFlightCommandLists.empty())
+        {
+            continue;
+        }
 
-            WaitForFenceValue(fenceValue);
+        // Move every command list whose fence has passed to the back and recycle them as one batch.
+        uint64_t completedFenceValue = m_d3d12Fence->GetCompletedValue();
+        auto completed = std::partition(inFlightCommandLists.begin(), inFlightCommandLists.end(),
+            [completedFenceValue](const CommandListEntry& entry) { return std::get<0>(entry) > completedFenceValue; });
 
-            commandList->Reset();
+        if (completed == inFlightCommandLists.end())
+        {
+            // Nothing has finished, sleep until the oldest command list finishes.
+            // Wake-ups from an older registration or from the destructor are harmless, we just check again.
+            uint64_t oldestFenceValue = std::get<0>(*std::min_element(inFlightCommandLists.begin(), inFlightCommandLists.end(),
+                [](const CommandListEntry& a, const CommandListEntry& b) { return std::get<0>(a) < std::get<0>(b); }));
+            m_d3d12Fence->SetEventOnCompletion(oldestFenceValue, m_FenceEvent.GetHandle());
+            m_FenceEvent.Wait();
+            ++m_NumFenceWaits;
+            continue;
+        }
 
-            m_AvailableCommandLists.Push(commandList);
+        size_t numCompleted = std::distance(completed, inFlightCommandLists.end());
+        for (auto iter = completed; iter != inFlightCommandLists.end(); ++iter)
+        {
+            auto& commandList = std::get<1>(*iter);
+            commandList->Reset();
+            if (std::get<2>(*iter))
+            {
+                m_AvailableBarrierCommandLists.Push(std::move(commandList));
+            }
+            else
+            {
+                m_AvailableCommandLists.Push(std::move(commandList));
+            }
         }
-        lock.unlock();
-        m_ProcessInFlightCommandListsThreadCV.notify_one();
+        inFlightCommandLists.erase(completed, inFlightCommandLists.end());
 
-        std::this_thread::yield();
+        m_NumRecycledCommandLists += numCompleted;
+        ++m_NumRecycleBatches;
+        {
+            std::lock_guard<std::mutex> lock(m_ProcessInFlightCommandListsThreadMutex);
+            m_NumInFlightCommandLists -= numCompleted;
+        }
+        m_ProcessInFlightCommandListsThreadCV.notify_all();
     }
-}
\ No newline at end of file
+}
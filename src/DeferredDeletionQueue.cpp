@@ -0,0 +1,172 @@
+#include "DeferredDeletionQueue.h"
+#include "CommandQueue.h"
+#include "DescriptorAllocatorPage.h"
+
+#include <cassert>
+
+DeferredDeletionQueue::DeferredDeletionQueue(const std::shared_ptr<CommandQueue> (&CommandQueues)[NumCommandQueues])
+    : m_NumObjects(0)
+    , m_NumDescriptorRanges(0)
+{
+    for (int i = 0; i < NumCommandQueues; ++i)
+    {
+        assert(CommandQueues[i] && "Error!Deferred deletion queue needs all command queues!");
+        m_CommandQueues[i] = CommandQueues[i];
+    }
+}
+
+DeferredDeletionQueue::~DeferredDeletionQueue()
+{
+    ReleaseAll();
+    //command lists which are destroyed with command queues may still retire objects here.
+    for (auto& pCommandQueue : m_CommandQueues)
+    {
+        pCommandQueue.reset();
+    }
+    ReleaseAll();
+}
+
+void DeferredDeletionQueue::Retire(Microsoft::WRL::ComPtr<IUnknown> pObject)
+{
+    if (!pObject)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Entry entry;
+    entry.pObject = std::move(pObject);
+    m_PendingEntries.push_back(std::move(entry));
+    ++m_NumObjects;
+}
+
+void DeferredDeletionQueue::Retire(std::shared_ptr<DescriptorAllocatorPage> pPage, UINT Offset, UINT NumDescriptors)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Entry entry;
+    entry.pDescriptorPage = std::move(pPage);
+    entry.DescriptorOffset = Offset;
+    entry.NumDescriptors = NumDescriptors;
+    m_PendingEntries.push_back(std::move(entry));
+    ++m_NumDescriptorRanges;
+}
+
+void DeferredDeletionQueue::Seal()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (m_PendingEntries.empty())
+    {
+        return;
+    }
+
+    Batch batch;
+    for (int i = 0; i < NumCommandQueues; ++i)
+    {
+        batch.FenceValues[i] = m_CommandQueues[i]->GetSignaledFenceValue();
+    }
+    //the pending vector is swapped into the batch,and an old vector takes its place.
+    batch.Entries.swap(m_PendingEntries);
+    if (!m_FreeEntryVectors.empty())
+    {
+        m_PendingEntries.swap(m_FreeEntryVectors.back());
+        m_FreeEntryVectors.pop_back();
+    }
+    m_Batches.push_back(std::move(batch));
+}
+
+size_t DeferredDeletionQueue::ReleaseCompleted()
+{
+    uint64_t completedFenceValues[NumCommandQueues];
+    for (int i = 0; i < NumCommandQueues; ++i)
+    {
+        completedFenceValues[i] = m_CommandQueues[i]->GetCompletedFenceValue();
+    }
+
+    size_t numReleased = 0;
+    std::vector<Entry> entries;
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            //Give the vector of last batch back.
+            if (entries.capacity() > 0 && m_FreeEntryVectors.size() < MaxFreeEntryVectors)
+            {
+                m_FreeEntryVectors.push_back(std::move(entries));
+                entries = std::vector<Entry>();
+            }
+            //batches are sealed in order,so fence values only grow from front to back.
+            if (m_Batches.empty())
+            {
+                break;
+            }
+            const auto& batch = m_Batches.front();
+            bool bCompleted = true;
+            for (int i = 0; i < NumCommandQueues; ++i)
+            {
+                bCompleted = bCompleted && completedFenceValues[i] >= batch.FenceValues[i];
+            }
+            if (!bCompleted)
+            {
+                break;
+            }
+            entries.swap(m_Batches.front().Entries);
+            m_Batches.pop_front();
+            for (const auto& entry : entries)
+            {
+                if (entry.pDescriptorPage)
+                {
+                    --m_NumDescriptorRanges;
+                }
+                else
+                {
+                    --m_NumObjects;
+                }
+            }
+        }
+        //Objects are released without the lock,since releasing may retire other objects.
+        numReleased += entries.size();
+        Release(entries);
+    }
+    return numReleased;
+}
+
+void DeferredDeletionQueue::ReleaseAll()
+{
+    std::vector<Entry> entries;
+    std::deque<Batch> batches;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        entries.swap(m_PendingEntries);
+        batches.swap(m_Batches);
+        m_NumObjects = 0;
+        m_NumDescriptorRanges = 0;
+    }
+    for (auto& batch : batches)
+    {
+        Release(batch.Entries);
+    }
+    Release(entries);
+}
+
+DeferredDeletionStatistics DeferredDeletionQueue::GetStatistics()const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    DeferredDeletionStatistics statistics;
+    statistics.NumPendingObjects = m_NumObjects;
+    statistics.NumPendingDescriptorRanges = m_NumDescriptorRanges;
+    statistics.NumBatches = m_Batches.size();
+    return statistics;
+}
+
+void DeferredDeletionQueue::Release(std::vector<Entry>& Entries)
+{
+    for (auto& entry : Entries)
+    {
+        if (entry.pDescriptorPage)
+        {
+            entry.pDescriptorPage->ReleaseDescriptors(entry.DescriptorOffset, entry.NumDescriptors);
+        }
+    }
+    //keep the capacity for next batch
+    Entries.clear();
+}
@@ -31,7 +31,7 @@ void DescriptorAllocation::Free()
 {
     if (!IsNull() && m_AllocationInPage)
     {
-        m_AllocationInPage->Free(std::move(*this), Application::GetApp()->GetFrameCount());
+        m_AllocationInPage->Free(std::move(*this));
 
         m_DescriptorCpuHandle.ptr = 0;
         m_DescriptorIncrementSize = 0;
@@ -2,74 +2,151 @@
 #include "DescriptorAllocatorPage.h"
 #include <assert.h>
 #include <mutex>
+#include <algorithm>
+#include <utility>
+
+std::atomic<UINT64> DescriptorAllocator::ms_NextAllocatorId(0);
 
 DescriptorAllocator::DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE heapType, UINT NumDescriptors /* = 256 */)
     :m_DescriptorHeapType(heapType)
-    , m_NumDescriptorsPerHeap(NumDescriptors) {};
+    , m_NumDescriptorsPerHeap(NumDescriptors)
+    , m_AllocatorId(ms_NextAllocatorId.fetch_add(1)) {};
 
 DescriptorAllocator::~DescriptorAllocator() {};
 
 DescriptorAllocation DescriptorAllocator::Allocate(UINT NumDescriptors)
 {
+    //The most common allocation is a single view,so it does not touch the shared lock.
+    if (NumDescriptors == 1)
+    {
+        auto& magazine = GetThreadMagazine();
+        if (magazine.Descriptors.empty())
+        {
+            RefillMagazine(magazine);
+        }
+        DescriptorAllocation allocation = std::move(magazine.Descriptors.back());
+        magazine.Descriptors.pop_back();
+        return allocation;
+    }
+
     //---------------------------------------------------
     std::lock_guard<std::mutex> lock(m_AllocationMutex);
     //---------------------------------------------------
+    return AllocateFromPages(NumDescriptors, GetSizeClass(NumDescriptors));
+}
 
+DescriptorAllocation DescriptorAllocator::AllocateFromPages(UINT NumDescriptors, UINT SizeClass)
+{
     DescriptorAllocation allocation;
+    auto& availableHeapIndex = m_AvailableHeapIndex[SizeClass];
     // for loop to allocate in available heap enough descriptors 
-    for (const auto& heapindex : m_AvailableHeapIndex)
+    for (auto iter = availableHeapIndex.begin(); iter != availableHeapIndex.end();)
     {
-        allocation = m_HeapPool[heapindex]->Allocate(NumDescriptors);
+        auto& page = m_HeapPool[*iter];
+        allocation = page->Allocate(NumDescriptors);
         //If there is no more handle in this page after allocation, we erase this page index from avail heap
-        if (m_HeapPool[heapindex]->FreeNumHandle() == 0)
+        if (page->FreeNumHandle() == 0)
+        {
+            iter = availableHeapIndex.erase(iter);
+        }
+        else
         {
-            m_AvailableHeapIndex.erase(heapindex);
+            ++iter;
         }
         //If allocation is not null, then allocation completes.
         if (!allocation.IsNull())
         {
-            break;
+            return allocation;
         }
     }
     // If there is no enough space in all available page,then we create a new page which has enough room.
-    if (allocation.IsNull())
+    // Only this page is bigger for a huge range,following pages still use the default size.
+    auto newPage = GetNewDescriptorAlloctorPage((std::max)(m_NumDescriptorsPerHeap, NumDescriptors), SizeClass);
+    allocation = newPage->Allocate(NumDescriptors);
+    assert(!allocation.IsNull() && "Descriptor Allocation Exception");
+
+    return allocation;
+}
+
+void DescriptorAllocator::RefillMagazine(Magazine& magazine)
+{
+    //---------------------------------------------------
+    std::lock_guard<std::mutex> lock(m_AllocationMutex);
+    //---------------------------------------------------
+    auto& availableHeapIndex = m_AvailableHeapIndex[0];
+    while (magazine.Descriptors.size() < MagazineSize)
     {
-        m_NumDescriptorsPerHeap = max(m_NumDescriptorsPerHeap, NumDescriptors);
+        if (availableHeapIndex.empty())
+        {
+            GetNewDescriptorAlloctorPage(m_NumDescriptorsPerHeap, 0);
+        }
+        auto iter = availableHeapIndex.begin();
+        auto& page = m_HeapPool[*iter];
+        //take as many descriptors as possible from one page under its lock once.
+        page->AllocateSingles(MagazineSize - static_cast<UINT>(magazine.Descriptors.size()), magazine.Descriptors);
+        if (page->FreeNumHandle() == 0)
+        {
+            availableHeapIndex.erase(iter);
+        }
+    }
+}
 
-        auto newPage = GetNewDescriptorAlloctorPage(m_NumDescriptorsPerHeap);
-        allocation = newPage->Allocate(NumDescriptors);
-        assert(!allocation.IsNull() && "Descriptor Allocation Exception");
+DescriptorAllocator::Magazine& DescriptorAllocator::GetThreadMagazine()
+{
+    //Each thread remembers its magazine of every allocator,so looking up does not lock.
+    thread_local std::vector<std::pair<UINT64, Magazine*>> tl_Magazines;
+    for (const auto& entry : tl_Magazines)
+    {
+        if (entry.first == m_AllocatorId)
+        {
+            return *entry.second;
+        }
     }
 
-    return allocation;
+    //---------------------------------------------------
+    std::lock_guard<std::mutex> lock(m_AllocationMutex);
+    //---------------------------------------------------
+    m_Magazines.push_back(std::make_unique<Magazine>());
+    Magazine* pMagazine = m_Magazines.back().get();
+    pMagazine->Descriptors.reserve(MagazineSize);
+    tl_Magazines.emplace_back(m_AllocatorId, pMagazine);
+    return *pMagazine;
 }
 
-void DescriptorAllocator::ReleaseStaleDescriptorAlloction(UINT64 CurrentFrame)
+void DescriptorAllocator::UpdateAvailablePages()
 {
     //------------------------------------------------------------------
     std::lock_guard<std::mutex> lock(m_AllocationMutex);
     //------------------------------------------------------------------
 
-    //we iterate all page in heap pool and release all stale descriptors
     for (size_t index = 0 ; index < m_HeapPool.size() ; ++index)
     {
-        m_HeapPool[index]->ReleaseStaleDescriptors(CurrentFrame);
-
         //If there are some free handles after releasing , we push this page into available page for reuse
         if (m_HeapPool[index]->FreeNumHandle() > 0)
         {
-            m_AvailableHeapIndex.insert(index);
+            m_AvailableHeapIndex[m_HeapSizeClass[index]].insert(index);
         }
     }
 }
 
-std::shared_ptr<DescriptorAllocatorPage> DescriptorAllocator::GetNewDescriptorAlloctorPage(UINT NumDescriptors)
+UINT DescriptorAllocator::GetSizeClass(UINT NumDescriptors)
+{
+    UINT sizeClass = 0;
+    while (sizeClass < NumSizeClasses - 1 && (1u << sizeClass) < NumDescriptors)
+    {
+        ++sizeClass;
+    }
+    return sizeClass;
+}
+
+std::shared_ptr<DescriptorAllocatorPage> DescriptorAllocator::GetNewDescriptorAlloctorPage(UINT NumDescriptors, UINT SizeClass)
 {
     std::shared_ptr<DescriptorAllocatorPage> newPage = std::make_shared<DescriptorAllocatorPage>(m_DescriptorHeapType,NumDescriptors);
 
     //we push this new page into heappool and available page
     m_HeapPool.push_back(newPage);
-    m_AvailableHeapIndex.insert(m_HeapPool.size() - 1);
+    m_HeapSizeClass.push_back(SizeClass);
+    m_AvailableHeapIndex[SizeClass].insert(m_HeapPool.size() - 1);
 
     return newPage;
-}
\ No newline at end of file
+}
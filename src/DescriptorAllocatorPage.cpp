@@ -1,20 +1,25 @@
 #include "DescriptorAllocatorPage.h"
 #include "Application.h"
 #include "DescriptorAllocation.h"
+#include "DeferredDeletionQueue.h"
 
 #include <assert.h>
 #include <d3dx12.h>
 
-DescriptorAllocatorPage::DescriptorAllocatorPage(D3D12_DESCRIPTOR_HEAP_TYPE DescriptorType, UINT NumDescriptors)
+std::atomic<uint64_t> DescriptorAllocatorPage::ms_ReleaseEpoch[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES] = {};
+
+DescriptorAllocatorPage::DescriptorAllocatorPage(D3D12_DESCRIPTOR_HEAP_TYPE DescriptorType, UINT NumDescriptors,
+    D3D12_DESCRIPTOR_HEAP_FLAGS Flags /* = D3D12_DESCRIPTOR_HEAP_FLAG_NONE */)
     : m_DescriptorHeapType(DescriptorType)
+    , m_IsShaderVisible((Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) != 0)
     , m_CurrentFreeNumHandle(NumDescriptors)
+    , m_FreeBlocks(NumDescriptors)
 {
     //Initialize private members
-    m_DescriptorHeap = Application::GetApp()->CreateDescriptorHeap(m_DescriptorHeapType, m_CurrentFreeNumHandle);
+    m_DescriptorHeap = Application::GetApp()->CreateDescriptorHeap(m_DescriptorHeapType, m_CurrentFreeNumHandle, Flags);
     m_BaseDescriptorCpuHandle = m_DescriptorHeap->GetCPUDescriptorHandleForHeapStart();
     m_DescriptorIncrementSize = Application::GetApp()->GetDescriptorIncrementSize(m_DescriptorHeapType);
-    //Push the whole descriptor heap into the free block.
-    AddNewFreeBlock(0, m_CurrentFreeNumHandle);
+    //the whole descriptor heap is one free block at the beginning.
 }
 
 DescriptorAllocatorPage::~DescriptorAllocatorPage()
@@ -27,128 +32,69 @@ DescriptorAllocation DescriptorAllocatorPage::Allocate(UINT NumDescriptors)
     std::lock_guard<std::mutex> lock(m_AllocationMutex);
     //-------------------------------------------------
 
-    DescriptorAllocation allocation;
     //If current descriptor heap has no enough room to allocate,return null
     if (NumDescriptors > m_CurrentFreeNumHandle)
     {
         return DescriptorAllocation();
     }
-    //Find the first free block which is greater or equal with the NumDescriptors
-    auto firstPos = m_FreeBlockBySize.lower_bound(NumDescriptors);
+    //Find a free block which is greater or equal with the NumDescriptors
+    uint64_t offset = m_FreeBlocks.Allocate(NumDescriptors);
     //If there is no free block to satisfy, then return null
-    if (firstPos == m_FreeBlockBySize.end())
+    if (offset == TLSFAllocator::InvalidOffset)
     {
         return DescriptorAllocation();
     }
-    //If the code run here,we can start to allocate.
-    UINT freeBlockOffset = firstPos->second->first;
-    UINT freeBlockSize = firstPos->first;
-    //Update offset and size after allocation
-    UINT newOffset = freeBlockOffset + NumDescriptors;
-    UINT newSize = freeBlockSize - NumDescriptors;
-    assert(newSize >= 0 && "Invalid Size Value");
-    //Erase old free block from containers.
-    m_FreeBlockByOffset.erase(firstPos->second);
-    m_FreeBlockBySize.erase(firstPos);
-    //If free block is run out of,we do nothing.If not,we push remain as free block into containers.
-    if (newSize != 0)
-    {
-        AddNewFreeBlock(newOffset, newSize);
-    }
     //Do not forget to update current free handles in descirptor heap.
     m_CurrentFreeNumHandle -= NumDescriptors;
-    return DescriptorAllocation(CD3DX12_CPU_DESCRIPTOR_HANDLE(m_BaseDescriptorCpuHandle, freeBlockOffset, m_DescriptorIncrementSize),
+    return DescriptorAllocation(CD3DX12_CPU_DESCRIPTOR_HANDLE(m_BaseDescriptorCpuHandle, static_cast<INT>(offset), m_DescriptorIncrementSize),
         NumDescriptors, m_DescriptorIncrementSize,shared_from_this());
 }
 
+UINT DescriptorAllocatorPage::AllocateSingles(UINT NumAllocations, std::vector<DescriptorAllocation>& Allocations)
+{
+    //-------------------------------------------------
+    std::lock_guard<std::mutex> lock(m_AllocationMutex);
+    //-------------------------------------------------
+
+    UINT numAllocated = 0;
+    while (numAllocated < NumAllocations && m_CurrentFreeNumHandle > 0)
+    {
+        uint64_t offset = m_FreeBlocks.Allocate(1);
+        if (offset == TLSFAllocator::InvalidOffset)
+        {
+            break;
+        }
+        --m_CurrentFreeNumHandle;
+        Allocations.emplace_back(CD3DX12_CPU_DESCRIPTOR_HANDLE(m_BaseDescriptorCpuHandle, static_cast<INT>(offset), m_DescriptorIncrementSize),
+            1, m_DescriptorIncrementSize, shared_from_this());
+        ++numAllocated;
+    }
+    return numAllocated;
+}
+
 UINT DescriptorAllocatorPage::FreeNumHandle()const
 {
     return m_CurrentFreeNumHandle;
 }
 
-void DescriptorAllocatorPage::AddNewFreeBlock(UINT BlockOffset, UINT BlockSize)
+TLSFStatistics DescriptorAllocatorPage::GetStatistics()
 {
-    auto OffsetIt = m_FreeBlockByOffset.emplace(BlockOffset, BlockSize);
-    auto SizeIt = m_FreeBlockBySize.emplace(BlockSize, OffsetIt.first);
-    OffsetIt.first->second.FreeBlockBySizeIt = SizeIt;
+    std::lock_guard<std::mutex> lock(m_AllocationMutex);
+    return m_FreeBlocks.GetStatistics();
 }
 
 bool DescriptorAllocatorPage::HasSapce(UINT NumDescriptors)
 {
-    return m_FreeBlockBySize.lower_bound(NumDescriptors) != m_FreeBlockBySize.end();
+    std::lock_guard<std::mutex> lock(m_AllocationMutex);
+    return m_FreeBlocks.HasSpace(NumDescriptors);
 }
 
 void DescriptorAllocatorPage::ReleaseBlock(UINT Offset, UINT NumDescriptors)
 {
-    //the first iterator which is greater than offset.
-    //if the iterator is upper-end iterator,that means the block is the last one.
-    auto nextBlockByOffsetIt = m_FreeBlockByOffset.upper_bound(Offset);
-    //the previous block iterator
-    //Note do not adjust nextBlockByOffsetIt...
-    auto prevBlockByOffsetIt = nextBlockByOffsetIt;
-    //If the block is front of all free blocks,we set prevBlockIt to end.
-    if (prevBlockByOffsetIt == m_FreeBlockByOffset.begin())
-    {
-        prevBlockByOffsetIt = m_FreeBlockByOffset.end();
-    }
-    else
-    {
-        --prevBlockByOffsetIt;
-    }
-
-    UINT newOffset = Offset;
-    UINT newSize = NumDescriptors;
-    //If the block is not the first one in container.
-    if (prevBlockByOffsetIt != m_FreeBlockByOffset.end())
-    {
-        /************************************************************************/
-        /*  PrveOffset                             Offset           
-                |             Size                   |      Size      |
-                |<---------------------------------->|<-------------->|                
-        /*      |-----------------------------------------------------|
-        /************************************************************************/
-        UINT prevBlockOffset = prevBlockByOffsetIt->first;
-        UINT prevBlockSize = prevBlockByOffsetIt->second.Size;
-
-        assert(prevBlockOffset + prevBlockSize <= Offset && "Invalid Offset");
-        //Check if new free block can merge with the previous one.
-        if (prevBlockOffset + prevBlockSize == Offset)
-        {
-            m_FreeBlockBySize.erase(prevBlockByOffsetIt->second.FreeBlockBySizeIt);
-            m_FreeBlockByOffset.erase(prevBlockByOffsetIt);
-
-            newOffset = prevBlockOffset;
-            newSize += prevBlockSize;
-        }
-    }
-    //If the block is not the last one in container.
-    if (nextBlockByOffsetIt != m_FreeBlockByOffset.end())
-    {
-        /************************************************************************/
-        /*    Offset                      NextOffset
-                |             Size            |         Size          | 
-                |<--------------------------->|<--------------------->|
-        /*      |-----------------------------------------------------|
-        /************************************************************************/
-        UINT nextBlockOffset = nextBlockByOffsetIt->first;
-        UINT nextBlockSize = nextBlockByOffsetIt->second.Size;
-
-        assert(Offset + NumDescriptors <= nextBlockOffset && "Invalid Offset");
-        //Check if new free block can merge with the next one.
-        if (Offset + NumDescriptors == nextBlockOffset)
-        {
-            m_FreeBlockBySize.erase(nextBlockByOffsetIt->second.FreeBlockBySizeIt);
-            m_FreeBlockByOffset.erase(nextBlockByOffsetIt);
-
-            newOffset = newOffset;
-            newSize += nextBlockSize;
-        }
-    }
-
+    //the free block is merged with its neighbours by TLSF allocator.
+    m_FreeBlocks.Free(Offset);
     //Do not forget update current handle num in descirptor heap
     m_CurrentFreeNumHandle += NumDescriptors;
-    //Finally,we add a new free block.
-    AddNewFreeBlock(newOffset, newSize);
 }
 
 UINT DescriptorAllocatorPage::ComputeOffset(D3D12_CPU_DESCRIPTOR_HANDLE Descriptor)
@@ -156,30 +102,36 @@ UINT DescriptorAllocatorPage::ComputeOffset(D3D12_CPU_DESCRIPTOR_HANDLE Descript
     return (Descriptor.ptr - m_BaseDescriptorCpuHandle.ptr) / m_DescriptorIncrementSize;
 }
 
-void DescriptorAllocatorPage::Free(DescriptorAllocation&& descirptorAllocation, UINT64 frame)
+void DescriptorAllocatorPage::Free(DescriptorAllocation&& descirptorAllocation)
 {
     UINT offset = ComputeOffset(descirptorAllocation.GetDescriptorHandle());
     UINT size = descirptorAllocation.GetNumHandles();
-    //--------------------------------------------------------
-    std::lock_guard<std::mutex> lock(m_AllocationMutex);
-    //--------------------------------------------------------
-    m_StaleDescriptorQueue.emplace(offset, size, frame);
+    auto pDeferredDeletionQueue = Application::GetApp()->GetDeferredDeletionQueue();
+    if (pDeferredDeletionQueue)
+    {
+        pDeferredDeletionQueue->Retire(shared_from_this(), offset, size);
+    }
+    else
+    {
+        //no command queue is created,so nothing can use them.
+        ReleaseDescriptors(offset, size);
+    }
 }
 
-void DescriptorAllocatorPage::ReleaseStaleDescriptors(UINT CurrentFrame)
+void DescriptorAllocatorPage::ReleaseDescriptors(UINT Offset, UINT NumDescriptors)
 {
     //-----------------------------------------------------
     std::lock_guard<std::mutex> lock(m_AllocationMutex);
     //-----------------------------------------------------
-
-    //Note: the CurrentFrame is biggest frame that we can safely release.
-    //So we must make sure that the descirptors which frame is greater than currentFrame in stale descirptor queue
-    //will not be reused.
-    while (!m_StaleDescriptorQueue.empty() && m_StaleDescriptorQueue.front().Frame <= CurrentFrame)
+    ReleaseBlock(Offset, NumDescriptors);
+    //shader visible descriptors are never the source of copies.
+    if (!m_IsShaderVisible)
     {
-        ReleaseBlock(m_StaleDescriptorQueue.front().Offset, m_StaleDescriptorQueue.front().Size);
-        
-        m_StaleDescriptorQueue.pop();
+        ms_ReleaseEpoch[m_DescriptorHeapType].fetch_add(1, std::memory_order_release);
     }
 }
 
+uint64_t DescriptorAllocatorPage::GetReleaseEpoch(D3D12_DESCRIPTOR_HEAP_TYPE Type)
+{
+    return ms_ReleaseEpoch[Type].load(std::memory_order_acquire);
+}
@@ -3,18 +3,30 @@
 #include "RootSignature.h"
 #include "d3dUtil.h"
 #include "CommandList.h"
+#include "BindlessDescriptorHeap.h"
+#include "DescriptorAllocatorPage.h"
+#include <algorithm>
 #include <stdexcept>
 
+std::atomic<uint64_t> DynamicDescriptorHeap::ms_NumTableCacheHits(0);
+std::atomic<uint64_t> DynamicDescriptorHeap::ms_NumTableCacheMisses(0);
+std::atomic<uint64_t> DynamicDescriptorHeap::ms_NumDescriptorsCopied(0);
+std::atomic<uint64_t> DynamicDescriptorHeap::ms_NumDescriptorsReused(0);
+
 DynamicDescriptorHeap::DynamicDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE HeapType, UINT HeapSize /* = 1024 */)
     :m_DescriptorHeapType(HeapType)
     ,m_DescriptorHeapSize(HeapSize)
     ,m_CurrentGpuDescriptorHeap(nullptr)
+    ,m_pCurrentDescriptorHeap(nullptr)
     ,m_DescriptorTableCache{}
     ,m_CurrentFreeNumHandle(0)
     ,m_DescriptorIncrementSize(0)
     ,m_DescriptorTableBitMask(0)
     ,m_StageDescriptorTableBitMask(0)
+    ,m_FrameIndex(0)
+    ,m_TableCacheEpoch(0)
 {
+    m_TableCacheEpoch = DescriptorAllocatorPage::GetReleaseEpoch(m_DescriptorHeapType);
     m_DescriptorIncrementSize = Application::GetApp()->GetDescriptorIncrementSize(m_DescriptorHeapType);
 
     m_DescriptorCpuCache = std::make_unique<D3D12_CPU_DESCRIPTOR_HANDLE[]>(m_DescriptorHeapSize);
@@ -43,6 +55,8 @@ void DynamicDescriptorHeap::ParseRootSignature(const RootSignature& rootSignatur
 
         m_DescriptorTableCache[rootIndex].BaseDescriptor = m_DescriptorCpuCache.get() + offset;
         m_DescriptorTableCache[rootIndex].DescriptorsNum = descriptorNum;
+        //the cpu cache may hold anything now.
+        m_DescriptorTableCache[rootIndex].NumNonNullDescriptors = descriptorNum;
 
         offset += descriptorNum;
         assert(offset <= m_DescriptorHeapSize && "The DescriptorHeap Size Is Not Big Enough");
@@ -72,29 +86,58 @@ void DynamicDescriptorHeap::StageDescriptors(const D3D12_CPU_DESCRIPTOR_HANDLE B
     {
         OffsetedDescriptor[i] = CD3DX12_CPU_DESCRIPTOR_HANDLE(BaseDescriptorHandle, i, m_DescriptorIncrementSize);
     }
+    auto& numNonNull = m_DescriptorTableCache[ParameterIndex].NumNonNullDescriptors;
+    numNonNull = (std::max)(numNonNull, Offset + DescriptorsNum);
 
     //Update staged descriptor table bit mask
     m_StageDescriptorTableBitMask |= 1 << ParameterIndex;
 }
 
+void DynamicDescriptorHeap::StageNullDescriptors(const D3D12_CPU_DESCRIPTOR_HANDLE NullDescriptorHandle, UINT ParameterIndex, UINT Offset)
+{
+    assert(ParameterIndex < m_MaxNumDescriptorTable && "Error!Root parameter index is out of range!");
+    auto& table = m_DescriptorTableCache[ParameterIndex];
+    assert(table.DescriptorsNum > 0 && "There Is No Descriptor In This Table or this root parameter is not descriptor table type");
+    assert(Offset <= table.DescriptorsNum && "Error!Offset exceeds descriptors numbers in table!");
+    assert(table.DescriptorsNum <= Application::MaxNullDescriptors && "Error!The table is bigger than null descriptor table!");
+
+    //slots after NumNonNullDescriptors are null already,and need not be staged again.
+    if (Offset >= table.NumNonNullDescriptors)
+    {
+        return;
+    }
+    //null descriptors are all same,so they are taken from the start of null table.
+    for (UINT i = Offset; i < table.NumNonNullDescriptors; ++i)
+    {
+        table.BaseDescriptor[i] = CD3DX12_CPU_DESCRIPTOR_HANDLE(NullDescriptorHandle, i - Offset, m_DescriptorIncrementSize);
+    }
+    table.NumNonNullDescriptors = Offset;
+
+    m_StageDescriptorTableBitMask |= 1 << ParameterIndex;
+}
+
 void DynamicDescriptorHeap::CommittedStagedDescriptors(CommandList& commandList, std::function<void(ID3D12GraphicsCommandList2*, UINT, D3D12_GPU_DESCRIPTOR_HANDLE)> setFun)
 {
+    if (m_StageDescriptorTableBitMask == 0)
+    {
+        return;
+    }
+    ValidateTableCache();
+    //Tables which are same as cached tables are bound without copying.
+    CommitCachedTables(commandList, setFun);
     //Before commit descriptors to Gpu descriptor heap ,we need to verify if the Gpu heap has enough space
     UINT stageDescriptorNum = ComputeStageDescriptorNum();
     //If some changes in descriptor heap
     if (stageDescriptorNum > 0)
     {
-        if (!m_CurrentGpuDescriptorHeap || stageDescriptorNum > m_CurrentFreeNumHandle)
+        if (stageDescriptorNum > m_CurrentFreeNumHandle)
         {
-            m_CurrentGpuDescriptorHeap = RequestDescriptorHeap();
-            m_CurrentCpuDescriptorHandle = m_CurrentGpuDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-            m_CurrentGpuDescriptorHandle = m_CurrentGpuDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
-            m_CurrentFreeNumHandle = m_DescriptorHeapSize;
-
-            //Here we need use commandlist to reset descriptorheap.
-            commandList.SetDescriptorHeap(m_DescriptorHeapType, m_CurrentGpuDescriptorHeap.Get());
-
-            m_StageDescriptorTableBitMask = m_DescriptorTableBitMask;
+            RequestNewDescriptorSpace(commandList);
+        }
+        else
+        {
+            //the heap may be kept from last frame,it is not bound after commandlist is reset.
+            commandList.SetDescriptorHeap(m_DescriptorHeapType, m_pCurrentDescriptorHeap);
         }
 
         DWORD rootIndex = 0;
@@ -118,6 +161,17 @@ void DynamicDescriptorHeap::CommittedStagedDescriptors(CommandList& commandList,
 
             //After copy,we can bind handle to commandlist
             setFun(commandList.GetGraphicsCommandList2().Get(), rootIndex, m_CurrentGpuDescriptorHandle);
+            //Cache the table,a table with same hash is replaced.
+            auto& cachedTable = m_TableCache[HashTable(rootIndex)];
+            cachedTable.GpuDescriptorHandle = m_CurrentGpuDescriptorHandle;
+            cachedTable.LastUsedFrame = m_FrameIndex;
+            cachedTable.Descriptors.resize(srcDescriptorNum);
+            for (UINT i = 0; i < srcDescriptorNum; ++i)
+            {
+                cachedTable.Descriptors[i] = srcDescriptorStart[i].ptr;
+            }
+            ++m_TableCacheStatistics.NumMisses;
+            m_TableCacheStatistics.NumDescriptorsCopied += srcDescriptorNum;
             //
             m_CurrentCpuDescriptorHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_CurrentCpuDescriptorHandle, srcDescriptorNum, m_DescriptorIncrementSize);
             m_CurrentGpuDescriptorHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_CurrentGpuDescriptorHandle, srcDescriptorNum, m_DescriptorIncrementSize);
@@ -141,17 +195,13 @@ void DynamicDescriptorHeap::CommittedStagedDescriptorsForDispatch(CommandList& c
 D3D12_GPU_DESCRIPTOR_HANDLE DynamicDescriptorHeap::CopySingleDescriptor(CommandList& commandList, D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptor)
 {
     //Check if the descriptorheap has enough space.
-    if (!m_CurrentGpuDescriptorHeap || m_CurrentFreeNumHandle < 1)
+    if (m_CurrentFreeNumHandle < 1)
     {
-        m_CurrentGpuDescriptorHeap = RequestDescriptorHeap();
-        m_CurrentCpuDescriptorHandle = m_CurrentGpuDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-        m_CurrentGpuDescriptorHandle = m_CurrentGpuDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
-        m_CurrentFreeNumHandle = m_DescriptorHeapSize;
-
-        //Here we need use commandlist to reset descriptorheap.
-        commandList.SetDescriptorHeap(m_DescriptorHeapType, m_CurrentGpuDescriptorHeap.Get());
-
-        m_StageDescriptorTableBitMask = m_DescriptorTableBitMask;
+        RequestNewDescriptorSpace(commandList);
+    }
+    else
+    {
+        commandList.SetDescriptorHeap(m_DescriptorHeapType, m_pCurrentDescriptorHeap);
     }
 
     auto device = Application::GetApp()->GetDevice();
@@ -197,6 +247,36 @@ Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> DynamicDescriptorHeap::CreateDescri
     return heap;
 }
 
+void DynamicDescriptorHeap::RequestNewDescriptorSpace(CommandList& commandList)
+{
+    auto pBindlessHeap = m_DescriptorHeapType == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV ?
+        Application::GetApp()->GetBindlessDescriptorHeap() : nullptr;
+
+    if (pBindlessHeap)
+    {
+        m_BindlessBlocks.push_back(pBindlessHeap->Allocate(m_DescriptorHeapSize));
+        m_CurrentCpuDescriptorHandle = m_BindlessBlocks.back().GetDescriptorHandle();
+        m_CurrentGpuDescriptorHandle = pBindlessHeap->GetGpuDescriptorHandle(m_CurrentCpuDescriptorHandle);
+        m_pCurrentDescriptorHeap = pBindlessHeap->GetD3D12DescriptorHeap();
+    }
+    else
+    {
+        m_CurrentGpuDescriptorHeap = RequestDescriptorHeap();
+        m_CurrentCpuDescriptorHandle = m_CurrentGpuDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+        m_CurrentGpuDescriptorHandle = m_CurrentGpuDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
+        m_pCurrentDescriptorHeap = m_CurrentGpuDescriptorHeap.Get();
+    }
+    m_CurrentFreeNumHandle = m_DescriptorHeapSize;
+    //cached tables are in last heap,which is not bound anymore.
+    m_TableCache.clear();
+
+    //Here we need use commandlist to reset descriptorheap.
+    commandList.SetDescriptorHeap(m_DescriptorHeapType, m_pCurrentDescriptorHeap);
+
+    //All tables are copied to the new space again.
+    m_StageDescriptorTableBitMask = m_DescriptorTableBitMask;
+}
+
 UINT DynamicDescriptorHeap::ComputeStageDescriptorNum()
 {
     UINT mask = m_StageDescriptorTableBitMask;
@@ -212,19 +292,129 @@ UINT DynamicDescriptorHeap::ComputeStageDescriptorNum()
     return Counter;
 }
 
+void DynamicDescriptorHeap::CommitCachedTables(CommandList& commandList, const std::function<void(ID3D12GraphicsCommandList2*, UINT, D3D12_GPU_DESCRIPTOR_HANDLE)>& setFun)
+{
+    if (m_TableCache.empty())
+    {
+        return;
+    }
+    UINT mask = m_StageDescriptorTableBitMask;
+    DWORD rootIndex = 0;
+    bool isHeapBound = false;
+    while (_BitScanForward(&rootIndex, mask))
+    {
+        mask ^= (1 << rootIndex);
+
+        auto iter = m_TableCache.find(HashTable(rootIndex));
+        if (iter == m_TableCache.end())
+        {
+            continue;
+        }
+        UINT descriptorNum = m_DescriptorTableCache[rootIndex].DescriptorsNum;
+        const D3D12_CPU_DESCRIPTOR_HANDLE* descriptors = m_DescriptorTableCache[rootIndex].BaseDescriptor;
+        auto& cachedTable = iter->second;
+        bool isSame = cachedTable.Descriptors.size() == descriptorNum && m_FrameIndex - cachedTable.LastUsedFrame < MaxCachedFrames;
+        for (UINT i = 0; i < descriptorNum && isSame; ++i)
+        {
+            isSame = cachedTable.Descriptors[i] == descriptors[i].ptr;
+        }
+        if (!isSame)
+        {
+            continue;
+        }
+        //the heap may be kept from last frame,it is not bound after commandlist is reset.
+        if (!isHeapBound)
+        {
+            commandList.SetDescriptorHeap(m_DescriptorHeapType, m_pCurrentDescriptorHeap);
+            isHeapBound = true;
+        }
+        setFun(commandList.GetGraphicsCommandList2().Get(), rootIndex, cachedTable.GpuDescriptorHandle);
+        cachedTable.LastUsedFrame = m_FrameIndex;
+
+        ++m_TableCacheStatistics.NumHits;
+        m_TableCacheStatistics.NumDescriptorsReused += descriptorNum;
+        m_StageDescriptorTableBitMask ^= (1 << rootIndex);
+    }
+}
+
+size_t DynamicDescriptorHeap::HashTable(UINT RootIndex)const
+{
+    const auto& table = m_DescriptorTableCache[RootIndex];
+    size_t seed = 0;
+    std::hash_combine(seed, table.DescriptorsNum);
+    for (UINT i = 0; i < table.DescriptorsNum; ++i)
+    {
+        std::hash_combine(seed, table.BaseDescriptor[i].ptr);
+    }
+    return seed;
+}
+
+void DynamicDescriptorHeap::ValidateTableCache()
+{
+    uint64_t epoch = DescriptorAllocatorPage::GetReleaseEpoch(m_DescriptorHeapType);
+    if (epoch != m_TableCacheEpoch)
+    {
+        m_TableCache.clear();
+        m_TableCacheEpoch = epoch;
+    }
+}
+
+DescriptorTableCacheStatistics DynamicDescriptorHeap::GetTableCacheStatistics()
+{
+    DescriptorTableCacheStatistics statistics;
+    statistics.NumHits = ms_NumTableCacheHits.load(std::memory_order_relaxed);
+    statistics.NumMisses = ms_NumTableCacheMisses.load(std::memory_order_relaxed);
+    statistics.NumDescriptorsCopied = ms_NumDescriptorsCopied.load(std::memory_order_relaxed);
+    statistics.NumDescriptorsReused = ms_NumDescriptorsReused.load(std::memory_order_relaxed);
+    return statistics;
+}
+
 void DynamicDescriptorHeap::Reset()
 {
     for (int i = 0; i < m_MaxNumDescriptorTable; ++i)
     {
-        m_DescriptorTableCache->Reset();
+        m_DescriptorTableCache[i].Reset();
     }
-    m_CurrentGpuDescriptorHeap.Reset();
-    m_CurrentCpuDescriptorHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(D3D12_DEFAULT);
-    m_CurrentGpuDescriptorHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(D3D12_DEFAULT);
     m_DescriptorTableBitMask = 0;
     m_StageDescriptorTableBitMask = 0;
-    m_AvailDescriptorHeapPool = m_AllDescriptorHeapPool;
-    m_CurrentFreeNumHandle = 0;
+
+    //Statistics are gathered here,so committing does not touch atomics.
+    ms_NumTableCacheHits.fetch_add(m_TableCacheStatistics.NumHits, std::memory_order_relaxed);
+    ms_NumTableCacheMisses.fetch_add(m_TableCacheStatistics.NumMisses, std::memory_order_relaxed);
+    ms_NumDescriptorsCopied.fetch_add(m_TableCacheStatistics.NumDescriptorsCopied, std::memory_order_relaxed);
+    ms_NumDescriptorsReused.fetch_add(m_TableCacheStatistics.NumDescriptorsReused, std::memory_order_relaxed);
+    m_TableCacheStatistics = DescriptorTableCacheStatistics();
+
+    //The commandlist is finished by gpu now,so current heap is kept with its cached tables,and other heaps can be reused.
+    ++m_FrameIndex;
+    for (auto iter = m_TableCache.begin(); iter != m_TableCache.end();)
+    {
+        if (m_FrameIndex - iter->second.LastUsedFrame >= MaxCachedFrames)
+        {
+            iter = m_TableCache.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+    m_AvailDescriptorHeapPool = DescriptorHeapPool();
+    DescriptorHeapPool allDescriptorHeaps = m_AllDescriptorHeapPool;
+    while (!allDescriptorHeaps.empty())
+    {
+        if (allDescriptorHeaps.front() != m_CurrentGpuDescriptorHeap)
+        {
+            m_AvailDescriptorHeapPool.push(allDescriptorHeaps.front());
+        }
+        allDescriptorHeaps.pop();
+    }
+    //the blocks go to deferred deletion queue,they are reused after the gpu is done with them.
+    if (!m_BindlessBlocks.empty())
+    {
+        auto currentBlock = std::move(m_BindlessBlocks.back());
+        m_BindlessBlocks.clear();
+        m_BindlessBlocks.push_back(std::move(currentBlock));
+    }
 
     //Do not reset unique_ptr
 }
\ No newline at end of file
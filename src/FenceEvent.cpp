@@ -0,0 +1,76 @@
+#include "FenceEvent.h"
+
+#include <cassert>
+
+#if defined(_WIN32)
+
+FenceEvent::FenceEvent()
+    : m_hEvent(::CreateEvent(NULL, FALSE, FALSE, NULL))
+{
+    assert(m_hEvent && "Failed to create fence event handle.");
+}
+
+FenceEvent::~FenceEvent()
+{
+    ::CloseHandle(m_hEvent);
+}
+
+void FenceEvent::Set(HANDLE hEvent)
+{
+    ::SetEvent(hEvent);
+}
+
+void FenceEvent::Wait()
+{
+    ::WaitForSingleObject(m_hEvent, INFINITE);
+}
+
+#else
+
+#include <mutex>
+#include <condition_variable>
+
+namespace
+{
+    struct PortableEvent
+    {
+        std::mutex Mutex;
+        std::condition_variable ConditionVariable;
+        bool bSignaled = false;
+    };
+}
+
+FenceEvent::FenceEvent()
+    : m_hEvent(new PortableEvent())
+{}
+
+FenceEvent::~FenceEvent()
+{
+    delete static_cast<PortableEvent*>(m_hEvent);
+}
+
+void FenceEvent::Set(HANDLE hEvent)
+{
+    auto pEvent = static_cast<PortableEvent*>(hEvent);
+    {
+        std::lock_guard<std::mutex> lock(pEvent->Mutex);
+        pEvent->bSignaled = true;
+    }
+    //it is auto-reset,only one waiting thread takes the signal.
+    pEvent->ConditionVariable.notify_one();
+}
+
+void FenceEvent::Wait()
+{
+    auto pEvent = static_cast<PortableEvent*>(m_hEvent);
+    std::unique_lock<std::mutex> lock(pEvent->Mutex);
+    pEvent->ConditionVariable.wait(lock, [pEvent]() { return pEvent->bSignaled; });
+    pEvent->bSignaled = false;
+}
+
+#endif
+
+void FenceEvent::Set()
+{
+    Set(m_hEvent);
+}
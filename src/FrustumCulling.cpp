@@ -1,5 +1,7 @@
 #include "FrustumCulling.h"
 #include "Model.h"
+#include "Application.h"
+#include "JobSystem.h"
 
 FrustumCullinger::FrustumCullinger()
 {
@@ -27,60 +29,80 @@ void FrustumCullinger::BindModelCulled(const Model* pModel)
     if (m_IsOpenCulling && pModel)
     {
         m_pModel = pModel;
-        //For perspective camera.
-        if (m_FrustumCamera->GetCameraStyle() == CameraStyle::Perspective)
+
+        std::vector<UINT8> visibility;
+        GetModelVisibility(pModel, visibility);
+
+        const auto& meshes = m_pModel->m_ModelLoader->Meshes();
+        for (size_t i = 0; i < meshes.size(); ++i)
         {
-            //we need to transform frustum aabb to model local space
-            DirectX::BoundingFrustum frustum;
-            m_FrustumCamera->GetCameraFrustum(frustum);
+            meshes[i].m_IsCulled = visibility[i] == 0;
+        }
+    }
+}
 
-            DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&m_pModel->GetWorldMatrix4x4f());
+void FrustumCullinger::GetModelVisibility(const Model* pModel, std::vector<UINT8>& MeshVisibility)const
+{
+    const auto& meshes = pModel->m_ModelLoader->Meshes();
+    MeshVisibility.assign(meshes.size(), 1);
+    if (!m_IsOpenCulling)
+    {
+        return;
+    }
+    assert(m_FrustumCamera && "You need to bind camera firstly!");
 
-            DirectX::XMMATRIX InvViewWorld =
-                m_FrustumCamera->GetInvView() * DirectX::XMMatrixInverse(&DirectX::XMMatrixDeterminant(world), world);
-            //
-            DirectX::BoundingFrustum localFrustum;
-            frustum.Transform(localFrustum, InvViewWorld);
+    DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&pModel->GetWorldMatrix4x4f());
+    //we need to transform frustum aabb to model local space
+    DirectX::XMMATRIX InvViewWorld =
+        m_FrustumCamera->GetInvView() * DirectX::XMMatrixInverse(&DirectX::XMMatrixDeterminant(world), world);
+    //For perspective camera.
+    if (m_FrustumCamera->GetCameraStyle() == CameraStyle::Perspective)
+    {
+        DirectX::BoundingFrustum frustum;
+        m_FrustumCamera->GetCameraFrustum(frustum);
+        //
+        DirectX::BoundingFrustum localFrustum;
+        frustum.Transform(localFrustum, InvViewWorld);
 
-            for (auto& mesh : m_pModel->m_ModelLoader->Meshes())
-            {
-                if (localFrustum.Contains(mesh.mMeshAABB) != DirectX::DISJOINT)
-                {
-                    mesh.m_IsCulled = false;
-                }
-                else
-                {
-                    mesh.m_IsCulled = true;
-                }
-            }
-        }
-        //For orthographic camera.
-        else
+        for (size_t i = 0; i < meshes.size(); ++i)
         {
-            DirectX::BoundingBox frustum;
-            m_FrustumCamera->GetCameraFrustum(frustum);
-            //transform aabb from camera space to local space.
-            DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&m_pModel->GetWorldMatrix4x4f());
+            MeshVisibility[i] = localFrustum.Contains(meshes[i].mMeshAABB) != DirectX::DISJOINT;
+        }
+    }
+    //For orthographic camera.
+    else
+    {
+        DirectX::BoundingBox frustum;
+        m_FrustumCamera->GetCameraFrustum(frustum);
+        //transform aabb from camera space to local space.
+        DirectX::BoundingBox localFrustum;
+        frustum.Transform(localFrustum, InvViewWorld);
 
-            DirectX::XMMATRIX InvViewWorld =
-                m_FrustumCamera->GetInvView() * DirectX::XMMatrixInverse(&DirectX::XMMatrixDeterminant(world), world);
-            //
-            DirectX::BoundingBox localFrustum;
-            frustum.Transform(localFrustum, InvViewWorld);
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            MeshVisibility[i] = localFrustum.Contains(meshes[i].mMeshAABB) != DirectX::DISJOINT;
+        }
+    }
+}
 
-            for (auto& mesh : m_pModel->m_ModelLoader->Meshes())
+void FrustumCullinger::GetModelsVisibility(const std::vector<const Model*>& Models, std::vector<std::vector<UINT8>>& MeshVisibilities)const
+{
+    MeshVisibilities.resize(Models.size());
+    //Each model writes its own visibility,so models are culled at same time.
+    Application::GetApp()->GetJobSystem()->ParallelFor(Models.size(), 1, [&](size_t Begin, size_t End)
+    {
+        for (size_t i = Begin; i < End; ++i)
+        {
+            if (Models[i])
             {
-                if (localFrustum.Contains(mesh.mMeshAABB) != DirectX::DISJOINT)
-                {
-                    mesh.m_IsCulled = false;
-                }
-                else
-                {
-                    mesh.m_IsCulled = true;
-                }
+                GetModelVisibility(Models[i], MeshVisibilities[i]);
+            }
+            else
+            {
+                MeshVisibilities[i].clear();
             }
         }
-    }
+    });
 }
 
 bool FrustumCullinger::IsCull(const ModelSpace::Mesh* pMesh)
@@ -1,4 +1,27 @@
 #include "GameTimer.h"
+#include <chrono>
+
+int64_t GameTimer::QueryCount()
+{
+#if defined(_WIN32)
+    int64_t count;
+    QueryPerformanceCounter((LARGE_INTEGER*)&count);
+    return count;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+int64_t GameTimer::QueryCountsPerSecond()
+{
+#if defined(_WIN32)
+    int64_t countsPerSecond;
+    QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSecond);
+    return countsPerSecond;
+#else
+    return 1000000000;
+#endif
+}
 
 void GameTimer::Tick()
 {
@@ -8,8 +31,7 @@ void GameTimer::Tick()
         return;
     }
 
-    __int64 currenttime;
-    QueryPerformanceCounter((LARGE_INTEGER*)&currenttime);
+    int64_t currenttime = QueryCount();
 
     mCurrTime = currenttime;
     mDeltaTime = (currenttime - mPrevTime) * mSecondsPerCount;
@@ -26,8 +48,7 @@ void GameTimer::Stop()
     if (mStopped)
         return;
 
-    __int64 currenttime;
-    QueryPerformanceCounter((LARGE_INTEGER*)&currenttime);
+    int64_t currenttime = QueryCount();
 
     mStopTime = currenttime;
     mStopped = true;
@@ -38,8 +59,7 @@ void GameTimer::Start()
     if (!mStopped)
         return;
 
-    __int64 currenttime;
-    QueryPerformanceCounter((LARGE_INTEGER*)&currenttime);
+    int64_t currenttime = QueryCount();
 
     mPrevTime = currenttime;
     mPausedTime += currenttime - mStopTime;
@@ -63,8 +83,7 @@ double GameTimer::TotalTime()const
 
 void GameTimer::Reset()
 {
-    __int64 currenttime;
-    QueryPerformanceCounter((LARGE_INTEGER*)&currenttime);
+    int64_t currenttime = QueryCount();
     
     mBaseTime = currenttime;
     mStopTime = 0;
@@ -11,20 +11,6 @@ GenerateMips::GenerateMips()
     auto commandQueue = Application::GetApp()->GetCommandQueue();
     auto commandList = commandQueue->GetCommandList();
     m_ComputeRootSignature = std::make_unique<RootSignature>();
-    //Allocate descriptors for UAVs
-    m_DefaultUAV = Application::GetApp()->AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 4);
-        //Since these resources are created during runtime,we need to create UAVs here
-    for (UINT i = 0; i < 4; ++i)
-    {
-        //here format is not important.
-        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
-        uavDesc.Texture2D.MipSlice = i;
-        uavDesc.Texture2D.PlaneSlice = 0;
-        uavDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
-        uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
-
-        device->CreateUnorderedAccessView(nullptr, nullptr, &uavDesc, m_DefaultUAV.GetDescriptorHandle(i));
-    }
     //Check root signature highest version
     D3D12_FEATURE_DATA_ROOT_SIGNATURE rootSigVersion = {};
     rootSigVersion.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
@@ -148,11 +148,10 @@ void GenerateSAT::GenerateSATs(std::shared_ptr<CommandList> commandList)
         ComputeCommandList->SetUnorderedAccessView(0, 1, m_pPingPong1Texture.get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, 0, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, &UavDesc);
         ComputeCommandList->Dispatch((int)textureDesc.Width / 256, (int)textureDesc.Height, textureDesc.DepthOrArraySize);
     }
-    //If we use a new compute command queue,we need to wait these commands finish
+    //If we use a new compute command queue,the copy commandlist waits for these commands on gpu
     if (ComputeCommandList != commandList)
     {
         auto commandQueue = Application::GetApp()->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COMPUTE);
-        auto fence = commandQueue->ExecuteCommandList(ComputeCommandList);
-        commandQueue->WaitForFenceValue(fence);
+        commandList->AddDependency(commandQueue->ExecuteCommandList(ComputeCommandList));
     }
 }
\ No newline at end of file
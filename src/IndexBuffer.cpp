@@ -1,5 +1,6 @@
 #include "IndexBuffer.h"
 #include <assert.h>
+#include <stdexcept>
 
 IndexBuffer::IndexBuffer(const std::wstring& indexName /* = L"NoName" */)
     :Buffer(indexName)
@@ -29,10 +30,10 @@ void IndexBuffer::SetD3D12Resource(Microsoft::WRL::ComPtr<ID3D12Resource>& d3d12
 
 D3D12_CPU_DESCRIPTOR_HANDLE IndexBuffer::GetShaderResourceView(const D3D12_SHADER_RESOURCE_VIEW_DESC* SrvDesc)const
 {
-    throw std::exception("Error! Index buffer does not have shader resource view");
+    throw std::runtime_error("Error! Index buffer does not have shader resource view");
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE IndexBuffer::GetUnorderedAccessView(const D3D12_UNORDERED_ACCESS_VIEW_DESC* UavDesc)const
 {
-    throw std::exception("Error! Index buffer does not have unordered resource view");
+    throw std::runtime_error("Error! Index buffer does not have unordered resource view");
 }
\ No newline at end of file
@@ -0,0 +1,349 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+//Which job system and deque the current thread belongs to.Non-worker threads have no deque.
+static thread_local const JobSystem* gs_pWorkerJobSystem = nullptr;
+static thread_local size_t gs_WorkerIndex = (std::numeric_limits<size_t>::max)();
+
+JobSystem::JobSystem(size_t NumWorkers)
+    : m_MainThreadId(std::this_thread::get_id())
+    , m_NextQueue(0)
+    , m_NumQueuedJobs(0)
+    , m_NumSleepingWorkers(0)
+    , m_NumSleepingWaiters(0)
+    , m_bStop(false)
+    , m_JobsExecuted(0)
+    , m_JobsStolen(0)
+    , m_MainThreadJobsExecuted(0)
+    , m_DeferredJobs(0)
+    , m_WorkerSleeps(0)
+    , m_WaiterSleeps(0)
+{
+    if (NumWorkers == 0)
+    {
+        size_t numHardwareThreads = std::thread::hardware_concurrency();
+        NumWorkers = numHardwareThreads > 1 ? numHardwareThreads - 1 : 1;
+    }
+    //every worker has a deque,threads which are not workers push to them in turn.
+    for (size_t i = 0; i < NumWorkers; ++i)
+    {
+        m_WorkerQueues.push_back(std::make_unique<WorkerQueue>());
+    }
+    m_Workers.reserve(NumWorkers);
+    for (size_t i = 0; i < NumWorkers; ++i)
+    {
+        m_Workers.emplace_back(&JobSystem::WorkerThread, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_WakeMutex);
+        m_bStop = true;
+    }
+    m_WakeCondition.notify_all();
+    for (auto& worker : m_Workers)
+    {
+        worker.join();
+    }
+    //main thread jobs which have not been executed
+    ExecuteMainThreadJobs();
+}
+
+void JobSystem::Schedule(std::function<void()> Func, JobCounter* pCounter, JobAffinity Affinity)
+{
+    if (pCounter)
+    {
+        pCounter->m_Count.fetch_add(1, std::memory_order_acq_rel);
+    }
+    Job job;
+    job.Func = std::move(Func);
+    job.pCounter = pCounter;
+    job.Affinity = Affinity;
+    Push(std::move(job));
+}
+
+void JobSystem::ScheduleAfter(JobCounter& Dependency, std::function<void()> Func, JobCounter* pCounter, JobAffinity Affinity)
+{
+    assert(&Dependency != pCounter && "Error!A job can not depend on its own counter!");
+    if (pCounter)
+    {
+        pCounter->m_Count.fetch_add(1, std::memory_order_acq_rel);
+    }
+    Job job;
+    job.Func = std::move(Func);
+    job.pCounter = pCounter;
+    job.Affinity = Affinity;
+    {
+        //the zero transition of a counter happens under its mutex,so the job is either pushed now or by FinishJob()
+        std::lock_guard<std::mutex> lock(Dependency.m_Mutex);
+        if (Dependency.m_Count.load(std::memory_order_acquire) != 0)
+        {
+            Dependency.m_Dependents.push_back(std::move(job));
+            m_DeferredJobs.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    Push(std::move(job));
+}
+
+void JobSystem::ParallelFor(size_t Count, size_t GrainSize, const std::function<void(size_t Begin, size_t End)>& Func)
+{
+    if (Count == 0)
+    {
+        return;
+    }
+    if (GrainSize == 0)
+    {
+        size_t numRanges = m_Workers.size() + 1;
+        GrainSize = (Count + numRanges - 1) / numRanges;
+    }
+
+    JobCounter counter;
+    for (size_t begin = GrainSize; begin < Count; begin += GrainSize)
+    {
+        size_t end = (std::min)(begin + GrainSize, Count);
+        Schedule([&Func, begin, end]() { Func(begin, end); }, &counter);
+    }
+    //the calling thread takes the first range
+    Func(0, (std::min)(GrainSize, Count));
+    Wait(counter);
+}
+
+void JobSystem::Wait(JobCounter& Counter)
+{
+    bool bMainThread = IsMainThread();
+    while (Counter.m_Count.load(std::memory_order_acquire) != 0)
+    {
+        Job job;
+        if (bMainThread && m_MainThreadJobs.TryPop(job))
+        {
+            m_MainThreadJobsExecuted.fetch_add(1, std::memory_order_relaxed);
+            Execute(job);
+        }
+        else if (Pop(job))
+        {
+            Execute(job);
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lock(m_WakeMutex);
+            //FinishJob() and Push() read the number of sleeping waiters after they change the counter or a queue,
+            //so either they see us sleeping and notify,or we see their change here.
+            m_NumSleepingWaiters.fetch_add(1);
+            auto canWake = [&]()
+            {
+                return Counter.m_Count.load() == 0 || m_NumQueuedJobs.load() != 0 ||
+                    (bMainThread && !m_MainThreadJobs.Empty());
+            };
+            if (!canWake())
+            {
+                m_WaiterSleeps.fetch_add(1, std::memory_order_relaxed);
+                m_WakeCondition.wait(lock, canWake);
+            }
+            m_NumSleepingWaiters.fetch_sub(1);
+        }
+    }
+    //the last job may still hold the mutex to push its dependents,
+    //we must not return before it,since the counter can be destroyed after Wait().
+    std::lock_guard<std::mutex> lock(Counter.m_Mutex);
+}
+
+void JobSystem::ExecuteMainThreadJobs()
+{
+    assert(IsMainThread() && "Error!Main thread jobs can only be executed on the main thread!");
+    //only execute jobs which are queued now,jobs scheduled by them will be executed next time.
+    size_t numJobs = m_MainThreadJobs.Size();
+    Job job;
+    for (size_t i = 0; i < numJobs && m_MainThreadJobs.TryPop(job); ++i)
+    {
+        m_MainThreadJobsExecuted.fetch_add(1, std::memory_order_relaxed);
+        Execute(job);
+    }
+}
+
+JobSystemStatistics JobSystem::GetStatistics()const
+{
+    JobSystemStatistics statistics;
+    statistics.JobsExecuted = m_JobsExecuted.load(std::memory_order_relaxed);
+    statistics.JobsStolen = m_JobsStolen.load(std::memory_order_relaxed);
+    statistics.MainThreadJobs = m_MainThreadJobsExecuted.load(std::memory_order_relaxed);
+    statistics.DeferredJobs = m_DeferredJobs.load(std::memory_order_relaxed);
+    statistics.WorkerSleeps = m_WorkerSleeps.load(std::memory_order_relaxed);
+    statistics.WaiterSleeps = m_WaiterSleeps.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+void JobSystem::ResetStatistics()
+{
+    m_JobsExecuted = 0;
+    m_JobsStolen = 0;
+    m_MainThreadJobsExecuted = 0;
+    m_DeferredJobs = 0;
+    m_WorkerSleeps = 0;
+    m_WaiterSleeps = 0;
+}
+
+void JobSystem::WorkerThread(size_t WorkerIndex)
+{
+    gs_pWorkerJobSystem = this;
+    gs_WorkerIndex = WorkerIndex;
+
+    while (true)
+    {
+        Job job;
+        if (Pop(job))
+        {
+            Execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_WakeMutex);
+        if (m_bStop && m_NumQueuedJobs.load() == 0)
+        {
+            break;
+        }
+        //Push() reads the number of sleeping workers after it increases queued jobs,
+        //so either it sees us sleeping and notifies,or we see its job here.
+        m_NumSleepingWorkers.fetch_add(1);
+        if (m_NumQueuedJobs.load() == 0 && !m_bStop)
+        {
+            m_WorkerSleeps.fetch_add(1, std::memory_order_relaxed);
+            m_WakeCondition.wait(lock, [this]() { return m_bStop || m_NumQueuedJobs.load() != 0; });
+        }
+        m_NumSleepingWorkers.fetch_sub(1);
+    }
+}
+
+void JobSystem::Push(Job job)
+{
+    if (job.Affinity == JobAffinity::MainThread)
+    {
+        m_MainThreadJobs.Push(std::move(job));
+        //only the main thread can execute it,and it may sleep in Wait().
+        if (m_NumSleepingWaiters.load() != 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_WakeMutex);
+            }
+            m_WakeCondition.notify_all();
+        }
+        return;
+    }
+
+    //workers push to their own deque,other threads spread jobs over all deques.
+    size_t queueIndex = gs_pWorkerJobSystem == this ? gs_WorkerIndex :
+        m_NextQueue.fetch_add(1, std::memory_order_relaxed) % m_WorkerQueues.size();
+    {
+        auto& queue = *m_WorkerQueues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+        queue.Jobs.push_back(std::move(job));
+    }
+    m_NumQueuedJobs.fetch_add(1);
+    //a sleeping worker or waiter can execute the job,whichever is woken.
+    if (m_NumSleepingWorkers.load() != 0 || m_NumSleepingWaiters.load() != 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_WakeMutex);
+        }
+        m_WakeCondition.notify_one();
+    }
+}
+
+bool JobSystem::Pop(Job& job)
+{
+    if (m_NumQueuedJobs.load(std::memory_order_acquire) == 0)
+    {
+        return false;
+    }
+
+    size_t numQueues = m_WorkerQueues.size();
+    bool bWorker = gs_pWorkerJobSystem == this;
+    size_t ownIndex = bWorker ? gs_WorkerIndex : m_NextQueue.load(std::memory_order_relaxed) % numQueues;
+    //newest job of own deque is the hottest in cache
+    if (bWorker)
+    {
+        auto& queue = *m_WorkerQueues[ownIndex];
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+        if (!queue.Jobs.empty())
+        {
+            job = std::move(queue.Jobs.back());
+            queue.Jobs.pop_back();
+            m_NumQueuedJobs.fetch_sub(1);
+            return true;
+        }
+    }
+    //steal the oldest job from others
+    for (size_t i = bWorker ? 1 : 0; i < numQueues; ++i)
+    {
+        auto& queue = *m_WorkerQueues[(ownIndex + i) % numQueues];
+        std::unique_lock<std::mutex> lock(queue.Mutex, std::try_to_lock);
+        if (lock.owns_lock() && !queue.Jobs.empty())
+        {
+            job = std::move(queue.Jobs.front());
+            queue.Jobs.pop_front();
+            m_NumQueuedJobs.fetch_sub(1);
+            if (bWorker)
+            {
+                m_JobsStolen.fetch_add(1, std::memory_order_relaxed);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::Execute(Job& job)
+{
+    job.Func();
+    m_JobsExecuted.fetch_add(1, std::memory_order_relaxed);
+    if (job.pCounter)
+    {
+        FinishJob(job.pCounter);
+    }
+}
+
+void JobSystem::FinishJob(JobCounter* pCounter)
+{
+    int count = pCounter->m_Count.load(std::memory_order_acquire);
+    while (true)
+    {
+        assert(count > 0 && "Error!Job counter is decreased too many times!");
+        if (count > 1)
+        {
+            if (pCounter->m_Count.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel))
+            {
+                return;
+            }
+            continue;
+        }
+        //this may be the last job,go to zero under the mutex and take the dependents.
+        std::vector<Job> dependents;
+        {
+            std::lock_guard<std::mutex> lock(pCounter->m_Mutex);
+            //sequentially consistent,since the number of sleeping waiters is read after it.
+            if (!pCounter->m_Count.compare_exchange_strong(count, 0))
+            {
+                continue;
+            }
+            dependents.swap(pCounter->m_Dependents);
+        }
+        for (auto& dependent : dependents)
+        {
+            Push(std::move(dependent));
+        }
+        //the counter can be destroyed by its waiter now,so we only touch the job system.
+        if (m_NumSleepingWaiters.load() != 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_WakeMutex);
+            }
+            m_WakeCondition.notify_all();
+        }
+        return;
+    }
+}
@@ -1,6 +1,7 @@
 
 #include "Mesh.h"
 #include "Application.h"
+#include <stdexcept>
 
 
 using namespace DirectX;
@@ -385,7 +386,7 @@ static void ReverseWinding(IndexCollection& indices, VertexCollection& vertices)
 void Mesh::Initialize(CommandList& commandList, VertexCollection& vertices, IndexCollection& indices, bool rhcoords)
 {
     if (vertices.size() >= USHRT_MAX)
-        throw std::exception("Too many vertices for 16-bit index buffer");
+        throw std::runtime_error("Too many vertices for 16-bit index buffer");
 
     if (!rhcoords)
         ReverseWinding(indices, vertices);
@@ -14,25 +14,6 @@ Model::Model(Scene* pScene)
     ,m_pIndexBuffer(nullptr)
     ,m_ModelWorld(MathHelper::Identity4x4())
 {
-    auto device = Application::GetApp()->GetDevice();
-    //Create default SRV
-    for (int i = 0; i < TextureUsage::NumTextureUsage; ++i)
-    {
-        m_DefaultSRV[i] = Application::GetApp()->AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, m_MaxTextureNum);
-
-        D3D12_SHADER_RESOURCE_VIEW_DESC SrvDesc = {};
-        SrvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-        SrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        SrvDesc.Texture2D.MipLevels = 1;
-        SrvDesc.Texture2D.MostDetailedMip = 0;
-        SrvDesc.Texture2D.PlaneSlice = 0;
-        SrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-
-        for (int num = 0; num < m_MaxTextureNum; ++num)
-        {
-            device->CreateShaderResourceView(nullptr, &SrvDesc, m_DefaultSRV[i].GetDescriptorHandle(num));
-        }
-    }
 }
 
 Model::~Model()
@@ -101,6 +82,15 @@ void Model::Destroy()
 //}
 
 void Model::LoadModelFromFilePath(const std::string& FilePath,std::shared_ptr<CommandList> commandList)
+{
+    ImportModel(FilePath);
+    //After initilize mesh constant and materials,we need to load texture immediately
+    LoadModelTexture(commandList);
+    //then we create vertex and index buffer
+    SetVertexAndIndexBuffer(commandList);
+}
+
+void Model::ImportModel(const std::string& FilePath)
 {
     m_ModelLoader = std::make_unique<ModelSpace::ModelLoader>(FilePath);
 
@@ -175,11 +165,6 @@ void Model::LoadModelFromFilePath(const std::string& FilePath,std::shared_ptr<Co
         }
         DirectX::BoundingBox::CreateMerged(m_ModelAABB, m_ModelAABB, meshes[i].mMeshAABB);
     }
-
-    //After initilize mesh constant and materials,we need to load texture immediately
-    LoadModelTexture(commandList);
-    //then we create vertex and index buffer
-    SetVertexAndIndexBuffer(commandList);
 }
 
 void Model::SetVertexAndIndexBuffer(std::shared_ptr<CommandList> commandList)
@@ -1,4 +1,5 @@
 #include "ModelLoader.h"
+#include <cstdio>
 
 ModelSpace::Mesh::Mesh(const ModelSpace::Mesh& copy)
     :mMeshName(copy.mMeshName)
@@ -81,7 +82,11 @@ void ModelSpace::ModelLoader::LoadModel(std::string path)
     {
         std::string error = "ERROR:ASSIMP: ";
         error += import.GetErrorString();
+#if defined(_WIN32)
         OutputDebugStringA(error.c_str());
+#else
+        std::fputs(error.c_str(), stderr);
+#endif
         return;
     }
     mModelName = path.substr(path.find_last_of('\\'));
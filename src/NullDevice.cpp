@@ -0,0 +1,2517 @@
+#include "NullDevice.h"
+#include "FenceEvent.h"
+#include "d3dx12.h"
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <cassert>
+
+
+namespace
+{
+    //A private interface id,only used to recognize a null device from an ID3D12Device pointer.
+    // {6F3B1C52-4A8E-4D2B-9C61-3E570AD42F91}
+    const GUID IID_NullD3D12Device = { 0x6f3b1c52, 0x4a8e, 0x4d2b, { 0x9c, 0x61, 0x3e, 0x57, 0x0a, 0xd4, 0x2f, 0x91 } };
+    //A fake gpu virtual address space.Zero is reserved for "no address".
+    const D3D12_GPU_VIRTUAL_ADDRESS gs_NullVirtualAddressBase = 0x0000000100000000ull;
+
+    //The content of one descriptor in a null descriptor heap.
+    //Every descriptor heap type uses same layout,so the increment size is same for all types.
+    struct NullDescriptor
+    {
+        enum Type : UINT32
+        {
+            Empty,
+            ConstantBufferView,
+            ShaderResourceView,
+            UnorderedAccessView,
+            RenderTargetView,
+            DepthStencilView,
+            Sampler
+        };
+
+        ID3D12Resource*           pResource;
+        D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+        UINT32                    ViewType;
+        UINT32                    Format;
+        UINT32                    Dimension;
+        UINT32                    Reserved;
+    };
+    static_assert(sizeof(NullDescriptor) == 32, "Null descriptor should be 32 bytes");
+
+    template<typename T>
+    inline T NullAlignUp(T Value, T Alignment)
+    {
+        return (Value + Alignment - 1) & ~(Alignment - 1);
+    }
+
+    //Depth stencil formats have a depth plane and a stencil plane,so their subresource count is same as a hardware device.
+    UINT8 NullPlaneCount(DXGI_FORMAT Format)
+    {
+        switch (Format)
+        {
+        case DXGI_FORMAT_R32G8X24_TYPELESS:
+        case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+        case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+        case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
+        case DXGI_FORMAT_R24G8_TYPELESS:
+        case DXGI_FORMAT_D24_UNORM_S8_UINT:
+        case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+        case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
+            return 2;
+        default:
+            return 1;
+        }
+    }
+
+    UINT NullBitsPerPixel(DXGI_FORMAT Format)
+    {
+        switch (Format)
+        {
+        case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        case DXGI_FORMAT_R32G32B32A32_UINT:
+        case DXGI_FORMAT_R32G32B32A32_SINT:
+            return 128;
+
+        case DXGI_FORMAT_R32G32B32_TYPELESS:
+        case DXGI_FORMAT_R32G32B32_FLOAT:
+        case DXGI_FORMAT_R32G32B32_UINT:
+        case DXGI_FORMAT_R32G32B32_SINT:
+            return 96;
+
+        case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        case DXGI_FORMAT_R16G16B16A16_UNORM:
+        case DXGI_FORMAT_R16G16B16A16_UINT:
+        case DXGI_FORMAT_R16G16B16A16_SNORM:
+        case DXGI_FORMAT_R16G16B16A16_SINT:
+        case DXGI_FORMAT_R32G32_TYPELESS:
+        case DXGI_FORMAT_R32G32_FLOAT:
+        case DXGI_FORMAT_R32G32_UINT:
+        case DXGI_FORMAT_R32G32_SINT:
+        case DXGI_FORMAT_R32G8X24_TYPELESS:
+        case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+        case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+        case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
+            return 64;
+
+        case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+        case DXGI_FORMAT_R10G10B10A2_UNORM:
+        case DXGI_FORMAT_R10G10B10A2_UINT:
+        case DXGI_FORMAT_R11G11B10_FLOAT:
+        case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        case DXGI_FORMAT_R8G8B8A8_UINT:
+        case DXGI_FORMAT_R8G8B8A8_SNORM:
+        case DXGI_FORMAT_R8G8B8A8_SINT:
+        case DXGI_FORMAT_R16G16_TYPELESS:
+        case DXGI_FORMAT_R16G16_FLOAT:
+        case DXGI_FORMAT_R16G16_UNORM:
+        case DXGI_FORMAT_R16G16_UINT:
+        case DXGI_FORMAT_R16G16_SNORM:
+        case DXGI_FORMAT_R16G16_SINT:
+        case DXGI_FORMAT_R32_TYPELESS:
+        case DXGI_FORMAT_D32_FLOAT:
+        case DXGI_FORMAT_R32_FLOAT:
+        case DXGI_FORMAT_R32_UINT:
+        case DXGI_FORMAT_R32_SINT:
+        case DXGI_FORMAT_R24G8_TYPELESS:
+        case DXGI_FORMAT_D24_UNORM_S8_UINT:
+        case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+        case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
+        case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+        case DXGI_FORMAT_R8G8_B8G8_UNORM:
+        case DXGI_FORMAT_G8R8_G8B8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+        case DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            return 32;
+
+        case DXGI_FORMAT_R8G8_TYPELESS:
+        case DXGI_FORMAT_R8G8_UNORM:
+        case DXGI_FORMAT_R8G8_UINT:
+        case DXGI_FORMAT_R8G8_SNORM:
+        case DXGI_FORMAT_R8G8_SINT:
+        case DXGI_FORMAT_R16_TYPELESS:
+        case DXGI_FORMAT_R16_FLOAT:
+        case DXGI_FORMAT_D16_UNORM:
+        case DXGI_FORMAT_R16_UNORM:
+        case DXGI_FORMAT_R16_UINT:
+        case DXGI_FORMAT_R16_SNORM:
+        case DXGI_FORMAT_R16_SINT:
+        case DXGI_FORMAT_B5G6R5_UNORM:
+        case DXGI_FORMAT_B5G5R5A1_UNORM:
+        case DXGI_FORMAT_B4G4R4A4_UNORM:
+            return 16;
+
+        case DXGI_FORMAT_R8_TYPELESS:
+        case DXGI_FORMAT_R8_UNORM:
+        case DXGI_FORMAT_R8_UINT:
+        case DXGI_FORMAT_R8_SNORM:
+        case DXGI_FORMAT_R8_SINT:
+        case DXGI_FORMAT_A8_UNORM:
+            return 8;
+
+        case DXGI_FORMAT_R1_UNORM:
+            return 1;
+
+        case DXGI_FORMAT_BC1_TYPELESS:
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+        case DXGI_FORMAT_BC4_TYPELESS:
+        case DXGI_FORMAT_BC4_UNORM:
+        case DXGI_FORMAT_BC4_SNORM:
+            return 4;
+
+        case DXGI_FORMAT_BC2_TYPELESS:
+        case DXGI_FORMAT_BC2_UNORM:
+        case DXGI_FORMAT_BC2_UNORM_SRGB:
+        case DXGI_FORMAT_BC3_TYPELESS:
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+        case DXGI_FORMAT_BC5_TYPELESS:
+        case DXGI_FORMAT_BC5_UNORM:
+        case DXGI_FORMAT_BC5_SNORM:
+        case DXGI_FORMAT_BC6H_TYPELESS:
+        case DXGI_FORMAT_BC6H_UF16:
+        case DXGI_FORMAT_BC6H_SF16:
+        case DXGI_FORMAT_BC7_TYPELESS:
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return 8;
+
+        default:
+            return 0;
+        }
+    }
+
+    bool NullIsBlockCompressed(DXGI_FORMAT Format)
+    {
+        return (Format >= DXGI_FORMAT_BC1_TYPELESS && Format <= DXGI_FORMAT_BC5_SNORM) ||
+               (Format >= DXGI_FORMAT_BC6H_TYPELESS && Format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+    }
+    //The size of one element in a row of texture,a block for block-compressed formats and a texel for others.
+    UINT NullBytesPerElement(DXGI_FORMAT Format)
+    {
+        UINT bpp = NullBitsPerPixel(Format);
+        return NullIsBlockCompressed(Format) ? bpp * 2 : (std::max)(bpp / 8, 1u);
+    }
+
+    UINT NullMipLevels(const D3D12_RESOURCE_DESC& Desc)
+    {
+        if (Desc.MipLevels != 0)
+        {
+            return Desc.MipLevels;
+        }
+        //zero means a full mip chain
+        UINT64 maxSize = std::max<UINT64>(Desc.Width, Desc.Height);
+        if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+        {
+            maxSize = std::max<UINT64>(maxSize, Desc.DepthOrArraySize);
+        }
+        UINT levels = 1;
+        while (maxSize > 1)
+        {
+            maxSize >>= 1;
+            ++levels;
+        }
+        return levels;
+    }
+
+    UINT NullSubresourceCount(const D3D12_RESOURCE_DESC& Desc)
+    {
+        if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        {
+            return 1;
+        }
+        UINT arraySize = Desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1 : Desc.DepthOrArraySize;
+        return NullMipLevels(Desc) * arraySize;
+    }
+    //Same layout rules with ID3D12Device::GetCopyableFootprints():
+    //row pitch is aligned to 256 bytes and every subresource is aligned to 512 bytes.
+    //Return false if the format is unknown.
+    bool NullComputeFootprints(
+        const D3D12_RESOURCE_DESC& Desc,
+        UINT FirstSubresource,
+        UINT NumSubresources,
+        UINT64 BaseOffset,
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts,
+        UINT* pNumRows,
+        UINT64* pRowSizeInBytes,
+        UINT64* pTotalBytes)
+    {
+        if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        {
+            if (FirstSubresource != 0 || NumSubresources > 1)
+            {
+                return false;
+            }
+            if (NumSubresources == 1)
+            {
+                if (pLayouts)
+                {
+                    pLayouts[0].Offset = BaseOffset;
+                    pLayouts[0].Footprint = { DXGI_FORMAT_UNKNOWN, (UINT)Desc.Width, 1, 1,
+                        NullAlignUp<UINT>((UINT)Desc.Width, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT) };
+                }
+                if (pNumRows) pNumRows[0] = 1;
+                if (pRowSizeInBytes) pRowSizeInBytes[0] = Desc.Width;
+            }
+            if (pTotalBytes) *pTotalBytes = Desc.Width;
+            return true;
+        }
+
+        UINT bpp = NullBitsPerPixel(Desc.Format);
+        if (bpp == 0)
+        {
+            return false;
+        }
+        bool isBlockCompressed = NullIsBlockCompressed(Desc.Format);
+        UINT bytesPerElement = NullBytesPerElement(Desc.Format);
+        UINT mipLevels = NullMipLevels(Desc);
+
+        UINT64 offset = 0;
+        UINT64 total = 0;
+        //The offset of FirstSubresource also depends on all previous subresources.
+        for (UINT subresource = 0; subresource < FirstSubresource + NumSubresources; ++subresource)
+        {
+            UINT mip = subresource % mipLevels;
+            UINT width = std::max<UINT>(1u, (UINT)(Desc.Width >> mip));
+            UINT height = Desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE1D ? 1u : std::max<UINT>(1u, Desc.Height >> mip);
+            UINT depth = Desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? std::max<UINT>(1u, Desc.DepthOrArraySize >> mip) : 1u;
+
+            UINT numRows = height;
+            UINT64 rowSize = 0;
+            if (isBlockCompressed)
+            {
+                width = NullAlignUp<UINT>(width, 4);
+                height = NullAlignUp<UINT>(height, 4);
+                numRows = height / 4;
+                rowSize = (UINT64)(width / 4) * bytesPerElement;
+            }
+            else
+            {
+                rowSize = ((UINT64)width * bpp + 7) / 8;
+            }
+            UINT rowPitch = NullAlignUp<UINT>((UINT)rowSize, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+            offset = NullAlignUp<UINT64>(offset, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+            if (subresource >= FirstSubresource)
+            {
+                UINT index = subresource - FirstSubresource;
+                if (pLayouts)
+                {
+                    pLayouts[index].Offset = BaseOffset + offset;
+                    pLayouts[index].Footprint = { Desc.Format, width, height, depth, rowPitch };
+                }
+                if (pNumRows) pNumRows[index] = numRows;
+                if (pRowSizeInBytes) pRowSizeInBytes[index] = rowSize;
+                //the last row of a subresource is not padded
+                total = offset + (UINT64)rowPitch * ((UINT64)numRows * depth - 1) + rowSize;
+            }
+            offset += (UINT64)rowPitch * numRows * depth;
+        }
+        if (pTotalBytes)
+        {
+            //the total size does not count the part before first subresource
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT first = {};
+            UINT64 firstOffset = 0;
+            if (NumSubresources > 0 && pLayouts)
+            {
+                firstOffset = pLayouts[0].Offset - BaseOffset;
+            }
+            else if (NumSubresources > 0 && FirstSubresource > 0)
+            {
+                NullComputeFootprints(Desc, FirstSubresource, 1, 0, &first, nullptr, nullptr, nullptr);
+                firstOffset = first.Offset;
+            }
+            *pTotalBytes = NumSubresources > 0 ? total - firstOffset : 0;
+        }
+        return true;
+    }
+    //The memory which one resource occupies in null device.
+    //Return UINT64_MAX if the desc is not supported.
+    UINT64 NullResourceSize(const D3D12_RESOURCE_DESC& Desc)
+    {
+        UINT64 totalBytes = 0;
+        if (!NullComputeFootprints(Desc, 0, NullSubresourceCount(Desc), 0, nullptr, nullptr, nullptr, &totalBytes))
+        {
+            return UINT64_MAX;
+        }
+        return totalBytes * std::max<UINT>(1u, Desc.SampleDesc.Count);
+    }
+
+    UINT64 NullResourceAlignment(const D3D12_RESOURCE_DESC& Desc)
+    {
+        if (Desc.Alignment != 0)
+        {
+            return Desc.Alignment;
+        }
+        return Desc.SampleDesc.Count > 1 ?
+            D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    }
+
+    //A block of cpu memory which backs a resource or a heap.
+    //The memory is allocated on first use,so that big heaps which are never touched cost nothing.
+    class NullMemoryBlock
+    {
+    public:
+        explicit NullMemoryBlock(UINT64 Size)
+            : m_Size(Size)
+            , m_pData(nullptr)
+        {}
+
+        ~NullMemoryBlock()
+        {
+            std::free(m_pData);
+        }
+
+        uint8_t* Data()
+        {
+            std::call_once(m_AllocateFlag, [this]()
+                {
+                    m_pData = static_cast<uint8_t*>(std::calloc(1, (size_t)std::max<UINT64>(m_Size, 1)));
+                    if (!m_pData)
+                    {
+                        throw std::bad_alloc();
+                    }
+                });
+            return m_pData;
+        }
+
+        UINT64 Size()const { return m_Size; }
+    private:
+        UINT64 m_Size;
+        uint8_t* m_pData;
+        std::once_flag m_AllocateFlag;
+    };
+
+    struct NullDeviceCounters
+    {
+        std::atomic<UINT64> ResourcesCreated{ 0 };
+        std::atomic<UINT64> HeapsCreated{ 0 };
+        std::atomic<UINT64> DescriptorHeapsCreated{ 0 };
+        std::atomic<UINT64> DescriptorsWritten{ 0 };
+        std::atomic<UINT64> DescriptorsCopied{ 0 };
+        std::atomic<UINT64> CommandListsExecuted{ 0 };
+        std::atomic<UINT64> CommandsRecorded{ 0 };
+        std::atomic<UINT64> RecordedBytes{ 0 };
+        std::atomic<UINT64> ResourceBarriers{ 0 };
+        std::atomic<UINT64> Draws{ 0 };
+        std::atomic<UINT64> Dispatches{ 0 };
+        std::atomic<UINT64> Copies{ 0 };
+        std::atomic<UINT64> BytesCopied{ 0 };
+        std::atomic<UINT64> FenceSignals{ 0 };
+        std::atomic<UINT64> FenceWaits{ 0 };
+    };
+
+    inline void NullCount(std::atomic<UINT64>& Counter, UINT64 Value = 1)
+    {
+        Counter.fetch_add(Value, std::memory_order_relaxed);
+    }
+
+    /************************************************************************/
+    /* Base classes of all null objects                                     */
+    /************************************************************************/
+
+    template<typename TInterface>
+    class NullObject : public TInterface
+    {
+    public:
+        virtual ~NullObject() = default;
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+        {
+            if (!ppvObject)
+            {
+                return E_POINTER;
+            }
+            if (IsSupportedInterface(riid))
+            {
+                *ppvObject = static_cast<TInterface*>(this);
+                AddRef();
+                return S_OK;
+            }
+            *ppvObject = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        ULONG STDMETHODCALLTYPE AddRef() override
+        {
+            return m_RefCount.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+        ULONG STDMETHODCALLTYPE Release() override
+        {
+            ULONG count = m_RefCount.fetch_sub(1, std::memory_order_acq_rel) - 1;
+            if (count == 0)
+            {
+                delete this;
+            }
+            return count;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT* pDataSize, void* pData) override
+        {
+            if (!pDataSize)
+            {
+                return E_INVALIDARG;
+            }
+            std::lock_guard<std::mutex> lock(m_PrivateDataMutex);
+            for (const auto& entry : m_PrivateData)
+            {
+                if (entry.Guid == guid && entry.Interface)
+                {
+                    if (pData)
+                    {
+                        if (*pDataSize < sizeof(IUnknown*))
+                        {
+                            return E_INVALIDARG;
+                        }
+                        entry.Interface->AddRef();
+                        *static_cast<IUnknown**>(pData) = entry.Interface.Get();
+                    }
+                    *pDataSize = sizeof(IUnknown*);
+                    return S_OK;
+                }
+                if (entry.Guid == guid)
+                {
+                    UINT size = (UINT)entry.Data.size();
+                    if (pData)
+                    {
+                        if (*pDataSize < size)
+                        {
+                            return E_INVALIDARG;
+                        }
+                        std::memcpy(pData, entry.Data.data(), size);
+                    }
+                    *pDataSize = size;
+                    return S_OK;
+                }
+            }
+            *pDataSize = 0;
+            return DXGI_ERROR_NOT_FOUND;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT DataSize, const void* pData) override
+        {
+            std::lock_guard<std::mutex> lock(m_PrivateDataMutex);
+            auto iter = std::find_if(m_PrivateData.begin(), m_PrivateData.end(),
+                [&guid](const PrivateDataEntry& entry) { return entry.Guid == guid; });
+            if (iter != m_PrivateData.end())
+            {
+                m_PrivateData.erase(iter);
+            }
+            if (pData && DataSize > 0)
+            {
+                const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+                m_PrivateData.push_back({ guid, std::vector<uint8_t>(pBytes, pBytes + DataSize) });
+            }
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown* pData) override
+        {
+            std::lock_guard<std::mutex> lock(m_PrivateDataMutex);
+            auto iter = std::find_if(m_PrivateData.begin(), m_PrivateData.end(),
+                [&guid](const PrivateDataEntry& entry) { return entry.Guid == guid; });
+            if (iter != m_PrivateData.end())
+            {
+                m_PrivateData.erase(iter);
+            }
+            //the interface is held until it is replaced or this object is destroyed,as d3d12 does.
+            if (pData)
+            {
+                PrivateDataEntry entry;
+                entry.Guid = guid;
+                entry.Interface = const_cast<IUnknown*>(pData);
+                m_PrivateData.push_back(std::move(entry));
+            }
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetName(LPCWSTR Name) override
+        {
+            std::lock_guard<std::mutex> lock(m_PrivateDataMutex);
+            m_Name = Name ? Name : L"";
+            return S_OK;
+        }
+    protected:
+        virtual bool IsSupportedInterface(REFIID riid)const
+        {
+            return riid == __uuidof(IUnknown) || riid == __uuidof(ID3D12Object);
+        }
+    private:
+        struct PrivateDataEntry
+        {
+            GUID Guid;
+            std::vector<uint8_t> Data;
+            Microsoft::WRL::ComPtr<IUnknown> Interface;
+        };
+
+        std::atomic<ULONG> m_RefCount{ 1 };
+        std::wstring m_Name;
+        std::vector<PrivateDataEntry> m_PrivateData;
+        std::mutex m_PrivateDataMutex;
+    };
+
+    /************************************************************************/
+    /* Null device                                                          */
+    /************************************************************************/
+
+    class NullD3D12Device : public NullObject<ID3D12Device2>
+    {
+    public:
+        explicit NullD3D12Device(const NullDeviceDesc& Desc)
+            : m_Desc(Desc)
+            , m_NextVirtualAddress(gs_NullVirtualAddressBase)
+        {}
+
+        const NullDeviceDesc& GetNullDesc()const { return m_Desc; }
+
+        NullDeviceCounters& GetCounters() { return m_Counters; }
+        //Reserve a range of fake gpu virtual address.
+        D3D12_GPU_VIRTUAL_ADDRESS AllocateVirtualAddress(UINT64 Size)
+        {
+            return m_NextVirtualAddress.fetch_add(
+                NullAlignUp<UINT64>(std::max<UINT64>(Size, 1), D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT));
+        }
+        //Whether a resource which is in a heap of this type gets cpu memory.
+        bool IsBackedHeap(const D3D12_HEAP_PROPERTIES& HeapProperties)const
+        {
+            if (m_Desc.BackResourceMemory)
+            {
+                return true;
+            }
+            return HeapProperties.Type == D3D12_HEAP_TYPE_UPLOAD ||
+                   HeapProperties.Type == D3D12_HEAP_TYPE_READBACK ||
+                   (HeapProperties.Type == D3D12_HEAP_TYPE_CUSTOM &&
+                    HeapProperties.CPUPageProperty != D3D12_CPU_PAGE_PROPERTY_NOT_AVAILABLE);
+        }
+
+        //ID3D12Device
+        UINT STDMETHODCALLTYPE GetNodeCount() override { return 1; }
+        HRESULT STDMETHODCALLTYPE CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* pDesc, REFIID riid, void** ppCommandQueue) override;
+        HRESULT STDMETHODCALLTYPE CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type, REFIID riid, void** ppCommandAllocator) override;
+        HRESULT STDMETHODCALLTYPE CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc, REFIID riid, void** ppPipelineState) override;
+        HRESULT STDMETHODCALLTYPE CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC* pDesc, REFIID riid, void** ppPipelineState) override;
+        HRESULT STDMETHODCALLTYPE CreateCommandList(UINT nodeMask, D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator* pCommandAllocator,
+            ID3D12PipelineState* pInitialState, REFIID riid, void** ppCommandList) override;
+        HRESULT STDMETHODCALLTYPE CheckFeatureSupport(D3D12_FEATURE Feature, void* pFeatureSupportData, UINT FeatureSupportDataSize) override;
+        HRESULT STDMETHODCALLTYPE CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* pDescriptorHeapDesc, REFIID riid, void** ppvHeap) override;
+        UINT STDMETHODCALLTYPE GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapType) override
+        {
+            return sizeof(NullDescriptor);
+        }
+        HRESULT STDMETHODCALLTYPE CreateRootSignature(UINT nodeMask, const void* pBlobWithRootSignature, SIZE_T blobLengthInBytes,
+            REFIID riid, void** ppvRootSignature) override;
+        void STDMETHODCALLTYPE CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override;
+        void STDMETHODCALLTYPE CreateShaderResourceView(ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc,
+            D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override;
+        void STDMETHODCALLTYPE CreateUnorderedAccessView(ID3D12Resource* pResource, ID3D12Resource* pCounterResource,
+            const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override;
+        void STDMETHODCALLTYPE CreateRenderTargetView(ID3D12Resource* pResource, const D3D12_RENDER_TARGET_VIEW_DESC* pDesc,
+            D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override;
+        void STDMETHODCALLTYPE CreateDepthStencilView(ID3D12Resource* pResource, const D3D12_DEPTH_STENCIL_VIEW_DESC* pDesc,
+            D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override;
+        void STDMETHODCALLTYPE CreateSampler(const D3D12_SAMPLER_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override;
+        void STDMETHODCALLTYPE CopyDescriptors(UINT NumDestDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* pDestDescriptorRangeStarts,
+            const UINT* pDestDescriptorRangeSizes, UINT NumSrcDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcDescriptorRangeStarts,
+            const UINT* pSrcDescriptorRangeSizes, D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapsType) override;
+        void STDMETHODCALLTYPE CopyDescriptorsSimple(UINT NumDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptorRangeStart,
+            D3D12_CPU_DESCRIPTOR_HANDLE SrcDescriptorRangeStart, D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapsType) override;
+        D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE GetResourceAllocationInfo(UINT visibleMask, UINT numResourceDescs,
+            const D3D12_RESOURCE_DESC* pResourceDescs) override;
+        D3D12_HEAP_PROPERTIES STDMETHODCALLTYPE GetCustomHeapProperties(UINT nodeMask, D3D12_HEAP_TYPE heapType) override;
+        HRESULT STDMETHODCALLTYPE CreateCommittedResource(const D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS HeapFlags,
+            const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES InitialResourceState, const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+            REFIID riidResource, void** ppvResource) override;
+        HRESULT STDMETHODCALLTYPE CreateHeap(const D3D12_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap) override;
+        HRESULT STDMETHODCALLTYPE CreatePlacedResource(ID3D12Heap* pHeap, UINT64 HeapOffset, const D3D12_RESOURCE_DESC* pDesc,
+            D3D12_RESOURCE_STATES InitialState, const D3D12_CLEAR_VALUE* pOptimizedClearValue, REFIID riid, void** ppvResource) override;
+        HRESULT STDMETHODCALLTYPE CreateReservedResource(const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES InitialState,
+            const D3D12_CLEAR_VALUE* pOptimizedClearValue, REFIID riid, void** ppvResource) override
+        {
+            return E_NOTIMPL;
+        }
+        HRESULT STDMETHODCALLTYPE CreateSharedHandle(ID3D12DeviceChild* pObject, const SECURITY_ATTRIBUTES* pAttributes, DWORD Access,
+            LPCWSTR Name, HANDLE* pHandle) override
+        {
+            return E_NOTIMPL;
+        }
+        HRESULT STDMETHODCALLTYPE OpenSharedHandle(HANDLE NTHandle, REFIID riid, void** ppvObj) override
+        {
+            return E_NOTIMPL;
+        }
+        HRESULT STDMETHODCALLTYPE OpenSharedHandleByName(LPCWSTR Name, DWORD Access, HANDLE* pNTHandle) override
+        {
+            return E_NOTIMPL;
+        }
+        HRESULT STDMETHODCALLTYPE MakeResident(UINT NumObjects, ID3D12Pageable* const* ppObjects) override { return S_OK; }
+        HRESULT STDMETHODCALLTYPE Evict(UINT NumObjects, ID3D12Pageable* const* ppObjects) override { return S_OK; }
+        HRESULT STDMETHODCALLTYPE CreateFence(UINT64 InitialValue, D3D12_FENCE_FLAGS Flags, REFIID riid, void** ppFence) override;
+        HRESULT STDMETHODCALLTYPE GetDeviceRemovedReason() override { return S_OK; }
+        void STDMETHODCALLTYPE GetCopyableFootprints(const D3D12_RESOURCE_DESC* pResourceDesc, UINT FirstSubresource, UINT NumSubresources,
+            UINT64 BaseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts, UINT* pNumRows, UINT64* pRowSizeInBytes, UINT64* pTotalBytes) override;
+        HRESULT STDMETHODCALLTYPE CreateQueryHeap(const D3D12_QUERY_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap) override
+        {
+            return E_NOTIMPL;
+        }
+        HRESULT STDMETHODCALLTYPE SetStablePowerState(BOOL Enable) override { return S_OK; }
+        HRESULT STDMETHODCALLTYPE CreateCommandSignature(const D3D12_COMMAND_SIGNATURE_DESC* pDesc, ID3D12RootSignature* pRootSignature,
+            REFIID riid, void** ppvCommandSignature) override
+        {
+            return E_NOTIMPL;
+        }
+        void STDMETHODCALLTYPE GetResourceTiling(ID3D12Resource* pTiledResource, UINT* pNumTilesForEntireResource, D3D12_PACKED_MIP_INFO* pPackedMipDesc,
+            D3D12_TILE_SHAPE* pStandardTileShapeForNonPackedMips, UINT* pNumSubresourceTilings, UINT FirstSubresourceTilingToGet,
+            D3D12_SUBRESOURCE_TILING* pSubresourceTilingsForNonPackedMips) override
+        {
+            //null device does not support tiled resources
+            if (pNumTilesForEntireResource) *pNumTilesForEntireResource = 0;
+            if (pPackedMipDesc) *pPackedMipDesc = {};
+            if (pStandardTileShapeForNonPackedMips) *pStandardTileShapeForNonPackedMips = {};
+            if (pNumSubresourceTilings) *pNumSubresourceTilings = 0;
+        }
+        LUID STDMETHODCALLTYPE GetAdapterLuid() override
+        {
+            LUID luid = {};
+            return luid;
+        }
+
+        //ID3D12Device1
+        HRESULT STDMETHODCALLTYPE CreatePipelineLibrary(const void* pLibraryBlob, SIZE_T BlobLength, REFIID riid, void** ppPipelineLibrary) override
+        {
+            return E_NOTIMPL;
+        }
+        HRESULT STDMETHODCALLTYPE SetEventOnMultipleFenceCompletion(ID3D12Fence* const* ppFences, const UINT64* pFenceValues, UINT NumFences,
+            D3D12_MULTIPLE_FENCE_WAIT_FLAGS Flags, HANDLE hEvent) override;
+        HRESULT STDMETHODCALLTYPE SetResidencyPriority(UINT NumObjects, ID3D12Pageable* const* ppObjects, const D3D12_RESIDENCY_PRIORITY* pPriorities) override
+        {
+            return S_OK;
+        }
+
+        //ID3D12Device2
+        HRESULT STDMETHODCALLTYPE CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC* pDesc, REFIID riid, void** ppPipelineState) override;
+
+    protected:
+        bool IsSupportedInterface(REFIID riid)const override
+        {
+            return NullObject<ID3D12Device2>::IsSupportedInterface(riid) ||
+                riid == __uuidof(ID3D12Device) ||
+                riid == __uuidof(ID3D12Device1) ||
+                riid == __uuidof(ID3D12Device2) ||
+                riid == IID_NullD3D12Device;
+        }
+    private:
+        void WriteDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor, const NullDescriptor& Descriptor)
+        {
+            assert(DestDescriptor.ptr && "Error!Invalid descriptor handle");
+            std::memcpy(reinterpret_cast<void*>(DestDescriptor.ptr), &Descriptor, sizeof(NullDescriptor));
+            NullCount(m_Counters.DescriptorsWritten);
+        }
+
+        NullDeviceDesc m_Desc;
+        NullDeviceCounters m_Counters;
+        std::atomic<UINT64> m_NextVirtualAddress;
+    };
+
+    //Hand an object to the caller as the interface of riid and drop our own reference.
+    template<typename TObject>
+    HRESULT NullReturnObject(TObject* pObject, REFIID riid, void** ppvObject)
+    {
+        if (!pObject)
+        {
+            return E_OUTOFMEMORY;
+        }
+        if (!ppvObject)
+        {
+            pObject->Release();
+            return S_FALSE;
+        }
+        HRESULT hr = pObject->QueryInterface(riid, ppvObject);
+        pObject->Release();
+        return hr;
+    }
+
+    template<typename TInterface>
+    class NullDeviceChild : public NullObject<TInterface>
+    {
+    public:
+        explicit NullDeviceChild(NullD3D12Device* pDevice)
+            : m_pDevice(pDevice)
+        {
+            m_pDevice->AddRef();
+        }
+
+        virtual ~NullDeviceChild()
+        {
+            m_pDevice->Release();
+        }
+
+        HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void** ppvDevice) override
+        {
+            return m_pDevice->QueryInterface(riid, ppvDevice);
+        }
+    protected:
+        bool IsSupportedInterface(REFIID riid)const override
+        {
+            return NullObject<TInterface>::IsSupportedInterface(riid) || riid == __uuidof(ID3D12DeviceChild);
+        }
+
+        NullD3D12Device* m_pDevice;
+    };
+
+    /************************************************************************/
+    /* Simple device children                                               */
+    /************************************************************************/
+
+    class NullD3D12RootSignature : public NullDeviceChild<ID3D12RootSignature>
+    {
+    public:
+        explicit NullD3D12RootSignature(NullD3D12Device* pDevice)
+            : NullDeviceChild<ID3D12RootSignature>(pDevice)
+        {}
+    protected:
+        bool IsSupportedInterface(REFIID riid)const override
+        {
+            return NullDeviceChild<ID3D12RootSignature>::IsSupportedInterface(riid) || riid == __uuidof(ID3D12RootSignature);
+        }
+    };
+
+    class NullD3D12PipelineState : public NullDeviceChild<ID3D12PipelineState>
+    {
+    public:
+        explicit NullD3D12PipelineState(NullD3D12Device* pDevice)
+            : NullDeviceChild<ID3D12PipelineState>(pDevice)
+        {}
+
+        HRESULT STDMETHODCALLTYPE GetCachedBlob(ID3DBlob** ppBlob) override
+        {
+            return E_NOTIMPL;
+        }
+    protected:
+        bool IsSupportedInterface(REFIID riid)const override
+        {
+            return NullDeviceChild<ID3D12PipelineState>::IsSupportedInterface(riid) ||
+                riid == __uuidof(ID3D12Pageable) || riid == __uuidof(ID3D12PipelineState);
+        }
+    };
+
+    class NullD3D12Heap : public NullDeviceChild<ID3D12Heap>
+    {
+    public:
+        NullD3D12Heap(NullD3D12Device* pDevice, const D3D12_HEAP_DESC& Desc)
+            : NullDeviceChild<ID3D12Heap>(pDevice)
+            , m_Desc(Desc)
+            , m_VirtualAddress(pDevice->AllocateVirtualAddress(Desc.SizeInBytes))
+        {
+            if (pDevice->IsBackedHeap(Desc.Properties))
+            {
+                m_pMemory = std::make_shared<NullMemoryBlock>(Desc.SizeInBytes);
+            }
+        }
+
+        D3D12_HEAP_DESC STDMETHODCALLTYPE GetDesc() override { return m_Desc; }
+
+        const std::shared_ptr<NullMemoryBlock>& GetMemory()const { return m_pMemory; }
+
+        D3D12_GPU_VIRTUAL_ADDRESS GetVirtualAddress()const { return m_VirtualAddress; }
+    protected:
+        bool IsSupportedInterface(REFIID riid)const override
+        {
+            return NullDeviceChild<ID3D12Heap>::IsSupportedInterface(riid) ||
+                riid == __uuidof(ID3D12Pageable) || riid == __uuidof(ID3D12Heap);
+        }
+    private:
+        D3D12_HEAP_DESC m_Desc;
+        D3D12_GPU_VIRTUAL_ADDRESS m_VirtualAddress;
+        std::shared_ptr<NullMemoryBlock> m_pMemory;
+    };
+
+    class NullD3D12Resource : public NullDeviceChild<ID3D12Resource>
+    {
+    public:
+        NullD3D12Resource(
+            NullD3D12Device* pDevice,
+            const D3D12_RESOURCE_DESC& Desc,
+            const D3D12_HEAP_PROPERTIES& HeapProperties,
+            D3D12_HEAP_FLAGS HeapFlags,
+            UINT64 Size,
+            std::shared_ptr<NullMemoryBlock> pMemory,
+            UINT64 MemoryOffset,
+            D3D12_GPU_VIRTUAL_ADDRESS VirtualAddress,
+            ID3D12Heap* pHeap)
+            : NullDeviceChild<ID3D12Resource>(pDevice)
+            , m_Desc(Desc)
+            , m_HeapProperties(HeapProperties)
+            , m_HeapFlags(HeapFlags)
+            , m_Size(Size)
+            , m_pMemory(std::move(pMemory))
+            , m_MemoryOffset(MemoryOffset)
+            , m_VirtualAddress(VirtualAddress)
+            , m_pHeap(pHeap)
+        {
+            m_Desc.MipLevels = (UINT16)NullMipLevels(Desc);
+            UINT numSubresources = NullSubresourceCount(m_Desc);
+            m_SubresourceLayouts.resize(numSubresources);
+            NullComputeFootprints(m_Desc, 0, numSubresources, 0, m_SubresourceLayouts.data(), nullptr, nullptr, nullptr);
+        }
+
+        HRESULT STDMETHODCALLTYPE Map(UINT Subresource, const D3D12_RANGE* pReadRange, void** ppData) override
+        {
+            if (m_HeapProperties.Type == D3D12_HEAP_TYPE_DEFAULT || Subresource >= m_SubresourceLayouts.size())
+            {
+                return E_INVALIDARG;
+            }
+            uint8_t* pData = GetData();
+            if (!pData)
+            {
+                return E_OUTOFMEMORY;
+            }
+            if (ppData)
+            {
+                *ppData = pData + m_SubresourceLayouts[Subresource].Offset;
+            }
+            return S_OK;
+        }
+
+        void STDMETHODCALLTYPE Unmap(UINT Subresource, const D3D12_RANGE* pWrittenRange) override {}
+
+        D3D12_RESOURCE_DESC STDMETHODCALLTYPE GetDesc() override { return m_Desc; }
+
+        D3D12_GPU_VIRTUAL_ADDRESS STDMETHODCALLTYPE GetGPUVirtualAddress() override
+        {
+            //only buffers have a gpu virtual address
+            return m_Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER ? m_VirtualAddress : 0;
+        }
+
+        HRESULT STDMETHODCALLTYPE WriteToSubresource(UINT DstSubresource, const D3D12_BOX* pDstBox, const void* pSrcData,
+            UINT SrcRowPitch, UINT SrcDepthPitch) override
+        {
+            return E_NOTIMPL;
+        }
+
+        HRESULT STDMETHODCALLTYPE ReadFromSubresource(void* pDstData, UINT DstRowPitch, UINT DstDepthPitch, UINT SrcSubresource,
+            const D3D12_BOX* pSrcBox) override
+        {
+            return E_NOTIMPL;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetHeapProperties(D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS* pHeapFlags) override
+        {
+            if (pHeapProperties) *pHeapProperties = m_HeapProperties;
+            if (pHeapFlags) *pHeapFlags = m_HeapFlags;
+            return S_OK;
+        }
+        //Cpu memory of this resource,nullptr if the resource is not backed.
+        uint8_t* GetData()
+        {
+            return m_pMemory ? m_pMemory->Data() + m_MemoryOffset : nullptr;
+        }
+
+        UINT64 GetSize()const { return m_Size; }
+
+        const D3D12_PLACED_SUBRESOURCE_FOOTPRINT* GetSubresourceLayout(UINT Subresource)const
+        {
+            return Subresource < m_SubresourceLayouts.size() ? &m_SubresourceLayouts[Subresource] : nullptr;
+        }
+    protected:
+        bool IsSupportedInterface(REFIID riid)const override
+        {
+            return NullDeviceChild<ID3D12Resource>::IsSupportedInterface(riid) ||
+                riid == __uuidof(ID3D12Pageable) || riid == __uuidof(ID3D12Resource);
+        }
+    private:
+        D3D12_RESOURCE_DESC m_Desc;
+        D3D12_HEAP_PROPERTIES m_HeapProperties;
+        D3D12_HEAP_FLAGS m_HeapFlags;
+        UINT64 m_Size;
+        std::shared_ptr<NullMemoryBlock> m_pMemory;
+        UINT64 m_MemoryOffset;
+        D3D12_GPU_VIRTUAL_ADDRESS m_VirtualAddress;
+        //a placed resource keeps its heap alive
+        Microsoft::WRL::ComPtr<ID3D12Heap> m_pHeap;
+        //linear layout of all subresources in cpu memory
+        std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> m_SubresourceLayouts;
+    };
+
+    class NullD3D12DescriptorHeap : public NullDeviceChild<ID3D12DescriptorHeap>
+    {
+    public:
+        NullD3D12DescriptorHeap(NullD3D12Device* pDevice, const D3D12_DESCRIPTOR_HEAP_DESC& Desc)
+            : NullDeviceChild<ID3D12DescriptorHeap>(pDevice)
+            , m_Desc(Desc)
+            , m_Descriptors(std::max<UINT>(Desc.NumDescriptors, 1u))
+        {}
+
+        D3D12_DESCRIPTOR_HEAP_DESC STDMETHODCALLTYPE GetDesc() override { return m_Desc; }
+
+        D3D12_CPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetCPUDescriptorHandleForHeapStart() override
+        {
+            D3D12_CPU_DESCRIPTOR_HANDLE handle = { reinterpret_cast<SIZE_T>(m_Descriptors.data()) };
+            return handle;
+        }
+        //A shader visible null heap uses the cpu address as gpu address too.
+        D3D12_GPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetGPUDescriptorHandleForHeapStart() override
+        {
+            D3D12_GPU_DESCRIPTOR_HANDLE handle = { 0 };
+            if (m_Desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE)
+            {
+                handle.ptr = reinterpret_cast<UINT64>(m_Descriptors.data());
+            }
+            return handle;
+        }
+    protected:
+        bool IsSupportedInterface(REFIID riid)const override
+        {
+            return NullDeviceChild<ID3D12DescriptorHeap>::IsSupportedInterface(riid) ||
+                riid == __uuidof(ID3D12Pageable) || riid == __uuidof(ID3D12DescriptorHeap);
+        }
+    private:
+        D3D12_DESCRIPTOR_HEAP_DESC m_Desc;
+        std::vector<NullDescriptor> m_Descriptors;
+    };
+
+    class NullD3D12Fence : public NullDeviceChild<ID3D12Fence>
+    {
+    public:
+        NullD3D12Fence(NullD3D12Device* pDevice, UINT64 InitialValue)
+            : NullDeviceChild<ID3D12Fence>(pDevice)
+            , m_CompletedValue(InitialValue)
+        {}
+
+        UINT64 STDMETHODCALLTYPE GetCompletedValue() override
+        {
+            return m_CompletedValue.load(std::memory_order_acquire);
+        }
+
+        HRESULT STDMETHODCALLTYPE SetEventOnCompletion(UINT64 Value, HANDLE hEvent) override
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            if (m_CompletedValue.load(std::memory_order_acquire) >= Value)
+            {
+                lock.unlock();
+                if (hEvent)
+                {
+                    FenceEvent::Set(hEvent);
+                }
+                return S_OK;
+            }
+            //a null event means that the caller wants to block until the fence completes
+            if (!hEvent)
+            {
+                m_ConditionVariable.wait(lock, [this, Value]() { return m_CompletedValue.load(std::memory_order_acquire) >= Value; });
+                return S_OK;
+            }
+            m_WaitingEvents.push_back({ Value, hEvent });
+            return S_OK;
+        }
+        //Cpu side signal
+        HRESULT STDMETHODCALLTYPE Signal(UINT64 Value) override
+        {
+            SetCompletedValue(Value);
+            NullCount(m_pDevice->GetCounters().FenceSignals);
+            return S_OK;
+        }
+        //Called by cpu signal or a null command queue when the queue reaches a signal.
+        void SetCompletedValue(UINT64 Value)
+        {
+            std::vector<HANDLE> completedEvents;
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_CompletedValue.store(Value, std::memory_order_release);
+
+                auto iter = std::partition(m_WaitingEvents.begin(), m_WaitingEvents.end(),
+                    [Value](const WaitingEvent& waiting) { return waiting.Value > Value; });
+                for (auto completed = iter; completed != m_WaitingEvents.end(); ++completed)
+                {
+                    completedEvents.push_back(completed->hEvent);
+                }
+                m_WaitingEvents.erase(iter, m_WaitingEvents.end());
+            }
+            m_ConditionVariable.notify_all();
+            for (HANDLE hEvent : completedEvents)
+            {
+                FenceEvent::Set(hEvent);
+            }
+        }
+        //Block the calling thread until the fence reaches the value or time out.
+        bool WaitForValue(UINT64 Value, std::chrono::milliseconds Timeout)
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            return m_ConditionVariable.wait_for(lock, Timeout,
+                [this, Value]() { return m_CompletedValue.load(std::memory_order_acquire) >= Value; });
+        }
+    protected:
+        bool IsSupportedInterface(REFIID riid)const override
+        {
+            return NullDeviceChild<ID3D12Fence>::IsSupportedInterface(riid) ||
+                riid == __uuidof(ID3D12Pageable) || riid == __uuidof(ID3D12Fence);
+        }
+    private:
+        struct WaitingEvent
+        {
+            UINT64 Value;
+            HANDLE hEvent;
+        };
+
+        std::atomic<UINT64> m_CompletedValue;
+        std::vector<WaitingEvent> m_WaitingEvents;
+        std::mutex m_Mutex;
+        std::condition_variable m_ConditionVariable;
+    };
+
+    class NullD3D12CommandAllocator : public NullDeviceChild<ID3D12CommandAllocator>
+    {
+    public:
+        NullD3D12CommandAllocator(NullD3D12Device* pDevice, D3D12_COMMAND_LIST_TYPE Type)
+            : NullDeviceChild<ID3D12CommandAllocator>(pDevice)
+            , m_Type(Type)
+        {}
+        //Like a real allocator,the memory is kept and reused by next recording.
+        HRESULT STDMETHODCALLTYPE Reset() override
+        {
+            m_CommandStream.clear();
+            return S_OK;
+        }
+
+        D3D12_COMMAND_LIST_TYPE GetType()const { return m_Type; }
+
+        std::vector<uint8_t>& GetCommandStream() { return m_CommandStream; }
+    protected:
+        bool IsSupportedInterface(REFIID riid)const override
+        {
+            return NullDeviceChild<ID3D12CommandAllocator>::IsSupportedInterface(riid) ||
+                riid == __uuidof(ID3D12Pageable) || riid == __uuidof(ID3D12CommandAllocator);
+        }
+    private:
+        D3D12_COMMAND_LIST_TYPE m_Type;
+        //all commands recorded by the command list which uses this allocator
+        std::vector<uint8_t> m_CommandStream;
+    };
+
+    /************************************************************************/
+    /* Command recording                                                    */
+    /************************************************************************/
+
+    enum class NullCommand : UINT32
+    {
+        SetState,
+        Draw,
+        DrawIndexed,
+        Dispatch,
+        CopyBufferRegion,
+        CopyTextureRegion,
+        CopyResource,
+        ResolveSubresource,
+        ResourceBarrier,
+        Clear,
+        WriteBufferImmediate
+    };
+
+    struct NullCommandHeader
+    {
+        NullCommand Command;
+        UINT32      PayloadSize;
+    };
+
+    struct NullStateCommand
+    {
+        UINT32 Slot;
+        UINT32 Count;
+        UINT64 Value;
+    };
+
+    struct NullDrawCommand
+    {
+        UINT CountPerInstance;
+        UINT InstanceCount;
+        UINT StartLocation;
+        INT  BaseVertexLocation;
+        UINT StartInstanceLocation;
+    };
+
+    struct NullDispatchCommand
+    {
+        UINT ThreadGroupCountX;
+        UINT ThreadGroupCountY;
+        UINT ThreadGroupCountZ;
+    };
+
+    struct NullCopyBufferCommand
+    {
+        ID3D12Resource* pDstBuffer;
+        UINT64          DstOffset;
+        ID3D12Resource* pSrcBuffer;
+        UINT64          SrcOffset;
+        UINT64          NumBytes;
+    };
+
+    struct NullCopyTextureCommand
+    {
+        D3D12_TEXTURE_COPY_LOCATION Dst;
+        D3D12_TEXTURE_COPY_LOCATION Src;
+        UINT      DstX;
+        UINT      DstY;
+        UINT      DstZ;
+        BOOL      HasBox;
+        D3D12_BOX SrcBox;
+    };
+
+    struct NullCopyResourceCommand
+    {
+        ID3D12Resource* pDstResource;
+        ID3D12Resource* pSrcResource;
+        UINT            DstSubresource;
+        UINT            SrcSubresource;
+    };
+
+    struct NullClearCommand
+    {
+        UINT64 View;
+        FLOAT  Values[4];
+    };
+
+    //Statistics of one replay,they are added to device counters once per ExecuteCommandLists().
+    struct NullReplayStatistics
+    {
+        UINT64 ResourceBarriers = 0;
+        UINT64 Draws = 0;
+        UINT64 Dispatches = 0;
+        UINT64 Copies = 0;
+        UINT64 BytesCopied = 0;
+    };
+
+    //Copy bytes if both sides are backed and in range.Return the number of copied bytes.
+    UINT64 NullCopyMemory(NullD3D12Resource* pDst, UINT64 DstOffset, NullD3D12Resource* pSrc, UINT64 SrcOffset, UINT64 NumBytes)
+    {
+        uint8_t* pDstData = pDst ? pDst->GetData() : nullptr;
+        uint8_t* pSrcData = pSrc ? pSrc->GetData() : nullptr;
+        if (!pDstData || !pSrcData ||
+            DstOffset + NumBytes > pDst->GetSize() || SrcOffset + NumBytes > pSrc->GetSize())
+        {
+            return 0;
+        }
+        std::memmove(pDstData + DstOffset, pSrcData + SrcOffset, (size_t)NumBytes);
+        return NumBytes;
+    }
+
+    //Translate a copy location into a linear footprint in cpu memory of a null resource.
+    bool NullResolveCopyLocation(const D3D12_TEXTURE_COPY_LOCATION& Location, D3D12_PLACED_SUBRESOURCE_FOOTPRINT& Layout)
+    {
+        auto pResource = static_cast<NullD3D12Resource*>(Location.pResource);
+        if (!pResource)
+        {
+            return false;
+        }
+        if (Location.Type == D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT)
+        {
+            Layout = Location.PlacedFootprint;
+            return true;
+        }
+        auto pLayout = pResource->GetSubresourceLayout(Location.SubresourceIndex);
+        if (!pLayout)
+        {
+            return false;
+        }
+        Layout = *pLayout;
+        return true;
+    }
+
+    UINT64 NullCopyTextureRegion(const NullCopyTextureCommand& Command)
+    {
+        auto pDst = static_cast<NullD3D12Resource*>(Command.Dst.pResource);
+        auto pSrc = static_cast<NullD3D12Resource*>(Command.Src.pResource);
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT dstLayout = {};
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT srcLayout = {};
+        if (!NullResolveCopyLocation(Command.Dst, dstLayout) || !NullResolveCopyLocation(Command.Src, srcLayout))
+        {
+            return 0;
+        }
+        uint8_t* pDstData = pDst->GetData();
+        uint8_t* pSrcData = pSrc->GetData();
+        DXGI_FORMAT format = srcLayout.Footprint.Format != DXGI_FORMAT_UNKNOWN ? srcLayout.Footprint.Format : dstLayout.Footprint.Format;
+        if (!pDstData || !pSrcData || NullBitsPerPixel(format) == 0)
+        {
+            return 0;
+        }
+
+        D3D12_BOX box = { 0, 0, 0, srcLayout.Footprint.Width, srcLayout.Footprint.Height, srcLayout.Footprint.Depth };
+        if (Command.HasBox)
+        {
+            box = Command.SrcBox;
+        }
+        //block-compressed formats are copied by 4x4 blocks
+        UINT blockSize = NullIsBlockCompressed(format) ? 4 : 1;
+        UINT bytesPerElement = NullBytesPerElement(format);
+        UINT64 rowBytes = (UINT64)((box.right - box.left + blockSize - 1) / blockSize) * bytesPerElement;
+        UINT numRows = (box.bottom - box.top + blockSize - 1) / blockSize;
+        UINT srcRowsPerSlice = (srcLayout.Footprint.Height + blockSize - 1) / blockSize;
+        UINT dstRowsPerSlice = (dstLayout.Footprint.Height + blockSize - 1) / blockSize;
+
+        UINT64 copiedBytes = 0;
+        for (UINT z = 0; z < box.back - box.front; ++z)
+        {
+            for (UINT row = 0; row < numRows; ++row)
+            {
+                UINT64 srcOffset = srcLayout.Offset +
+                    (UINT64)(box.front + z) * srcLayout.Footprint.RowPitch * srcRowsPerSlice +
+                    (UINT64)(box.top / blockSize + row) * srcLayout.Footprint.RowPitch +
+                    (UINT64)(box.left / blockSize) * bytesPerElement;
+                UINT64 dstOffset = dstLayout.Offset +
+                    (UINT64)(Command.DstZ + z) * dstLayout.Footprint.RowPitch * dstRowsPerSlice +
+                    (UINT64)(Command.DstY / blockSize + row) * dstLayout.Footprint.RowPitch +
+                    (UINT64)(Command.DstX / blockSize) * bytesPerElement;
+                if (srcOffset + rowBytes > pSrc->GetSize() || dstOffset + rowBytes > pDst->GetSize())
+                {
+                    return copiedBytes;
+                }
+                std::memcpy(pDstData + dstOffset, pSrcData + srcOffset, (size_t)rowBytes);
+                copiedBytes += rowBytes;
+            }
+        }
+        return copiedBytes;
+    }
+
+    class NullD3D12GraphicsCommandList : public NullDeviceChild<ID3D12GraphicsCommandList2>
+    {
+    public:
+        NullD3D12GraphicsCommandList(NullD3D12Device* pDevice, D3D12_COMMAND_LIST_TYPE Type)
+            : NullDeviceChild<ID3D12GraphicsCommandList2>(pDevice)
+            , m_Type(Type)
+            , m_IsRecording(false)
+            , m_StreamBegin(0)
+            , m_StreamEnd(0)
+            , m_NumRecordedCommands(0)
+            , m_NumRecordedBytes(0)
+        {}
+
+        //ID3D12CommandList
+        D3D12_COMMAND_LIST_TYPE STDMETHODCALLTYPE GetType() override { return m_Type; }
+
+        //ID3D12GraphicsCommandList
+        HRESULT STDMETHODCALLTYPE Close() override
+        {
+            if (!m_IsRecording)
+            {
+                return E_FAIL;
+            }
+            m_IsRecording = false;
+            m_StreamEnd = m_pAllocator->GetCommandStream().size();
+
+            auto& counters = m_pDevice->GetCounters();
+            NullCount(counters.CommandsRecorded, m_NumRecordedCommands);
+            NullCount(counters.RecordedBytes, m_NumRecordedBytes);
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE Reset(ID3D12CommandAllocator* pAllocator, ID3D12PipelineState* pInitialState) override
+        {
+            if (m_IsRecording || !pAllocator)
+            {
+                return E_FAIL;
+            }
+            m_pAllocator = static_cast<NullD3D12CommandAllocator*>(pAllocator);
+            m_IsRecording = true;
+            m_StreamBegin = m_StreamEnd = m_pAllocator->GetCommandStream().size();
+            m_NumRecordedCommands = 0;
+            m_NumRecordedBytes = 0;
+            if (pInitialState)
+            {
+                SetPipelineState(pInitialState);
+            }
+            return S_OK;
+        }
+
+        void STDMETHODCALLTYPE ClearState(ID3D12PipelineState* pPipelineState) override
+        {
+            RecordState(0, 0, reinterpret_cast<UINT64>(pPipelineState));
+        }
+
+        void STDMETHODCALLTYPE DrawInstanced(UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation,
+            UINT StartInstanceLocation) override
+        {
+            NullDrawCommand command = { VertexCountPerInstance, InstanceCount, StartVertexLocation, 0, StartInstanceLocation };
+            Record(NullCommand::Draw, &command, sizeof(command));
+        }
+
+        void STDMETHODCALLTYPE DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation,
+            INT BaseVertexLocation, UINT StartInstanceLocation) override
+        {
+            NullDrawCommand command = { IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation };
+            Record(NullCommand::DrawIndexed, &command, sizeof(command));
+        }
+
+        void STDMETHODCALLTYPE Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ) override
+        {
+            NullDispatchCommand command = { ThreadGroupCountX, ThreadGroupCountY, ThreadGroupCountZ };
+            Record(NullCommand::Dispatch, &command, sizeof(command));
+        }
+
+        void STDMETHODCALLTYPE CopyBufferRegion(ID3D12Resource* pDstBuffer, UINT64 DstOffset, ID3D12Resource* pSrcBuffer,
+            UINT64 SrcOffset, UINT64 NumBytes) override
+        {
+            NullCopyBufferCommand command = { pDstBuffer, DstOffset, pSrcBuffer, SrcOffset, NumBytes };
+            Record(NullCommand::CopyBufferRegion, &command, sizeof(command));
+        }
+
+        void STDMETHODCALLTYPE CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* pDst, UINT DstX, UINT DstY, UINT DstZ,
+            const D3D12_TEXTURE_COPY_LOCATION* pSrc, const D3D12_BOX* pSrcBox) override
+        {
+            NullCopyTextureCommand command = {};
+            command.Dst = *pDst;
+            command.Src = *pSrc;
+            command.DstX = DstX;
+            command.DstY = DstY;
+            command.DstZ = DstZ;
+            command.HasBox = pSrcBox != nullptr;
+            if (pSrcBox)
+            {
+                command.SrcBox = *pSrcBox;
+            }
+            Record(NullCommand::CopyTextureRegion, &command, sizeof(command));
+        }
+
+        void STDMETHODCALLTYPE CopyResource(ID3D12Resource* pDstResource, ID3D12Resource* pSrcResource) override
+        {
+            NullCopyResourceCommand command = { pDstResource, pSrcResource, 0, 0 };
+            Record(NullCommand::CopyResource, &command, sizeof(command));
+        }
+
+        void STDMETHODCALLTYPE CopyTiles(ID3D12Resource* pTiledResource, const D3D12_TILED_RESOURCE_COORDINATE* pTileRegionStartCoordinate,
+            const D3D12_TILE_REGION_SIZE* pTileRegionSize, ID3D12Resource* pBuffer, UINT64 BufferStartOffsetInBytes, D3D12_TILE_COPY_FLAGS Flags) override
+        {
+            RecordState(0, 0, 0);
+        }
+
+        void STDMETHODCALLTYPE ResolveSubresource(ID3D12Resource* pDstResource, UINT DstSubresource, ID3D12Resource* pSrcResource,
+            UINT SrcSubresource, DXGI_FORMAT Format) override
+        {
+            NullCopyResourceCommand command = { pDstResource, pSrcResource, DstSubresource, SrcSubresource };
+            Record(NullCommand::ResolveSubresource, &command, sizeof(command));
+        }
+
+        void STDMETHODCALLTYPE IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology) override
+        {
+            RecordState(0, 1, PrimitiveTopology);
+        }
+
+        void STDMETHODCALLTYPE RSSetViewports(UINT NumViewports, const D3D12_VIEWPORT* pViewports) override
+        {
+            Record(NullCommand::SetState, pViewports, NumViewports * sizeof(D3D12_VIEWPORT));
+        }
+
+        void STDMETHODCALLTYPE RSSetScissorRects(UINT NumRects, const D3D12_RECT* pRects) override
+        {
+            Record(NullCommand::SetState, pRects, NumRects * sizeof(D3D12_RECT));
+        }
+
+        void STDMETHODCALLTYPE OMSetBlendFactor(const FLOAT BlendFactor[4]) override
+        {
+            Record(NullCommand::SetState, BlendFactor, BlendFactor ? sizeof(FLOAT) * 4 : 0);
+        }
+
+        void STDMETHODCALLTYPE OMSetStencilRef(UINT StencilRef) override
+        {
+            RecordState(0, 1, StencilRef);
+        }
+
+        void STDMETHODCALLTYPE SetPipelineState(ID3D12PipelineState* pPipelineState) override
+        {
+            RecordState(0, 1, reinterpret_cast<UINT64>(pPipelineState));
+        }
+
+        void STDMETHODCALLTYPE ResourceBarrier(UINT NumBarriers, const D3D12_RESOURCE_BARRIER* pBarriers) override
+        {
+            Record(NullCommand::ResourceBarrier, pBarriers, NumBarriers * sizeof(D3D12_RESOURCE_BARRIER));
+        }
+
+        void STDMETHODCALLTYPE ExecuteBundle(ID3D12GraphicsCommandList* pCommandList) override
+        {
+            RecordState(0, 1, reinterpret_cast<UINT64>(pCommandList));
+        }
+
+        void STDMETHODCALLTYPE SetDescriptorHeaps(UINT NumDescriptorHeaps, ID3D12DescriptorHeap* const* ppDescriptorHeaps) override
+        {
+            Record(NullCommand::SetState, ppDescriptorHeaps, NumDescriptorHeaps * sizeof(ID3D12DescriptorHeap*));
+        }
+
+        void STDMETHODCALLTYPE SetComputeRootSignature(ID3D12RootSignature* pRootSignature) override
+        {
+            RecordState(0, 1, reinterpret_cast<UINT64>(pRootSignature));
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRootSignature(ID3D12RootSignature* pRootSignature) override
+        {
+            RecordState(0, 1, reinterpret_cast<UINT64>(pRootSignature));
+        }
+
+        void STDMETHODCALLTYPE SetComputeRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor) override
+        {
+            RecordState(RootParameterIndex, 1, BaseDescriptor.ptr);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor) override
+        {
+            RecordState(RootParameterIndex, 1, BaseDescriptor.ptr);
+        }
+
+        void STDMETHODCALLTYPE SetComputeRoot32BitConstant(UINT RootParameterIndex, UINT SrcData, UINT DestOffsetIn32BitValues) override
+        {
+            RecordState(RootParameterIndex, DestOffsetIn32BitValues, SrcData);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRoot32BitConstant(UINT RootParameterIndex, UINT SrcData, UINT DestOffsetIn32BitValues) override
+        {
+            RecordState(RootParameterIndex, DestOffsetIn32BitValues, SrcData);
+        }
+
+        void STDMETHODCALLTYPE SetComputeRoot32BitConstants(UINT RootParameterIndex, UINT Num32BitValuesToSet, const void* pSrcData,
+            UINT DestOffsetIn32BitValues) override
+        {
+            Record(NullCommand::SetState, pSrcData, Num32BitValuesToSet * sizeof(UINT));
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRoot32BitConstants(UINT RootParameterIndex, UINT Num32BitValuesToSet, const void* pSrcData,
+            UINT DestOffsetIn32BitValues) override
+        {
+            Record(NullCommand::SetState, pSrcData, Num32BitValuesToSet * sizeof(UINT));
+        }
+
+        void STDMETHODCALLTYPE SetComputeRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+        {
+            RecordState(RootParameterIndex, 1, BufferLocation);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+        {
+            RecordState(RootParameterIndex, 1, BufferLocation);
+        }
+
+        void STDMETHODCALLTYPE SetComputeRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+        {
+            RecordState(RootParameterIndex, 1, BufferLocation);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+        {
+            RecordState(RootParameterIndex, 1, BufferLocation);
+        }
+
+        void STDMETHODCALLTYPE SetComputeRootUnorderedAccessView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+        {
+            RecordState(RootParameterIndex, 1, BufferLocation);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRootUnorderedAccessView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+        {
+            RecordState(RootParameterIndex, 1, BufferLocation);
+        }
+
+        void STDMETHODCALLTYPE IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView) override
+        {
+            Record(NullCommand::SetState, pView, pView ? sizeof(D3D12_INDEX_BUFFER_VIEW) : 0);
+        }
+
+        void STDMETHODCALLTYPE IASetVertexBuffers(UINT StartSlot, UINT NumViews, const D3D12_VERTEX_BUFFER_VIEW* pViews) override
+        {
+            Record(NullCommand::SetState, pViews, pViews ? NumViews * sizeof(D3D12_VERTEX_BUFFER_VIEW) : 0);
+        }
+
+        void STDMETHODCALLTYPE SOSetTargets(UINT StartSlot, UINT NumViews, const D3D12_STREAM_OUTPUT_BUFFER_VIEW* pViews) override
+        {
+            Record(NullCommand::SetState, pViews, pViews ? NumViews * sizeof(D3D12_STREAM_OUTPUT_BUFFER_VIEW) : 0);
+        }
+
+        void STDMETHODCALLTYPE OMSetRenderTargets(UINT NumRenderTargetDescriptors, const D3D12_CPU_DESCRIPTOR_HANDLE* pRenderTargetDescriptors,
+            BOOL RTsSingleHandleToDescriptorRange, const D3D12_CPU_DESCRIPTOR_HANDLE* pDepthStencilDescriptor) override
+        {
+            UINT numHandles = RTsSingleHandleToDescriptorRange ? (std::min)(NumRenderTargetDescriptors, 1u) : NumRenderTargetDescriptors;
+            Record(NullCommand::SetState, pRenderTargetDescriptors,
+                pRenderTargetDescriptors ? numHandles * sizeof(D3D12_CPU_DESCRIPTOR_HANDLE) : 0);
+        }
+
+        void STDMETHODCALLTYPE ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView, D3D12_CLEAR_FLAGS ClearFlags, FLOAT Depth,
+            UINT8 Stencil, UINT NumRects, const D3D12_RECT* pRects) override
+        {
+            NullClearCommand command = { DepthStencilView.ptr, { Depth, (FLOAT)Stencil, 0.0f, 0.0f } };
+            Record(NullCommand::Clear, &command, sizeof(command));
+        }
+
+        void STDMETHODCALLTYPE ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetView, const FLOAT ColorRGBA[4], UINT NumRects,
+            const D3D12_RECT* pRects) override
+        {
+            NullClearCommand command = { RenderTargetView.ptr, { ColorRGBA[0], ColorRGBA[1], ColorRGBA[2], ColorRGBA[3] } };
+            Record(NullCommand::Clear, &command, sizeof(command));
+        }
+
+        void STDMETHODCALLTYPE ClearUnorderedAccessViewUint(D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle,
+            ID3D12Resource* pResource, const UINT Values[4], UINT NumRects, const D3D12_RECT* pRects) override
+        {
+            NullClearCommand command = { ViewCPUHandle.ptr, { (FLOAT)Values[0], (FLOAT)Values[1], (FLOAT)Values[2], (FLOAT)Values[3] } };
+            Record(NullCommand::Clear, &command, sizeof(command));
+        }
+
+        void STDMETHODCALLTYPE ClearUnorderedAccessViewFloat(D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle,
+            ID3D12Resource* pResource, const FLOAT Values[4], UINT NumRects, const D3D12_RECT* pRects) override
+        {
+            NullClearCommand command = { ViewCPUHandle.ptr, { Values[0], Values[1], Values[2], Values[3] } };
+            Record(NullCommand::Clear, &command, sizeof(command));
+        }
+
+        void STDMETHODCALLTYPE DiscardResource(ID3D12Resource* pResource, const D3D12_DISCARD_REGION* pRegion) override
+        {
+            RecordState(0, 1, reinterpret_cast<UINT64>(pResource));
+        }
+
+        void STDMETHODCALLTYPE BeginQuery(ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index) override
+        {
+            RecordState(Index, Type, reinterpret_cast<UINT64>(pQueryHeap));
+        }
+
+        void STDMETHODCALLTYPE EndQuery(ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index) override
+        {
+            RecordState(Index, Type, reinterpret_cast<UINT64>(pQueryHeap));
+        }
+
+        void STDMETHODCALLTYPE ResolveQueryData(ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT StartIndex, UINT NumQueries,
+            ID3D12Resource* pDestinationBuffer, UINT64 AlignedDestinationBufferOffset) override
+        {
+            RecordState(StartIndex, NumQueries, reinterpret_cast<UINT64>(pQueryHeap));
+        }
+
+        void STDMETHODCALLTYPE SetPredication(ID3D12Resource* pBuffer, UINT64 AlignedBufferOffset, D3D12_PREDICATION_OP Operation) override
+        {
+            RecordState(0, Operation, reinterpret_cast<UINT64>(pBuffer));
+        }
+
+        void STDMETHODCALLTYPE SetMarker(UINT Metadata, const void* pData, UINT Size) override {}
+
+        void STDMETHODCALLTYPE BeginEvent(UINT Metadata, const void* pData, UINT Size) override {}
+
+        void STDMETHODCALLTYPE EndEvent() override {}
+
+        void STDMETHODCALLTYPE ExecuteIndirect(ID3D12CommandSignature* pCommandSignature, UINT MaxCommandCount, ID3D12Resource* pArgumentBuffer,
+            UINT64 ArgumentBufferOffset, ID3D12Resource* pCountBuffer, UINT64 CountBufferOffset) override
+        {
+            RecordState(0, MaxCommandCount, reinterpret_cast<UINT64>(pArgumentBuffer));
+        }
+
+        //ID3D12GraphicsCommandList1
+        void STDMETHODCALLTYPE AtomicCopyBufferUINT(ID3D12Resource* pDstBuffer, UINT64 DstOffset, ID3D12Resource* pSrcBuffer, UINT64 SrcOffset,
+            UINT Dependencies, ID3D12Resource* const* ppDependentResources, const D3D12_SUBRESOURCE_RANGE_UINT64* pDependentSubresourceRanges) override
+        {
+            CopyBufferRegion(pDstBuffer, DstOffset, pSrcBuffer, SrcOffset, sizeof(UINT));
+        }
+
+        void STDMETHODCALLTYPE AtomicCopyBufferUINT64(ID3D12Resource* pDstBuffer, UINT64 DstOffset, ID3D12Resource* pSrcBuffer, UINT64 SrcOffset,
+            UINT Dependencies, ID3D12Resource* const* ppDependentResources, const D3D12_SUBRESOURCE_RANGE_UINT64* pDependentSubresourceRanges) override
+        {
+            CopyBufferRegion(pDstBuffer, DstOffset, pSrcBuffer, SrcOffset, sizeof(UINT64));
+        }
+
+        void STDMETHODCALLTYPE OMSetDepthBounds(FLOAT Min, FLOAT Max) override
+        {
+            RecordState(0, 2, 0);
+        }
+
+        void STDMETHODCALLTYPE SetSamplePositions(UINT NumSamplesPerPixel, UINT NumPixels, D3D12_SAMPLE_POSITION* pSamplePositions) override
+        {
+            Record(NullCommand::SetState, pSamplePositions, pSamplePositions ? NumSamplesPerPixel * NumPixels * sizeof(D3D12_SAMPLE_POSITION) : 0);
+        }
+
+        void STDMETHODCALLTYPE ResolveSubresourceRegion(ID3D12Resource* pDstResource, UINT DstSubresource, UINT DstX, UINT DstY,
+            ID3D12Resource* pSrcResource, UINT SrcSubresource, D3D12_RECT* pSrcRect, DXGI_FORMAT Format, D3D12_RESOLVE_MODE ResolveMode) override
+        {
+            ResolveSubresource(pDstResource, DstSubresource, pSrcResource, SrcSubresource, Format);
+        }
+
+        void STDMETHODCALLTYPE SetViewInstanceMask(UINT Mask) override
+        {
+            RecordState(0, 1, Mask);
+        }
+
+        //ID3D12GraphicsCommandList2
+        void STDMETHODCALLTYPE WriteBufferImmediate(UINT Count, const D3D12_WRITEBUFFERIMMEDIATE_PARAMETER* pParams,
+            const D3D12_WRITEBUFFERIMMEDIATE_MODE* pModes) override
+        {
+            Record(NullCommand::WriteBufferImmediate, pParams, Count * sizeof(D3D12_WRITEBUFFERIMMEDIATE_PARAMETER));
+        }
+
+        //Run all recorded commands on the cpu.Called by a null command queue.
+        void Replay(NullReplayStatistics& Statistics)
+        {
+            assert(!m_IsRecording && "Error!Command list must be closed before execution");
+            const auto& stream = m_pAllocator->GetCommandStream();
+            size_t offset = m_StreamBegin;
+            while (offset + sizeof(NullCommandHeader) <= m_StreamEnd)
+            {
+                NullCommandHeader header;
+                std::memcpy(&header, stream.data() + offset, sizeof(header));
+                const uint8_t* pPayload = stream.data() + offset + sizeof(header);
+                offset += sizeof(header) + header.PayloadSize;
+
+                switch (header.Command)
+                {
+                case NullCommand::Draw:
+                case NullCommand::DrawIndexed:
+                    ++Statistics.Draws;
+                    break;
+                case NullCommand::Dispatch:
+                    ++Statistics.Dispatches;
+                    break;
+                case NullCommand::ResourceBarrier:
+                    Statistics.ResourceBarriers += header.PayloadSize / sizeof(D3D12_RESOURCE_BARRIER);
+                    break;
+                case NullCommand::CopyBufferRegion:
+                {
+                    NullCopyBufferCommand command;
+                    std::memcpy(&command, pPayload, sizeof(command));
+                    Statistics.BytesCopied += NullCopyMemory(
+                        static_cast<NullD3D12Resource*>(command.pDstBuffer), command.DstOffset,
+                        static_cast<NullD3D12Resource*>(command.pSrcBuffer), command.SrcOffset, command.NumBytes);
+                    ++Statistics.Copies;
+                }
+                break;
+                case NullCommand::CopyTextureRegion:
+                {
+                    NullCopyTextureCommand command;
+                    std::memcpy(&command, pPayload, sizeof(command));
+                    Statistics.BytesCopied += NullCopyTextureRegion(command);
+                    ++Statistics.Copies;
+                }
+                break;
+                case NullCommand::CopyResource:
+                {
+                    NullCopyResourceCommand command;
+                    std::memcpy(&command, pPayload, sizeof(command));
+                    auto pDst = static_cast<NullD3D12Resource*>(command.pDstResource);
+                    auto pSrc = static_cast<NullD3D12Resource*>(command.pSrcResource);
+                    Statistics.BytesCopied += NullCopyMemory(pDst, 0, pSrc, 0, (std::min)(pDst->GetSize(), pSrc->GetSize()));
+                    ++Statistics.Copies;
+                }
+                break;
+                case NullCommand::ResolveSubresource:
+                {
+                    //null device does not do multisample,just copy the first sample
+                    NullCopyResourceCommand command;
+                    std::memcpy(&command, pPayload, sizeof(command));
+                    auto pDst = static_cast<NullD3D12Resource*>(command.pDstResource);
+                    auto pSrc = static_cast<NullD3D12Resource*>(command.pSrcResource);
+                    auto pDstLayout = pDst->GetSubresourceLayout(command.DstSubresource);
+                    auto pSrcLayout = pSrc->GetSubresourceLayout(command.SrcSubresource);
+                    if (pDstLayout && pSrcLayout)
+                    {
+                        UINT64 size = (UINT64)pDstLayout->Footprint.RowPitch * pDstLayout->Footprint.Height * pDstLayout->Footprint.Depth;
+                        Statistics.BytesCopied += NullCopyMemory(pDst, pDstLayout->Offset, pSrc, pSrcLayout->Offset, size);
+                    }
+                    ++Statistics.Copies;
+                }
+                break;
+                default:
+                    break;
+                }
+            }
+        }
+    protected:
+        bool IsSupportedInterface(REFIID riid)const override
+        {
+            return NullDeviceChild<ID3D12GraphicsCommandList2>::IsSupportedInterface(riid) ||
+                riid == __uuidof(ID3D12CommandList) ||
+                riid == __uuidof(ID3D12GraphicsCommandList) ||
+                riid == __uuidof(ID3D12GraphicsCommandList1) ||
+                riid == __uuidof(ID3D12GraphicsCommandList2);
+        }
+    private:
+        //Append a packet to the memory of command allocator.
+        void Record(NullCommand Command, const void* pPayload, size_t PayloadSize)
+        {
+            assert(m_IsRecording && "Error!Command list is closed");
+            auto& stream = m_pAllocator->GetCommandStream();
+            size_t offset = stream.size();
+            NullCommandHeader header = { Command, (UINT32)PayloadSize };
+            stream.resize(offset + sizeof(header) + PayloadSize);
+            std::memcpy(stream.data() + offset, &header, sizeof(header));
+            if (PayloadSize > 0)
+            {
+                std::memcpy(stream.data() + offset + sizeof(header), pPayload, PayloadSize);
+            }
+            ++m_NumRecordedCommands;
+            m_NumRecordedBytes += sizeof(header) + PayloadSize;
+        }
+
+        void RecordState(UINT32 Slot, UINT32 Count, UINT64 Value)
+        {
+            NullStateCommand command = { Slot, Count, Value };
+            Record(NullCommand::SetState, &command, sizeof(command));
+        }
+
+        D3D12_COMMAND_LIST_TYPE m_Type;
+        Microsoft::WRL::ComPtr<NullD3D12CommandAllocator> m_pAllocator;
+        bool m_IsRecording;
+        //the range of command stream in allocator which belongs to this list
+        size_t m_StreamBegin;
+        size_t m_StreamEnd;
+        //local counters,they are added to device counters when the list is closed.
+        UINT64 m_NumRecordedCommands;
+        UINT64 m_NumRecordedBytes;
+    };
+
+    /************************************************************************/
+    /* Command queue                                                        */
+    /************************************************************************/
+
+    //A null command queue executes command lists on the submitting thread.
+    //Signals and waits are kept in order on a timeline: if nothing is pending,an operation runs at once,
+    //otherwise it is handed to a timeline thread which sleeps for fence latency or waits for other fences.
+    class NullD3D12CommandQueue : public NullDeviceChild<ID3D12CommandQueue>
+    {
+    public:
+        NullD3D12CommandQueue(NullD3D12Device* pDevice, const D3D12_COMMAND_QUEUE_DESC& Desc)
+            : NullDeviceChild<ID3D12CommandQueue>(pDevice)
+            , m_Desc(Desc)
+            , m_bShutdown(false)
+        {
+            m_TimelineThread = std::thread(&NullD3D12CommandQueue::ProcessTimeline, this);
+        }
+
+        ~NullD3D12CommandQueue()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_TimelineMutex);
+                m_bShutdown = true;
+            }
+            m_TimelineConditionVariable.notify_all();
+            m_TimelineThread.join();
+        }
+
+        void STDMETHODCALLTYPE UpdateTileMappings(ID3D12Resource* pResource, UINT NumResourceRegions,
+            const D3D12_TILED_RESOURCE_COORDINATE* pResourceRegionStartCoordinates, const D3D12_TILE_REGION_SIZE* pResourceRegionSizes,
+            ID3D12Heap* pHeap, UINT NumRanges, const D3D12_TILE_RANGE_FLAGS* pRangeFlags, const UINT* pHeapRangeStartOffsets,
+            const UINT* pRangeTileCounts, D3D12_TILE_MAPPING_FLAGS Flags) override {}
+
+        void STDMETHODCALLTYPE CopyTileMappings(ID3D12Resource* pDstResource, const D3D12_TILED_RESOURCE_COORDINATE* pDstRegionStartCoordinate,
+            ID3D12Resource* pSrcResource, const D3D12_TILED_RESOURCE_COORDINATE* pSrcRegionStartCoordinate,
+            const D3D12_TILE_REGION_SIZE* pRegionSize, D3D12_TILE_MAPPING_FLAGS Flags) override {}
+
+        void STDMETHODCALLTYPE ExecuteCommandLists(UINT NumCommandLists, ID3D12CommandList* const* ppCommandLists) override
+        {
+            TimelineOperation operation;
+            operation.Type = TimelineOperationType::Execute;
+            operation.CommandLists.assign(ppCommandLists, ppCommandLists + NumCommandLists);
+            Submit(std::move(operation));
+        }
+
+        void STDMETHODCALLTYPE SetMarker(UINT Metadata, const void* pData, UINT Size) override {}
+
+        void STDMETHODCALLTYPE BeginEvent(UINT Metadata, const void* pData, UINT Size) override {}
+
+        void STDMETHODCALLTYPE EndEvent() override {}
+
+        HRESULT STDMETHODCALLTYPE Signal(ID3D12Fence* pFence, UINT64 Value) override
+        {
+            if (!pFence)
+            {
+                return E_INVALIDARG;
+            }
+            TimelineOperation operation;
+            operation.Type = TimelineOperationType::Signal;
+            operation.pFence = static_cast<NullD3D12Fence*>(pFence);
+            operation.Value = Value;
+            operation.Deadline = std::chrono::steady_clock::now() + m_pDevice->GetNullDesc().FenceLatency;
+            Submit(std::move(operation));
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE Wait(ID3D12Fence* pFence, UINT64 Value) override
+        {
+            if (!pFence)
+            {
+                return E_INVALIDARG;
+            }
+            TimelineOperation operation;
+            operation.Type = TimelineOperationType::Wait;
+            operation.pFence = static_cast<NullD3D12Fence*>(pFence);
+            operation.Value = Value;
+            Submit(std::move(operation));
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetTimestampFrequency(UINT64* pFrequency) override
+        {
+            if (!pFrequency)
+            {
+                return E_INVALIDARG;
+            }
+            *pFrequency = 1000000000ull;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetClockCalibration(UINT64* pGpuTimestamp, UINT64* pCpuTimestamp) override
+        {
+            UINT64 now = (UINT64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            if (pGpuTimestamp) *pGpuTimestamp = now;
+            if (pCpuTimestamp) *pCpuTimestamp = now;
+            return S_OK;
+        }
+
+        D3D12_COMMAND_QUEUE_DESC STDMETHODCALLTYPE GetDesc() override { return m_Desc; }
+    protected:
+        bool IsSupportedInterface(REFIID riid)const override
+        {
+            return NullDeviceChild<ID3D12CommandQueue>::IsSupportedInterface(riid) ||
+                riid == __uuidof(ID3D12Pageable) || riid == __uuidof(ID3D12CommandQueue);
+        }
+    private:
+        enum class TimelineOperationType
+        {
+            Execute,
+            Signal,
+            Wait
+        };
+
+        struct TimelineOperation
+        {
+            TimelineOperationType Type = TimelineOperationType::Execute;
+            std::vector<Microsoft::WRL::ComPtr<ID3D12CommandList>> CommandLists;
+            Microsoft::WRL::ComPtr<NullD3D12Fence> pFence;
+            UINT64 Value = 0;
+            std::chrono::steady_clock::time_point Deadline;
+        };
+
+        bool IsReady(const TimelineOperation& Operation)const
+        {
+            switch (Operation.Type)
+            {
+            case TimelineOperationType::Signal:
+                return std::chrono::steady_clock::now() >= Operation.Deadline;
+            case TimelineOperationType::Wait:
+                return Operation.pFence->GetCompletedValue() >= Operation.Value;
+            default:
+                return true;
+            }
+        }
+
+        void Submit(TimelineOperation&& Operation)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_TimelineMutex);
+                //run at once if nothing is pending,this keeps the order of operations.
+                if (m_Timeline.empty() && IsReady(Operation))
+                {
+                    RunOperation(Operation);
+                    return;
+                }
+                m_Timeline.push_back(std::move(Operation));
+            }
+            m_TimelineConditionVariable.notify_one();
+        }
+        //Must be called with timeline mutex held.
+        void RunOperation(TimelineOperation& Operation)
+        {
+            auto& counters = m_pDevice->GetCounters();
+            switch (Operation.Type)
+            {
+            case TimelineOperationType::Execute:
+            {
+                NullReplayStatistics statistics;
+                for (auto& commandList : Operation.CommandLists)
+                {
+                    static_cast<NullD3D12GraphicsCommandList*>(commandList.Get())->Replay(statistics);
+                }
+                NullCount(counters.CommandListsExecuted, Operation.CommandLists.size());
+                NullCount(counters.ResourceBarriers, statistics.ResourceBarriers);
+                NullCount(counters.Draws, statistics.Draws);
+                NullCount(counters.Dispatches, statistics.Dispatches);
+                NullCount(counters.Copies, statistics.Copies);
+                NullCount(counters.BytesCopied, statistics.BytesCopied);
+            }
+            break;
+            case TimelineOperationType::Signal:
+                Operation.pFence->SetCompletedValue(Operation.Value);
+                NullCount(counters.FenceSignals);
+                break;
+            case TimelineOperationType::Wait:
+                NullCount(counters.FenceWaits);
+                break;
+            }
+        }
+
+        void ProcessTimeline()
+        {
+            std::unique_lock<std::mutex> lock(m_TimelineMutex);
+            while (true)
+            {
+                m_TimelineConditionVariable.wait(lock, [this]() { return m_bShutdown || !m_Timeline.empty(); });
+                if (m_bShutdown)
+                {
+                    break;
+                }
+                //the operation stays in the front until it is done,so that Submit() never overtakes it.
+                //Note:references to deque elements are not invalidated by push_back().
+                TimelineOperation& operation = m_Timeline.front();
+                if (operation.Type == TimelineOperationType::Signal)
+                {
+                    m_TimelineConditionVariable.wait_until(lock, operation.Deadline, [this]() { return m_bShutdown; });
+                }
+                else if (operation.Type == TimelineOperationType::Wait)
+                {
+                    lock.unlock();
+                    while (!operation.pFence->WaitForValue(operation.Value, std::chrono::milliseconds(1)))
+                    {
+                        std::lock_guard<std::mutex> shutdownLock(m_TimelineMutex);
+                        if (m_bShutdown)
+                        {
+                            break;
+                        }
+                    }
+                    lock.lock();
+                }
+                if (m_bShutdown)
+                {
+                    break;
+                }
+                RunOperation(operation);
+                m_Timeline.pop_front();
+            }
+        }
+
+        D3D12_COMMAND_QUEUE_DESC m_Desc;
+
+        std::deque<TimelineOperation> m_Timeline;
+        std::mutex m_TimelineMutex;
+        std::condition_variable m_TimelineConditionVariable;
+        std::thread m_TimelineThread;
+        bool m_bShutdown;
+    };
+
+    /************************************************************************/
+    /* Null device member functions                                         */
+    /************************************************************************/
+
+    HRESULT NullD3D12Device::CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* pDesc, REFIID riid, void** ppCommandQueue)
+    {
+        if (!pDesc)
+        {
+            return E_INVALIDARG;
+        }
+        return NullReturnObject(new (std::nothrow) NullD3D12CommandQueue(this, *pDesc), riid, ppCommandQueue);
+    }
+
+    HRESULT NullD3D12Device::CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type, REFIID riid, void** ppCommandAllocator)
+    {
+        return NullReturnObject(new (std::nothrow) NullD3D12CommandAllocator(this, type), riid, ppCommandAllocator);
+    }
+
+    HRESULT NullD3D12Device::CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc, REFIID riid, void** ppPipelineState)
+    {
+        if (!pDesc)
+        {
+            return E_INVALIDARG;
+        }
+        return NullReturnObject(new (std::nothrow) NullD3D12PipelineState(this), riid, ppPipelineState);
+    }
+
+    HRESULT NullD3D12Device::CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC* pDesc, REFIID riid, void** ppPipelineState)
+    {
+        if (!pDesc)
+        {
+            return E_INVALIDARG;
+        }
+        return NullReturnObject(new (std::nothrow) NullD3D12PipelineState(this), riid, ppPipelineState);
+    }
+
+    HRESULT NullD3D12Device::CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC* pDesc, REFIID riid, void** ppPipelineState)
+    {
+        if (!pDesc)
+        {
+            return E_INVALIDARG;
+        }
+        return NullReturnObject(new (std::nothrow) NullD3D12PipelineState(this), riid, ppPipelineState);
+    }
+
+    HRESULT NullD3D12Device::CreateCommandList(UINT nodeMask, D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator* pCommandAllocator,
+        ID3D12PipelineState* pInitialState, REFIID riid, void** ppCommandList)
+    {
+        if (!pCommandAllocator)
+        {
+            return E_INVALIDARG;
+        }
+        auto pCommandList = new (std::nothrow) NullD3D12GraphicsCommandList(this, type);
+        if (pCommandList)
+        {
+            //a new command list is in recording state
+            pCommandList->Reset(pCommandAllocator, pInitialState);
+        }
+        return NullReturnObject(pCommandList, riid, ppCommandList);
+    }
+
+    HRESULT NullD3D12Device::CheckFeatureSupport(D3D12_FEATURE Feature, void* pFeatureSupportData, UINT FeatureSupportDataSize)
+    {
+        if (!pFeatureSupportData)
+        {
+            return E_INVALIDARG;
+        }
+        switch (Feature)
+        {
+        case D3D12_FEATURE_D3D12_OPTIONS:
+        {
+            if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS))
+            {
+                return E_INVALIDARG;
+            }
+            D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+            options.ResourceBindingTier = D3D12_RESOURCE_BINDING_TIER_3;
+            options.TiledResourcesTier = D3D12_TILED_RESOURCES_TIER_NOT_SUPPORTED;
+            options.ResourceHeapTier = D3D12_RESOURCE_HEAP_TIER_2;
+            options.TypedUAVLoadAdditionalFormats = TRUE;
+            std::memcpy(pFeatureSupportData, &options, sizeof(options));
+            return S_OK;
+        }
+        case D3D12_FEATURE_ARCHITECTURE:
+        {
+            if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_ARCHITECTURE))
+            {
+                return E_INVALIDARG;
+            }
+            auto pData = static_cast<D3D12_FEATURE_DATA_ARCHITECTURE*>(pFeatureSupportData);
+            pData->TileBasedRenderer = FALSE;
+            pData->UMA = TRUE;
+            pData->CacheCoherentUMA = TRUE;
+            return S_OK;
+        }
+        case D3D12_FEATURE_FEATURE_LEVELS:
+        {
+            if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_FEATURE_LEVELS))
+            {
+                return E_INVALIDARG;
+            }
+            auto pData = static_cast<D3D12_FEATURE_DATA_FEATURE_LEVELS*>(pFeatureSupportData);
+            pData->MaxSupportedFeatureLevel = D3D_FEATURE_LEVEL_11_0;
+            for (UINT i = 0; i < pData->NumFeatureLevels; ++i)
+            {
+                if (pData->pFeatureLevelsRequested[i] <= D3D_FEATURE_LEVEL_12_1)
+                {
+                    pData->MaxSupportedFeatureLevel = (std::max)(pData->MaxSupportedFeatureLevel, pData->pFeatureLevelsRequested[i]);
+                }
+            }
+            return S_OK;
+        }
+        case D3D12_FEATURE_FORMAT_SUPPORT:
+        {
+            if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_FORMAT_SUPPORT))
+            {
+                return E_INVALIDARG;
+            }
+            auto pData = static_cast<D3D12_FEATURE_DATA_FORMAT_SUPPORT*>(pFeatureSupportData);
+            bool isKnown = NullBitsPerPixel(pData->Format) != 0;
+            pData->Support1 = isKnown ? static_cast<D3D12_FORMAT_SUPPORT1>(~0u) : D3D12_FORMAT_SUPPORT1_NONE;
+            pData->Support2 = isKnown ? static_cast<D3D12_FORMAT_SUPPORT2>(~0u) : D3D12_FORMAT_SUPPORT2_NONE;
+            return S_OK;
+        }
+        case D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS:
+        {
+            if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS))
+            {
+                return E_INVALIDARG;
+            }
+            auto pData = static_cast<D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS*>(pFeatureSupportData);
+            UINT count = pData->SampleCount;
+            pData->NumQualityLevels = (count == 1 || count == 2 || count == 4 || count == 8) ? 1 : 0;
+            return S_OK;
+        }
+        case D3D12_FEATURE_FORMAT_INFO:
+        {
+            if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_FORMAT_INFO))
+            {
+                return E_INVALIDARG;
+            }
+            auto pData = static_cast<D3D12_FEATURE_DATA_FORMAT_INFO*>(pFeatureSupportData);
+            if (NullBitsPerPixel(pData->Format) == 0)
+            {
+                return E_INVALIDARG;
+            }
+            pData->PlaneCount = NullPlaneCount(pData->Format);
+            return S_OK;
+        }
+        case D3D12_FEATURE_ROOT_SIGNATURE:
+        {
+            if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_ROOT_SIGNATURE))
+            {
+                return E_INVALIDARG;
+            }
+            auto pData = static_cast<D3D12_FEATURE_DATA_ROOT_SIGNATURE*>(pFeatureSupportData);
+            pData->HighestVersion = (std::min)(pData->HighestVersion, D3D_ROOT_SIGNATURE_VERSION_1_1);
+            return S_OK;
+        }
+        default:
+            return E_INVALIDARG;
+        }
+    }
+
+    HRESULT NullD3D12Device::CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* pDescriptorHeapDesc, REFIID riid, void** ppvHeap)
+    {
+        if (!pDescriptorHeapDesc)
+        {
+            return E_INVALIDARG;
+        }
+        NullCount(m_Counters.DescriptorHeapsCreated);
+        return NullReturnObject(new (std::nothrow) NullD3D12DescriptorHeap(this, *pDescriptorHeapDesc), riid, ppvHeap);
+    }
+
+    HRESULT NullD3D12Device::CreateRootSignature(UINT nodeMask, const void* pBlobWithRootSignature, SIZE_T blobLengthInBytes,
+        REFIID riid, void** ppvRootSignature)
+    {
+        if (!pBlobWithRootSignature || blobLengthInBytes == 0)
+        {
+            return E_INVALIDARG;
+        }
+        return NullReturnObject(new (std::nothrow) NullD3D12RootSignature(this), riid, ppvRootSignature);
+    }
+
+    void NullD3D12Device::CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor)
+    {
+        NullDescriptor descriptor = {};
+        descriptor.ViewType = NullDescriptor::ConstantBufferView;
+        descriptor.BufferLocation = pDesc ? pDesc->BufferLocation : 0;
+        WriteDescriptor(DestDescriptor, descriptor);
+    }
+
+    void NullD3D12Device::CreateShaderResourceView(ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc,
+        D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor)
+    {
+        NullDescriptor descriptor = {};
+        descriptor.pResource = pResource;
+        descriptor.ViewType = NullDescriptor::ShaderResourceView;
+        descriptor.Format = pDesc ? pDesc->Format : DXGI_FORMAT_UNKNOWN;
+        descriptor.Dimension = pDesc ? pDesc->ViewDimension : D3D12_SRV_DIMENSION_UNKNOWN;
+        WriteDescriptor(DestDescriptor, descriptor);
+    }
+
+    void NullD3D12Device::CreateUnorderedAccessView(ID3D12Resource* pResource, ID3D12Resource* pCounterResource,
+        const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor)
+    {
+        NullDescriptor descriptor = {};
+        descriptor.pResource = pResource;
+        descriptor.ViewType = NullDescriptor::UnorderedAccessView;
+        descriptor.Format = pDesc ? pDesc->Format : DXGI_FORMAT_UNKNOWN;
+        descriptor.Dimension = pDesc ? pDesc->ViewDimension : D3D12_UAV_DIMENSION_UNKNOWN;
+        WriteDescriptor(DestDescriptor, descriptor);
+    }
+
+    void NullD3D12Device::CreateRenderTargetView(ID3D12Resource* pResource, const D3D12_RENDER_TARGET_VIEW_DESC* pDesc,
+        D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor)
+    {
+        NullDescriptor descriptor = {};
+        descriptor.pResource = pResource;
+        descriptor.ViewType = NullDescriptor::RenderTargetView;
+        descriptor.Format = pDesc ? pDesc->Format : DXGI_FORMAT_UNKNOWN;
+        descriptor.Dimension = pDesc ? pDesc->ViewDimension : D3D12_RTV_DIMENSION_UNKNOWN;
+        WriteDescriptor(DestDescriptor, descriptor);
+    }
+
+    void NullD3D12Device::CreateDepthStencilView(ID3D12Resource* pResource, const D3D12_DEPTH_STENCIL_VIEW_DESC* pDesc,
+        D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor)
+    {
+        NullDescriptor descriptor = {};
+        descriptor.pResource = pResource;
+        descriptor.ViewType = NullDescriptor::DepthStencilView;
+        descriptor.Format = pDesc ? pDesc->Format : DXGI_FORMAT_UNKNOWN;
+        descriptor.Dimension = pDesc ? pDesc->ViewDimension : D3D12_DSV_DIMENSION_UNKNOWN;
+        WriteDescriptor(DestDescriptor, descriptor);
+    }
+
+    void NullD3D12Device::CreateSampler(const D3D12_SAMPLER_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor)
+    {
+        NullDescriptor descriptor = {};
+        descriptor.ViewType = NullDescriptor::Sampler;
+        descriptor.Format = pDesc ? pDesc->Filter : 0;
+        descriptor.Dimension = pDesc ? pDesc->AddressU : 0;
+        WriteDescriptor(DestDescriptor, descriptor);
+    }
+
+    void NullD3D12Device::CopyDescriptors(UINT NumDestDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* pDestDescriptorRangeStarts,
+        const UINT* pDestDescriptorRangeSizes, UINT NumSrcDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcDescriptorRangeStarts,
+        const UINT* pSrcDescriptorRangeSizes, D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapsType)
+    {
+        //walk both range lists at the same time,a null size array means every range has one descriptor.
+        UINT dstRange = 0, dstOffset = 0;
+        UINT srcRange = 0, srcOffset = 0;
+        UINT64 numCopied = 0;
+        while (dstRange < NumDestDescriptorRanges && srcRange < NumSrcDescriptorRanges)
+        {
+            UINT dstSize = pDestDescriptorRangeSizes ? pDestDescriptorRangeSizes[dstRange] : 1;
+            UINT srcSize = pSrcDescriptorRangeSizes ? pSrcDescriptorRangeSizes[srcRange] : 1;
+            UINT count = (std::min)(dstSize - dstOffset, srcSize - srcOffset);
+            if (count > 0)
+            {
+                std::memcpy(
+                    reinterpret_cast<uint8_t*>(pDestDescriptorRangeStarts[dstRange].ptr) + (SIZE_T)dstOffset * sizeof(NullDescriptor),
+                    reinterpret_cast<const uint8_t*>(pSrcDescriptorRangeStarts[srcRange].ptr) + (SIZE_T)srcOffset * sizeof(NullDescriptor),
+                    (SIZE_T)count * sizeof(NullDescriptor));
+                numCopied += count;
+            }
+            dstOffset += count;
+            srcOffset += count;
+            if (dstOffset >= dstSize)
+            {
+                ++dstRange;
+                dstOffset = 0;
+            }
+            if (srcOffset >= srcSize)
+            {
+                ++srcRange;
+                srcOffset = 0;
+            }
+        }
+        NullCount(m_Counters.DescriptorsCopied, numCopied);
+    }
+
+    void NullD3D12Device::CopyDescriptorsSimple(UINT NumDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptorRangeStart,
+        D3D12_CPU_DESCRIPTOR_HANDLE SrcDescriptorRangeStart, D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapsType)
+    {
+        std::memcpy(reinterpret_cast<void*>(DestDescriptorRangeStart.ptr), reinterpret_cast<const void*>(SrcDescriptorRangeStart.ptr),
+            (SIZE_T)NumDescriptors * sizeof(NullDescriptor));
+        NullCount(m_Counters.DescriptorsCopied, NumDescriptors);
+    }
+
+    D3D12_RESOURCE_ALLOCATION_INFO NullD3D12Device::GetResourceAllocationInfo(UINT visibleMask, UINT numResourceDescs,
+        const D3D12_RESOURCE_DESC* pResourceDescs)
+    {
+        D3D12_RESOURCE_ALLOCATION_INFO info = { 0, 0 };
+        for (UINT i = 0; i < numResourceDescs; ++i)
+        {
+            UINT64 size = NullResourceSize(pResourceDescs[i]);
+            if (size == UINT64_MAX)
+            {
+                info.SizeInBytes = UINT64_MAX;
+                return info;
+            }
+            UINT64 alignment = NullResourceAlignment(pResourceDescs[i]);
+            info.SizeInBytes = NullAlignUp<UINT64>(info.SizeInBytes, alignment) + NullAlignUp<UINT64>(size, alignment);
+            info.Alignment = (std::max)(info.Alignment, alignment);
+        }
+        return info;
+    }
+
+    D3D12_HEAP_PROPERTIES NullD3D12Device::GetCustomHeapProperties(UINT nodeMask, D3D12_HEAP_TYPE heapType)
+    {
+        D3D12_HEAP_PROPERTIES properties = {};
+        properties.Type = D3D12_HEAP_TYPE_CUSTOM;
+        properties.MemoryPoolPreference = D3D12_MEMORY_POOL_L0;
+        properties.CreationNodeMask = 1;
+        properties.VisibleNodeMask = 1;
+        switch (heapType)
+        {
+        case D3D12_HEAP_TYPE_UPLOAD:
+            properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_COMBINE;
+            break;
+        case D3D12_HEAP_TYPE_READBACK:
+            properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_BACK;
+            break;
+        default:
+            properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_NOT_AVAILABLE;
+            break;
+        }
+        return properties;
+    }
+
+    HRESULT NullD3D12Device::CreateCommittedResource(const D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS HeapFlags,
+        const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES InitialResourceState, const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+        REFIID riidResource, void** ppvResource)
+    {
+        if (!pHeapProperties || !pDesc)
+        {
+            return E_INVALIDARG;
+        }
+        UINT64 size = NullResourceSize(*pDesc);
+        if (size == UINT64_MAX)
+        {
+            return E_INVALIDARG;
+        }
+        std::shared_ptr<NullMemoryBlock> pMemory;
+        if (IsBackedHeap(*pHeapProperties))
+        {
+            pMemory = std::make_shared<NullMemoryBlock>(size);
+        }
+        NullCount(m_Counters.ResourcesCreated);
+        return NullReturnObject(
+            new (std::nothrow) NullD3D12Resource(this, *pDesc, *pHeapProperties, HeapFlags, size, std::move(pMemory), 0,
+                AllocateVirtualAddress(size), nullptr),
+            riidResource, ppvResource);
+    }
+
+    HRESULT NullD3D12Device::CreateHeap(const D3D12_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap)
+    {
+        if (!pDesc || pDesc->SizeInBytes == 0)
+        {
+            return E_INVALIDARG;
+        }
+        NullCount(m_Counters.HeapsCreated);
+        return NullReturnObject(new (std::nothrow) NullD3D12Heap(this, *pDesc), riid, ppvHeap);
+    }
+
+    HRESULT NullD3D12Device::CreatePlacedResource(ID3D12Heap* pHeap, UINT64 HeapOffset, const D3D12_RESOURCE_DESC* pDesc,
+        D3D12_RESOURCE_STATES InitialState, const D3D12_CLEAR_VALUE* pOptimizedClearValue, REFIID riid, void** ppvResource)
+    {
+        if (!pHeap || !pDesc)
+        {
+            return E_INVALIDARG;
+        }
+        auto pNullHeap = static_cast<NullD3D12Heap*>(pHeap);
+        D3D12_HEAP_DESC heapDesc = pNullHeap->GetDesc();
+        UINT64 size = NullResourceSize(*pDesc);
+        if (size == UINT64_MAX || HeapOffset % NullResourceAlignment(*pDesc) != 0 || HeapOffset + size > heapDesc.SizeInBytes)
+        {
+            return E_INVALIDARG;
+        }
+        //resources which are placed in same heap range alias same memory
+        NullCount(m_Counters.ResourcesCreated);
+        return NullReturnObject(
+            new (std::nothrow) NullD3D12Resource(this, *pDesc, heapDesc.Properties, heapDesc.Flags, size, pNullHeap->GetMemory(), HeapOffset,
+                pNullHeap->GetVirtualAddress() + HeapOffset, pHeap),
+            riid, ppvResource);
+    }
+
+    HRESULT NullD3D12Device::CreateFence(UINT64 InitialValue, D3D12_FENCE_FLAGS Flags, REFIID riid, void** ppFence)
+    {
+        return NullReturnObject(new (std::nothrow) NullD3D12Fence(this, InitialValue), riid, ppFence);
+    }
+
+    void NullD3D12Device::GetCopyableFootprints(const D3D12_RESOURCE_DESC* pResourceDesc, UINT FirstSubresource, UINT NumSubresources,
+        UINT64 BaseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts, UINT* pNumRows, UINT64* pRowSizeInBytes, UINT64* pTotalBytes)
+    {
+        if (!pResourceDesc || !NullComputeFootprints(*pResourceDesc, FirstSubresource, NumSubresources, BaseOffset,
+            pLayouts, pNumRows, pRowSizeInBytes, pTotalBytes))
+        {
+            //same behaviour with a hardware device when the desc is invalid
+            for (UINT i = 0; i < NumSubresources; ++i)
+            {
+                if (pLayouts) pLayouts[i].Offset = UINT64_MAX;
+                if (pNumRows) pNumRows[i] = UINT_MAX;
+                if (pRowSizeInBytes) pRowSizeInBytes[i] = UINT64_MAX;
+            }
+            if (pTotalBytes) *pTotalBytes = UINT64_MAX;
+        }
+    }
+
+    HRESULT NullD3D12Device::SetEventOnMultipleFenceCompletion(ID3D12Fence* const* ppFences, const UINT64* pFenceValues, UINT NumFences,
+        D3D12_MULTIPLE_FENCE_WAIT_FLAGS Flags, HANDLE hEvent)
+    {
+        auto isComplete = [&]()
+        {
+            bool waitAny = (Flags & D3D12_MULTIPLE_FENCE_WAIT_FLAG_ANY) != 0;
+            for (UINT i = 0; i < NumFences; ++i)
+            {
+                bool completed = ppFences[i]->GetCompletedValue() >= pFenceValues[i];
+                if (waitAny && completed) return true;
+                if (!waitAny && !completed) return false;
+            }
+            return !waitAny || NumFences == 0;
+        };
+        if (isComplete())
+        {
+            if (hEvent)
+            {
+                FenceEvent::Set(hEvent);
+            }
+            return S_OK;
+        }
+        if (hEvent)
+        {
+            //asynchronous notification of several fences is not supported by null device
+            return E_NOTIMPL;
+        }
+        while (!isComplete())
+        {
+            std::this_thread::yield();
+        }
+        return S_OK;
+    }
+
+    NullD3D12Device* GetNullD3D12Device(ID3D12Device* pDevice)
+    {
+        if (!pDevice)
+        {
+            return nullptr;
+        }
+        Microsoft::WRL::ComPtr<ID3D12Device2> device;
+        if (FAILED(pDevice->QueryInterface(IID_NullD3D12Device, reinterpret_cast<void**>(device.GetAddressOf()))))
+        {
+            return nullptr;
+        }
+        //the device is still referenced by the caller
+        return static_cast<NullD3D12Device*>(device.Get());
+    }
+}
+
+Microsoft::WRL::ComPtr<ID3D12Device2> NullDevice::Create(const NullDeviceDesc& Desc)
+{
+    Microsoft::WRL::ComPtr<ID3D12Device2> device;
+    device.Attach(new NullD3D12Device(Desc));
+    return device;
+}
+
+bool NullDevice::IsNullDevice(ID3D12Device* pDevice)
+{
+    return GetNullD3D12Device(pDevice) != nullptr;
+}
+
+NullDeviceStatistics NullDevice::GetStatistics(ID3D12Device* pDevice)
+{
+    NullDeviceStatistics statistics;
+    NullD3D12Device* pNullDevice = GetNullD3D12Device(pDevice);
+    if (pNullDevice)
+    {
+        auto& counters = pNullDevice->GetCounters();
+        statistics.ResourcesCreated = counters.ResourcesCreated.load();
+        statistics.HeapsCreated = counters.HeapsCreated.load();
+        statistics.DescriptorHeapsCreated = counters.DescriptorHeapsCreated.load();
+        statistics.DescriptorsWritten = counters.DescriptorsWritten.load();
+        statistics.DescriptorsCopied = counters.DescriptorsCopied.load();
+        statistics.CommandListsExecuted = counters.CommandListsExecuted.load();
+        statistics.CommandsRecorded = counters.CommandsRecorded.load();
+        statistics.RecordedBytes = counters.RecordedBytes.load();
+        statistics.ResourceBarriers = counters.ResourceBarriers.load();
+        statistics.Draws = counters.Draws.load();
+        statistics.Dispatches = counters.Dispatches.load();
+        statistics.Copies = counters.Copies.load();
+        statistics.BytesCopied = counters.BytesCopied.load();
+        statistics.FenceSignals = counters.FenceSignals.load();
+        statistics.FenceWaits = counters.FenceWaits.load();
+    }
+    return statistics;
+}
+
+void NullDevice::ResetStatistics(ID3D12Device* pDevice)
+{
+    NullD3D12Device* pNullDevice = GetNullD3D12Device(pDevice);
+    if (pNullDevice)
+    {
+        auto& counters = pNullDevice->GetCounters();
+        for (auto* pCounter : { &counters.ResourcesCreated, &counters.HeapsCreated, &counters.DescriptorHeapsCreated,
+            &counters.DescriptorsWritten, &counters.DescriptorsCopied, &counters.CommandListsExecuted, &counters.CommandsRecorded,
+            &counters.RecordedBytes, &counters.ResourceBarriers, &counters.Draws, &counters.Dispatches, &counters.Copies,
+            &counters.BytesCopied, &counters.FenceSignals, &counters.FenceWaits })
+        {
+            pCounter->store(0);
+        }
+    }
+}
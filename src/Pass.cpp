@@ -5,6 +5,8 @@
 #include "Camera.h"
 #include "FrustumCulling.h"
 #include "DynamicDescriptorHeap.h"
+#include "CommandQueue.h"
+#include "JobSystem.h"
 
 /************************************************************************/
 /*                                                                      */
@@ -12,34 +14,6 @@
 ShadowPass::ShadowPass()
     :m_ShadowPassState(TRUE)
 {
-    //Since in most cases,we will not use bind all space in shader.So we need to  create default srv for shadow maps
-    m_DirectionalAndSpotDefaultSrv = Application::GetApp()->AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, m_MaxDirectionAndSpotLightShadowNum);
-    for (int i = 0; i < m_MaxDirectionAndSpotLightShadowNum; ++i)
-    {
-        D3D12_SHADER_RESOURCE_VIEW_DESC DirectionAndSpotSrv = {};
-        DirectionAndSpotSrv.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-        DirectionAndSpotSrv.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        DirectionAndSpotSrv.Texture2DArray.ArraySize = 1;
-        DirectionAndSpotSrv.Texture2DArray.FirstArraySlice = 0;
-        DirectionAndSpotSrv.Texture2DArray.MipLevels = 1;
-        DirectionAndSpotSrv.Texture2DArray.MostDetailedMip = 0;
-        DirectionAndSpotSrv.Texture2DArray.PlaneSlice = 0;
-        DirectionAndSpotSrv.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
-
-        Application::GetApp()->GetDevice()->CreateShaderResourceView(nullptr, &DirectionAndSpotSrv, m_DirectionalAndSpotDefaultSrv.GetDescriptorHandle(i));
-    }
-    m_PointDefaultSrv = Application::GetApp()->AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, m_MaxPointLightShadowNum);
-    for (int i = 0; i < m_MaxPointLightShadowNum; ++i)
-    {
-        D3D12_SHADER_RESOURCE_VIEW_DESC PointSrv = {};
-        PointSrv.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-        PointSrv.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        PointSrv.TextureCube.MipLevels = 1;
-        PointSrv.TextureCube.MostDetailedMip = 0;
-        PointSrv.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
-
-        Application::GetApp()->GetDevice()->CreateShaderResourceView(nullptr, &PointSrv, m_PointDefaultSrv.GetDescriptorHandle(i));
-    }
 };
 
 void ShadowPass::ExecutePass(std::shared_ptr<CommandList> commandList)
@@ -53,6 +27,8 @@ void ShadowPass::ExecutePass(std::shared_ptr<CommandList> commandList)
             {
                 directionlight->SetSceneBoundingBox(Scene::GetScene()->GetSceneBoundingBox());
                 directionlight->RenderShadow(commandList);
+                //the shadow map is not used until forward rendering reads it,so gpu can transition it while rendering other shadows.
+                commandList->BarrierTransitionBegin(directionlight->GetLightShadow(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
             }
         }
         for (const auto& spotlight : Scene::GetScene()->GetSceneSpotLights())
@@ -60,6 +36,7 @@ void ShadowPass::ExecutePass(std::shared_ptr<CommandList> commandList)
             if (spotlight->GetRenderingShadowState())
             {
                 spotlight->RenderShadow(commandList);
+                commandList->BarrierTransitionBegin(spotlight->GetLightShadow(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
             }
         }
         for (const auto& pointlight : Scene::GetScene()->GetScenePointLights())
@@ -67,11 +44,71 @@ void ShadowPass::ExecutePass(std::shared_ptr<CommandList> commandList)
             if (pointlight->GetRenderingShadowState())
             {
                 pointlight->RenderShadow(commandList);
+                commandList->BarrierTransitionBegin(pointlight->GetLightShadow(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
             }
         }
     }
 }
 
+void ShadowPass::ExecutePassParallel(std::vector<std::shared_ptr<CommandList>>& commandLists)
+{
+    if (!m_ShadowPassState)
+    {
+        return;
+    }
+    auto lights = GetShadowLights();
+    //Scene bounding box is shared by all directional lights,so we set it before recording.
+    for (const auto& directionlight : Scene::GetScene()->GetSceneDirectionalLights())
+    {
+        if (directionlight->GetRenderingShadowState())
+        {
+            directionlight->SetSceneBoundingBox(Scene::GetScene()->GetSceneBoundingBox());
+        }
+    }
+
+    auto commandQueue = Application::GetApp()->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
+    //Each light writes its own slot,so the order does not depend on which job finishes first.
+    std::vector<std::shared_ptr<CommandList>> shadowCommandLists(lights.size());
+    Application::GetApp()->GetJobSystem()->ParallelFor(lights.size(), 1, [&](size_t Begin, size_t End)
+    {
+        for (size_t i = Begin; i < End; ++i)
+        {
+            shadowCommandLists[i] = commandQueue->GetCommandList();
+            lights[i]->RenderShadow(shadowCommandLists[i]);
+            //there is no other work on this command list,so it becomes a normal barrier when the list is closed.
+            shadowCommandLists[i]->BarrierTransitionBegin(lights[i]->GetLightShadow(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        }
+    });
+    commandLists.insert(commandLists.end(), shadowCommandLists.begin(), shadowCommandLists.end());
+}
+
+std::vector<Light*> ShadowPass::GetShadowLights()const
+{
+    std::vector<Light*> lights;
+    for (const auto& directionlight : Scene::GetScene()->GetSceneDirectionalLights())
+    {
+        if (directionlight->GetRenderingShadowState())
+        {
+            lights.push_back(directionlight.get());
+        }
+    }
+    for (const auto& spotlight : Scene::GetScene()->GetSceneSpotLights())
+    {
+        if (spotlight->GetRenderingShadowState())
+        {
+            lights.push_back(spotlight.get());
+        }
+    }
+    for (const auto& pointlight : Scene::GetScene()->GetScenePointLights())
+    {
+        if (pointlight->GetRenderingShadowState())
+        {
+            lights.push_back(pointlight.get());
+        }
+    }
+    return lights;
+}
+
 std::vector<const Texture*> ShadowPass::GetShadows(LightType Type)const
 {
     std::vector<const Texture*> shadows;
@@ -223,17 +260,9 @@ void PassBase::ExecutePass(
     assert(m_pRenderTarget && m_pRootSignature && "Error!This pass has not been set render target or root signature!");
     m_pPassFrustumCullinger->BindFrustumCamera(m_pRenderingCamera);
 
-    CD3DX12_VIEWPORT ViewPort = CD3DX12_VIEWPORT(m_pRenderTarget->GetTexture(AttachmentPoint::Color0).GetD3D12Resource().Get());
-    RECT ScissorRect = { 0,0,(int)ViewPort.Width,(int)ViewPort.Height };
     //Firstly,we need to clear and set render targets 
-    {
-        commandList->ClearRenderTarget(m_pRenderTarget.get());
-        commandList->SetD3D12ViewPort(&ViewPort);
-        commandList->SetD3D12ScissorRect(&ScissorRect);
-        commandList->SetRenderTargets(*m_pRenderTarget);
-    }
-    commandList->SetD3D12PipelineState(m_id3d12PassPipelineState);
-    commandList->SetGraphicsRootSignature(m_pRootSignature.get());
+    commandList->ClearRenderTarget(m_pRenderTarget.get());
+    SetPassState(commandList);
 
     //
     if (SetResourceFunc)
@@ -242,4 +271,17 @@ void PassBase::ExecutePass(
     }
 }
 
+void PassBase::SetPassState(std::shared_ptr<CommandList> commandList)
+{
+    CD3DX12_VIEWPORT ViewPort = CD3DX12_VIEWPORT(m_pRenderTarget->GetTexture(AttachmentPoint::Color0).GetD3D12Resource().Get());
+    RECT ScissorRect = { 0,0,(int)ViewPort.Width,(int)ViewPort.Height };
+
+    commandList->SetD3D12ViewPort(&ViewPort);
+    commandList->SetD3D12ScissorRect(&ScissorRect);
+    commandList->SetRenderTargets(*m_pRenderTarget);
+
+    commandList->SetD3D12PipelineState(m_id3d12PassPipelineState);
+    commandList->SetGraphicsRootSignature(m_pRootSignature.get());
+}
+
 
@@ -5,6 +5,11 @@
 #include "Camera.h"
 #include "FrustumCulling.h"
 #include "DynamicDescriptorHeap.h"
+#include "CommandQueue.h"
+#include "JobSystem.h"
+#include "BindlessDescriptorHeap.h"
+
+#include <algorithm>
 
 /************************************************************************/
 /*Following functions are for forward rendering.                                 
@@ -14,6 +19,7 @@ ForwardRendering::ForwardRendering(ForwardPassType Type, std::shared_ptr<RenderT
     :PassBase(pRenderTarget, pOutputCamera)
     , m_ForwardType(Type)
     , m_pForwardShdaowPass(std::make_unique<ShadowPass>())
+    , m_IsBindless(Application::GetApp()->GetBindlessDescriptorHeap() != nullptr)
 {
     //Create default pipeline and root signature for forward rendering.
     auto device = Application::GetApp()->GetDevice();
@@ -59,7 +65,31 @@ ForwardRendering::ForwardRendering(ForwardPassType Type, std::shared_ptr<RenderT
     D3D12_ROOT_SIGNATURE_FLAGS Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
     CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC versionedRootSigDesc = {};
-    versionedRootSigDesc.Init_1_1(RenderingRootParameter::NumRootParameters, RootParameters, staticSamplers.size(), staticSamplers.data(), Flags);
+    //
+    //Bindless tables are unbounded and start from offset 0,and the heap has descriptors which are not initialized,so they must be volatile.
+    CD3DX12_DESCRIPTOR_RANGE1 bindless2D = { D3D12_DESCRIPTOR_RANGE_TYPE_SRV,UINT_MAX,0,100,D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE,0 };
+    CD3DX12_DESCRIPTOR_RANGE1 bindless2DArray = { D3D12_DESCRIPTOR_RANGE_TYPE_SRV,UINT_MAX,0,101,D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE,0 };
+    CD3DX12_DESCRIPTOR_RANGE1 bindlessCube = { D3D12_DESCRIPTOR_RANGE_TYPE_SRV,UINT_MAX,0,102,D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE,0 };
+
+    CD3DX12_ROOT_PARAMETER1 BindlessRootParameters[BindlessRenderingRootParameter::NumBindlessRootParameters];
+    if (m_IsBindless)
+    {
+        for (int i = 0; i < BindlessRenderingRootParameter::StructuredTextureIndices; ++i)
+        {
+            BindlessRootParameters[i] = RootParameters[i];
+        }
+        BindlessRootParameters[BindlessRenderingRootParameter::StructuredTextureIndices].InitAsShaderResourceView(0, 9, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_PIXEL);
+        BindlessRootParameters[BindlessRenderingRootParameter::BindlessConstants].InitAsConstants(sizeof(ForwardRenderingBindlessConstants) / 4, 2, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        BindlessRootParameters[BindlessRenderingRootParameter::BindlessTexture2DTable].InitAsDescriptorTable(1, &bindless2D, D3D12_SHADER_VISIBILITY_PIXEL);
+        BindlessRootParameters[BindlessRenderingRootParameter::BindlessTexture2DArrayTable].InitAsDescriptorTable(1, &bindless2DArray, D3D12_SHADER_VISIBILITY_PIXEL);
+        BindlessRootParameters[BindlessRenderingRootParameter::BindlessTextureCubeTable].InitAsDescriptorTable(1, &bindlessCube, D3D12_SHADER_VISIBILITY_PIXEL);
+
+        versionedRootSigDesc.Init_1_1(BindlessRenderingRootParameter::NumBindlessRootParameters, BindlessRootParameters, staticSamplers.size(), staticSamplers.data(), Flags);
+    }
+    else
+    {
+        versionedRootSigDesc.Init_1_1(RenderingRootParameter::NumRootParameters, RootParameters, staticSamplers.size(), staticSamplers.data(), Flags);
+    }
     //
     m_pRootSignature->SetRootSignatureDesc(versionedRootSigDesc.Desc_1_1, highestVersion.HighestVersion);
     //-------------------------------------------------------------------------------------------------------------
@@ -67,8 +97,14 @@ ForwardRendering::ForwardRendering(ForwardPassType Type, std::shared_ptr<RenderT
     Microsoft::WRL::ComPtr<ID3DBlob> ForwardVS;
     Microsoft::WRL::ComPtr<ID3DBlob> ForwardPS;
 
-    ForwardVS = d3dUtil::CompileShader(L"..\\NeoEngine\\Shaders\\ForwardRendering.hlsl", nullptr, "VS", "vs_5_1");
-    ForwardPS = d3dUtil::CompileShader(L"..\\NeoEngine\\Shaders\\ForwardRendering.hlsl", nullptr, "PS", "ps_5_1");
+    D3D_SHADER_MACRO bindlessMacro[] =
+    {
+        "NEO_BINDLESS","1",
+        NULL,NULL
+    };
+    const D3D_SHADER_MACRO* pMacro = m_IsBindless ? bindlessMacro : nullptr;
+    ForwardVS = d3dUtil::CompileShader(L"..\\NeoEngine\\Shaders\\ForwardRendering.hlsl", pMacro, "VS", "vs_5_1");
+    ForwardPS = d3dUtil::CompileShader(L"..\\NeoEngine\\Shaders\\ForwardRendering.hlsl", pMacro, "PS", "ps_5_1");
     //
     DXGI_SAMPLE_DESC DefaultSampleDesc = Application::GetApp()->CheckMultipleSampleQulityLevels(m_pRenderTarget->GetRenderTargetFormats().RTFormats[0], Application::GetApp()->m_MultiSampleCount);
     //Create Default pipeline state.
@@ -111,132 +147,21 @@ void ForwardRendering::ExecutePass(
     std::function<void()> SetResourceFunc)
 {
     //Set shadow pass
+    //Shadow maps are left in split barriers,RecordModel() ends them when it binds shadow maps for the first model.
     m_pForwardShdaowPass->ExecutePass(commandList);
     //If setResourceFunc is empty,then use default resource func.
     if (!SetResourceFunc)
     {
         SetResourceFunc = [&]()
         {
-            for (const auto& pModel : m_pInputMoedels)
+            //frustum camera has been bound by PassBase::ExecutePass() now.
+            std::vector<std::vector<UINT8>> meshVisibilities;
+            m_pPassFrustumCullinger->GetModelsVisibility(m_pInputMoedels, meshVisibilities);
+            for (size_t i = 0; i < m_pInputMoedels.size(); ++i)
             {
-                if (pModel)
+                if (m_pInputMoedels[i])
                 {
-                    auto meshes = pModel->GetModelLoader()->Meshes();
-
-                    m_pPassFrustumCullinger->BindModelCulled(pModel);
-
-                    commandList->SetVertexBuffer(0, pModel->GetVertexBuffer());
-                    commandList->SetIndexBuffer(pModel->GetIndexBuffer());
-                    commandList->SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-                    commandList->SetGraphicsDynamicConstantBuffer(RenderingRootParameter::PassConstantCB, m_ForwardPassConstants);
-                    commandList->SetGraphicsStructuredBuffer(RenderingRootParameter::StructuredLight, m_pForwardShdaowPass->GetLightConstants());
-                    commandList->SetGraphicsStructuredBuffer(RenderingRootParameter::StructuredMaterials, pModel->GetMeshMaterials());
-                    for (int usage = 0; usage < TextureUsage::NumTextureUsage; ++usage)
-                    {
-                        UINT rootParameterIndex = 0;
-                        auto Usage = static_cast<TextureUsage>(usage);
-                        switch (Usage)
-                        {
-                        case Diffuse:
-                            rootParameterIndex = RenderingRootParameter::DiffuseTexture;
-                            break;
-                        case Specular:
-                            rootParameterIndex = RenderingRootParameter::SpecularTexture;
-                            break;
-                        case HeightMap:
-                            rootParameterIndex = RenderingRootParameter::HeightTexture;
-                            break;
-                        case NormalMap:
-                            rootParameterIndex = RenderingRootParameter::NormalTexture;
-                            break;
-                        case Ambient:
-                            rootParameterIndex = RenderingRootParameter::AmbientTexture;
-                            break;
-                        case Opacity:
-                            rootParameterIndex = RenderingRootParameter::OpacityTexture;
-                            break;
-                        case Emissive:
-                            rootParameterIndex = RenderingRootParameter::EmissiveTexture;
-                            break;
-                        default:
-                            assert(FALSE && "Error!Unexpected texture usage!");
-                            break;
-                        }
-                        //Bind textures into shaders.
-                        for (size_t i = 0; i < pModel->GetTextures(Usage).size(); ++i)
-                        {
-                            commandList->SetShaderResourceView(rootParameterIndex, i, pModel->GetTextures(Usage)[i].get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-                        }
-                        if (pModel->GetTextures(Usage).size() < m_MaxTextureNum)
-                        {
-                            commandList->GetDynamicDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->StageDescriptors(
-                                pModel->GetDefaultSrvDescriptors(Usage).GetDescriptorHandle(),
-                                rootParameterIndex,
-                                pModel->GetTextures(Usage).size(),
-                                m_MaxTextureNum - pModel->GetTextures(Usage).size());
-                        }
-                    }
-                    //Set directional and spot shadow textures
-                    auto DirectionalAndSpotShadow = m_pForwardShdaowPass->GetDirectionAndSpotShadows();
-                    for (int i = 0; i < DirectionalAndSpotShadow.size(); ++i)
-                    {
-                        auto Desc = DirectionalAndSpotShadow[i]->GetD3D12ResourceDesc();
-                        D3D12_SHADER_RESOURCE_VIEW_DESC SrvDesc = {};
-                        SrvDesc.Format = Desc.Format;
-                        SrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-                        SrvDesc.Texture2DArray.ArraySize = Desc.DepthOrArraySize;
-                        SrvDesc.Texture2DArray.FirstArraySlice = 0;
-                        SrvDesc.Texture2DArray.MipLevels = 1;
-                        SrvDesc.Texture2DArray.MostDetailedMip = 0;
-                        SrvDesc.Texture2DArray.PlaneSlice = 0;
-                        SrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
-
-                        commandList->SetShaderResourceView(
-                            RenderingRootParameter::DirectionAndSoptLightShadowTexture, i,
-                            DirectionalAndSpotShadow[i],
-                            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 0, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, &SrvDesc);
-                    }
-                    commandList->GetDynamicDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->StageDescriptors(
-                        m_pForwardShdaowPass->GetDirectionAndSpotDefaultSrvDescriptors().GetDescriptorHandle(),
-                        RenderingRootParameter::DirectionAndSoptLightShadowTexture,
-                        DirectionalAndSpotShadow.size(),
-                        m_MaxDirectionAndSpotLightShadowNum - DirectionalAndSpotShadow.size());
-                    ////Set point shadow textures
-                    auto PointShadows = m_pForwardShdaowPass->GetPointShadows();
-                    for (int i = 0; i < PointShadows.size(); ++i)
-                    {
-                        auto Desc = PointShadows[i]->GetD3D12ResourceDesc();
-                        //Point light shadow map is cube map.
-                        D3D12_SHADER_RESOURCE_VIEW_DESC SrvDesc = {};
-                        SrvDesc.Format = Desc.Format;
-                        SrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-                        SrvDesc.TextureCube.MipLevels = 1;
-                        SrvDesc.TextureCube.MostDetailedMip = 0;
-                        SrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
-
-                        commandList->SetShaderResourceView(
-                            RenderingRootParameter::PointLightShadowTexture, i,
-                            PointShadows[i],
-                            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 0, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, &SrvDesc);
-                    }
-                    commandList->GetDynamicDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->StageDescriptors(
-                        m_pForwardShdaowPass->GetPointDefaultSrvDescriptors().GetDescriptorHandle(),
-                        RenderingRootParameter::PointLightShadowTexture,
-                        PointShadows.size(),
-                        m_MaxPointLightShadowNum - PointShadows.size());
-                    //After binding resources,we can begin to draw
-                    for (size_t i = 0; i < meshes.size(); ++i)
-                    {
-                        //Check if this mesh is culled by frustum.
-                        if (meshes[i].m_IsCulled == false)
-                        {
-                            //Bind each mesh resources to shader
-                            auto meshconstantBuffer = pModel->GetMeshConstants();
-                            commandList->SetGraphicsDynamicConstantBuffer(RenderingRootParameter::MeshConstantCB, meshconstantBuffer[i]);
-                            commandList->DrawIndexed(meshes[i].mIndices.size(), 1, meshes[i].mIndexOffset, meshes[i].mVertexOffset, 0);
-                        }
-                    }
+                    RecordModel(commandList, m_pInputMoedels[i], meshVisibilities[i]);
                 }
             }
         };
@@ -264,6 +189,241 @@ void ForwardRendering::ExecutePass(
     }
 }
 
+std::shared_ptr<CommandList> ForwardRendering::ExecutePassParallel(std::shared_ptr<CommandList> commandList, UINT NumCommandLists)
+{
+    assert(m_pRenderTarget && m_pRootSignature && "Error!This pass has not been set render target or root signature!");
+    auto commandQueue = Application::GetApp()->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
+    //The sequence of command lists is:clear -> shadows -> models,it is same as ExecutePass().
+    std::vector<std::shared_ptr<CommandList>> commandLists = { commandList };
+    m_pForwardShdaowPass->ExecutePassParallel(commandLists);
+
+    m_pPassFrustumCullinger->BindFrustumCamera(m_pRenderingCamera);
+    commandList->ClearRenderTarget(m_pRenderTarget.get());
+    //Models are culled one per job,so a large model does not make a range of recording much longer than others.
+    std::vector<std::vector<UINT8>> meshVisibilities;
+    m_pPassFrustumCullinger->GetModelsVisibility(m_pInputMoedels, meshVisibilities);
+
+    size_t numModels = m_pInputMoedels.size();
+    size_t numRanges = std::max<size_t>(1, std::min<size_t>(NumCommandLists, numModels));
+    size_t modelsPerRange = (numModels + numRanges - 1) / numRanges;
+    //Each range writes its own slot,so the order does not depend on which job finishes first.
+    std::vector<std::shared_ptr<CommandList>> modelCommandLists(numRanges);
+    Application::GetApp()->GetJobSystem()->ParallelFor(numModels, modelsPerRange, [&](size_t Begin, size_t End)
+    {
+        auto modelCommandList = commandQueue->GetCommandList();
+        SetPassState(modelCommandList);
+
+        for (size_t i = Begin; i < End; ++i)
+        {
+            if (m_pInputMoedels[i])
+            {
+                RecordModel(modelCommandList, m_pInputMoedels[i], meshVisibilities[i]);
+            }
+        }
+        modelCommandLists[Begin / modelsPerRange] = modelCommandList;
+    });
+    for (const auto& modelCommandList : modelCommandLists)
+    {
+        if (modelCommandList)
+        {
+            commandLists.push_back(modelCommandList);
+        }
+    }
+    //Resource states of all command lists are resolved in this order when they are executed.
+    commandQueue->ExecuteCommandLists(commandLists);
+
+    auto nextCommandList = commandQueue->GetCommandList();
+    SetPassState(nextCommandList);
+    return nextCommandList;
+}
+
+void ForwardRendering::SetBindlessResources(std::shared_ptr<CommandList> commandList, const Model* pModel)
+{
+    ForwardRenderingBindlessConstants bindlessConstants;
+    //Indices of model textures are created with textures,so there is no descriptor copy here.
+    std::vector<UINT> textureIndices;
+    for (int usage = 0; usage < TextureUsage::NumTextureUsage; ++usage)
+    {
+        bindlessConstants.TextureIndexOffsets[usage] = static_cast<UINT>(textureIndices.size());
+        for (const auto& pTexture : pModel->GetTextures(static_cast<TextureUsage>(usage)))
+        {
+            commandList->BarrierTransition(pTexture.get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+            textureIndices.push_back(pTexture->GetBindlessIndex());
+        }
+    }
+    bindlessConstants.TextureIndexOffsets[TextureUsage::NumTextureUsage] = static_cast<UINT>(textureIndices.size());
+    //a structured buffer can not be empty.
+    if (textureIndices.empty())
+    {
+        textureIndices.push_back(0);
+    }
+    //Set directional and spot shadow indices
+    auto DirectionalAndSpotShadow = m_pForwardShdaowPass->GetDirectionAndSpotShadows();
+    for (int i = 0; i < m_MaxDirectionAndSpotLightShadowNum; ++i)
+    {
+        bindlessConstants.DirectionAndSpotShadowIndices[i] = UINT_MAX;
+        if (i < DirectionalAndSpotShadow.size())
+        {
+            auto Desc = DirectionalAndSpotShadow[i]->GetD3D12ResourceDesc();
+            D3D12_SHADER_RESOURCE_VIEW_DESC SrvDesc = {};
+            SrvDesc.Format = Desc.Format;
+            SrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            SrvDesc.Texture2DArray.ArraySize = Desc.DepthOrArraySize;
+            SrvDesc.Texture2DArray.FirstArraySlice = 0;
+            SrvDesc.Texture2DArray.MipLevels = 1;
+            SrvDesc.Texture2DArray.MostDetailedMip = 0;
+            SrvDesc.Texture2DArray.PlaneSlice = 0;
+            SrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+
+            commandList->BarrierTransition(DirectionalAndSpotShadow[i], D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+            bindlessConstants.DirectionAndSpotShadowIndices[i] = DirectionalAndSpotShadow[i]->GetBindlessIndex(&SrvDesc);
+        }
+    }
+    //Set point shadow indices
+    auto PointShadows = m_pForwardShdaowPass->GetPointShadows();
+    for (int i = 0; i < m_MaxPointLightShadowNum; ++i)
+    {
+        bindlessConstants.PointShadowIndices[i] = UINT_MAX;
+        if (i < PointShadows.size())
+        {
+            auto Desc = PointShadows[i]->GetD3D12ResourceDesc();
+            //Point light shadow map is cube map.
+            D3D12_SHADER_RESOURCE_VIEW_DESC SrvDesc = {};
+            SrvDesc.Format = Desc.Format;
+            SrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            SrvDesc.TextureCube.MipLevels = 1;
+            SrvDesc.TextureCube.MostDetailedMip = 0;
+            SrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+
+            commandList->BarrierTransition(PointShadows[i], D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+            bindlessConstants.PointShadowIndices[i] = PointShadows[i]->GetBindlessIndex(&SrvDesc);
+        }
+    }
+
+    commandList->SetGraphicsStructuredBuffer(BindlessRenderingRootParameter::StructuredTextureIndices, textureIndices);
+    commandList->SetGraphics32BitConstants(BindlessRenderingRootParameter::BindlessConstants, 0, bindlessConstants);
+}
+
+void ForwardRendering::RecordModel(std::shared_ptr<CommandList> commandList, const Model* pModel, const std::vector<UINT8>& MeshVisibility)
+{
+    const auto& meshes = pModel->GetModelLoader()->Meshes();
+
+    commandList->SetVertexBuffer(0, pModel->GetVertexBuffer());
+    commandList->SetIndexBuffer(pModel->GetIndexBuffer());
+    commandList->SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    commandList->SetGraphicsDynamicConstantBuffer(RenderingRootParameter::PassConstantCB, m_ForwardPassConstants);
+    commandList->SetGraphicsStructuredBuffer(RenderingRootParameter::StructuredLight, m_pForwardShdaowPass->GetLightConstants());
+    commandList->SetGraphicsStructuredBuffer(RenderingRootParameter::StructuredMaterials, pModel->GetMeshMaterials());
+    if (m_IsBindless)
+    {
+        SetBindlessResources(commandList, pModel);
+    }
+    else
+    {
+        for (int usage = 0; usage < TextureUsage::NumTextureUsage; ++usage)
+        {
+            UINT rootParameterIndex = 0;
+            auto Usage = static_cast<TextureUsage>(usage);
+            switch (Usage)
+            {
+            case Diffuse:
+                rootParameterIndex = RenderingRootParameter::DiffuseTexture;
+                break;
+            case Specular:
+                rootParameterIndex = RenderingRootParameter::SpecularTexture;
+                break;
+            case HeightMap:
+                rootParameterIndex = RenderingRootParameter::HeightTexture;
+                break;
+            case NormalMap:
+                rootParameterIndex = RenderingRootParameter::NormalTexture;
+                break;
+            case Ambient:
+                rootParameterIndex = RenderingRootParameter::AmbientTexture;
+                break;
+            case Opacity:
+                rootParameterIndex = RenderingRootParameter::OpacityTexture;
+                break;
+            case Emissive:
+                rootParameterIndex = RenderingRootParameter::EmissiveTexture;
+                break;
+            default:
+                assert(FALSE && "Error!Unexpected texture usage!");
+                break;
+            }
+            //Bind textures into shaders.
+            for (size_t i = 0; i < pModel->GetTextures(Usage).size(); ++i)
+            {
+                commandList->SetShaderResourceView(rootParameterIndex, i, pModel->GetTextures(Usage)[i].get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+            }
+            //only slots which are used by last model are filled with null descriptors again.
+            commandList->GetDynamicDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->StageNullDescriptors(
+                Application::GetApp()->GetNullDescriptors(NullDescriptorType::Texture2D),
+                rootParameterIndex,
+                static_cast<UINT>(pModel->GetTextures(Usage).size()));
+        }
+        //Set directional and spot shadow textures
+        auto DirectionalAndSpotShadow = m_pForwardShdaowPass->GetDirectionAndSpotShadows();
+        for (int i = 0; i < DirectionalAndSpotShadow.size(); ++i)
+        {
+            auto Desc = DirectionalAndSpotShadow[i]->GetD3D12ResourceDesc();
+            D3D12_SHADER_RESOURCE_VIEW_DESC SrvDesc = {};
+            SrvDesc.Format = Desc.Format;
+            SrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            SrvDesc.Texture2DArray.ArraySize = Desc.DepthOrArraySize;
+            SrvDesc.Texture2DArray.FirstArraySlice = 0;
+            SrvDesc.Texture2DArray.MipLevels = 1;
+            SrvDesc.Texture2DArray.MostDetailedMip = 0;
+            SrvDesc.Texture2DArray.PlaneSlice = 0;
+            SrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+
+            commandList->SetShaderResourceView(
+                RenderingRootParameter::DirectionAndSoptLightShadowTexture, i,
+                DirectionalAndSpotShadow[i],
+                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 0, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, &SrvDesc);
+        }
+        commandList->GetDynamicDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->StageNullDescriptors(
+            Application::GetApp()->GetNullDescriptors(NullDescriptorType::Texture2DArray),
+            RenderingRootParameter::DirectionAndSoptLightShadowTexture,
+            static_cast<UINT>(DirectionalAndSpotShadow.size()));
+        ////Set point shadow textures
+        auto PointShadows = m_pForwardShdaowPass->GetPointShadows();
+        for (int i = 0; i < PointShadows.size(); ++i)
+        {
+            auto Desc = PointShadows[i]->GetD3D12ResourceDesc();
+            //Point light shadow map is cube map.
+            D3D12_SHADER_RESOURCE_VIEW_DESC SrvDesc = {};
+            SrvDesc.Format = Desc.Format;
+            SrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            SrvDesc.TextureCube.MipLevels = 1;
+            SrvDesc.TextureCube.MostDetailedMip = 0;
+            SrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+
+            commandList->SetShaderResourceView(
+                RenderingRootParameter::PointLightShadowTexture, i,
+                PointShadows[i],
+                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 0, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, &SrvDesc);
+        }
+        commandList->GetDynamicDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->StageNullDescriptors(
+            Application::GetApp()->GetNullDescriptors(NullDescriptorType::TextureCube),
+            RenderingRootParameter::PointLightShadowTexture,
+            static_cast<UINT>(PointShadows.size()));
+    }
+    //After binding resources,we can begin to draw
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        //Check if this mesh is culled by frustum.
+        if (MeshVisibility[i])
+        {
+            //Bind each mesh resources to shader
+            const auto& meshconstantBuffer = pModel->GetMeshConstants();
+            commandList->SetGraphicsDynamicConstantBuffer(RenderingRootParameter::MeshConstantCB, meshconstantBuffer[i]);
+            commandList->DrawIndexed(meshes[i].mIndices.size(), 1, meshes[i].mIndexOffset, meshes[i].mVertexOffset, 0);
+        }
+    }
+}
+
 void ForwardRendering::UpdatePass(const UpdateEventArgs& Args, std::function<void()> UpdateFunc /* = */)
 {
     auto width = m_pRenderTarget->GetTexture(AttachmentPoint::Color0).GetD3D12ResourceDesc().Width;
@@ -2,6 +2,10 @@
 #include "d3dUtil.h"
 #include "Application.h"
 #include "ResourceStateTracker.h"
+#include "ResourceHeapAllocator.h"
+#include "DeferredDeletionQueue.h"
+#include "BindlessDescriptorHeap.h"
+#include "ViewCache.h"
 
 Resource::Resource(const std::wstring& name)
     :m_ResourceName(name)
@@ -9,7 +13,10 @@ Resource::Resource(const std::wstring& name)
     , m_d3d12ClearValue(nullptr)
 {};
 
-Resource::~Resource() {};
+Resource::~Resource()
+{
+    RetireD3D12Resource();
+}
 
 Resource::Resource(const D3D12_RESOURCE_DESC& ResourceDesc, const std::wstring& ResourceName, const D3D12_CLEAR_VALUE* ClearValue)
     :m_ResourceName(ResourceName)
@@ -27,22 +34,18 @@ Resource::Resource(const D3D12_RESOURCE_DESC& ResourceDesc, const std::wstring&
         m_d3d12ClearValue = std::make_unique<D3D12_CLEAR_VALUE>(*ClearValue);
     }
 
-    auto device = Application::GetApp()->GetDevice();
-
-    ThrowIfFailed(device->CreateCommittedResource(
-        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-        D3D12_HEAP_FLAG_NONE,
-        &resDesc,
+    m_d3d12Resource = Application::GetApp()->GetResourceHeapAllocator()->CreateResource(
+        resDesc,
         D3D12_RESOURCE_STATE_COMMON,
-        m_d3d12ClearValue.get(),
-        IID_PPV_ARGS(&m_d3d12Resource)));
+        m_d3d12ClearValue.get());
 
     //Add resource inilization state to resource barrier tracker.
-    ResourceStateTracker::AddGlobalResourceState(m_d3d12Resource.Get(), D3D12_RESOURCE_STATE_COMMON);
+    m_pGlobalState = ResourceStateTracker::AddGlobalResourceState(m_d3d12Resource.Get(), D3D12_RESOURCE_STATE_COMMON);
 }
 
 Resource::Resource(Microsoft::WRL::ComPtr<ID3D12Resource> pResource, const std::wstring& ResourceName, const D3D12_CLEAR_VALUE* ClearValue /* = nullptr */)
     :m_d3d12Resource(pResource)
+    , m_pGlobalState(ResourceStateTracker::FindGlobalResourceState(pResource.Get()))
 {
     if (ClearValue)
     {
@@ -54,6 +57,7 @@ Resource::Resource(Microsoft::WRL::ComPtr<ID3D12Resource> pResource, const std::
 Resource::Resource(const Resource& copy)
     : m_d3d12Resource(copy.m_d3d12Resource)
     , m_ResourceName(copy.m_ResourceName)
+    , m_pGlobalState(copy.m_pGlobalState)
 {
     m_d3d12ClearValue = nullptr;
     if (copy.m_d3d12ClearValue)
@@ -72,8 +76,10 @@ Resource& Resource::operator=(const Resource& assign)
             m_d3d12ClearValue = std::make_unique<D3D12_CLEAR_VALUE>(*assign.m_d3d12ClearValue);
         }
 
+        RetireD3D12Resource();
         m_d3d12Resource = assign.m_d3d12Resource;
         m_ResourceName = assign.m_ResourceName;
+        m_pGlobalState = assign.m_pGlobalState;
     }
 
     return *this;
@@ -83,6 +89,7 @@ Resource::Resource(Resource&& move)
     :m_d3d12Resource(std::move(move.m_d3d12Resource))
     , m_ResourceName(std::move(move.m_ResourceName))
     , m_d3d12ClearValue(std::move(move.m_d3d12ClearValue))
+    , m_pGlobalState(std::move(move.m_pGlobalState))
 {
     move.m_d3d12Resource = nullptr;
     move.m_d3d12ClearValue = nullptr;
@@ -93,9 +100,11 @@ Resource& Resource::operator=(Resource&& move)
 {
     if (this != &move)
     {
+        RetireD3D12Resource();
         m_d3d12Resource = std::move(move.m_d3d12Resource);
         m_ResourceName = std::move(move.m_ResourceName);
         m_d3d12ClearValue = std::move(move.m_d3d12ClearValue);
+        m_pGlobalState = std::move(move.m_pGlobalState);
 
         move.m_d3d12Resource = nullptr;
         move.m_d3d12ClearValue = nullptr;
@@ -127,6 +136,11 @@ void Resource::SetD3D12Resource(Microsoft::WRL::ComPtr<ID3D12Resource>& d3d12Res
 {
     assert(d3d12Resource.Get() != nullptr && "Invalid Resource");
 
+    if (m_d3d12Resource != d3d12Resource)
+    {
+        RetireD3D12Resource();
+        m_pGlobalState = ResourceStateTracker::FindGlobalResourceState(d3d12Resource.Get());
+    }
     m_d3d12Resource = d3d12Resource;
     m_d3d12ClearValue = nullptr;
     if (ClearValue)
@@ -137,7 +151,7 @@ void Resource::SetD3D12Resource(Microsoft::WRL::ComPtr<ID3D12Resource>& d3d12Res
 
 void Resource::Reset()
 {
-    m_d3d12Resource.Reset();
+    RetireD3D12Resource();
     m_d3d12ClearValue.reset();
     m_ResourceName = L"NoName";
 
@@ -148,4 +162,28 @@ void Resource::Reset()
 void Resource::SetName(const std::wstring& ResourceName)
 {
     m_ResourceName = ResourceName;
-}
\ No newline at end of file
+}
+
+UINT Resource::GetBindlessIndex(const D3D12_SHADER_RESOURCE_VIEW_DESC* SrvDesc /* = nullptr */)const
+{
+    assert(m_d3d12Resource && "Resource has been released!");
+    auto pBindlessHeap = Application::GetApp()->GetBindlessDescriptorHeap();
+    assert(pBindlessHeap && "Error!Bindless mode is off!");
+
+    auto handle = Application::GetApp()->GetViewCache()->GetBindlessShaderResourceView(m_d3d12Resource.Get(), SrvDesc);
+    return pBindlessHeap->GetIndex(handle);
+}
+
+void Resource::RetireD3D12Resource()
+{
+    if (m_d3d12Resource)
+    {
+        auto pDeferredDeletionQueue = Application::GetApp()->GetDeferredDeletionQueue();
+        if (pDeferredDeletionQueue)
+        {
+            pDeferredDeletionQueue->Retire(std::move(m_d3d12Resource));
+        }
+        m_d3d12Resource = nullptr;
+    }
+    m_pGlobalState = nullptr;
+}
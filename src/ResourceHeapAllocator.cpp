@@ -0,0 +1,226 @@
+#include "ResourceHeapAllocator.h"
+#include "Application.h"
+
+#include <atomic>
+#include <cassert>
+
+namespace
+{
+    //private data of a placed resource which holds its range
+    // {6F1C2A7E-3B9D-4C51-9A2E-715D0C84F316}
+    const GUID gs_PlacedRangeGuid = { 0x6f1c2a7e, 0x3b9d, 0x4c51, { 0x9a, 0x2e, 0x71, 0x5d, 0x0c, 0x84, 0xf3, 0x16 } };
+}
+
+struct ResourceHeapAllocator::Heap
+{
+    explicit Heap(UINT64 Size)
+        : m_Allocator(Size, D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+    {}
+
+    Microsoft::WRL::ComPtr<ID3D12Heap> m_d3d12Heap;
+    TLSFAllocator m_Allocator;
+    std::mutex m_Mutex;
+};
+
+//It is attached to a placed resource by SetPrivateDataInterface(),
+//so it is destroyed with the resource and gives the range back to its heap.
+class ResourceHeapAllocator::PlacedRange : public IUnknown
+{
+public:
+    PlacedRange(std::shared_ptr<Heap> pHeap, UINT64 Offset)
+        : m_pHeap(std::move(pHeap))
+        , m_Offset(Offset)
+    {}
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+    {
+        if (!ppvObject)
+        {
+            return E_POINTER;
+        }
+        if (riid == __uuidof(IUnknown))
+        {
+            *ppvObject = static_cast<IUnknown*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppvObject = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return m_RefCount.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        ULONG count = m_RefCount.fetch_sub(1, std::memory_order_acq_rel) - 1;
+        if (count == 0)
+        {
+            delete this;
+        }
+        return count;
+    }
+private:
+    ~PlacedRange()
+    {
+        std::lock_guard<std::mutex> lock(m_pHeap->m_Mutex);
+        m_pHeap->m_Allocator.Free(m_Offset);
+    }
+
+    std::atomic<ULONG> m_RefCount{ 1 };
+    std::shared_ptr<Heap> m_pHeap;
+    UINT64 m_Offset;
+};
+
+ResourceHeapAllocator::ResourceHeapAllocator(UINT64 HeapSize)
+    : m_HeapSize(HeapSize)
+    , m_NumCommittedResources(0)
+{
+    assert(HeapSize % D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT == 0 && "Error!Heap size must be a multiple of 64KB!");
+}
+
+ResourceHeapAllocator::~ResourceHeapAllocator()
+{}
+
+Microsoft::WRL::ComPtr<ID3D12Resource> ResourceHeapAllocator::CreateResource(
+    const D3D12_RESOURCE_DESC& Desc,
+    D3D12_RESOURCE_STATES InitialState,
+    const D3D12_CLEAR_VALUE* pClearValue /* = nullptr */)
+{
+    auto device = Application::GetApp()->GetDevice();
+    Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+
+    D3D12_RESOURCE_DESC desc = Desc;
+    ResourceHeapTier tier = GetTier(desc);
+    D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = {};
+    //small textures can be placed at 4KB alignment,if the device agrees.
+    if (tier == ResourceHeapTier::NonRenderTargetTexture && desc.SampleDesc.Count == 1 && desc.Alignment == 0)
+    {
+        desc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+        allocationInfo = device->GetResourceAllocationInfo(0, 1, &desc);
+        if (allocationInfo.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+        {
+            desc.Alignment = 0;
+            allocationInfo = device->GetResourceAllocationInfo(0, 1, &desc);
+        }
+    }
+    else if (tier != ResourceHeapTier::NumTiers)
+    {
+        allocationInfo = device->GetResourceAllocationInfo(0, 1, &desc);
+    }
+
+    if (tier != ResourceHeapTier::NumTiers &&
+        allocationInfo.SizeInBytes != UINT64_MAX &&
+        allocationInfo.SizeInBytes <= m_HeapSize / 2 &&
+        allocationInfo.Alignment <= D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
+    {
+        UINT64 offset;
+        auto pHeap = AllocateRange(tier, allocationInfo.SizeInBytes, allocationInfo.Alignment, offset);
+        //range is freed when the last reference of it is released,even if creating resource fails.
+        auto pRange = new PlacedRange(pHeap, offset);
+        HRESULT hr = device->CreatePlacedResource(
+            pHeap->m_d3d12Heap.Get(),
+            offset,
+            &desc,
+            InitialState,
+            pClearValue,
+            IID_PPV_ARGS(&resource));
+        if (SUCCEEDED(hr))
+        {
+            hr = resource->SetPrivateDataInterface(gs_PlacedRangeGuid, pRange);
+        }
+        pRange->Release();
+        ThrowIfFailed(hr);
+        return resource;
+    }
+
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+    ThrowIfFailed(device->CreateCommittedResource(
+        &heapProperties,
+        D3D12_HEAP_FLAG_NONE,
+        &Desc,
+        InitialState,
+        pClearValue,
+        IID_PPV_ARGS(&resource)));
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        ++m_NumCommittedResources;
+    }
+    return resource;
+}
+
+ResourceHeapStatistics ResourceHeapAllocator::GetStatistics()const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    ResourceHeapStatistics statistics;
+    for (int i = 0; i < static_cast<int>(ResourceHeapTier::NumTiers); ++i)
+    {
+        auto& tierStatistics = statistics.Tiers[i];
+        statistics.NumHeaps[i] = static_cast<UINT>(m_Heaps[i].size());
+        for (const auto& pHeap : m_Heaps[i])
+        {
+            std::lock_guard<std::mutex> heapLock(pHeap->m_Mutex);
+            auto heapStatistics = pHeap->m_Allocator.GetStatistics();
+            tierStatistics.TotalSize += heapStatistics.TotalSize;
+            tierStatistics.UsedSize += heapStatistics.UsedSize;
+            tierStatistics.FreeSize += heapStatistics.FreeSize;
+            tierStatistics.NumAllocations += heapStatistics.NumAllocations;
+            tierStatistics.NumFreeBlocks += heapStatistics.NumFreeBlocks;
+            tierStatistics.LargestFreeBlock = (std::max)(tierStatistics.LargestFreeBlock, heapStatistics.LargestFreeBlock);
+        }
+    }
+    statistics.NumCommittedResources = m_NumCommittedResources;
+    return statistics;
+}
+
+ResourceHeapTier ResourceHeapAllocator::GetTier(const D3D12_RESOURCE_DESC& Desc)
+{
+    if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        return ResourceHeapTier::Buffer;
+    }
+    //render targets and depth stencils are not placed,see ResourceHeapAllocator.h.
+    if ((Desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0)
+    {
+        return ResourceHeapTier::NumTiers;
+    }
+    return ResourceHeapTier::NonRenderTargetTexture;
+}
+
+std::shared_ptr<ResourceHeapAllocator::Heap> ResourceHeapAllocator::AllocateRange(ResourceHeapTier Tier, UINT64 Size, UINT64 Alignment, UINT64& Offset)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto& heaps = m_Heaps[static_cast<int>(Tier)];
+    for (const auto& pHeap : heaps)
+    {
+        std::lock_guard<std::mutex> heapLock(pHeap->m_Mutex);
+        Offset = pHeap->m_Allocator.Allocate(Size, Alignment);
+        if (Offset != TLSFAllocator::InvalidOffset)
+        {
+            return pHeap;
+        }
+    }
+
+    //no heap has enough room
+    static const D3D12_HEAP_FLAGS tierFlags[] =
+    {
+        D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+        D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES
+    };
+    auto pHeap = std::make_shared<Heap>(m_HeapSize);
+    CD3DX12_HEAP_DESC heapDesc(
+        m_HeapSize,
+        D3D12_HEAP_TYPE_DEFAULT,
+        D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+        tierFlags[static_cast<int>(Tier)]);
+    ThrowIfFailed(Application::GetApp()->GetDevice()->CreateHeap(&heapDesc, IID_PPV_ARGS(&pHeap->m_d3d12Heap)));
+    heaps.push_back(pHeap);
+
+    Offset = pHeap->m_Allocator.Allocate(Size, Alignment);
+    assert(Offset != TLSFAllocator::InvalidOffset && "Error!A new heap can not hold the resource!");
+    return pHeap;
+}
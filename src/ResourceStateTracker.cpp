@@ -1,66 +1,418 @@
 #include "ResourceStateTracker.h"
 #include <assert.h>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
 #include "Resource.h"
 #include "CommandList.h"
+#include "d3dUtil.h"
 
-std::unordered_map<ID3D12Resource*, ResourceStateTracker::ResourceState> ResourceStateTracker::m_GlobalResourceState;
-bool ResourceStateTracker::m_IsLock = false;
-std::mutex ResourceStateTracker::ms_GlobalMutex;
+std::atomic<uint64_t> ResourceStateTracker::ms_NumGlobalStates(0);
+std::atomic<uint64_t> ResourceStateTracker::ms_NumLookups(0);
+std::atomic<uint64_t> ResourceStateTracker::ms_NumStateLocks(0);
+std::atomic<uint64_t> ResourceStateTracker::ms_NumContendedStateLocks(0);
+std::atomic<uint64_t> ResourceStateTracker::ms_NumSplitStates(0);
+std::atomic<uint64_t> ResourceStateTracker::ms_NumHeapSplitStates(0);
+std::atomic<uint64_t> ResourceStateTracker::ms_NumRequestedBarriers(0);
+std::atomic<uint64_t> ResourceStateTracker::ms_NumIssuedBarriers(0);
+std::atomic<uint64_t> ResourceStateTracker::ms_NumMergedBarriers(0);
+std::atomic<uint64_t> ResourceStateTracker::ms_NumCombinedReadBarriers(0);
+std::atomic<uint64_t> ResourceStateTracker::ms_NumPromotedBarriers(0);
+std::atomic<uint64_t> ResourceStateTracker::ms_NumSplitBarriers(0);
+std::mutex ResourceStateTracker::ms_FrameStatisticsMutex;
+BarrierStatistics ResourceStateTracker::ms_FrameStatistics;
+std::atomic<bool> ResourceStateTracker::ms_IsValidation(false);
 
-ResourceStateTracker::ResourceStateTracker()
+struct GlobalResourceState
+{
+    std::unique_lock<std::mutex> Lock()
+    {
+        ResourceStateTracker::ms_NumStateLocks.fetch_add(1, std::memory_order_relaxed);
+        std::unique_lock<std::mutex> lock(Mutex, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            ResourceStateTracker::ms_NumContendedStateLocks.fetch_add(1, std::memory_order_relaxed);
+            lock.lock();
+        }
+        return lock;
+    }
+
+    std::mutex Mutex;
+    ResourceStateTracker::ResourceState State;
+    //the last fence of copy or compute queue which used this resource,pFence is null if there is no one.
+    ResourceStateTracker::QueueFence Fence = {};
+    //buffers and simultaneous-access textures,it is set when the state is added.
+    std::atomic<bool> DecaysToCommon{ false };
+};
+
+namespace
+{
+    //Global states are found by ID3D12Resource in shards,so adding and finding them do not serialize all threads.
+    const size_t gs_NumStateShards = 64;
+
+    struct GlobalStateShard
+    {
+        std::mutex Mutex;
+        std::unordered_map<ID3D12Resource*, std::shared_ptr<GlobalResourceState>> States;
+    };
+
+    GlobalStateShard gs_GlobalStateShards[gs_NumStateShards];
+
+    GlobalStateShard& GetGlobalStateShard(ID3D12Resource* pResource)
+    {
+        return gs_GlobalStateShards[std::hash<ID3D12Resource*>{}(pResource) % gs_NumStateShards];
+    }
+
+    //states which can be used on copy queue
+    bool IsCopyQueueState(D3D12_RESOURCE_STATES State)
+    {
+        return State == D3D12_RESOURCE_STATE_COMMON
+            || State == D3D12_RESOURCE_STATE_COPY_DEST
+            || State == D3D12_RESOURCE_STATE_COPY_SOURCE;
+    }
+
+    //states which only read the resource,any of them can be combined into one state.
+    const D3D12_RESOURCE_STATES gs_ReadStates = D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER
+        | D3D12_RESOURCE_STATE_INDEX_BUFFER
+        | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE
+        | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
+        | D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT
+        | D3D12_RESOURCE_STATE_COPY_SOURCE
+        | D3D12_RESOURCE_STATE_DEPTH_READ
+        | D3D12_RESOURCE_STATE_RESOLVE_SOURCE;
+
+    bool IsReadState(D3D12_RESOURCE_STATES State)
+    {
+        return State != D3D12_RESOURCE_STATE_COMMON && (State & ~gs_ReadStates) == 0;
+    }
+
+    //Buffers and simultaneous-access textures are promoted from COMMON to any state,and decay to COMMON on any queue.
+    bool CanDecayToCommon(ID3D12Resource* pResource)
+    {
+        auto desc = pResource->GetDesc();
+        return desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER
+            || (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS) != 0;
+    }
+
+    const char* GetCommandListTypeName(D3D12_COMMAND_LIST_TYPE Type)
+    {
+        switch (Type)
+        {
+        case D3D12_COMMAND_LIST_TYPE_DIRECT:
+            return "direct";
+        case D3D12_COMMAND_LIST_TYPE_COMPUTE:
+            return "compute";
+        case D3D12_COMMAND_LIST_TYPE_COPY:
+            return "copy";
+        default:
+            return "unknown";
+        }
+    }
+
+    UINT GetNumSubResources(ID3D12Resource* pResource)
+    {
+        CD3DX12_RESOURCE_DESC desc(pResource->GetDesc());
+        if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        {
+            return 1;
+        }
+        //the device which creates the resource,so resources of a replayed barrier trace work too.
+        Microsoft::WRL::ComPtr<ID3D12Device> device;
+        ThrowIfFailed(pResource->GetDevice(IID_PPV_ARGS(&device)));
+        return desc.Subresources(device.Get());
+    }
+
+    BarrierTraceEventType GetTraceEventType(const D3D12_RESOURCE_BARRIER& barrier)
+    {
+        switch (barrier.Type)
+        {
+        case D3D12_RESOURCE_BARRIER_TYPE_UAV:
+            return BarrierTraceEventType::UavBarrier;
+        case D3D12_RESOURCE_BARRIER_TYPE_ALIASING:
+            return BarrierTraceEventType::AliasBarrier;
+        default:
+            return BarrierTraceEventType::Transition;
+        }
+    }
+}
+
+void ResourceStateTracker::ResourceState::SetResourceState(UINT subResource, D3D12_RESOURCE_STATES state, ID3D12Resource* pResource)
+{
+    if (subResource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+    {
+        MakeUniform(state);
+        return;
+    }
+    if (IsUniform())
+    {
+        if (state == State)
+        {
+            return;
+        }
+        UINT numSubResources = GetNumSubResources(pResource);
+        if (numSubResources <= 1)
+        {
+            State = state;
+            return;
+        }
+        Split(numSubResources);
+    }
+    assert(subResource < NumSubResources && "Error!Subresource is out of range!");
+    GetStates()[subResource] = state;
+    TryMakeUniform();
+}
+
+void ResourceStateTracker::ResourceState::Merge(const ResourceState& other)
+{
+    if (other.IsUniform())
+    {
+        if (other.State != UnknownState)
+        {
+            MakeUniform(other.State);
+        }
+        return;
+    }
+    if (IsUniform())
+    {
+        Split(other.NumSubResources);
+    }
+    assert(NumSubResources == other.NumSubResources && "Error!Subresource states of a resource have different sizes!");
+    auto pStates = GetStates();
+    auto pOtherStates = other.GetStates();
+    for (UINT subResource = 0; subResource < NumSubResources; ++subResource)
+    {
+        if (pOtherStates[subResource] != UnknownState)
+        {
+            pStates[subResource] = pOtherStates[subResource];
+        }
+    }
+    TryMakeUniform();
+}
+
+void ResourceStateTracker::ResourceState::Split(UINT numSubResources)
+{
+    assert(IsUniform() && "Error!Subresource states are split already!");
+    NumSubResources = numSubResources;
+    if (numSubResources > MaxInlineSubResources)
+    {
+        pHeapStates = new D3D12_RESOURCE_STATES[numSubResources];
+        std::fill(pHeapStates, pHeapStates + numSubResources, State);
+        ms_NumHeapSplitStates.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        std::fill(InlineStates, InlineStates + numSubResources, State);
+    }
+    ms_NumSplitStates.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ResourceStateTracker::ResourceState::TryMakeUniform()
+{
+    if (IsUniform())
+    {
+        return;
+    }
+    auto pStates = GetStates();
+    for (UINT subResource = 1; subResource < NumSubResources; ++subResource)
+    {
+        if (pStates[subResource] != pStates[0])
+        {
+            return;
+        }
+    }
+    MakeUniform(pStates[0]);
+}
+
+void ResourceStateTracker::ResourceState::MakeUniform(D3D12_RESOURCE_STATES state)
+{
+    if (NumSubResources > MaxInlineSubResources)
+    {
+        delete[] pHeapStates;
+    }
+    State = state;
+    NumSubResources = 0;
+    pHeapStates = nullptr;
+}
+
+ResourceStateTracker::ResourceState::ResourceState(const ResourceState& other)
+    : State(other.State), NumSubResources(0), pHeapStates(nullptr)
+{
+    *this = other;
+}
+
+ResourceStateTracker::ResourceState& ResourceStateTracker::ResourceState::operator=(const ResourceState& other)
+{
+    if (this != &other)
+    {
+        MakeUniform(other.State);
+        NumSubResources = other.NumSubResources;
+        if (NumSubResources > MaxInlineSubResources)
+        {
+            pHeapStates = new D3D12_RESOURCE_STATES[NumSubResources];
+        }
+        std::copy(other.GetStates(), other.GetStates() + NumSubResources, GetStates());
+    }
+    return *this;
+}
+
+ResourceStateTracker::ResourceState::ResourceState(ResourceState&& other) noexcept
+    : State(other.State), NumSubResources(0), pHeapStates(nullptr)
+{
+    *this = std::move(other);
+}
+
+ResourceStateTracker::ResourceState& ResourceStateTracker::ResourceState::operator=(ResourceState&& other) noexcept
+{
+    if (this != &other)
+    {
+        MakeUniform(other.State);
+        NumSubResources = other.NumSubResources;
+        if (NumSubResources > MaxInlineSubResources)
+        {
+            //heap states are taken over.
+            pHeapStates = other.pHeapStates;
+        }
+        else
+        {
+            std::copy(other.InlineStates, other.InlineStates + NumSubResources, InlineStates);
+        }
+        other.NumSubResources = 0;
+        other.pHeapStates = nullptr;
+    }
+    return *this;
+}
+
+ResourceStateTracker::ResourceStateTracker(D3D12_COMMAND_LIST_TYPE Type)
+    :m_CommandListType(Type)
 {};
 
 ResourceStateTracker::~ResourceStateTracker() {};
 
 void ResourceStateTracker::ResourceBarrier(const D3D12_RESOURCE_BARRIER& barrier)
 {
+    ResourceBarrier(barrier, nullptr, nullptr);
+}
+
+void ResourceStateTracker::ResourceBarrier(const D3D12_RESOURCE_BARRIER& barrier, const std::shared_ptr<GlobalResourceState>& pGlobalState, const void* pCallSite)
+{
+    RecordTraceEvent(GetTraceEventType(barrier), &barrier, pCallSite);
+    ++m_BarrierStatistics.NumRequestedBarriers;
+    //Split barriers of a resource must be ended before any other barrier of it.
+    if (!m_SplitBarriers.empty())
+    {
+        switch (barrier.Type)
+        {
+        case D3D12_RESOURCE_BARRIER_TYPE_TRANSITION:
+            EndSplitBarriers(barrier.Transition.pResource);
+            break;
+        case D3D12_RESOURCE_BARRIER_TYPE_UAV:
+            EndSplitBarriers(barrier.UAV.pResource);
+            break;
+        case D3D12_RESOURCE_BARRIER_TYPE_ALIASING:
+            //null means any resource may be aliased.
+            if (!barrier.Aliasing.pResourceBefore || !barrier.Aliasing.pResourceAfter)
+            {
+                EndSplitBarriers(nullptr);
+            }
+            else
+            {
+                EndSplitBarriers(barrier.Aliasing.pResourceBefore);
+                EndSplitBarriers(barrier.Aliasing.pResourceAfter);
+            }
+            break;
+        }
+    }
     //We just handle the type of barrier is Transition.
     if (barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION)
     {
         const auto resourceTransition = barrier.Transition;
+        assert((m_CommandListType != D3D12_COMMAND_LIST_TYPE_COPY || IsCopyQueueState(resourceTransition.StateAfter))
+            && "Error!Copy commandlist can only transition resources to COMMON,COPY_DEST or COPY_SOURCE!");
         //check if this resource have already existed in final resource state
         auto posIter = m_FinalResourceState.find(resourceTransition.pResource);
         //If a resource has existed in final resource state,that means we can get the final state of this resource
         if (posIter != m_FinalResourceState.end())
         {
-            auto& subresourceState = posIter->second.subResourceState;
+            auto& resourceState = posIter->second.State;
             //
             if (resourceTransition.Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES
-                && !subresourceState.empty())
+                && !resourceState.IsUniform())
             {
-                for (auto state : subresourceState)
+                auto pStates = resourceState.GetStates();
+                for (UINT subResource = 0; subResource < resourceState.NumSubResources; ++subResource)
                 {
-                    if (resourceTransition.StateAfter != state.second)
+                    D3D12_RESOURCE_BARRIER newBarrier = barrier;
+                    //-----------------------------------------------------
+                    newBarrier.Transition.Subresource = subResource;
+                    //----------------------------------------------------
+                    //a subresource which is not used by this commandlist yet is resolved with its global state.
+                    if (pStates[subResource] == ResourceState::UnknownState)
                     {
-                        D3D12_RESOURCE_BARRIER newBarrier = barrier;
-                        //-----------------------------------------------------
-                        newBarrier.Transition.Subresource = state.first;
-                        //----------------------------------------------------
-                        newBarrier.Transition.StateBefore = state.second;
-
-                        m_ValidResourceBarrier.push_back(newBarrier);
+                        m_PendingResourceBarrier.push_back(newBarrier);
+                    }
+                    else if (resourceTransition.StateAfter != pStates[subResource])
+                    {
+                        newBarrier.Transition.StateBefore = pStates[subResource];
+                        if (IsImplicitPromotion(pStates[subResource], resourceTransition.StateAfter, posIter->second.DecaysToCommon))
+                        {
+                            ElidePromotedBarrier(newBarrier);
+                        }
+                        else
+                        {
+                            m_ValidResourceBarrier.push_back(newBarrier);
+                        }
                     }
                 }
+                resourceState.SetResourceState(resourceTransition.Subresource, resourceTransition.StateAfter, resourceTransition.pResource);
+            }
+            else if (resourceState.GetSubResourceState(resourceTransition.Subresource) == ResourceState::UnknownState)
+            {
+                m_PendingResourceBarrier.push_back(barrier);
+                resourceState.SetResourceState(resourceTransition.Subresource, resourceTransition.StateAfter, resourceTransition.pResource);
             }
             else
             {
-                auto FinalState = posIter->second.GetSubResourceState(resourceTransition.Subresource);
-                if (resourceTransition.StateAfter != FinalState)
+                auto FinalState = resourceState.GetSubResourceState(resourceTransition.Subresource);
+                auto stateAfter = CombineReadStates(FinalState, resourceTransition.StateAfter);
+                if (stateAfter != FinalState)
                 {
                     D3D12_RESOURCE_BARRIER newBarrier = barrier;
                     newBarrier.Transition.StateBefore = FinalState;
+                    newBarrier.Transition.StateAfter = stateAfter;
 
-                    m_ValidResourceBarrier.push_back(newBarrier);
+                    if (IsImplicitPromotion(FinalState, stateAfter, posIter->second.DecaysToCommon))
+                    {
+                        ElidePromotedBarrier(newBarrier);
+                    }
+                    else
+                    {
+                        m_ValidResourceBarrier.push_back(newBarrier);
+                    }
+                }
+                else if (stateAfter != resourceTransition.StateAfter)
+                {
+                    ++m_BarrierStatistics.NumCombinedReadBarriers;
                 }
+                resourceState.SetResourceState(resourceTransition.Subresource, stateAfter, resourceTransition.pResource);
             }
         }
         //If the resource has not final state,push this barrier into pending barrier
         else
         {
             m_PendingResourceBarrier.push_back(barrier);
+            //the global state is only looked up once for a commandlist.
+            posIter = m_FinalResourceState.emplace(resourceTransition.pResource, LocalResourceState()).first;
+            auto& localState = posIter->second;
+            localState.pGlobalState = pGlobalState ? pGlobalState : FindGlobalResourceState(resourceTransition.pResource);
+            localState.DecaysToCommon = localState.pGlobalState ? localState.pGlobalState->DecaysToCommon.load(std::memory_order_relaxed)
+                : CanDecayToCommon(resourceTransition.pResource);
+            //other subresources are unknown until they are used.
+            if (resourceTransition.Subresource != D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+            {
+                posIter->second.State = ResourceState(ResourceState::UnknownState);
+            }
+            posIter->second.State.SetResourceState(resourceTransition.Subresource, resourceTransition.StateAfter, resourceTransition.pResource);
         }
-        //Update final resource state
-        m_FinalResourceState[resourceTransition.pResource].SetResourceState(resourceTransition.Subresource, resourceTransition.StateAfter);
     }
     else//We just push the UavBarrier and AliasBarrier directly.
     {
@@ -68,127 +420,506 @@ void ResourceStateTracker::ResourceBarrier(const D3D12_RESOURCE_BARRIER& barrier
     }
 }
 
-void ResourceStateTracker::TransitionResource(ID3D12Resource* pD3D12Resource, D3D12_RESOURCE_STATES StateAfter, UINT subResource /* = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES */)
+void ResourceStateTracker::TransitionResource(ID3D12Resource* pD3D12Resource, D3D12_RESOURCE_STATES StateAfter, UINT subResource /* = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES */,
+    const void* pCallSite /* = nullptr */)
 {
     if (pD3D12Resource)
     {
-        ResourceBarrier(CD3DX12_RESOURCE_BARRIER::Transition(pD3D12Resource, D3D12_RESOURCE_STATE_COMMON, StateAfter, subResource));
+        ResourceBarrier(CD3DX12_RESOURCE_BARRIER::Transition(pD3D12Resource, D3D12_RESOURCE_STATE_COMMON, StateAfter, subResource), nullptr, pCallSite);
     }
 }
 
-void ResourceStateTracker::TransitionResource(const Resource* pResource, D3D12_RESOURCE_STATES StateAfter, UINT subResource /* = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES */)
+void ResourceStateTracker::TransitionResource(const Resource* pResource, D3D12_RESOURCE_STATES StateAfter, UINT subResource /* = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES */,
+    const void* pCallSite /* = nullptr */)
 {
-    if (pResource)
+    if (pResource && pResource->IsValidResource())
     {
-        TransitionResource(pResource->GetD3D12Resource().Get(), StateAfter, subResource);
+        //the handle of global state is passed,so it need not to be looked up.
+        ResourceBarrier(CD3DX12_RESOURCE_BARRIER::Transition(pResource->GetD3D12Resource().Get(), D3D12_RESOURCE_STATE_COMMON, StateAfter, subResource),
+            pResource->GetGlobalResourceState(), pCallSite);
     }
 }
 
-void ResourceStateTracker::AliasBarrier(const Resource* pResourceBefore /* = nullptr */, const Resource* pResourceAfter /* = nullptr */)
+void ResourceStateTracker::AliasBarrier(const Resource* pResourceBefore /* = nullptr */, const Resource* pResourceAfter /* = nullptr */,
+    const void* pCallSite /* = nullptr */)
 {
     auto resourceBefore = pResourceBefore == nullptr ? nullptr : pResourceBefore->GetD3D12Resource().Get();
     auto resourceAfter = pResourceAfter == nullptr ? nullptr : pResourceAfter->GetD3D12Resource().Get();
 
-    ResourceBarrier(CD3DX12_RESOURCE_BARRIER::Aliasing(resourceBefore, resourceAfter));
+    ResourceBarrier(CD3DX12_RESOURCE_BARRIER::Aliasing(resourceBefore, resourceAfter), nullptr, pCallSite);
 }
 
-void ResourceStateTracker::UavBarrier(const Resource* pResource)
+void ResourceStateTracker::UavBarrier(const Resource* pResource /* = nullptr */, const void* pCallSite /* = nullptr */)
 {
     auto presource = pResource == nullptr ? nullptr : pResource->GetD3D12Resource().Get();
 
-    ResourceBarrier(CD3DX12_RESOURCE_BARRIER::UAV(presource));
+    ResourceBarrier(CD3DX12_RESOURCE_BARRIER::UAV(presource), nullptr, pCallSite);
+}
+
+void ResourceStateTracker::BeginTransitionResource(ID3D12Resource* pD3D12Resource, D3D12_RESOURCE_STATES StateAfter, UINT subResource /* = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES */,
+    const void* pCallSite /* = nullptr */)
+{
+    if (pD3D12Resource)
+    {
+        BeginTransitionResource(pD3D12Resource, StateAfter, subResource, nullptr, pCallSite);
+    }
+}
+
+void ResourceStateTracker::BeginTransitionResource(const Resource* pResource, D3D12_RESOURCE_STATES StateAfter, UINT subResource /* = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES */,
+    const void* pCallSite /* = nullptr */)
+{
+    if (pResource && pResource->IsValidResource())
+    {
+        BeginTransitionResource(pResource->GetD3D12Resource().Get(), StateAfter, subResource, pResource->GetGlobalResourceState(), pCallSite);
+    }
+}
+
+void ResourceStateTracker::BeginTransitionResource(ID3D12Resource* pD3D12Resource, D3D12_RESOURCE_STATES StateAfter, UINT subResource,
+    const std::shared_ptr<GlobalResourceState>& pGlobalState, const void* pCallSite)
+{
+    auto posIter = m_FinalResourceState.find(pD3D12Resource);
+    //A split barrier needs the state before,so the state must be known and same for all subresources which are transitioned.
+    if (posIter == m_FinalResourceState.end()
+        || (subResource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES && !posIter->second.State.IsUniform())
+        || posIter->second.State.GetSubResourceState(subResource) == ResourceState::UnknownState)
+    {
+        ResourceBarrier(CD3DX12_RESOURCE_BARRIER::Transition(pD3D12Resource, D3D12_RESOURCE_STATE_COMMON, StateAfter, subResource), pGlobalState, pCallSite);
+        return;
+    }
+    assert((m_CommandListType != D3D12_COMMAND_LIST_TYPE_COPY || IsCopyQueueState(StateAfter))
+        && "Error!Copy commandlist can only transition resources to COMMON,COPY_DEST or COPY_SOURCE!");
+    auto splitBarrier = CD3DX12_RESOURCE_BARRIER::Transition(pD3D12Resource, D3D12_RESOURCE_STATE_COMMON, StateAfter, subResource, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+    RecordTraceEvent(BarrierTraceEventType::BeginTransition, &splitBarrier, pCallSite);
+    ++m_BarrierStatistics.NumRequestedBarriers;
+    EndSplitBarriers(pD3D12Resource);
+
+    auto stateBefore = posIter->second.State.GetSubResourceState(subResource);
+    if (stateBefore == StateAfter)
+    {
+        return;
+    }
+    splitBarrier.Transition.StateBefore = stateBefore;
+    m_ValidResourceBarrier.push_back(splitBarrier);
+    splitBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+    m_SplitBarriers.push_back(splitBarrier);
+    posIter->second.State.SetResourceState(subResource, StateAfter, pD3D12Resource);
+}
+
+void ResourceStateTracker::EndSplitBarriers()
+{
+    RecordTraceEvent(BarrierTraceEventType::EndSplitBarriers);
+    EndSplitBarriers(nullptr);
+}
+
+void ResourceStateTracker::EndSplitBarriers(ID3D12Resource* pResource)
+{
+    size_t numSplitBarriers = 0;
+    for (const auto& splitBarrier : m_SplitBarriers)
+    {
+        if (!pResource || splitBarrier.Transition.pResource == pResource)
+        {
+            m_ValidResourceBarrier.push_back(splitBarrier);
+        }
+        else
+        {
+            m_SplitBarriers[numSplitBarriers++] = splitBarrier;
+        }
+    }
+    m_SplitBarriers.resize(numSplitBarriers);
+}
+
+void ResourceStateTracker::RecordTraceEvent(BarrierTraceEventType Type, const D3D12_RESOURCE_BARRIER* pBarrier /* = nullptr */, const void* pCallSite /* = nullptr */)
+{
+    if (!BarrierTrace::IsCapturing())
+    {
+        return;
+    }
+    BarrierTraceEvent event = { Type, 0, D3D12_RESOURCE_STATE_COMMON, nullptr, nullptr, pCallSite };
+    if (pBarrier)
+    {
+        switch (pBarrier->Type)
+        {
+        case D3D12_RESOURCE_BARRIER_TYPE_TRANSITION:
+            event.pResource = pBarrier->Transition.pResource;
+            event.Subresource = pBarrier->Transition.Subresource;
+            event.StateAfter = pBarrier->Transition.StateAfter;
+            break;
+        case D3D12_RESOURCE_BARRIER_TYPE_UAV:
+            event.pResource = pBarrier->UAV.pResource;
+            break;
+        case D3D12_RESOURCE_BARRIER_TYPE_ALIASING:
+            event.pResource = pBarrier->Aliasing.pResourceBefore;
+            event.pResourceAfter = pBarrier->Aliasing.pResourceAfter;
+            break;
+        }
+    }
+    m_TraceEvents.push_back(event);
 }
 
 void ResourceStateTracker::FlushValidResourceBarrier(CommandList& commandList)
 {
     if (!m_ValidResourceBarrier.empty())
     {
-        commandList.GetGraphicsCommandList2()->ResourceBarrier(m_ValidResourceBarrier.size(), m_ValidResourceBarrier.data());
+        RecordTraceEvent(BarrierTraceEventType::Flush);
+        OptimizeBarriers(m_ValidResourceBarrier);
+        if (!m_ValidResourceBarrier.empty())
+        {
+            commandList.GetGraphicsCommandList2()->ResourceBarrier(m_ValidResourceBarrier.size(), m_ValidResourceBarrier.data());
+            m_BarrierStatistics.NumIssuedBarriers += m_ValidResourceBarrier.size();
+        }
         m_ValidResourceBarrier.clear();
     }
 }
 
-UINT ResourceStateTracker::FlushPendingResourceBarrier(CommandList& commandList)
+UINT ResourceStateTracker::FlushValidResourceBarrier(std::vector<D3D12_RESOURCE_BARRIER>& Barriers)
 {
-    assert(m_IsLock);
+    if (m_ValidResourceBarrier.empty())
+    {
+        return 0;
+    }
+    RecordTraceEvent(BarrierTraceEventType::Flush);
+    OptimizeBarriers(m_ValidResourceBarrier);
+    Barriers.insert(Barriers.end(), m_ValidResourceBarrier.begin(), m_ValidResourceBarrier.end());
+    UINT BarrierSize = (UINT)m_ValidResourceBarrier.size();
+    m_BarrierStatistics.NumIssuedBarriers += BarrierSize;
+    m_ValidResourceBarrier.clear();
+    return BarrierSize;
+}
 
-    std::vector<D3D12_RESOURCE_BARRIER> intermediateResourceBarrier;
-    if (!m_PendingResourceBarrier.empty())
+void ResourceStateTracker::OptimizeBarriers(std::vector<D3D12_RESOURCE_BARRIER>& Barriers)
+{
+    //a removed transition is marked by null resource.
+    bool hasRemovedBarrier = false;
+    m_LastTransitions.clear();
+    for (size_t i = 0; i < Barriers.size(); ++i)
     {
-        for (const auto& pendingBarrier : m_PendingResourceBarrier)
+        auto& barrier = Barriers[i];
+        if (barrier.Type != D3D12_RESOURCE_BARRIER_TYPE_TRANSITION)
         {
-            if (pendingBarrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION)
+            //transitions are not merged across a uav or aliasing barrier of the same resource.
+            auto pResourceBefore = barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_UAV ? barrier.UAV.pResource : barrier.Aliasing.pResourceBefore;
+            auto pResourceAfter = barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_UAV ? barrier.UAV.pResource : barrier.Aliasing.pResourceAfter;
+            if (!pResourceBefore || !pResourceAfter)
             {
-                auto pendingTransition = pendingBarrier.Transition;
-                auto posIter = m_GlobalResourceState.find(pendingTransition.pResource);
-                if (posIter != m_GlobalResourceState.end())
+                m_LastTransitions.clear();
+            }
+            else
+            {
+                m_LastTransitions.erase(pResourceBefore);
+                m_LastTransitions.erase(pResourceAfter);
+            }
+            continue;
+        }
+        auto& transition = barrier.Transition;
+        auto lastIter = m_LastTransitions.find(transition.pResource);
+        if (lastIter == m_LastTransitions.end())
+        {
+            m_LastTransitions.emplace(transition.pResource, i);
+            continue;
+        }
+        auto& lastBarrier = Barriers[lastIter->second];
+        auto& lastTransition = lastBarrier.Transition;
+        //transitions of different subresources may overlap,so only the last one of the resource can be merged.
+        if (lastTransition.Subresource != transition.Subresource)
+        {
+            lastIter->second = i;
+        }
+        else if (lastBarrier.Flags == D3D12_RESOURCE_BARRIER_FLAG_NONE && barrier.Flags == D3D12_RESOURCE_BARRIER_FLAG_NONE)
+        {
+            assert(lastTransition.StateAfter == transition.StateBefore && "Error!Transitions of a subresource are not continuous!");
+            lastTransition.StateAfter = transition.StateAfter;
+            transition.pResource = nullptr;
+            ++m_BarrierStatistics.NumMergedBarriers;
+            //A->B->A
+            if (lastTransition.StateBefore == lastTransition.StateAfter)
+            {
+                lastTransition.pResource = nullptr;
+                ++m_BarrierStatistics.NumMergedBarriers;
+                m_LastTransitions.erase(lastIter);
+            }
+            hasRemovedBarrier = true;
+        }
+        else if (lastBarrier.Flags == D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY && barrier.Flags == D3D12_RESOURCE_BARRIER_FLAG_END_ONLY)
+        {
+            //there is no gpu work between begin and end,so a normal barrier is enough.
+            lastBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+            transition.pResource = nullptr;
+            hasRemovedBarrier = true;
+        }
+        else
+        {
+            lastIter->second = i;
+        }
+    }
+
+    if (hasRemovedBarrier)
+    {
+        Barriers.erase(std::remove_if(Barriers.begin(), Barriers.end(), [](const D3D12_RESOURCE_BARRIER& barrier)
+        {
+            return barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION && !barrier.Transition.pResource;
+        }), Barriers.end());
+    }
+    for (const auto& barrier : Barriers)
+    {
+        if (barrier.Flags == D3D12_RESOURCE_BARRIER_FLAG_END_ONLY)
+        {
+            ++m_BarrierStatistics.NumSplitBarriers;
+        }
+    }
+}
+
+UINT ResourceStateTracker::FlushPendingResourceBarrier(std::vector<D3D12_RESOURCE_BARRIER>& intermediateResourceBarrier)
+{
+    //events of this commandlist are appended to the trace when its states are resolved,so the trace is in the order of queues.
+    if (!m_TraceEvents.empty())
+    {
+        RecordTraceEvent(BarrierTraceEventType::Close);
+        BarrierTrace::RecordCommandList(m_CommandListType, m_TraceEvents);
+        m_TraceEvents.clear();
+    }
+    size_t numBarriers = intermediateResourceBarrier.size();
+    for (const auto& pendingBarrier : m_PendingResourceBarrier)
+    {
+        if (pendingBarrier.Type != D3D12_RESOURCE_BARRIER_TYPE_TRANSITION)
+        {
+            continue;
+        }
+        auto pendingTransition = pendingBarrier.Transition;
+        auto posIter = m_FinalResourceState.find(pendingTransition.pResource);
+        if (posIter == m_FinalResourceState.end() || !posIter->second.pGlobalState)
+        {
+            assert(!"Error!Resource is not existed in Global Resource State Map.Check if this resource is not inserted in map or the resource has been destroyed");
+            continue;
+        }
+        auto& globalState = *posIter->second.pGlobalState;
+        //-------------------------------------------------------------
+        auto lock = globalState.Lock();
+        //-------------------------------------------------------------
+        AddQueueWait(globalState);
+        //Check if the global resource state is same with stateAfter of pending barrier
+        const auto& resourceState = globalState.State;
+        if (pendingTransition.Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES
+            && !resourceState.IsUniform())
+        {
+            auto pStates = resourceState.GetStates();
+            for (UINT subResource = 0; subResource < resourceState.NumSubResources; ++subResource)
+            {
+                if (pStates[subResource] != pendingTransition.StateAfter)
                 {
-                    //Check if the global resource state is same with stateAfter of pending barrier
-                    if (pendingTransition.Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES
-                        && !posIter->second.subResourceState.empty())
-                    {
-                        auto resourceState = posIter->second;
-                        for (const auto& subResState : resourceState.subResourceState)
-                        {
-                            if (subResState.second != pendingTransition.StateAfter)
-                            {
-                                D3D12_RESOURCE_BARRIER newBarrier = pendingBarrier;
-                                newBarrier.Transition.StateBefore = subResState.second;
-                                intermediateResourceBarrier.push_back(newBarrier);
-                            }
-                        }
-                    }
-                    else
+                    D3D12_RESOURCE_BARRIER newBarrier = pendingBarrier;
+                    newBarrier.Transition.Subresource = subResource;
+                    newBarrier.Transition.StateBefore = pStates[subResource];
+                    if (IsImplicitPromotion(pStates[subResource], pendingTransition.StateAfter, posIter->second.DecaysToCommon))
                     {
-                        auto finalState = posIter->second.GetSubResourceState(pendingTransition.Subresource);
-                        if (finalState != pendingTransition.StateAfter)
-                        {
-                            D3D12_RESOURCE_BARRIER newBarrier = pendingBarrier;
-                            newBarrier.Transition.StateBefore = finalState;
-                            intermediateResourceBarrier.push_back(newBarrier);
-                        }
+                        ElidePromotedBarrier(newBarrier);
+                        continue;
                     }
+                    assert((m_CommandListType != D3D12_COMMAND_LIST_TYPE_COPY || IsCopyQueueState(newBarrier.Transition.StateBefore))
+                        && "Error!A resource used by copy commandlist must be in COMMON,COPY_DEST or COPY_SOURCE state!");
+                    intermediateResourceBarrier.push_back(newBarrier);
+                }
+            }
+        }
+        else
+        {
+            auto finalState = resourceState.GetSubResourceState(pendingTransition.Subresource);
+            if (finalState != pendingTransition.StateAfter)
+            {
+                D3D12_RESOURCE_BARRIER newBarrier = pendingBarrier;
+                newBarrier.Transition.StateBefore = finalState;
+                if (IsImplicitPromotion(finalState, pendingTransition.StateAfter, posIter->second.DecaysToCommon))
+                {
+                    ElidePromotedBarrier(newBarrier);
                 }
-                else//As a debug state
+                else
                 {
-                    assert("Error!Resource is not existed in Global Resource State Map.Check if this resource is not inserted in map or the resource has been destroyed");
+                    assert((m_CommandListType != D3D12_COMMAND_LIST_TYPE_COPY || IsCopyQueueState(newBarrier.Transition.StateBefore))
+                        && "Error!A resource used by copy commandlist must be in COMMON,COPY_DEST or COPY_SOURCE state!");
+                    intermediateResourceBarrier.push_back(newBarrier);
                 }
             }
         }
     }
 
-    UINT BarrierSize = (UINT)intermediateResourceBarrier.size();
-    if (BarrierSize > 0)
-    {  
-        commandList.GetGraphicsCommandList2()->ResourceBarrier(intermediateResourceBarrier.size(), intermediateResourceBarrier.data());
-    }
+    UINT BarrierSize = (UINT)(intermediateResourceBarrier.size() - numBarriers);
+    m_BarrierStatistics.NumIssuedBarriers += BarrierSize;
     m_PendingResourceBarrier.clear();
 
     return BarrierSize;
 }
 
-void ResourceStateTracker::CommitFinalResourceState()
+void ResourceStateTracker::CommitFinalResourceState(std::unordered_set<ID3D12Resource*>& CommittedResources, ID3D12Fence* pFence, UINT64 FenceValue,
+    std::vector<std::shared_ptr<GlobalResourceState>>& DecayedStates)
 {
-    assert(m_IsLock);
-
-    for (const auto& finalResourceState : m_FinalResourceState)
+    assert(m_SplitBarriers.empty() && "Error!Split barriers must be ended before the commandlist is closed!");
+    for (auto& finalResourceState : m_FinalResourceState)
     {
-        //We upate global resource state.
-        //Here operator= is perfect for us.Since it will automatically update old resource state or add new resource state.
-        m_GlobalResourceState[finalResourceState.first] = finalResourceState.second;
+        CommittedResources.insert(finalResourceState.first);
+        auto& pGlobalState = finalResourceState.second.pGlobalState;
+        if (!pGlobalState)
+        {
+            pGlobalState = AddGlobalResourceState(finalResourceState.first, D3D12_RESOURCE_STATE_COMMON);
+        }
+        //-------------------------------------------------------------
+        auto lock = pGlobalState->Lock();
+        //-------------------------------------------------------------
+        //Resources used by copy or compute queue can not be used by other queues until the fence is completed.
+        if (m_CommandListType != D3D12_COMMAND_LIST_TYPE_DIRECT && pFence)
+        {
+            //the queue which signals the fence need not to wait for it.
+            pGlobalState->Fence = QueueFence{ pFence,FenceValue,1u << m_CommandListType };
+        }
+        //subresources which are not used by this commandlist keep their global states.
+        pGlobalState->State.Merge(finalResourceState.second.State);
+        //Resources used by copy queue,buffers and simultaneous-access textures decay to COMMON when ExecuteCommandLists() has finished.
+        //Later commandlists in the same ExecuteCommandLists() still see the state before decaying.
+        if (m_CommandListType == D3D12_COMMAND_LIST_TYPE_COPY || finalResourceState.second.DecaysToCommon)
+        {
+            DecayedStates.push_back(pGlobalState);
+        }
     }
     //Clear final resource state
     m_FinalResourceState.clear();
+    CommitBarrierStatistics();
+}
+
+void ResourceStateTracker::FlushQueueWaits(ID3D12CommandQueue* pCommandQueue)
+{
+    for (const auto& queueWait : m_QueueWaits)
+    {
+        pCommandQueue->Wait(queueWait.first, queueWait.second);
+    }
+    m_QueueWaits.clear();
+}
+
+void ResourceStateTracker::DecayResourceStates(std::vector<std::shared_ptr<GlobalResourceState>>& DecayedStates)
+{
+    for (const auto& pGlobalState : DecayedStates)
+    {
+        auto lock = pGlobalState->Lock();
+        pGlobalState->State = ResourceState(D3D12_RESOURCE_STATE_COMMON);
+    }
+    DecayedStates.clear();
+}
+
+bool ResourceStateTracker::IsImplicitPromotion(D3D12_RESOURCE_STATES StateBefore, D3D12_RESOURCE_STATES StateAfter, bool DecaysToCommon)const
+{
+    if (StateBefore != D3D12_RESOURCE_STATE_COMMON)
+    {
+        return false;
+    }
+    //Other textures are promoted to read states too on direct or compute queue,but they only decay when they are not transitioned
+    //explicitly after that,so only the promotion on copy queue is modelled for them.
+    return DecaysToCommon
+        || (m_CommandListType == D3D12_COMMAND_LIST_TYPE_COPY
+            && (StateAfter == D3D12_RESOURCE_STATE_COPY_DEST || StateAfter == D3D12_RESOURCE_STATE_COPY_SOURCE));
+}
+
+void ResourceStateTracker::ElidePromotedBarrier(const D3D12_RESOURCE_BARRIER& barrier)
+{
+    ++m_BarrierStatistics.NumPromotedBarriers;
+    if (ms_IsValidation.load(std::memory_order_relaxed))
+    {
+        char message[256];
+        std::snprintf(message, sizeof(message), "ResourceStateTracker:elided barrier of resource %p,subresource %u,0x%X -> 0x%X,implicit promotion on %s queue.\n",
+            static_cast<void*>(barrier.Transition.pResource), barrier.Transition.Subresource,
+            static_cast<UINT>(barrier.Transition.StateBefore), static_cast<UINT>(barrier.Transition.StateAfter),
+            GetCommandListTypeName(m_CommandListType));
+#if defined(_WIN32)
+        OutputDebugStringA(message);
+#else
+        std::fputs(message, stderr);
+#endif
+    }
 }
 
-void ResourceStateTracker::AddGlobalResourceState(ID3D12Resource* pResource,D3D12_RESOURCE_STATES State)
+D3D12_RESOURCE_STATES ResourceStateTracker::CombineReadStates(D3D12_RESOURCE_STATES StateBefore, D3D12_RESOURCE_STATES StateAfter)const
+{
+    //compute and copy queues do not support all read states.
+    if (m_CommandListType != D3D12_COMMAND_LIST_TYPE_DIRECT || !IsReadState(StateBefore) || !IsReadState(StateAfter))
+    {
+        return StateAfter;
+    }
+    return StateBefore | StateAfter;
+}
+
+void ResourceStateTracker::CommitBarrierStatistics()
+{
+    ms_NumRequestedBarriers.fetch_add(m_BarrierStatistics.NumRequestedBarriers, std::memory_order_relaxed);
+    ms_NumIssuedBarriers.fetch_add(m_BarrierStatistics.NumIssuedBarriers, std::memory_order_relaxed);
+    ms_NumMergedBarriers.fetch_add(m_BarrierStatistics.NumMergedBarriers, std::memory_order_relaxed);
+    ms_NumCombinedReadBarriers.fetch_add(m_BarrierStatistics.NumCombinedReadBarriers, std::memory_order_relaxed);
+    ms_NumPromotedBarriers.fetch_add(m_BarrierStatistics.NumPromotedBarriers, std::memory_order_relaxed);
+    ms_NumSplitBarriers.fetch_add(m_BarrierStatistics.NumSplitBarriers, std::memory_order_relaxed);
+    m_BarrierStatistics = BarrierStatistics();
+}
+
+void ResourceStateTracker::AddQueueWait(GlobalResourceState& GlobalState)
+{
+    auto& queueFence = GlobalState.Fence;
+    if (!queueFence.pFence)
+    {
+        return;
+    }
+    //the copy has finished,no queue need to wait for it any more.
+    if (queueFence.pFence->GetCompletedValue() >= queueFence.FenceValue)
+    {
+        queueFence = QueueFence{};
+        return;
+    }
+    //a queue is in order too,after it has waited once,later commandlists on it need not to wait.
+    UINT queueBit = 1u << m_CommandListType;
+    if (queueFence.WaitedQueues & queueBit)
+    {
+        return;
+    }
+    queueFence.WaitedQueues |= queueBit;
+
+    auto& waitValue = m_QueueWaits[queueFence.pFence];
+    waitValue = (std::max)(waitValue, queueFence.FenceValue);
+}
+
+std::shared_ptr<GlobalResourceState> ResourceStateTracker::AddGlobalResourceState(ID3D12Resource* pResource,D3D12_RESOURCE_STATES State)
 {
     //Note: pointer state
-    if (pResource)
+    if (!pResource)
     {
-        std::lock_guard<std::mutex> lock(ms_GlobalMutex);
-        m_GlobalResourceState[pResource].SetResourceState(D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, State);
+        return nullptr;
     }
+    std::shared_ptr<GlobalResourceState> pGlobalState;
+    {
+        auto& shard = GetGlobalStateShard(pResource);
+        std::lock_guard<std::mutex> lock(shard.Mutex);
+        auto& pState = shard.States[pResource];
+        if (!pState)
+        {
+            pState = std::make_shared<GlobalResourceState>();
+            ms_NumGlobalStates.fetch_add(1, std::memory_order_relaxed);
+        }
+        pGlobalState = pState;
+    }
+    {
+        auto lock = pGlobalState->Lock();
+        pGlobalState->State = ResourceState(State);
+        pGlobalState->Fence = QueueFence{};
+        pGlobalState->DecaysToCommon.store(CanDecayToCommon(pResource), std::memory_order_relaxed);
+    }
+    //the trace is recorded out of the lock,since it takes locks of global states when it writes a resource.
+    BarrierTrace::RecordResource(pResource, State);
+    return pGlobalState;
+}
+
+std::shared_ptr<GlobalResourceState> ResourceStateTracker::FindGlobalResourceState(ID3D12Resource* pResource)
+{
+    if (!pResource)
+    {
+        return nullptr;
+    }
+    ms_NumLookups.fetch_add(1, std::memory_order_relaxed);
+    auto& shard = GetGlobalStateShard(pResource);
+    std::lock_guard<std::mutex> lock(shard.Mutex);
+    auto posIter = shard.States.find(pResource);
+    return posIter != shard.States.end() ? posIter->second : nullptr;
 }
 
 void ResourceStateTracker::RemoveGlobalResourceState(ID3D12Resource* pResource)
@@ -196,21 +927,94 @@ void ResourceStateTracker::RemoveGlobalResourceState(ID3D12Resource* pResource)
     //Note: pointer state
     if (pResource)
     {
-        std::lock_guard<std::mutex> lock(ms_GlobalMutex);
-        m_GlobalResourceState.erase(pResource);
+        {
+            auto& shard = GetGlobalStateShard(pResource);
+            std::lock_guard<std::mutex> lock(shard.Mutex);
+            if (shard.States.erase(pResource))
+            {
+                ms_NumGlobalStates.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+        BarrierTrace::RecordRemoveResource(pResource);
     }
 }
 
-void ResourceStateTracker::Lock()
+void ResourceStateTracker::SnapshotGlobalResourceState(ID3D12Resource* pResource, D3D12_RESOURCE_STATES& State, std::vector<D3D12_RESOURCE_STATES>& States)
 {
-    m_IsLock = true;
-    ms_GlobalMutex.lock();
+    State = D3D12_RESOURCE_STATE_COMMON;
+    States.clear();
+    auto pGlobalState = FindGlobalResourceState(pResource);
+    if (!pGlobalState)
+    {
+        return;
+    }
+    auto lock = pGlobalState->Lock();
+    const auto& resourceState = pGlobalState->State;
+    if (resourceState.IsUniform())
+    {
+        State = resourceState.State;
+    }
+    else
+    {
+        States.assign(resourceState.GetStates(), resourceState.GetStates() + resourceState.NumSubResources);
+    }
 }
 
-void ResourceStateTracker::UnLock()
+void ResourceStateTracker::RestoreGlobalResourceState(ID3D12Resource* pResource, D3D12_RESOURCE_STATES State, const std::vector<D3D12_RESOURCE_STATES>& States)
 {
-    m_IsLock = false;
-    ms_GlobalMutex.unlock();
+    auto pGlobalState = FindGlobalResourceState(pResource);
+    if (!pGlobalState)
+    {
+        pGlobalState = AddGlobalResourceState(pResource, State);
+    }
+    auto lock = pGlobalState->Lock();
+    auto& resourceState = pGlobalState->State;
+    resourceState = ResourceState(State);
+    if (!States.empty())
+    {
+        resourceState.Split(static_cast<UINT>(States.size()));
+        std::copy(States.begin(), States.end(), resourceState.GetStates());
+        resourceState.TryMakeUniform();
+    }
+}
+
+ResourceStateTrackerStatistics ResourceStateTracker::GetStatistics()
+{
+    ResourceStateTrackerStatistics statistics;
+    statistics.NumGlobalStates = ms_NumGlobalStates.load(std::memory_order_relaxed);
+    statistics.NumLookups = ms_NumLookups.load(std::memory_order_relaxed);
+    statistics.NumStateLocks = ms_NumStateLocks.load(std::memory_order_relaxed);
+    statistics.NumContendedStateLocks = ms_NumContendedStateLocks.load(std::memory_order_relaxed);
+    statistics.NumSplitStates = ms_NumSplitStates.load(std::memory_order_relaxed);
+    statistics.NumHeapSplitStates = ms_NumHeapSplitStates.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+void ResourceStateTracker::EndFrame()
+{
+    std::lock_guard<std::mutex> lock(ms_FrameStatisticsMutex);
+    ms_FrameStatistics.NumRequestedBarriers = ms_NumRequestedBarriers.exchange(0, std::memory_order_relaxed);
+    ms_FrameStatistics.NumIssuedBarriers = ms_NumIssuedBarriers.exchange(0, std::memory_order_relaxed);
+    ms_FrameStatistics.NumMergedBarriers = ms_NumMergedBarriers.exchange(0, std::memory_order_relaxed);
+    ms_FrameStatistics.NumCombinedReadBarriers = ms_NumCombinedReadBarriers.exchange(0, std::memory_order_relaxed);
+    ms_FrameStatistics.NumPromotedBarriers = ms_NumPromotedBarriers.exchange(0, std::memory_order_relaxed);
+    ms_FrameStatistics.NumSplitBarriers = ms_NumSplitBarriers.exchange(0, std::memory_order_relaxed);
+}
+
+BarrierStatistics ResourceStateTracker::GetFrameStatistics()
+{
+    std::lock_guard<std::mutex> lock(ms_FrameStatisticsMutex);
+    return ms_FrameStatistics;
+}
+
+void ResourceStateTracker::SetValidation(bool Enable)
+{
+    ms_IsValidation.store(Enable, std::memory_order_relaxed);
+}
+
+bool ResourceStateTracker::IsValidation()
+{
+    return ms_IsValidation.load(std::memory_order_relaxed);
 }
 
 void ResourceStateTracker::Reset()
@@ -218,4 +1022,9 @@ void ResourceStateTracker::Reset()
     m_PendingResourceBarrier.clear();
     m_ValidResourceBarrier.clear();
     m_FinalResourceState.clear();
-}
\ No newline at end of file
+    m_QueueWaits.clear();
+    m_SplitBarriers.clear();
+    m_TraceEvents.clear();
+    //commandlists which are closed without committing states still count.
+    CommitBarrierStatistics();
+}
@@ -8,6 +8,7 @@ RootSignature::RootSignature()
     , m_d3d12RootSigDesc1(D3D12_ROOT_SIGNATURE_DESC1())
     , m_CbvSrvUavDescriptorTableBitMask(0)
     , m_SamplerTableBitMask(0)
+    , m_BindlessTableBitMask(0)
     , m_NumDescriptorsPerTable{0}
 {};
 
@@ -16,6 +17,7 @@ RootSignature::RootSignature(const D3D12_ROOT_SIGNATURE_DESC1& rootSigDesc1, D3D
     ,m_d3d12RootSigDesc1()
     ,m_CbvSrvUavDescriptorTableBitMask(0)
     , m_SamplerTableBitMask(0)
+    , m_BindlessTableBitMask(0)
     , m_NumDescriptorsPerTable{ 0 }
 {
     SetRootSignatureDesc(rootSigDesc1, rootSigVersion);
@@ -51,7 +53,21 @@ void RootSignature::SetRootSignatureDesc(const D3D12_ROOT_SIGNATURE_DESC1& rootS
             pRootParameter[i].DescriptorTable.pDescriptorRanges = pDescriptorRange;
             pRootParameter[i].DescriptorTable.NumDescriptorRanges = pRootParameter[i].DescriptorTable.NumDescriptorRanges;
 
-            if (pDescriptorRange)
+            //Check if the table is bindless table,which is bound to the whole bindless heap.
+            bool isBindlessTable = pDescriptorRange != nullptr;
+            for (UINT j = 0; j < pRootParameter[i].DescriptorTable.NumDescriptorRanges; ++j)
+            {
+                if (pDescriptorRange[j].NumDescriptors != UINT_MAX || pDescriptorRange[j].OffsetInDescriptorsFromTableStart != 0)
+                {
+                    isBindlessTable = false;
+                }
+            }
+            if (isBindlessTable)
+            {
+                assert(pDescriptorRange[0].RangeType != D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER && "Error!Bindless table can not hold samplers!");
+                m_BindlessTableBitMask |= (1 << i);
+            }
+            else if (pDescriptorRange)
             {
                 //Since different ranges maybe have different type(CBV,SRV,UAV,SAMPLER) in one descriptor table.
                 //But we must note that the sampler can not be put same descriptor table with CBV,SRV and UAV.
@@ -82,7 +98,7 @@ void RootSignature::SetRootSignatureDesc(const D3D12_ROOT_SIGNATURE_DESC1& rootS
                 }
             }
             //Compute all descriptor number in every descriptor table.
-            for (UINT j = 0; j < pRootParameter[i].DescriptorTable.NumDescriptorRanges; ++j)
+            for (UINT j = 0; j < pRootParameter[i].DescriptorTable.NumDescriptorRanges && !isBindlessTable; ++j)
             {
                 
                 m_NumDescriptorsPerTable[i] += pDescriptorRange[j].NumDescriptors;
@@ -110,6 +126,8 @@ void RootSignature::SetRootSignatureDesc(const D3D12_ROOT_SIGNATURE_DESC1& rootS
     versionRootSignatureDesc.Init_1_1(m_d3d12RootSigDesc1.NumParameters, m_d3d12RootSigDesc1.pParameters,
         m_d3d12RootSigDesc1.NumStaticSamplers, m_d3d12RootSigDesc1.pStaticSamplers, m_d3d12RootSigDesc1.Flags);
 
+    auto device = Application::GetApp()->GetDevice();
+#if defined(_WIN32)
     Microsoft::WRL::ComPtr<ID3DBlob> serializedRootSignature;
     Microsoft::WRL::ComPtr<ID3DBlob> errorBlob;
     //Create root signature
@@ -122,9 +140,13 @@ void RootSignature::SetRootSignatureDesc(const D3D12_ROOT_SIGNATURE_DESC1& rootS
     }
     ThrowIfFailed(hr);
 
-    auto device = Application::GetApp()->GetDevice();
     ThrowIfFailed(device->CreateRootSignature(0, serializedRootSignature->GetBufferPointer(),
         serializedRootSignature->GetBufferSize(), IID_PPV_ARGS(&m_d3d12RootSignature)));
+#else
+    //There is no d3d12 runtime to serialize root signatures,only the null device runs here and it does not parse them.
+    ThrowIfFailed(device->CreateRootSignature(0, &versionRootSignatureDesc,
+        sizeof(versionRootSignatureDesc), IID_PPV_ARGS(&m_d3d12RootSignature)));
+#endif
 }
 
 UINT RootSignature::GetDescriptorTableBitMask(D3D12_DESCRIPTOR_HEAP_TYPE type)const
@@ -167,6 +189,7 @@ void RootSignature::Destroy()
 
     m_CbvSrvUavDescriptorTableBitMask = 0;
     m_SamplerTableBitMask = 0;
+    m_BindlessTableBitMask = 0;
 
     ::memset(m_NumDescriptorsPerTable, 0, sizeof(m_NumDescriptorsPerTable));
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "CommandList.h"
 #include "FrustumCulling.h"
 #include "Light.h"
+#include "JobSystem.h"
 
 #include <memory>
 
@@ -140,11 +141,29 @@ std::string Scene::LoadModelFromFilePath(const std::string& Path,std::shared_ptr
 std::vector<std::string> Scene::LoadModelFromFilePaths(const std::vector<std::string>& Paths,std::shared_ptr<CommandList> commandList)
 {
     assert(Paths.size() && "Error!Paths array can not be empty!");
+    //Files are imported on job threads,then textures and buffers are recorded on the command list in order of paths.
+    std::vector<std::unique_ptr<Model>> models(Paths.size());
+    Application::GetApp()->GetJobSystem()->ParallelFor(Paths.size(), 1, [&](size_t Begin, size_t End)
+    {
+        for (size_t i = Begin; i < End; ++i)
+        {
+            models[i] = std::make_unique<Model>(ms_pScene);
+            models[i]->ImportModel(Paths[i]);
+        }
+    });
+
     std::vector<std::string> names;
-    for (const auto& path : Paths)
+    for (auto& model : models)
     {
-        names.push_back(LoadModelFromFilePath(path, commandList));
+        model->LoadModelTexture(commandList);
+        model->SetVertexAndIndexBuffer(commandList);
+
+        names.push_back(model->ModelName());
+        m_SceneModelsMap.insert({ model->ModelName(),std::move(model) });
     }
+    //reset scene state
+    Scene::GetScene()->m_IsDirtyScene = true;
+
     return names;
 }
 
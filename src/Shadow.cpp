@@ -8,6 +8,7 @@
 #include "Light.h"
 #include "CommandList.h"
 #include "Pass.h"
+#include "JobSystem.h"
 
 #include <DirectXColors.h>
 
@@ -644,143 +645,148 @@ void CascadedShadow::UpdateShadowInfo()
     assert(m_pMainCamera && "Error!Main camera is null!");
     //Firstly,we need to divide the view space of main camera
     float DepthRange = m_pMainCamera->GetFarZ() - m_pMainCamera->GetNearZ();
-    //we loop to compute proj matrix for each cascade
-    for (int i = 0; i < (int)m_CascadeLevel; ++i)
+    //Camera matrices and scene AABB are updated lazily,so we get them before cascades are computed on job threads.
+    DirectX::XMMATRIX EyeProjection = m_pMainCamera->GetProj();
+    DirectX::XMMATRIX ViewToWorld = m_pMainCamera->GetInvView();
+    DirectX::XMMATRIX WorldToLight = m_pLight->GetLightViewMatrix();
+    auto SceneAABBWorldSpace = Scene::GetScene()->GetSceneBoundingBox();
+    //we compute proj matrix for each cascade,every cascade only writes its own camera and partition depth.
+    Application::GetApp()->GetJobSystem()->ParallelFor(static_cast<size_t>(m_CascadeLevel), 1, [&](size_t Begin, size_t End)
     {
-        float cascadeDepthStart = 0.0f;
-        float cascadeDepthEnd = 0.0f;
-        //According to partition mathod to compute slice
-        if (m_SelectedCascadedFit == FIT_PROJECTION_TO_CASCADES::FIT_TO_SCENE)
-        {
-            cascadeDepthStart = 0.0f;
-            cascadeDepthEnd = DepthRange * m_CascadePartitionFactor[i];
-        }
-        else if (m_SelectedCascadedFit == FIT_PROJECTION_TO_CASCADES::FIT_TO_CASCADE)
-        {
-            if (i == 0) cascadeDepthStart = 0.0f;
-            else        cascadeDepthStart = DepthRange * m_CascadePartitionFactor[i - 1];
-            cascadeDepthEnd = DepthRange * m_CascadePartitionFactor[i];
-        }
-        m_CascadePartitionDepth[i] = cascadeDepthEnd;
-        //then we use start and end value to compute slice view frustum points
-        DirectX::XMVECTOR FrustumCornersViewSpace[8];
-        GetFrustumPointsViewSpaceFromInterval(cascadeDepthStart, cascadeDepthEnd, m_pMainCamera->GetProj(), FrustumCornersViewSpace);
-        //next,we need to transform these points to light space
-        DirectX::XMMATRIX ViewToWorld = m_pMainCamera->GetInvView();
-        DirectX::XMMATRIX WorldToLight = m_pLight->GetLightViewMatrix();
-        DirectX::XMVECTOR FrustumCornersWorldSpace[8];
-        DirectX::XMVECTOR FrustumCornersLightSpace[8];
-        DirectX::XMVECTOR FrustumSliceMaxLightSpace = { -FLT_MAX,-FLT_MAX,-FLT_MAX,-FLT_MAX };
-        DirectX::XMVECTOR FrustumSliceMinLightSpace = { FLT_MAX,FLT_MAX,FLT_MAX,FLT_MAX };
-        //then,we use these points to compute min and max,and to compute x and y for light frustum.
-        for (int i = 0; i < 8; ++i)
+        for (int i = static_cast<int>(Begin); i < static_cast<int>(End); ++i)
         {
-            FrustumCornersWorldSpace[i] = DirectX::XMVector3TransformCoord(FrustumCornersViewSpace[i], ViewToWorld);
-            FrustumCornersLightSpace[i] = DirectX::XMVector3TransformCoord(FrustumCornersViewSpace[i], ViewToWorld * WorldToLight);
-            FrustumSliceMaxLightSpace = DirectX::XMVectorMax(FrustumSliceMaxLightSpace, FrustumCornersLightSpace[i]);
-            FrustumSliceMinLightSpace = DirectX::XMVectorMin(FrustumSliceMinLightSpace, FrustumCornersLightSpace[i]);
-        }
-        //
-        DirectX::XMVECTOR WorldUnitsPerTexelVector;
-        if (m_SelectedCascadedFit == FIT_PROJECTION_TO_CASCADES::FIT_TO_SCENE)
-        {
-            DirectX::XMVECTOR Diagonal = DirectX::XMVectorSubtract(
-                FrustumCornersWorldSpace[7],
-                FrustumCornersWorldSpace[0]);
-            Diagonal = DirectX::XMVector3Length(Diagonal);
+            float cascadeDepthStart = 0.0f;
+            float cascadeDepthEnd = 0.0f;
+            //According to partition mathod to compute slice
+            if (m_SelectedCascadedFit == FIT_PROJECTION_TO_CASCADES::FIT_TO_SCENE)
+            {
+                cascadeDepthStart = 0.0f;
+                cascadeDepthEnd = DepthRange * m_CascadePartitionFactor[i];
+            }
+            else if (m_SelectedCascadedFit == FIT_PROJECTION_TO_CASCADES::FIT_TO_CASCADE)
+            {
+                if (i == 0) cascadeDepthStart = 0.0f;
+                else        cascadeDepthStart = DepthRange * m_CascadePartitionFactor[i - 1];
+                cascadeDepthEnd = DepthRange * m_CascadePartitionFactor[i];
+            }
+            m_CascadePartitionDepth[i] = cascadeDepthEnd;
+            //then we use start and end value to compute slice view frustum points
+            DirectX::XMVECTOR FrustumCornersViewSpace[8];
+            GetFrustumPointsViewSpaceFromInterval(cascadeDepthStart, cascadeDepthEnd, EyeProjection, FrustumCornersViewSpace);
+            //next,we need to transform these points to light space
+            DirectX::XMVECTOR FrustumCornersWorldSpace[8];
+            DirectX::XMVECTOR FrustumCornersLightSpace[8];
+            DirectX::XMVECTOR FrustumSliceMaxLightSpace = { -FLT_MAX,-FLT_MAX,-FLT_MAX,-FLT_MAX };
+            DirectX::XMVECTOR FrustumSliceMinLightSpace = { FLT_MAX,FLT_MAX,FLT_MAX,FLT_MAX };
+            //then,we use these points to compute min and max,and to compute x and y for light frustum.
+            for (int i = 0; i < 8; ++i)
+            {
+                FrustumCornersWorldSpace[i] = DirectX::XMVector3TransformCoord(FrustumCornersViewSpace[i], ViewToWorld);
+                FrustumCornersLightSpace[i] = DirectX::XMVector3TransformCoord(FrustumCornersViewSpace[i], ViewToWorld * WorldToLight);
+                FrustumSliceMaxLightSpace = DirectX::XMVectorMax(FrustumSliceMaxLightSpace, FrustumCornersLightSpace[i]);
+                FrustumSliceMinLightSpace = DirectX::XMVectorMin(FrustumSliceMinLightSpace, FrustumCornersLightSpace[i]);
+            }
+            //
+            DirectX::XMVECTOR WorldUnitsPerTexelVector;
+            if (m_SelectedCascadedFit == FIT_PROJECTION_TO_CASCADES::FIT_TO_SCENE)
+            {
+                DirectX::XMVECTOR Diagonal = DirectX::XMVectorSubtract(
+                    FrustumCornersWorldSpace[7],
+                    FrustumCornersWorldSpace[0]);
+                Diagonal = DirectX::XMVector3Length(Diagonal);
 
-            XMVECTOR Offset =
-                (Diagonal - (FrustumSliceMaxLightSpace - FrustumSliceMinLightSpace)) * gHalfVector;
-            Offset *= gVectorZToZero;
+                XMVECTOR Offset =
+                    (Diagonal - (FrustumSliceMaxLightSpace - FrustumSliceMinLightSpace)) * gHalfVector;
+                Offset *= gVectorZToZero;
 
-            FrustumSliceMaxLightSpace += Offset;
-            FrustumSliceMinLightSpace -= Offset;
+                FrustumSliceMaxLightSpace += Offset;
+                FrustumSliceMinLightSpace -= Offset;
 
-            float CascadedLength = DirectX::XMVectorGetX(Diagonal);
-            float WorldUnitsPerTexel = (CascadedLength / (float)m_Width);
-            WorldUnitsPerTexelVector = DirectX::XMVectorSet(WorldUnitsPerTexel, WorldUnitsPerTexel, 0.0f, 0.0f);
-        }
-        else//fllowing code , I can not understand.......
-        {
-            // We calculate a looser bound based on the size of the PCF blur.  This ensures us that we're 
-            // sampling within the correct map.
-            float fScaleDuetoBlureAMT = ((float)(m_FilterSize * 2 + 1)
-                / (float)m_Width);
-            XMVECTORF32 vScaleDuetoBlureAMT = { fScaleDuetoBlureAMT, fScaleDuetoBlureAMT, 0.0f, 0.0f };
-
-            float fNormalizeByBufferSize = (1.0f / (float)m_Width);
-            XMVECTOR vNormalizeByBufferSize = DirectX::XMVectorSet(fNormalizeByBufferSize, fNormalizeByBufferSize, 0.0f, 0.0f);
-
-            // We calculate the offsets as a percentage of the bound.
-            XMVECTOR vBoarderOffset = FrustumSliceMaxLightSpace - FrustumSliceMinLightSpace;
-            vBoarderOffset *= gHalfVector;
-            vBoarderOffset *= vScaleDuetoBlureAMT;
-            FrustumSliceMaxLightSpace += vBoarderOffset;
-            FrustumSliceMinLightSpace -= vBoarderOffset;
-
-            // The world units per texel are used to snap  the orthographic projection
-            // to texel sized increments.  
-            // Because we're fitting tighly to the cascades, the shimmering shadow edges will still be present when the 
-            // camera rotates.  However, when zooming in or strafing the shadow edge will not shimmer.
-            WorldUnitsPerTexelVector = FrustumSliceMaxLightSpace - FrustumSliceMinLightSpace;
-            WorldUnitsPerTexelVector *= vNormalizeByBufferSize;
-        }
-        //Here we limit camera move footstep into one texel to solve shadows jitter.
-        //This is a matter of integer dividing by the world space size of a texel
-        FrustumSliceMinLightSpace /= WorldUnitsPerTexelVector;
-        FrustumSliceMinLightSpace = XMVectorFloor(FrustumSliceMinLightSpace);
-        FrustumSliceMinLightSpace *= WorldUnitsPerTexelVector;
-
-        FrustumSliceMaxLightSpace /= WorldUnitsPerTexelVector;
-        FrustumSliceMaxLightSpace = XMVectorFloor(FrustumSliceMaxLightSpace);
-        FrustumSliceMaxLightSpace *= WorldUnitsPerTexelVector;
-        //Finally,we can use scene AABB and frustum slice to compute znear and zfar of light frustum.
-        //Here,we have two method to decide znear and zfar.
-        //FIT_TO_SCENE: directly use scene AABB to compute znear and zfar.This method is enough for many cases.
-        //But in special case,such as the camera view is small but scene aabb is long,this will lead the light frustum has a large distance between znear and zfar.
-        //FIT_TO_CASCADE: use camera frustum slice and scene aabb to compute znear and zfar.This will get a tighter light frustum.
-        //for cascaded shadow map,this is a very important technology,since many slice will be smaller than scene aabb.
+                float CascadedLength = DirectX::XMVectorGetX(Diagonal);
+                float WorldUnitsPerTexel = (CascadedLength / (float)m_Width);
+                WorldUnitsPerTexelVector = DirectX::XMVectorSet(WorldUnitsPerTexel, WorldUnitsPerTexel, 0.0f, 0.0f);
+            }
+            else//fllowing code , I can not understand.......
+            {
+                // We calculate a looser bound based on the size of the PCF blur.  This ensures us that we're 
+                // sampling within the correct map.
+                float fScaleDuetoBlureAMT = ((float)(m_FilterSize * 2 + 1)
+                    / (float)m_Width);
+                XMVECTORF32 vScaleDuetoBlureAMT = { fScaleDuetoBlureAMT, fScaleDuetoBlureAMT, 0.0f, 0.0f };
+
+                float fNormalizeByBufferSize = (1.0f / (float)m_Width);
+                XMVECTOR vNormalizeByBufferSize = DirectX::XMVectorSet(fNormalizeByBufferSize, fNormalizeByBufferSize, 0.0f, 0.0f);
+
+                // We calculate the offsets as a percentage of the bound.
+                XMVECTOR vBoarderOffset = FrustumSliceMaxLightSpace - FrustumSliceMinLightSpace;
+                vBoarderOffset *= gHalfVector;
+                vBoarderOffset *= vScaleDuetoBlureAMT;
+                FrustumSliceMaxLightSpace += vBoarderOffset;
+                FrustumSliceMinLightSpace -= vBoarderOffset;
+
+                // The world units per texel are used to snap  the orthographic projection
+                // to texel sized increments.  
+                // Because we're fitting tighly to the cascades, the shimmering shadow edges will still be present when the 
+                // camera rotates.  However, when zooming in or strafing the shadow edge will not shimmer.
+                WorldUnitsPerTexelVector = FrustumSliceMaxLightSpace - FrustumSliceMinLightSpace;
+                WorldUnitsPerTexelVector *= vNormalizeByBufferSize;
+            }
+            //Here we limit camera move footstep into one texel to solve shadows jitter.
+            //This is a matter of integer dividing by the world space size of a texel
+            FrustumSliceMinLightSpace /= WorldUnitsPerTexelVector;
+            FrustumSliceMinLightSpace = XMVectorFloor(FrustumSliceMinLightSpace);
+            FrustumSliceMinLightSpace *= WorldUnitsPerTexelVector;
+
+            FrustumSliceMaxLightSpace /= WorldUnitsPerTexelVector;
+            FrustumSliceMaxLightSpace = XMVectorFloor(FrustumSliceMaxLightSpace);
+            FrustumSliceMaxLightSpace *= WorldUnitsPerTexelVector;
+            //Finally,we can use scene AABB and frustum slice to compute znear and zfar of light frustum.
+            //Here,we have two method to decide znear and zfar.
+            //FIT_TO_SCENE: directly use scene AABB to compute znear and zfar.This method is enough for many cases.
+            //But in special case,such as the camera view is small but scene aabb is long,this will lead the light frustum has a large distance between znear and zfar.
+            //FIT_TO_CASCADE: use camera frustum slice and scene aabb to compute znear and zfar.This will get a tighter light frustum.
+            //for cascaded shadow map,this is a very important technology,since many slice will be smaller than scene aabb.
         
-        //We need to transform the corners of scene AABB to light space
-        auto SceneAABBWorldSpace = Scene::GetScene()->GetSceneBoundingBox();
-        DirectX::XMFLOAT3 AABBCornersWorldSpace[8];
-        SceneAABBWorldSpace.GetCorners(AABBCornersWorldSpace);
-        DirectX::XMVECTOR AABBCornerLightSpace[8];
-        for (int i = 0; i < 8; ++i)
-        {
-            AABBCornerLightSpace[i] = DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&AABBCornersWorldSpace[i]), m_pLight->GetLightViewMatrix());
-        }
-        //A simple method.
-        //We just compute the min and max of aabb in light space.
-        float zNear = 0.0f;
-        float zFar = 1000.0f;
-        if (m_SelectedCascadedNearFar == FIT_TO_NEAR_FAR::FIT_TO_SCENE_AABB)
-        {
-            DirectX::XMVECTOR MaxAABBCornersLightSpace = { -FLT_MAX,-FLT_MAX,-FLT_MAX,-FLT_MAX };
-            DirectX::XMVECTOR MinAABBCornersLightSpace = { FLT_MAX,FLT_MAX,FLT_MAX,FLT_MAX };
-            //compute min and max
+            //We need to transform the corners of scene AABB to light space
+            DirectX::XMFLOAT3 AABBCornersWorldSpace[8];
+            SceneAABBWorldSpace.GetCorners(AABBCornersWorldSpace);
+            DirectX::XMVECTOR AABBCornerLightSpace[8];
             for (int i = 0; i < 8; ++i)
             {
-                MaxAABBCornersLightSpace = DirectX::XMVectorMax(MaxAABBCornersLightSpace, AABBCornerLightSpace[i]);
-                MinAABBCornersLightSpace = DirectX::XMVectorMin(MinAABBCornersLightSpace, AABBCornerLightSpace[i]);
+                AABBCornerLightSpace[i] = DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&AABBCornersWorldSpace[i]), WorldToLight);
             }
-            zNear = DirectX::XMVectorGetZ(MinAABBCornersLightSpace);
-            zFar = DirectX::XMVectorGetZ(MaxAABBCornersLightSpace);
-        }
-        //A better method to compute tighter frustum for light.
-        else if (m_SelectedCascadedNearFar == FIT_TO_NEAR_FAR::FIT_TO_CASCADE_AABB)
-        {
-            ComputeNearAndFar(zNear, zFar, FrustumSliceMinLightSpace, FrustumSliceMaxLightSpace, AABBCornerLightSpace);
+            //A simple method.
+            //We just compute the min and max of aabb in light space.
+            float zNear = 0.0f;
+            float zFar = 1000.0f;
+            if (m_SelectedCascadedNearFar == FIT_TO_NEAR_FAR::FIT_TO_SCENE_AABB)
+            {
+                DirectX::XMVECTOR MaxAABBCornersLightSpace = { -FLT_MAX,-FLT_MAX,-FLT_MAX,-FLT_MAX };
+                DirectX::XMVECTOR MinAABBCornersLightSpace = { FLT_MAX,FLT_MAX,FLT_MAX,FLT_MAX };
+                //compute min and max
+                for (int i = 0; i < 8; ++i)
+                {
+                    MaxAABBCornersLightSpace = DirectX::XMVectorMax(MaxAABBCornersLightSpace, AABBCornerLightSpace[i]);
+                    MinAABBCornersLightSpace = DirectX::XMVectorMin(MinAABBCornersLightSpace, AABBCornerLightSpace[i]);
+                }
+                zNear = DirectX::XMVectorGetZ(MinAABBCornersLightSpace);
+                zFar = DirectX::XMVectorGetZ(MaxAABBCornersLightSpace);
+            }
+            //A better method to compute tighter frustum for light.
+            else if (m_SelectedCascadedNearFar == FIT_TO_NEAR_FAR::FIT_TO_CASCADE_AABB)
+            {
+                ComputeNearAndFar(zNear, zFar, FrustumSliceMinLightSpace, FrustumSliceMaxLightSpace, AABBCornerLightSpace);
+            }
+            //Until now,we get all parameter for light frustum,we can compute light frustum.
+            m_CascadedCameras[i]->SetLens(
+                DirectX::XMVectorGetX(FrustumSliceMinLightSpace),
+                DirectX::XMVectorGetX(FrustumSliceMaxLightSpace),
+                DirectX::XMVectorGetY(FrustumSliceMinLightSpace),
+                DirectX::XMVectorGetY(FrustumSliceMaxLightSpace),
+                zNear,
+                zFar);
         }
-        //Until now,we get all parameter for light frustum,we can compute light frustum.
-        m_CascadedCameras[i]->SetLens(
-            DirectX::XMVectorGetX(FrustumSliceMinLightSpace),
-            DirectX::XMVectorGetX(FrustumSliceMaxLightSpace),
-            DirectX::XMVectorGetY(FrustumSliceMinLightSpace),
-            DirectX::XMVectorGetY(FrustumSliceMaxLightSpace),
-            zNear,
-            zFar);
-    }
+    });
 }
 
 
@@ -1304,143 +1310,148 @@ void CascadedVarianceShadow::UpdateShadowInfo()
     assert(m_pMainCamera && "Error!Main camera is null!");
     //Firstly,we need to divide the view space of main camera
     float DepthRange = m_pMainCamera->GetFarZ() - m_pMainCamera->GetNearZ();
-    //we loop to compute proj matrix for each cascade
-    for (int i = 0; i < (int)m_CascadeLevel; ++i)
+    //Camera matrices and scene AABB are updated lazily,so we get them before cascades are computed on job threads.
+    DirectX::XMMATRIX EyeProjection = m_pMainCamera->GetProj();
+    DirectX::XMMATRIX ViewToWorld = m_pMainCamera->GetInvView();
+    DirectX::XMMATRIX WorldToLight = m_pLight->GetLightViewMatrix();
+    auto SceneAABBWorldSpace = Scene::GetScene()->GetSceneBoundingBox();
+    //we compute proj matrix for each cascade,every cascade only writes its own camera and partition depth.
+    Application::GetApp()->GetJobSystem()->ParallelFor(static_cast<size_t>(m_CascadeLevel), 1, [&](size_t Begin, size_t End)
     {
-        float cascadeDepthStart = 0.0f;
-        float cascadeDepthEnd = 0.0f;
-        //According to partition mathod to compute slice
-        if (m_SelectedCascadedFit == FIT_PROJECTION_TO_CASCADES::FIT_TO_SCENE)
-        {
-            cascadeDepthStart = 0.0f;
-            cascadeDepthEnd = DepthRange * m_CascadePartitionFactor[i];
-        }
-        else if (m_SelectedCascadedFit == FIT_PROJECTION_TO_CASCADES::FIT_TO_CASCADE)
-        {
-            if (i == 0) cascadeDepthStart = 0.0f;
-            else        cascadeDepthStart = DepthRange * m_CascadePartitionFactor[i - 1];
-            cascadeDepthEnd = DepthRange * m_CascadePartitionFactor[i];
-        }
-        m_CascadePartitionDepth[i] = cascadeDepthEnd;
-        //then we use start and end value to compute slice view frustum points
-        DirectX::XMVECTOR FrustumCornersViewSpace[8];
-        GetFrustumPointsViewSpaceFromInterval(cascadeDepthStart, cascadeDepthEnd, m_pMainCamera->GetProj(), FrustumCornersViewSpace);
-        //next,we need to transform these points to light space
-        DirectX::XMMATRIX ViewToWorld = m_pMainCamera->GetInvView();
-        DirectX::XMMATRIX WorldToLight = m_pLight->GetLightViewMatrix();
-        DirectX::XMVECTOR FrustumCornersWorldSpace[8];
-        DirectX::XMVECTOR FrustumCornersLightSpace[8];
-        DirectX::XMVECTOR FrustumSliceMaxLightSpace = { -FLT_MAX,-FLT_MAX,-FLT_MAX,-FLT_MAX };
-        DirectX::XMVECTOR FrustumSliceMinLightSpace = { FLT_MAX,FLT_MAX,FLT_MAX,FLT_MAX };
-        //then,we use these points to compute min and max,and to compute x and y for light frustum.
-        for (int i = 0; i < 8; ++i)
+        for (int i = static_cast<int>(Begin); i < static_cast<int>(End); ++i)
         {
-            FrustumCornersWorldSpace[i] = DirectX::XMVector3TransformCoord(FrustumCornersViewSpace[i], ViewToWorld);
-            FrustumCornersLightSpace[i] = DirectX::XMVector3TransformCoord(FrustumCornersViewSpace[i], ViewToWorld * WorldToLight);
-            FrustumSliceMaxLightSpace = DirectX::XMVectorMax(FrustumSliceMaxLightSpace, FrustumCornersLightSpace[i]);
-            FrustumSliceMinLightSpace = DirectX::XMVectorMin(FrustumSliceMinLightSpace, FrustumCornersLightSpace[i]);
-        }
-        //
-        DirectX::XMVECTOR WorldUnitsPerTexelVector;
-        if (m_SelectedCascadedFit == FIT_PROJECTION_TO_CASCADES::FIT_TO_SCENE)
-        {
-            DirectX::XMVECTOR Diagonal = DirectX::XMVectorSubtract(
-                FrustumCornersWorldSpace[7],
-                FrustumCornersWorldSpace[0]);
-            Diagonal = DirectX::XMVector3Length(Diagonal);
+            float cascadeDepthStart = 0.0f;
+            float cascadeDepthEnd = 0.0f;
+            //According to partition mathod to compute slice
+            if (m_SelectedCascadedFit == FIT_PROJECTION_TO_CASCADES::FIT_TO_SCENE)
+            {
+                cascadeDepthStart = 0.0f;
+                cascadeDepthEnd = DepthRange * m_CascadePartitionFactor[i];
+            }
+            else if (m_SelectedCascadedFit == FIT_PROJECTION_TO_CASCADES::FIT_TO_CASCADE)
+            {
+                if (i == 0) cascadeDepthStart = 0.0f;
+                else        cascadeDepthStart = DepthRange * m_CascadePartitionFactor[i - 1];
+                cascadeDepthEnd = DepthRange * m_CascadePartitionFactor[i];
+            }
+            m_CascadePartitionDepth[i] = cascadeDepthEnd;
+            //then we use start and end value to compute slice view frustum points
+            DirectX::XMVECTOR FrustumCornersViewSpace[8];
+            GetFrustumPointsViewSpaceFromInterval(cascadeDepthStart, cascadeDepthEnd, EyeProjection, FrustumCornersViewSpace);
+            //next,we need to transform these points to light space
+            DirectX::XMVECTOR FrustumCornersWorldSpace[8];
+            DirectX::XMVECTOR FrustumCornersLightSpace[8];
+            DirectX::XMVECTOR FrustumSliceMaxLightSpace = { -FLT_MAX,-FLT_MAX,-FLT_MAX,-FLT_MAX };
+            DirectX::XMVECTOR FrustumSliceMinLightSpace = { FLT_MAX,FLT_MAX,FLT_MAX,FLT_MAX };
+            //then,we use these points to compute min and max,and to compute x and y for light frustum.
+            for (int i = 0; i < 8; ++i)
+            {
+                FrustumCornersWorldSpace[i] = DirectX::XMVector3TransformCoord(FrustumCornersViewSpace[i], ViewToWorld);
+                FrustumCornersLightSpace[i] = DirectX::XMVector3TransformCoord(FrustumCornersViewSpace[i], ViewToWorld * WorldToLight);
+                FrustumSliceMaxLightSpace = DirectX::XMVectorMax(FrustumSliceMaxLightSpace, FrustumCornersLightSpace[i]);
+                FrustumSliceMinLightSpace = DirectX::XMVectorMin(FrustumSliceMinLightSpace, FrustumCornersLightSpace[i]);
+            }
+            //
+            DirectX::XMVECTOR WorldUnitsPerTexelVector;
+            if (m_SelectedCascadedFit == FIT_PROJECTION_TO_CASCADES::FIT_TO_SCENE)
+            {
+                DirectX::XMVECTOR Diagonal = DirectX::XMVectorSubtract(
+                    FrustumCornersWorldSpace[7],
+                    FrustumCornersWorldSpace[0]);
+                Diagonal = DirectX::XMVector3Length(Diagonal);
 
-            XMVECTOR Offset =
-                (Diagonal - (FrustumSliceMaxLightSpace - FrustumSliceMinLightSpace)) * gHalfVector;
-            Offset *= gVectorZToZero;
+                XMVECTOR Offset =
+                    (Diagonal - (FrustumSliceMaxLightSpace - FrustumSliceMinLightSpace)) * gHalfVector;
+                Offset *= gVectorZToZero;
 
-            FrustumSliceMaxLightSpace += Offset;
-            FrustumSliceMinLightSpace -= Offset;
+                FrustumSliceMaxLightSpace += Offset;
+                FrustumSliceMinLightSpace -= Offset;
 
-            float CascadedLength = DirectX::XMVectorGetX(Diagonal);
-            float WorldUnitsPerTexel = (CascadedLength / (float)m_Width);
-            WorldUnitsPerTexelVector = DirectX::XMVectorSet(WorldUnitsPerTexel, WorldUnitsPerTexel, 0.0f, 0.0f);
-        }
-        else//fllowing code , I can not understand.......
-        {
-            // We calculate a looser bound based on the size of the PCF blur.  This ensures us that we're 
-            // sampling within the correct map.
-            float fScaleDuetoBlureAMT = ((float)(m_FilterSize * 2 + 1)
-                / (float)m_Width);
-            XMVECTORF32 vScaleDuetoBlureAMT = { fScaleDuetoBlureAMT, fScaleDuetoBlureAMT, 0.0f, 0.0f };
-
-            float fNormalizeByBufferSize = (1.0f / (float)m_Width);
-            XMVECTOR vNormalizeByBufferSize = DirectX::XMVectorSet(fNormalizeByBufferSize, fNormalizeByBufferSize, 0.0f, 0.0f);
-
-            // We calculate the offsets as a percentage of the bound.
-            XMVECTOR vBoarderOffset = FrustumSliceMaxLightSpace - FrustumSliceMinLightSpace;
-            vBoarderOffset *= gHalfVector;
-            vBoarderOffset *= vScaleDuetoBlureAMT;
-            FrustumSliceMaxLightSpace += vBoarderOffset;
-            FrustumSliceMinLightSpace -= vBoarderOffset;
-
-            // The world units per texel are used to snap  the orthographic projection
-            // to texel sized increments.  
-            // Because we're fitting tighly to the cascades, the shimmering shadow edges will still be present when the 
-            // camera rotates.  However, when zooming in or strafing the shadow edge will not shimmer.
-            WorldUnitsPerTexelVector = FrustumSliceMaxLightSpace - FrustumSliceMinLightSpace;
-            WorldUnitsPerTexelVector *= vNormalizeByBufferSize;
-        }
-        //Here we limit camera move footstep into one texel to solve shadows jitter.
-        //This is a matter of integer dividing by the world space size of a texel
-        FrustumSliceMinLightSpace /= WorldUnitsPerTexelVector;
-        FrustumSliceMinLightSpace = XMVectorFloor(FrustumSliceMinLightSpace);
-        FrustumSliceMinLightSpace *= WorldUnitsPerTexelVector;
-
-        FrustumSliceMaxLightSpace /= WorldUnitsPerTexelVector;
-        FrustumSliceMaxLightSpace = XMVectorFloor(FrustumSliceMaxLightSpace);
-        FrustumSliceMaxLightSpace *= WorldUnitsPerTexelVector;
-        //Finally,we can use scene AABB and frustum slice to compute znear and zfar of light frustum.
-        //Here,we have two method to decide znear and zfar.
-        //FIT_TO_SCENE: directly use scene AABB to compute znear and zfar.This method is enough for many cases.
-        //But in special case,such as the camera view is small but scene aabb is long,this will lead the light frustum has a large distance between znear and zfar.
-        //FIT_TO_CASCADE: use camera frustum slice and scene aabb to compute znear and zfar.This will get a tighter light frustum.
-        //for cascaded shadow map,this is a very important technology,since many slice will be smaller than scene aabb.
-
-        //We need to transform the corners of scene AABB to light space
-        auto SceneAABBWorldSpace = Scene::GetScene()->GetSceneBoundingBox();
-        DirectX::XMFLOAT3 AABBCornersWorldSpace[8];
-        SceneAABBWorldSpace.GetCorners(AABBCornersWorldSpace);
-        DirectX::XMVECTOR AABBCornerLightSpace[8];
-        for (int i = 0; i < 8; ++i)
-        {
-            AABBCornerLightSpace[i] = DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&AABBCornersWorldSpace[i]), m_pLight->GetLightViewMatrix());
-        }
-        //A simple method.
-        //We just compute the min and max of aabb in light space.
-        float zNear = 0.0f;
-        float zFar = 1000.0f;
-        if (m_SelectedCascadedNearFar == FIT_TO_NEAR_FAR::FIT_TO_SCENE_AABB)
-        {
-            DirectX::XMVECTOR MaxAABBCornersLightSpace = { -FLT_MAX,-FLT_MAX,-FLT_MAX,-FLT_MAX };
-            DirectX::XMVECTOR MinAABBCornersLightSpace = { FLT_MAX,FLT_MAX,FLT_MAX,FLT_MAX };
-            //compute min and max
+                float CascadedLength = DirectX::XMVectorGetX(Diagonal);
+                float WorldUnitsPerTexel = (CascadedLength / (float)m_Width);
+                WorldUnitsPerTexelVector = DirectX::XMVectorSet(WorldUnitsPerTexel, WorldUnitsPerTexel, 0.0f, 0.0f);
+            }
+            else//fllowing code , I can not understand.......
+            {
+                // We calculate a looser bound based on the size of the PCF blur.  This ensures us that we're 
+                // sampling within the correct map.
+                float fScaleDuetoBlureAMT = ((float)(m_FilterSize * 2 + 1)
+                    / (float)m_Width);
+                XMVECTORF32 vScaleDuetoBlureAMT = { fScaleDuetoBlureAMT, fScaleDuetoBlureAMT, 0.0f, 0.0f };
+
+                float fNormalizeByBufferSize = (1.0f / (float)m_Width);
+                XMVECTOR vNormalizeByBufferSize = DirectX::XMVectorSet(fNormalizeByBufferSize, fNormalizeByBufferSize, 0.0f, 0.0f);
+
+                // We calculate the offsets as a percentage of the bound.
+                XMVECTOR vBoarderOffset = FrustumSliceMaxLightSpace - FrustumSliceMinLightSpace;
+                vBoarderOffset *= gHalfVector;
+                vBoarderOffset *= vScaleDuetoBlureAMT;
+                FrustumSliceMaxLightSpace += vBoarderOffset;
+                FrustumSliceMinLightSpace -= vBoarderOffset;
+
+                // The world units per texel are used to snap  the orthographic projection
+                // to texel sized increments.  
+                // Because we're fitting tighly to the cascades, the shimmering shadow edges will still be present when the 
+                // camera rotates.  However, when zooming in or strafing the shadow edge will not shimmer.
+                WorldUnitsPerTexelVector = FrustumSliceMaxLightSpace - FrustumSliceMinLightSpace;
+                WorldUnitsPerTexelVector *= vNormalizeByBufferSize;
+            }
+            //Here we limit camera move footstep into one texel to solve shadows jitter.
+            //This is a matter of integer dividing by the world space size of a texel
+            FrustumSliceMinLightSpace /= WorldUnitsPerTexelVector;
+            FrustumSliceMinLightSpace = XMVectorFloor(FrustumSliceMinLightSpace);
+            FrustumSliceMinLightSpace *= WorldUnitsPerTexelVector;
+
+            FrustumSliceMaxLightSpace /= WorldUnitsPerTexelVector;
+            FrustumSliceMaxLightSpace = XMVectorFloor(FrustumSliceMaxLightSpace);
+            FrustumSliceMaxLightSpace *= WorldUnitsPerTexelVector;
+            //Finally,we can use scene AABB and frustum slice to compute znear and zfar of light frustum.
+            //Here,we have two method to decide znear and zfar.
+            //FIT_TO_SCENE: directly use scene AABB to compute znear and zfar.This method is enough for many cases.
+            //But in special case,such as the camera view is small but scene aabb is long,this will lead the light frustum has a large distance between znear and zfar.
+            //FIT_TO_CASCADE: use camera frustum slice and scene aabb to compute znear and zfar.This will get a tighter light frustum.
+            //for cascaded shadow map,this is a very important technology,since many slice will be smaller than scene aabb.
+
+            //We need to transform the corners of scene AABB to light space
+            DirectX::XMFLOAT3 AABBCornersWorldSpace[8];
+            SceneAABBWorldSpace.GetCorners(AABBCornersWorldSpace);
+            DirectX::XMVECTOR AABBCornerLightSpace[8];
             for (int i = 0; i < 8; ++i)
             {
-                MaxAABBCornersLightSpace = DirectX::XMVectorMax(MaxAABBCornersLightSpace, AABBCornerLightSpace[i]);
-                MinAABBCornersLightSpace = DirectX::XMVectorMin(MinAABBCornersLightSpace, AABBCornerLightSpace[i]);
+                AABBCornerLightSpace[i] = DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&AABBCornersWorldSpace[i]), WorldToLight);
             }
-            zNear = DirectX::XMVectorGetZ(MinAABBCornersLightSpace);
-            zFar = DirectX::XMVectorGetZ(MaxAABBCornersLightSpace);
-        }
-        //A better method to compute tighter frustum for light.
-        else if (m_SelectedCascadedNearFar == FIT_TO_NEAR_FAR::FIT_TO_CASCADE_AABB)
-        {
-            ComputeNearAndFar(zNear, zFar, FrustumSliceMinLightSpace, FrustumSliceMaxLightSpace, AABBCornerLightSpace);
+            //A simple method.
+            //We just compute the min and max of aabb in light space.
+            float zNear = 0.0f;
+            float zFar = 1000.0f;
+            if (m_SelectedCascadedNearFar == FIT_TO_NEAR_FAR::FIT_TO_SCENE_AABB)
+            {
+                DirectX::XMVECTOR MaxAABBCornersLightSpace = { -FLT_MAX,-FLT_MAX,-FLT_MAX,-FLT_MAX };
+                DirectX::XMVECTOR MinAABBCornersLightSpace = { FLT_MAX,FLT_MAX,FLT_MAX,FLT_MAX };
+                //compute min and max
+                for (int i = 0; i < 8; ++i)
+                {
+                    MaxAABBCornersLightSpace = DirectX::XMVectorMax(MaxAABBCornersLightSpace, AABBCornerLightSpace[i]);
+                    MinAABBCornersLightSpace = DirectX::XMVectorMin(MinAABBCornersLightSpace, AABBCornerLightSpace[i]);
+                }
+                zNear = DirectX::XMVectorGetZ(MinAABBCornersLightSpace);
+                zFar = DirectX::XMVectorGetZ(MaxAABBCornersLightSpace);
+            }
+            //A better method to compute tighter frustum for light.
+            else if (m_SelectedCascadedNearFar == FIT_TO_NEAR_FAR::FIT_TO_CASCADE_AABB)
+            {
+                ComputeNearAndFar(zNear, zFar, FrustumSliceMinLightSpace, FrustumSliceMaxLightSpace, AABBCornerLightSpace);
+            }
+            //Until now,we get all parameter for light frustum,we can compute light frustum.
+            m_CascadedCameras[i]->SetLens(
+                DirectX::XMVectorGetX(FrustumSliceMinLightSpace),
+                DirectX::XMVectorGetX(FrustumSliceMaxLightSpace),
+                DirectX::XMVectorGetY(FrustumSliceMinLightSpace),
+                DirectX::XMVectorGetY(FrustumSliceMaxLightSpace),
+                zNear,
+                zFar);
         }
-        //Until now,we get all parameter for light frustum,we can compute light frustum.
-        m_CascadedCameras[i]->SetLens(
-            DirectX::XMVectorGetX(FrustumSliceMinLightSpace),
-            DirectX::XMVectorGetX(FrustumSliceMaxLightSpace),
-            DirectX::XMVectorGetY(FrustumSliceMinLightSpace),
-            DirectX::XMVectorGetY(FrustumSliceMaxLightSpace),
-            zNear,
-            zFar);
-    }
+    });
 }
 
 void CascadedVarianceShadow::GetFrustumPointsViewSpaceFromInterval(
@@ -0,0 +1,330 @@
+#include "TLSFAllocator.h"
+
+#include <cassert>
+#include <cstring>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+    uint32_t HighestBit(uint64_t Value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, Value);
+        return static_cast<uint32_t>(index);
+#else
+        return 63u - static_cast<uint32_t>(__builtin_clzll(Value));
+#endif
+    }
+
+    uint32_t LowestBit(uint64_t Value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, Value);
+        return static_cast<uint32_t>(index);
+#else
+        return static_cast<uint32_t>(__builtin_ctzll(Value));
+#endif
+    }
+
+    uint64_t AlignUp(uint64_t Value, uint64_t Alignment)
+    {
+        return (Value + Alignment - 1) & ~(Alignment - 1);
+    }
+}
+
+TLSFAllocator::TLSFAllocator(uint64_t Size, uint64_t MinBlockSize)
+    : m_Size(AlignUp(Size, MinBlockSize))
+    , m_MinBlockSize(MinBlockSize)
+    , m_UsedSize(0)
+    , m_NumAllocations(0)
+    , m_FirstLevelBitmap(0)
+    , m_Blocks(static_cast<size_t>(AlignUp(Size, MinBlockSize) / MinBlockSize))
+{
+    assert(Size > 0 && "Error!TLSF allocator can not manage an empty range!");
+    assert((MinBlockSize & (MinBlockSize - 1)) == 0 && "Error!Min block size must be a power of 2!");
+    Reset();
+}
+
+TLSFAllocator::~TLSFAllocator()
+{}
+
+void TLSFAllocator::Reset()
+{
+    m_UsedSize = 0;
+    m_NumAllocations = 0;
+    m_FirstLevelBitmap = 0;
+    std::memset(m_SecondLevelBitmap, 0, sizeof(m_SecondLevelBitmap));
+    std::memset(m_FreeLists, 0, sizeof(m_FreeLists));
+
+    Block* pBlock = GetBlock(0);
+    *pBlock = Block{ 0, m_Size, nullptr, nullptr, nullptr, true, false };
+    InsertFreeBlock(pBlock);
+}
+
+uint64_t TLSFAllocator::Allocate(uint64_t Size, uint64_t Alignment)
+{
+    assert(Size > 0 && "Error!Can not allocate 0 byte!");
+    assert(Alignment > 0 && (Alignment & (Alignment - 1)) == 0 && "Error!Alignment must be a power of 2!");
+    Size = AlignUp(Size, m_MinBlockSize);
+    //every offset is aligned to min block size already
+    if (Alignment < m_MinBlockSize)
+    {
+        Alignment = m_MinBlockSize;
+    }
+
+    //Firstly try the list of Size,whose first block may be aligned already.
+    //If it is not,search again for a size which fits any offset after aligning.
+    Block* pBlock = nullptr;
+    for (int attempt = 0; attempt < 2 && !pBlock; ++attempt)
+    {
+        uint64_t requestSize = attempt == 0 ? Size : Size + Alignment - 1;
+        if (requestSize < Size || requestSize > m_Size)
+        {
+            break;
+        }
+        //round up to next class,so that every block in the found list is big enough.
+        if (requestSize >= SmallBlockSize)
+        {
+            uint64_t round = (1ull << (HighestBit(requestSize) - SecondLevelBits)) - 1;
+            if (requestSize + round < requestSize)
+            {
+                break;
+            }
+            requestSize += round;
+        }
+        uint32_t firstLevel, secondLevel;
+        Mapping(requestSize, firstLevel, secondLevel);
+        Block* pCandidate = FindSuitableBlock(firstLevel, secondLevel);
+        if (pCandidate && AlignUp(pCandidate->Offset, Alignment) + Size <= pCandidate->Offset + pCandidate->Size)
+        {
+            pBlock = pCandidate;
+        }
+        if (Alignment == m_MinBlockSize)
+        {
+            break;
+        }
+    }
+    if (!pBlock)
+    {
+        return InvalidOffset;
+    }
+
+    RemoveFreeBlock(pBlock);
+    //the front of block which is skipped by alignment is still free
+    uint64_t padding = AlignUp(pBlock->Offset, Alignment) - pBlock->Offset;
+    if (padding > 0)
+    {
+        SplitBlock(pBlock, padding);
+        Block* pAligned = GetNextPhysical(pBlock);
+        InsertFreeBlock(pBlock);
+        pBlock = pAligned;
+    }
+    if (pBlock->Size > Size)
+    {
+        SplitBlock(pBlock, Size);
+        InsertFreeBlock(GetNextPhysical(pBlock));
+    }
+
+    pBlock->bFree = false;
+    pBlock->bAllocated = true;
+    m_UsedSize += pBlock->Size;
+    ++m_NumAllocations;
+    return pBlock->Offset;
+}
+
+bool TLSFAllocator::HasSpace(uint64_t Size)const
+{
+    Size = AlignUp(Size, m_MinBlockSize);
+    if (Size == 0 || Size > m_Size - m_UsedSize)
+    {
+        return false;
+    }
+    if (Size >= SmallBlockSize)
+    {
+        Size += (1ull << (HighestBit(Size) - SecondLevelBits)) - 1;
+    }
+    uint32_t firstLevel, secondLevel;
+    Mapping(Size, firstLevel, secondLevel);
+    return FindSuitableBlock(firstLevel, secondLevel) != nullptr;
+}
+
+void TLSFAllocator::Free(uint64_t Offset)
+{
+    assert(Offset < m_Size && Offset % m_MinBlockSize == 0 && "Error!The offset is not allocated by this allocator!");
+    Block* pBlock = GetBlock(Offset);
+    assert(pBlock->bAllocated && "Error!The offset is not allocated by this allocator!");
+
+    pBlock->bFree = true;
+    pBlock->bAllocated = false;
+    m_UsedSize -= pBlock->Size;
+    --m_NumAllocations;
+
+    Block* pNext = GetNextPhysical(pBlock);
+    if (pNext && pNext->bFree)
+    {
+        RemoveFreeBlock(pNext);
+        MergeWithNext(pBlock);
+    }
+    if (pBlock->pPrevPhysical && pBlock->pPrevPhysical->bFree)
+    {
+        Block* pPrev = pBlock->pPrevPhysical;
+        RemoveFreeBlock(pPrev);
+        MergeWithNext(pPrev);
+        pBlock = pPrev;
+    }
+    InsertFreeBlock(pBlock);
+}
+
+TLSFStatistics TLSFAllocator::GetStatistics()const
+{
+    TLSFStatistics statistics;
+    statistics.TotalSize = m_Size;
+    statistics.UsedSize = m_UsedSize;
+    statistics.FreeSize = m_Size - m_UsedSize;
+    statistics.NumAllocations = m_NumAllocations;
+
+    uint64_t firstLevelBitmap = m_FirstLevelBitmap;
+    while (firstLevelBitmap)
+    {
+        uint32_t firstLevel = LowestBit(firstLevelBitmap);
+        firstLevelBitmap &= firstLevelBitmap - 1;
+        uint64_t secondLevelBitmap = m_SecondLevelBitmap[firstLevel];
+        while (secondLevelBitmap)
+        {
+            uint32_t secondLevel = LowestBit(secondLevelBitmap);
+            secondLevelBitmap &= secondLevelBitmap - 1;
+            for (Block* pBlock = m_FreeLists[firstLevel][secondLevel]; pBlock; pBlock = pBlock->pNextFree)
+            {
+                ++statistics.NumFreeBlocks;
+                if (pBlock->Size > statistics.LargestFreeBlock)
+                {
+                    statistics.LargestFreeBlock = pBlock->Size;
+                }
+            }
+        }
+    }
+    return statistics;
+}
+
+void TLSFAllocator::Mapping(uint64_t Size, uint32_t& FirstLevel, uint32_t& SecondLevel)
+{
+    if (Size < SmallBlockSize)
+    {
+        FirstLevel = 0;
+        SecondLevel = static_cast<uint32_t>(Size);
+    }
+    else
+    {
+        uint32_t highestBit = HighestBit(Size);
+        SecondLevel = static_cast<uint32_t>(Size >> (highestBit - SecondLevelBits)) ^ SecondLevelCount;
+        FirstLevel = highestBit - SecondLevelBits + 1;
+    }
+}
+
+TLSFAllocator::Block* TLSFAllocator::FindSuitableBlock(uint32_t& FirstLevel, uint32_t& SecondLevel)const
+{
+    uint32_t secondLevelBitmap = m_SecondLevelBitmap[FirstLevel] & (~0u << SecondLevel);
+    if (!secondLevelBitmap)
+    {
+        //no block in this first level is big enough,so take the smallest bigger first level.
+        uint64_t firstLevelBitmap = FirstLevel + 1 < 64 ? m_FirstLevelBitmap & (~0ull << (FirstLevel + 1)) : 0;
+        if (!firstLevelBitmap)
+        {
+            return nullptr;
+        }
+        FirstLevel = LowestBit(firstLevelBitmap);
+        secondLevelBitmap = m_SecondLevelBitmap[FirstLevel];
+    }
+    SecondLevel = LowestBit(secondLevelBitmap);
+    return m_FreeLists[FirstLevel][SecondLevel];
+}
+
+void TLSFAllocator::InsertFreeBlock(Block* pBlock)
+{
+    uint32_t firstLevel, secondLevel;
+    Mapping(pBlock->Size, firstLevel, secondLevel);
+
+    Block* pHead = m_FreeLists[firstLevel][secondLevel];
+    pBlock->bFree = true;
+    pBlock->pPrevFree = nullptr;
+    pBlock->pNextFree = pHead;
+    if (pHead)
+    {
+        pHead->pPrevFree = pBlock;
+    }
+    m_FreeLists[firstLevel][secondLevel] = pBlock;
+
+    m_FirstLevelBitmap |= 1ull << firstLevel;
+    m_SecondLevelBitmap[firstLevel] |= 1u << secondLevel;
+}
+
+void TLSFAllocator::RemoveFreeBlock(Block* pBlock)
+{
+    uint32_t firstLevel, secondLevel;
+    Mapping(pBlock->Size, firstLevel, secondLevel);
+
+    if (pBlock->pPrevFree)
+    {
+        pBlock->pPrevFree->pNextFree = pBlock->pNextFree;
+    }
+    else
+    {
+        m_FreeLists[firstLevel][secondLevel] = pBlock->pNextFree;
+    }
+    if (pBlock->pNextFree)
+    {
+        pBlock->pNextFree->pPrevFree = pBlock->pPrevFree;
+    }
+    pBlock->pPrevFree = nullptr;
+    pBlock->pNextFree = nullptr;
+
+    if (!m_FreeLists[firstLevel][secondLevel])
+    {
+        m_SecondLevelBitmap[firstLevel] &= ~(1u << secondLevel);
+        if (!m_SecondLevelBitmap[firstLevel])
+        {
+            m_FirstLevelBitmap &= ~(1ull << firstLevel);
+        }
+    }
+}
+
+void TLSFAllocator::SplitBlock(Block* pBlock, uint64_t Size)
+{
+    assert(pBlock->Size > Size && "Error!The block is too small to split!");
+
+    Block* pNext = GetNextPhysical(pBlock);
+    Block* pRest = GetBlock(pBlock->Offset + Size);
+    *pRest = Block{ pBlock->Offset + Size, pBlock->Size - Size, pBlock, nullptr, nullptr, true, false };
+    if (pNext)
+    {
+        pNext->pPrevPhysical = pRest;
+    }
+    pBlock->Size = Size;
+}
+
+void TLSFAllocator::MergeWithNext(Block* pBlock)
+{
+    Block* pNext = GetNextPhysical(pBlock);
+    Block* pNextNext = GetNextPhysical(pNext);
+    pBlock->Size += pNext->Size;
+    if (pNextNext)
+    {
+        pNextNext->pPrevPhysical = pBlock;
+    }
+    pNext->bFree = false;
+}
+
+TLSFAllocator::Block* TLSFAllocator::GetBlock(uint64_t Offset)
+{
+    return &m_Blocks[static_cast<size_t>(Offset / m_MinBlockSize)];
+}
+
+TLSFAllocator::Block* TLSFAllocator::GetNextPhysical(Block* pBlock)
+{
+    uint64_t nextOffset = pBlock->Offset + pBlock->Size;
+    return nextOffset < m_Size ? GetBlock(nextOffset) : nullptr;
+}
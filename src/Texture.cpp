@@ -2,6 +2,9 @@
 #include "Application.h"
 #include "DescriptorAllocator.h"
 #include "ResourceStateTracker.h"
+#include "ResourceHeapAllocator.h"
+#include "BindlessDescriptorHeap.h"
+#include "ViewCache.h"
 
 Texture::Texture(TextureUsage textureUsage /* = TextureUsage::Albedo */, std::wstring textureName /* = "NoName" */)
     :Resource(textureName)
@@ -109,12 +112,13 @@ void Texture::CreateView()
             m_DescriptorAllocation = Application::GetApp()->AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 1);
             device->CreateDepthStencilView(m_d3d12Resource.Get(), nullptr, m_DescriptorAllocation.GetDescriptorHandle());
         }
-        //-----------------------------------------------------------------
-        std::lock_guard<std::mutex> lock(m_ShderResourceViewsMutex);
-        std::lock_guard<std::mutex> guard(m_UnorderedAccessViewMutex);
-        //-----------------------------------------------------------------
-        m_ShaderResourceViewMap.clear();
-        m_UnorderedAccessViewMap.clear();
+        //In bindless mode,textures which are only sampled get their persistent index at creation.
+        //Render targets and depth stencils are copied often,so they get it when it is used at first time.
+        auto noBindlessFlags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL | D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE;
+        if (Application::GetApp()->GetBindlessDescriptorHeap() && (flag & noBindlessFlags) == 0)
+        {
+            GetBindlessIndex();
+        }
     }
 }
 
@@ -131,62 +135,16 @@ D3D12_CPU_DESCRIPTOR_HANDLE Texture::GetDepthStencilView()const
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE Texture::GetShaderResourceView(const D3D12_SHADER_RESOURCE_VIEW_DESC* SrvDesc)const
-{
-    UINT hash = 0;
-    if (SrvDesc)
-    {
-        hash = std::hash<D3D12_SHADER_RESOURCE_VIEW_DESC>{}(*SrvDesc);
-    }
-    //--------------------------------------------------------------
-    std::lock_guard<std::mutex> lock(m_ShderResourceViewsMutex);
-    //--------------------------------------------------------------
-    auto iter = m_ShaderResourceViewMap.find(hash);
-    if (iter == m_ShaderResourceViewMap.end())
-    {
-        auto allocation = CreateShaderResourceView(SrvDesc);
-        iter = m_ShaderResourceViewMap.insert({ hash,std::move(allocation) }).first;
-    }
-
-    return iter->second.GetDescriptorHandle();
-}
-
-D3D12_CPU_DESCRIPTOR_HANDLE Texture::GetUnorderedAccessView(const D3D12_UNORDERED_ACCESS_VIEW_DESC* UavDesc)const
-{
-    UINT hash = 0;
-    if (UavDesc)
-    {
-        hash = std::hash<D3D12_UNORDERED_ACCESS_VIEW_DESC>{}(*UavDesc);
-    }
-    //------------------------------------------------------------------
-    std::lock_guard<std::mutex> guard(m_UnorderedAccessViewMutex);
-    //------------------------------------------------------------------
-    auto iter = m_UnorderedAccessViewMap.find(hash);
-    if (iter == m_UnorderedAccessViewMap.end())
-    {
-        auto allocation = CreateUnorderedAccessView(UavDesc);
-        iter = m_UnorderedAccessViewMap.insert({ hash,std::move(allocation) }).first;
-    }
-    return iter->second.GetDescriptorHandle();
-}
-
-DescriptorAllocation Texture::CreateShaderResourceView(const D3D12_SHADER_RESOURCE_VIEW_DESC* SrvDesc /* = nullptr */)const
 {
     assert(m_d3d12Resource && "Resource has been released!");
-
-    auto device = Application::GetApp()->GetDevice();
-    auto allocation = Application::GetApp()->AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
-    device->CreateShaderResourceView(m_d3d12Resource.Get(), SrvDesc, allocation.GetDescriptorHandle());
-    return allocation;
+    //views are shared by all textures which reference the same d3d12 resource.
+    return Application::GetApp()->GetViewCache()->GetShaderResourceView(m_d3d12Resource.Get(), SrvDesc);
 }
 
-DescriptorAllocation Texture::CreateUnorderedAccessView(const D3D12_UNORDERED_ACCESS_VIEW_DESC* UavDesc /* = nullptr */)const
+D3D12_CPU_DESCRIPTOR_HANDLE Texture::GetUnorderedAccessView(const D3D12_UNORDERED_ACCESS_VIEW_DESC* UavDesc)const
 {
     assert(m_d3d12Resource && "Resource has been released!");
-
-    auto device = Application::GetApp()->GetDevice();
-    auto allocation = Application::GetApp()->AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
-    device->CreateUnorderedAccessView(m_d3d12Resource.Get(), nullptr, UavDesc, allocation.GetDescriptorHandle());
-    return allocation;
+    return Application::GetApp()->GetViewCache()->GetUnorderedAccessView(m_d3d12Resource.Get(), UavDesc);
 }
 
 void Texture::Resize(UINT Width, UINT Height)
@@ -197,21 +155,17 @@ void Texture::Resize(UINT Width, UINT Height)
         if (resourceDesc.Width != Width || resourceDesc.Height != Height)
         {
             ResourceStateTracker::RemoveGlobalResourceState(m_d3d12Resource.Get());
-            m_d3d12Resource.Reset();
+            RetireD3D12Resource();
 
             D3D12_RESOURCE_DESC newDesc = resourceDesc;
             newDesc.Width = Width;
             newDesc.Height = Height;
 
-            auto device = Application::GetApp()->GetDevice();
-            ThrowIfFailed(device->CreateCommittedResource(
-                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-                D3D12_HEAP_FLAG_NONE,
-                &newDesc,
+            m_d3d12Resource = Application::GetApp()->GetResourceHeapAllocator()->CreateResource(
+                newDesc,
                 D3D12_RESOURCE_STATE_COMMON,
-                m_d3d12ClearValue.get(),
-                IID_PPV_ARGS(&m_d3d12Resource)));
-            ResourceStateTracker::AddGlobalResourceState(m_d3d12Resource.Get(), D3D12_RESOURCE_STATE_COMMON);
+                m_d3d12ClearValue.get());
+            m_pGlobalState = ResourceStateTracker::AddGlobalResourceState(m_d3d12Resource.Get(), D3D12_RESOURCE_STATE_COMMON);
 
             CreateView();
         }
@@ -226,20 +180,16 @@ void Texture::ResetFormat(DXGI_FORMAT Format)
         if (resourceDesc.Format != Format)
         {
             ResourceStateTracker::RemoveGlobalResourceState(m_d3d12Resource.Get());
-            m_d3d12Resource.Reset();
+            RetireD3D12Resource();
 
             D3D12_RESOURCE_DESC newDesc = resourceDesc;
             resourceDesc.Format = Format;
 
-            auto device = Application::GetApp()->GetDevice();
-            ThrowIfFailed(device->CreateCommittedResource(
-                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-                D3D12_HEAP_FLAG_NONE,
-                &newDesc,
+            m_d3d12Resource = Application::GetApp()->GetResourceHeapAllocator()->CreateResource(
+                newDesc,
                 D3D12_RESOURCE_STATE_COMMON,
-                m_d3d12ClearValue.get(),
-                IID_PPV_ARGS(&m_d3d12Resource)));
-            ResourceStateTracker::AddGlobalResourceState(m_d3d12Resource.Get(), D3D12_RESOURCE_STATE_COMMON);
+                m_d3d12ClearValue.get());
+            m_pGlobalState = ResourceStateTracker::AddGlobalResourceState(m_d3d12Resource.Get(), D3D12_RESOURCE_STATE_COMMON);
 
             CreateView();
         }
@@ -2,118 +2,71 @@
 #include "Application.h"
 #include "d3dUtil.h"
 
-UploadBuffer::UploadBuffer(size_t pageSize)
-    : m_PageSize(pageSize)
+UploadBuffer::UploadBuffer()
+    : m_pRingBuffer(Application::GetApp()->GetUploadRingBuffer())
+    , m_Offset(0)
 {}
 
 UploadBuffer::~UploadBuffer()
-{}
+{
+    Reset();
+}
 
 UploadBuffer::Allocation UploadBuffer::Allocate(size_t sizeInBytes, size_t alignment)
 {
-    if (sizeInBytes > m_PageSize)
+    size_t alignedSize = Math::AlignUp(sizeInBytes, alignment);
+    size_t chunkSize = m_pRingBuffer->GetChunkSize();
+
+    Allocation allocation;
+    //too big for a chunk,so it gets its own upload buffer.
+    if (alignedSize > chunkSize)
     {
-        throw std::bad_alloc();
+        auto spill = m_pRingBuffer->AllocateSpill(alignedSize);
+        m_Spills.push_back(spill);
+        allocation.CPU = spill.CPU;
+        allocation.GPU = spill.GPU;
+        allocation.Resource = spill.Resource.Get();
+        allocation.Offset = 0;
+        return allocation;
     }
 
-    // If there is no current page, or the requested allocation exceeds the
-    // remaining space in the current page, request a new page.
-    if (!m_CurrentPage || !m_CurrentPage->HasSpace(sizeInBytes, alignment))
+    size_t alignedOffset = Math::AlignUp(m_Offset, alignment);
+    // If there is no current chunk, or the requested allocation exceeds the
+    // remaining space in the current chunk, request a new chunk.
+    if (m_Chunks.empty() || alignedOffset + alignedSize > chunkSize)
     {
-        m_CurrentPage = RequestPage();
+        if (!m_Chunks.empty())
+        {
+            m_pRingBuffer->AddUsage(0, chunkSize - m_Offset);
+        }
+        m_Chunks.push_back(m_pRingBuffer->RequestChunk());
+        m_Offset = 0;
+        alignedOffset = 0;
     }
 
-    return m_CurrentPage->Allocate(sizeInBytes, alignment);
-}
+    const auto& chunk = m_Chunks.back();
+    allocation.CPU = chunk.CPU + alignedOffset;
+    allocation.GPU = chunk.GPU + alignedOffset;
+    allocation.Resource = chunk.pResource;
+    allocation.Offset = chunk.Offset + alignedOffset;
 
-std::shared_ptr<UploadBuffer::Page> UploadBuffer::RequestPage()
-{
-    std::shared_ptr<Page> page;
+    m_pRingBuffer->AddUsage(sizeInBytes, alignedOffset - m_Offset + alignedSize - sizeInBytes);
+    m_Offset = alignedOffset + alignedSize;
 
-    if (!m_AvailablePages.empty())
-    {
-        page = m_AvailablePages.front();
-        m_AvailablePages.pop_front();
-    }
-    else
-    {
-        page = std::make_shared<Page>(m_PageSize);
-        m_PagePool.push_back(page);
-    }
-
-    return page;
+    return allocation;
 }
 
 void UploadBuffer::Reset()
 {
-    m_CurrentPage = nullptr;
-    // Reset all available pages.
-    m_AvailablePages = m_PagePool;
-
-    for ( auto page : m_AvailablePages )
+    for (const auto& chunk : m_Chunks)
     {
-        // Reset the page for new allocations.
-        page->Reset();
+        m_pRingBuffer->RetireChunk(chunk);
     }
-}
-
-UploadBuffer::Page::Page(size_t sizeInBytes)
-    : m_PageSize(sizeInBytes)
-    , m_Offset(0)
-    , m_CPUPtr(nullptr)
-    , m_GPUPtr(D3D12_GPU_VIRTUAL_ADDRESS(0))
-{
-    auto device = Application::GetApp()->GetDevice();
-
-    ThrowIfFailed(device->CreateCommittedResource(
-        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-        D3D12_HEAP_FLAG_NONE,
-        &CD3DX12_RESOURCE_DESC::Buffer(m_PageSize),
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        nullptr,
-        IID_PPV_ARGS(&m_d3d12Resource)
-    ));
-
-    m_GPUPtr = m_d3d12Resource->GetGPUVirtualAddress();
-    m_d3d12Resource->Map(0, nullptr, &m_CPUPtr);
-}
-
-UploadBuffer::Page::~Page()
-{
-    m_d3d12Resource->Unmap(0, nullptr);
-    m_CPUPtr = nullptr;
-    m_GPUPtr = D3D12_GPU_VIRTUAL_ADDRESS(0);
-}
-
-bool UploadBuffer::Page::HasSpace(size_t sizeInBytes, size_t alignment ) const
-{
-    size_t alignedSize = Math::AlignUp(sizeInBytes, alignment);
-    size_t alignedOffset = Math::AlignUp(m_Offset, alignment);
-
-    return alignedOffset + alignedSize <= m_PageSize;
-}
-
-UploadBuffer::Allocation UploadBuffer::Page::Allocate(size_t sizeInBytes, size_t alignment)
-{
-    if (!HasSpace(sizeInBytes, alignment))
+    for (const auto& spill : m_Spills)
     {
-        // Can't allocate space from page.
-        throw std::bad_alloc();
+        m_pRingBuffer->RetireSpill(spill);
     }
-
-    size_t alignedSize = Math::AlignUp(sizeInBytes, alignment);
-    m_Offset = Math::AlignUp(m_Offset, alignment);
-
-    Allocation allocation;
-    allocation.CPU = static_cast<uint8_t*>(m_CPUPtr) + m_Offset;
-    allocation.GPU = m_GPUPtr + m_Offset;
-
-    m_Offset += alignedSize;
-
-    return allocation;
-}
-
-void UploadBuffer::Page::Reset()
-{
+    m_Chunks.clear();
+    m_Spills.clear();
     m_Offset = 0;
-}
\ No newline at end of file
+}
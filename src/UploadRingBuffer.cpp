@@ -0,0 +1,223 @@
+#include "UploadRingBuffer.h"
+#include "Application.h"
+
+#include <algorithm>
+#include <cassert>
+
+UploadRingBuffer::UploadRingBuffer(size_t HeapSize, size_t ChunkSize, UINT TrimInterval)
+    : m_HeapSize(HeapSize)
+    , m_ChunkSize(ChunkSize)
+    , m_NumChunksPerHeap(HeapSize / ChunkSize)
+    , m_TrimInterval(TrimInterval)
+    , m_NumFramesSinceTrim(0)
+    , m_NumOccupiedChunks(0)
+    , m_PooledSpillBytes(0)
+    , m_FrameIndex(0)
+    , m_TrimHighWaterChunks(0)
+    , m_BytesUsed(0)
+    , m_BytesWasted(0)
+    , m_Spills(0)
+    , m_SpillsReused(0)
+    , m_SpillBytes(0)
+    , m_ChunksRequested(0)
+    , m_FrameHighWaterChunks(0)
+{
+    assert(ChunkSize > 0 && HeapSize % ChunkSize == 0 && "Error!Chunk size must divide heap size!");
+}
+
+UploadRingBuffer::~UploadRingBuffer()
+{}
+
+UploadRingBuffer::Chunk UploadRingBuffer::RequestChunk()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    size_t heapIndex = 0;
+    while (heapIndex < m_Heaps.size() && m_Heaps[heapIndex]->m_NumOccupied == m_NumChunksPerHeap)
+    {
+        ++heapIndex;
+    }
+    //all heaps are full
+    if (heapIndex == m_Heaps.size())
+    {
+        m_Heaps.push_back(std::make_unique<Heap>(m_HeapSize, m_NumChunksPerHeap));
+    }
+
+    auto& heap = *m_Heaps[heapIndex];
+    Chunk chunk;
+    chunk.HeapIndex = heapIndex;
+    chunk.ChunkIndex = heap.m_Head;
+    chunk.Offset = heap.m_Head * m_ChunkSize;
+    chunk.CPU = heap.m_CPUPtr + chunk.Offset;
+    chunk.GPU = heap.m_GPUPtr + chunk.Offset;
+    chunk.pResource = heap.m_d3d12Resource.Get();
+
+    heap.m_Head = (heap.m_Head + 1) % m_NumChunksPerHeap;
+    ++heap.m_NumOccupied;
+
+    ++m_NumOccupiedChunks;
+    ++m_ChunksRequested;
+    m_FrameHighWaterChunks = (std::max)(m_FrameHighWaterChunks, m_NumOccupiedChunks);
+    m_TrimHighWaterChunks = (std::max)(m_TrimHighWaterChunks, m_NumOccupiedChunks);
+
+    return chunk;
+}
+
+void UploadRingBuffer::RetireChunk(const Chunk& chunk)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    assert(chunk.HeapIndex < m_Heaps.size() && "Error!The chunk does not belong to this ring buffer!");
+    auto& heap = *m_Heaps[chunk.HeapIndex];
+    heap.m_Retired[chunk.ChunkIndex] = true;
+    //command lists finish in any order,the tail only moves over retired chunks.
+    while (heap.m_NumOccupied > 0 && heap.m_Retired[heap.m_Tail])
+    {
+        heap.m_Retired[heap.m_Tail] = false;
+        heap.m_Tail = (heap.m_Tail + 1) % m_NumChunksPerHeap;
+        --heap.m_NumOccupied;
+        --m_NumOccupiedChunks;
+    }
+}
+
+UploadRingBuffer::Spill UploadRingBuffer::AllocateSpill(size_t SizeInBytes)
+{
+    m_Spills.fetch_add(1, std::memory_order_relaxed);
+    m_SpillBytes.fetch_add(SizeInBytes, std::memory_order_relaxed);
+
+    //round up to a power of 2,so that spills of similar sizes can reuse each other.
+    size_t spillSize = m_ChunkSize;
+    while (spillSize < SizeInBytes)
+    {
+        spillSize <<= 1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto iter = m_PooledSpills.find(spillSize);
+        if (iter != m_PooledSpills.end())
+        {
+            Spill spill = iter->second.first;
+            m_PooledSpills.erase(iter);
+            m_PooledSpillBytes -= spillSize;
+            m_SpillsReused.fetch_add(1, std::memory_order_relaxed);
+            return spill;
+        }
+    }
+
+    auto device = Application::GetApp()->GetDevice();
+
+    Spill spill;
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+    auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(spillSize);
+    ThrowIfFailed(device->CreateCommittedResource(
+        &heapProperties,
+        D3D12_HEAP_FLAG_NONE,
+        &resourceDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&spill.Resource)));
+
+    spill.GPU = spill.Resource->GetGPUVirtualAddress();
+    spill.Size = spillSize;
+    //spills stay mapped in the pool like heaps
+    ThrowIfFailed(spill.Resource->Map(0, nullptr, &spill.CPU));
+
+    return spill;
+}
+
+void UploadRingBuffer::RetireSpill(const Spill& spill)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_PooledSpills.emplace(spill.Size, std::make_pair(spill, m_FrameIndex));
+    m_PooledSpillBytes += spill.Size;
+}
+
+void UploadRingBuffer::AddUsage(size_t BytesUsed, size_t BytesWasted)
+{
+    m_BytesUsed.fetch_add(BytesUsed, std::memory_order_relaxed);
+    m_BytesWasted.fetch_add(BytesWasted, std::memory_order_relaxed);
+}
+
+void UploadRingBuffer::EndFrame()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_FrameStatistics.BytesUsed = m_BytesUsed.exchange(0, std::memory_order_relaxed);
+    m_FrameStatistics.BytesWasted = m_BytesWasted.exchange(0, std::memory_order_relaxed);
+    m_FrameStatistics.Spills = m_Spills.exchange(0, std::memory_order_relaxed);
+    m_FrameStatistics.SpillsReused = m_SpillsReused.exchange(0, std::memory_order_relaxed);
+    m_FrameStatistics.SpillBytes = m_SpillBytes.exchange(0, std::memory_order_relaxed);
+    m_FrameStatistics.PooledSpillBytes = m_PooledSpillBytes;
+    m_FrameStatistics.ChunksRequested = m_ChunksRequested;
+    m_FrameStatistics.HighWaterChunks = m_FrameHighWaterChunks;
+    m_FrameStatistics.NumHeaps = m_Heaps.size();
+    m_ChunksRequested = 0;
+    m_FrameHighWaterChunks = m_NumOccupiedChunks;
+    ++m_FrameIndex;
+
+    if (++m_NumFramesSinceTrim < m_TrimInterval)
+    {
+        return;
+    }
+    //keep enough heaps for the worst frame since last trim,and release empty heaps over it.
+    //Only heaps at the end are released,so heap index of chunks in flight does not change.
+    size_t numNeededHeaps = (std::max<size_t>)(1, (m_TrimHighWaterChunks + m_NumChunksPerHeap - 1) / m_NumChunksPerHeap);
+    while (m_Heaps.size() > numNeededHeaps && m_Heaps.back()->m_NumOccupied == 0)
+    {
+        m_Heaps.pop_back();
+    }
+    //spills which are not reused since last trim are released
+    for (auto iter = m_PooledSpills.begin(); iter != m_PooledSpills.end();)
+    {
+        if (iter->second.second + m_TrimInterval <= m_FrameIndex)
+        {
+            iter->second.first.Resource->Unmap(0, nullptr);
+            m_PooledSpillBytes -= iter->first;
+            iter = m_PooledSpills.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+    m_NumFramesSinceTrim = 0;
+    m_TrimHighWaterChunks = m_NumOccupiedChunks;
+}
+
+UploadRingBufferStatistics UploadRingBuffer::GetFrameStatistics()const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_FrameStatistics;
+}
+
+UploadRingBuffer::Heap::Heap(size_t HeapSize, size_t NumChunks)
+    : m_CPUPtr(nullptr)
+    , m_GPUPtr(D3D12_GPU_VIRTUAL_ADDRESS(0))
+    , m_Head(0)
+    , m_Tail(0)
+    , m_NumOccupied(0)
+    , m_Retired(NumChunks, false)
+{
+    auto device = Application::GetApp()->GetDevice();
+
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+    auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(HeapSize);
+    ThrowIfFailed(device->CreateCommittedResource(
+        &heapProperties,
+        D3D12_HEAP_FLAG_NONE,
+        &resourceDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&m_d3d12Resource)));
+
+    m_GPUPtr = m_d3d12Resource->GetGPUVirtualAddress();
+    //upload heaps can stay mapped during their whole life
+    ThrowIfFailed(m_d3d12Resource->Map(0, nullptr, reinterpret_cast<void**>(&m_CPUPtr)));
+}
+
+UploadRingBuffer::Heap::~Heap()
+{
+    m_d3d12Resource->Unmap(0, nullptr);
+    m_CPUPtr = nullptr;
+    m_GPUPtr = D3D12_GPU_VIRTUAL_ADDRESS(0);
+}
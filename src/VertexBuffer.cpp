@@ -1,4 +1,5 @@
 #include "VertexBuffer.h"
+#include <stdexcept>
 
 VertexBuffer::VertexBuffer(const std::wstring& vertexName)
     :Buffer(vertexName)
@@ -27,11 +28,11 @@ void VertexBuffer::SetD3D12Resource(Microsoft::WRL::ComPtr<ID3D12Resource>& d3d1
 
 D3D12_CPU_DESCRIPTOR_HANDLE VertexBuffer::GetShaderResourceView(const D3D12_SHADER_RESOURCE_VIEW_DESC* SrvDesc)const
 {
-    throw std::exception("Error! Vertex buffer does not have shader resource view");
+    throw std::runtime_error("Error! Vertex buffer does not have shader resource view");
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE VertexBuffer::GetUnorderedAccessView(const D3D12_UNORDERED_ACCESS_VIEW_DESC* UavDesc)const
 {
-    throw std::exception("Error! Vertex buffer does not have unordered access view");
+    throw std::runtime_error("Error! Vertex buffer does not have unordered access view");
 }
 
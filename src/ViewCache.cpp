@@ -0,0 +1,367 @@
+#include "ViewCache.h"
+#include "d3dUtil.h"
+#include "Application.h"
+#include "BindlessDescriptorHeap.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+
+namespace
+{
+    //private data of a resource which evicts its views
+    // {3B8E5D71-0C4A-4F2E-B6D9-52A1E7C0F84B}
+    const GUID gs_ViewCacheEvictorGuid = { 0x3b8e5d71, 0x0c4a, 0x4f2e, { 0xb6, 0xd9, 0x52, 0xa1, 0xe7, 0xc0, 0xf8, 0x4b } };
+}
+
+//It is attached to a resource by SetPrivateDataInterface(),
+//so it is destroyed with the resource and evicts views of the resource.
+class ViewCacheEvictor : public IUnknown
+{
+public:
+    ViewCacheEvictor(std::weak_ptr<ViewCache> pViewCache, ID3D12Resource* pResource)
+        : m_pViewCache(std::move(pViewCache))
+        , m_pResource(pResource)
+    {}
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+    {
+        if (!ppvObject)
+        {
+            return E_POINTER;
+        }
+        if (riid == __uuidof(IUnknown))
+        {
+            *ppvObject = static_cast<IUnknown*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppvObject = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return m_RefCount.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        ULONG count = m_RefCount.fetch_sub(1, std::memory_order_acq_rel) - 1;
+        if (count == 0)
+        {
+            delete this;
+        }
+        return count;
+    }
+private:
+    ~ViewCacheEvictor()
+    {
+        //the cache may be destroyed before the resource.
+        if (auto pViewCache = m_pViewCache.lock())
+        {
+            pViewCache->Evict(m_pResource);
+        }
+    }
+
+    std::atomic<ULONG> m_RefCount{ 1 };
+    std::weak_ptr<ViewCache> m_pViewCache;
+    //It is not referenced,since this object is owned by the resource.
+    ID3D12Resource* m_pResource;
+};
+
+ViewCache::ViewCache()
+    : m_NumHits(0)
+    , m_NumMisses(0)
+    , m_NumEvictions(0)
+    , m_NumViews(0)
+{
+    for (auto& shard : m_Shards)
+    {
+        for (auto& bucket : shard.Buckets)
+        {
+            bucket.store(nullptr, std::memory_order_relaxed);
+        }
+        shard.NumReaders.store(0, std::memory_order_relaxed);
+    }
+}
+
+ViewCache::~ViewCache()
+{
+    for (auto& shard : m_Shards)
+    {
+        for (auto& bucket : shard.Buckets)
+        {
+            Node* pNode = bucket.load(std::memory_order_relaxed);
+            while (pNode)
+            {
+                Node* pNext = pNode->pNext.load(std::memory_order_relaxed);
+                delete pNode;
+                pNode = pNext;
+            }
+        }
+        for (Node* pNode : shard.RetiredNodes)
+        {
+            delete pNode;
+        }
+    }
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE ViewCache::GetShaderResourceView(ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc /* = nullptr */)
+{
+    assert(pResource && "Error!Can not create view for null resource!");
+    Key key = MakeKey(pResource, ViewType::ShaderResource, pDesc, sizeof(D3D12_SHADER_RESOURCE_VIEW_DESC));
+    size_t hash = HashKey(key);
+    D3D12_CPU_DESCRIPTOR_HANDLE handle;
+    if (Find(key, hash, handle))
+    {
+        return handle;
+    }
+
+    auto allocation = Application::GetApp()->AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+    Application::GetApp()->GetDevice()->CreateShaderResourceView(pResource, pDesc, allocation.GetDescriptorHandle());
+    return Insert(key, hash, std::move(allocation));
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE ViewCache::GetUnorderedAccessView(ID3D12Resource* pResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc /* = nullptr */)
+{
+    assert(pResource && "Error!Can not create view for null resource!");
+    Key key = MakeKey(pResource, ViewType::UnorderedAccess, pDesc, sizeof(D3D12_UNORDERED_ACCESS_VIEW_DESC));
+    size_t hash = HashKey(key);
+    D3D12_CPU_DESCRIPTOR_HANDLE handle;
+    if (Find(key, hash, handle))
+    {
+        return handle;
+    }
+
+    auto allocation = Application::GetApp()->AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+    Application::GetApp()->GetDevice()->CreateUnorderedAccessView(pResource, nullptr, pDesc, allocation.GetDescriptorHandle());
+    return Insert(key, hash, std::move(allocation));
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE ViewCache::GetBindlessShaderResourceView(ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc /* = nullptr */)
+{
+    assert(pResource && "Error!Can not create view for null resource!");
+    auto pBindlessHeap = Application::GetApp()->GetBindlessDescriptorHeap();
+    assert(pBindlessHeap && "Error!Bindless mode is off!");
+
+    Key key = MakeKey(pResource, ViewType::BindlessShaderResource, pDesc, sizeof(D3D12_SHADER_RESOURCE_VIEW_DESC));
+    size_t hash = HashKey(key);
+    D3D12_CPU_DESCRIPTOR_HANDLE handle;
+    if (Find(key, hash, handle))
+    {
+        return handle;
+    }
+
+    //the bindless view is a copy of the cpu view.
+    auto srv = GetShaderResourceView(pResource, pDesc);
+    auto allocation = pBindlessHeap->Allocate(1);
+    Application::GetApp()->GetDevice()->CopyDescriptorsSimple(1, allocation.GetDescriptorHandle(), srv, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    return Insert(key, hash, std::move(allocation));
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE ViewCache::GetSampler(const D3D12_SAMPLER_DESC& Desc)
+{
+    Key key = MakeKey(nullptr, ViewType::Sampler, &Desc, sizeof(D3D12_SAMPLER_DESC));
+    size_t hash = HashKey(key);
+    D3D12_CPU_DESCRIPTOR_HANDLE handle;
+    if (Find(key, hash, handle))
+    {
+        return handle;
+    }
+
+    auto allocation = Application::GetApp()->AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, 1);
+    Application::GetApp()->GetDevice()->CreateSampler(&Desc, allocation.GetDescriptorHandle());
+    return Insert(key, hash, std::move(allocation));
+}
+
+void ViewCache::Evict(ID3D12Resource* pResource)
+{
+    Key key = MakeKey(pResource, ViewType::ShaderResource, nullptr, 0);
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.Mutex);
+    for (auto& bucket : shard.Buckets)
+    {
+        std::atomic<Node*>* pLink = &bucket;
+        Node* pNode = pLink->load(std::memory_order_relaxed);
+        while (pNode)
+        {
+            Node* pNext = pNode->pNext.load(std::memory_order_relaxed);
+            if (pNode->NodeKey.pResource == pResource)
+            {
+                //readers which are on this node can still walk to next node.
+                pLink->store(pNext, std::memory_order_seq_cst);
+                shard.RetiredNodes.push_back(pNode);
+                m_NumEvictions.fetch_add(1, std::memory_order_relaxed);
+                m_NumViews.fetch_sub(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                pLink = &pNode->pNext;
+            }
+            pNode = pNext;
+        }
+    }
+    FreeRetiredNodes(shard);
+}
+
+ViewCacheStatistics ViewCache::GetStatistics()const
+{
+    ViewCacheStatistics statistics;
+    statistics.NumHits = m_NumHits.load(std::memory_order_relaxed);
+    statistics.NumMisses = m_NumMisses.load(std::memory_order_relaxed);
+    statistics.NumEvictions = m_NumEvictions.load(std::memory_order_relaxed);
+    statistics.NumViews = m_NumViews.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+ViewCache::Key ViewCache::MakeKey(ID3D12Resource* pResource, ViewType Type, const void* pDesc, size_t DescSize)
+{
+    Key key;
+    std::memset(&key, 0, sizeof(key));
+    key.pResource = pResource;
+    key.Type = Type;
+    key.HasDesc = pDesc ? 1 : 0;
+    if (pDesc)
+    {
+        assert(DescSize <= MaxDescSize && "Error!The desc is too big!");
+        std::memcpy(key.Desc, pDesc, DescSize);
+        //padding before the union of view desc may be anything.
+        size_t paddingBegin = 0;
+        size_t paddingEnd = 0;
+        switch (Type)
+        {
+        case ViewType::ShaderResource:
+        case ViewType::BindlessShaderResource:
+            paddingBegin = offsetof(D3D12_SHADER_RESOURCE_VIEW_DESC, Shader4ComponentMapping) + sizeof(UINT);
+            paddingEnd = offsetof(D3D12_SHADER_RESOURCE_VIEW_DESC, Buffer);
+            break;
+        case ViewType::UnorderedAccess:
+            paddingBegin = offsetof(D3D12_UNORDERED_ACCESS_VIEW_DESC, ViewDimension) + sizeof(D3D12_UAV_DIMENSION);
+            paddingEnd = offsetof(D3D12_UNORDERED_ACCESS_VIEW_DESC, Buffer);
+            break;
+        default:
+            break;
+        }
+        if (paddingEnd > paddingBegin)
+        {
+            std::memset(key.Desc + paddingBegin, 0, paddingEnd - paddingBegin);
+        }
+    }
+    return key;
+}
+
+size_t ViewCache::HashKey(const Key& key)
+{
+    //FNV-1a over the key,the tail padding of Key is not included.
+    const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(&key);
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < offsetof(Key, Desc) + MaxDescSize; ++i)
+    {
+        hash = (hash ^ pBytes[i]) * 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+ViewCache::Shard& ViewCache::GetShard(const Key& key)
+{
+    //all views of a resource are in one shard,so evicting only walks one shard.
+    size_t hash = std::hash<ID3D12Resource*>{}(key.pResource);
+    return m_Shards[hash % NumShards];
+}
+
+bool ViewCache::Find(const Key& key, size_t Hash, D3D12_CPU_DESCRIPTOR_HANDLE& Handle)
+{
+    Shard& shard = GetShard(key);
+    shard.NumReaders.fetch_add(1, std::memory_order_seq_cst);
+
+    //the handle is copied before leaving,since the node may be freed after that.
+    bool found = false;
+    const Node* pNode = shard.Buckets[Hash % NumBucketsPerShard].load(std::memory_order_seq_cst);
+    while (pNode)
+    {
+        if (pNode->Hash == Hash && std::memcmp(&pNode->NodeKey, &key, offsetof(Key, Desc) + MaxDescSize) == 0)
+        {
+            Handle = pNode->Descriptor.GetDescriptorHandle();
+            found = true;
+            break;
+        }
+        pNode = pNode->pNext.load(std::memory_order_acquire);
+    }
+
+    shard.NumReaders.fetch_sub(1, std::memory_order_release);
+    if (found)
+    {
+        m_NumHits.fetch_add(1, std::memory_order_relaxed);
+    }
+    return found;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE ViewCache::Insert(const Key& key, size_t Hash, DescriptorAllocation&& Descriptor)
+{
+    //the resource must evict its views before it can be found again.
+    if (key.pResource)
+    {
+        AttachEvictor(key.pResource);
+    }
+
+    Shard& shard = GetShard(key);
+    D3D12_CPU_DESCRIPTOR_HANDLE handle = {};
+    {
+        std::lock_guard<std::mutex> lock(shard.Mutex);
+        FreeRetiredNodes(shard);
+        //another thread may insert the same view after Find(),then the new descriptor is dropped.
+        auto& bucket = shard.Buckets[Hash % NumBucketsPerShard];
+        for (Node* pNode = bucket.load(std::memory_order_relaxed); pNode; pNode = pNode->pNext.load(std::memory_order_relaxed))
+        {
+            if (pNode->Hash == Hash && std::memcmp(&pNode->NodeKey, &key, offsetof(Key, Desc) + MaxDescSize) == 0)
+            {
+                handle = pNode->Descriptor.GetDescriptorHandle();
+                break;
+            }
+        }
+        if (handle.ptr == 0)
+        {
+            Node* pNewNode = new Node();
+            pNewNode->Hash = Hash;
+            std::memcpy(&pNewNode->NodeKey, &key, sizeof(Key));
+            pNewNode->Descriptor = std::move(Descriptor);
+            pNewNode->pNext.store(bucket.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            //the node is complete before it is published.
+            bucket.store(pNewNode, std::memory_order_release);
+
+            handle = pNewNode->Descriptor.GetDescriptorHandle();
+            m_NumViews.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    m_NumMisses.fetch_add(1, std::memory_order_relaxed);
+    return handle;
+}
+
+void ViewCache::AttachEvictor(ID3D12Resource* pResource)
+{
+    //Checking and attaching are locked together,since attaching twice would release the first evictor and evict views.
+    std::lock_guard<std::mutex> lock(m_EvictorMutex);
+    UINT dataSize = 0;
+    if (SUCCEEDED(pResource->GetPrivateData(gs_ViewCacheEvictorGuid, &dataSize, nullptr)))
+    {
+        return;
+    }
+    auto pEvictor = new ViewCacheEvictor(weak_from_this(), pResource);
+    ThrowIfFailed(pResource->SetPrivateDataInterface(gs_ViewCacheEvictorGuid, pEvictor));
+    pEvictor->Release();
+}
+
+void ViewCache::FreeRetiredNodes(Shard& shard)
+{
+    //a reader which comes after unlinking can not reach retired nodes,so no reader means nobody is on them.
+    if (!shard.RetiredNodes.empty() && shard.NumReaders.load(std::memory_order_seq_cst) == 0)
+    {
+        for (Node* pNode : shard.RetiredNodes)
+        {
+            delete pNode;
+        }
+        shard.RetiredNodes.clear();
+    }
+}
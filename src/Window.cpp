@@ -26,9 +26,13 @@ Window::Window(HWND hwnd,const std::wstring& windowName,int width, int height, b
     for (int i = 0; i < m_BackBufferCount; ++i)
     {
         m_BackBufferTextures[i] = std::make_unique<Texture>(TextureUsage::RenderTargetTexture,L"BackBuffer[" + std::to_wstring(i) + L"]");
+    }
+    for (UINT i = 0; i < m_MaxFramesInFlight; ++i)
+    {
         m_FenceValue[i] = 0;
-        m_FrameCount[i] = 0;
     }
+    m_NumFramesInFlight = m_BackBufferCount;
+    m_CurrentFrameSlot = 0;
 
     auto App = Application::GetApp();
     // Create render target descriptor heap
@@ -167,6 +171,8 @@ void Window::OnResize(const ResizeEventArgs& ResizeArgs)
             ResourceStateTracker::RemoveGlobalResourceState(m_BackBufferTextures[i]->GetD3D12Resource().Get());
             m_BackBufferTextures[i]->Reset();
         }
+        // Swapchain can not resize until all references of backbuffers are released.
+        Application::GetApp()->ReleaseRetiredObjects(true);
 
         DXGI_SWAP_CHAIN_DESC1 swapchainDesc1;
         ThrowIfFailed(m_dxgiSwapChain->GetDesc1(&swapchainDesc1));
@@ -240,9 +246,10 @@ void Window::UpdateRenderTargetView()
         Microsoft::WRL::ComPtr<ID3D12Resource> backbuffer;
         //GetBuffer() method will hele us create backbuffer resource.
         ThrowIfFailed(m_dxgiSwapChain->GetBuffer(i, IID_PPV_ARGS(&backbuffer)));
+        //The state is added before setting,so the texture keeps the handle of global state.
+        ResourceStateTracker::AddGlobalResourceState(backbuffer.Get(), D3D12_RESOURCE_STATE_PRESENT);
         //This is important!
         m_BackBufferTextures[i]->SetD3D12Resource(backbuffer);
-        ResourceStateTracker::AddGlobalResourceState(m_BackBufferTextures[i]->GetD3D12Resource().Get(), D3D12_RESOURCE_STATE_PRESENT);
         device->CreateRenderTargetView(m_BackBufferTextures[i]->GetD3D12Resource().Get(), nullptr, m_BackBufferTextures[i]->GetRenderTargetView());
     }
 }
@@ -366,19 +373,42 @@ UINT Window::Present(const Texture* pTexture)
     //So I have to make sure the flag is always ZERO by forcing the m_Vsync is TRUE.
     UINT Flag = m_SupportTearing && !m_Vsync ? DXGI_PRESENT_ALLOW_TEARING : 0;
     ThrowIfFailed(m_dxgiSwapChain->Present(SyncInterval, Flag));
+    m_FenceValue[m_CurrentFrameSlot] = commandQueue->Signal();
     //After present,do not forget to refresh current backbuffer index.
-    m_FenceValue[m_CurrentBackBufferIndex] = commandQueue->Signal();
-    m_FrameCount[m_CurrentBackBufferIndex] = Application::GetFrameCount();
-
     m_CurrentBackBufferIndex = m_dxgiSwapChain->GetCurrentBackBufferIndex();
-
-    commandQueue->WaitForFenceValue(m_FenceValue[m_CurrentBackBufferIndex]);
-    //After all command compeleted,we can safely release all stale descriptors
-    Application::GetApp()->ReleaseStaleDescriptors(m_FrameCount[m_CurrentBackBufferIndex]);
+    //Next frame reuses the slot of the frame which is (frames in flight - 1) frames before this one,
+    //so we only wait for that frame instead of the frame which used next backbuffer.
+    m_CurrentFrameSlot = (m_CurrentFrameSlot + 1) % m_NumFramesInFlight;
+    commandQueue->WaitForFenceValue(m_FenceValue[m_CurrentFrameSlot]);
+    //All command lists of this frame are executed,so the frame can be ended now.
+    Application::GetApp()->EndFrame();
 
     return m_CurrentBackBufferIndex;
 }
 
+void Window::SetFramesInFlight(UINT NumFramesInFlight)
+{
+    assert(NumFramesInFlight > 0 && NumFramesInFlight <= m_MaxFramesInFlight && "Error!Invalid number of frames in flight!");
+    if (NumFramesInFlight == m_NumFramesInFlight)
+    {
+        return;
+    }
+    //Slots are remapped,so we wait for all frames and start the ring again.
+    Application::GetApp()->Flush();
+    Application::GetApp()->ReleaseRetiredObjects(true);
+    for (UINT i = 0; i < m_MaxFramesInFlight; ++i)
+    {
+        m_FenceValue[i] = 0;
+    }
+    m_NumFramesInFlight = NumFramesInFlight;
+    m_CurrentFrameSlot = 0;
+}
+
+UINT Window::GetFramesInFlight()const
+{
+    return m_NumFramesInFlight;
+}
+
 UINT Window::GetCurrentBackBufferIndex()const
 {
     assert(m_dxgiSwapChain);
@@ -1,5 +1,8 @@
 #include "d3dUtil.h"
+#if defined(_WIN32)
 #include <comdef.h>
+#endif
+#include <cstdio>
 
 DxException::DxException(HRESULT hr, const std::wstring& functionName, const std::wstring& filename, int lineNumber) :
     ErrorCode(hr),
@@ -12,8 +15,14 @@ DxException::DxException(HRESULT hr, const std::wstring& functionName, const std
 std::wstring DxException::ToString()const
 {
     // Get the string description of the error code.
+#if defined(_WIN32)
     _com_error err(ErrorCode);
     std::wstring msg = err.ErrorMessage();
+#else
+    wchar_t code[16];
+    std::swprintf(code, 16, L"0x%08X", static_cast<unsigned int>(ErrorCode));
+    std::wstring msg = code;
+#endif
 
     return FunctionName + L" failed in " + Filename + L"; line " + std::to_wstring(LineNumber) + L"; error: " + msg;
 }
@@ -27,18 +36,21 @@ Microsoft::WRL::ComPtr<ID3D12Resource> d3dUtil::CreateDefaultBuffer(
 {
     Microsoft::WRL::ComPtr<ID3D12Resource> defaultBuffer;
 
+    CD3DX12_HEAP_PROPERTIES defaultHeapProperties(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_HEAP_PROPERTIES uploadHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+    auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(byteSize);
     ThrowIfFailed(device->CreateCommittedResource(
-        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+        &defaultHeapProperties,
         D3D12_HEAP_FLAG_NONE,
-        &CD3DX12_RESOURCE_DESC::Buffer(byteSize),
+        &bufferDesc,
         D3D12_RESOURCE_STATE_COPY_DEST,
         nullptr,
         IID_PPV_ARGS(&defaultBuffer)));
 
     ThrowIfFailed(device->CreateCommittedResource(
-        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+        &uploadHeapProperties,
         D3D12_HEAP_FLAG_NONE,
-        &CD3DX12_RESOURCE_DESC::Buffer(byteSize),
+        &bufferDesc,
         D3D12_RESOURCE_STATE_GENERIC_READ,
         nullptr,
         IID_PPV_ARGS(&uploadBuffer)));
@@ -49,13 +61,15 @@ Microsoft::WRL::ComPtr<ID3D12Resource> d3dUtil::CreateDefaultBuffer(
     subResourceData.RowPitch = byteSize;
     subResourceData.SlicePitch = subResourceData.RowPitch;
 
-    commandlist->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-        uploadBuffer.Get(), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_SOURCE));
+    auto uploadBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
+        uploadBuffer.Get(), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    commandlist->ResourceBarrier(1, &uploadBarrier);
 
     ::UpdateSubresources(commandlist, defaultBuffer.Get(), uploadBuffer.Get(), 0, 0, 1, &subResourceData);
 
-    commandlist->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-        defaultBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
+    auto defaultBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
+        defaultBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ);
+    commandlist->ResourceBarrier(1, &defaultBarrier);
 
     return defaultBuffer;
 }
@@ -66,6 +80,7 @@ Microsoft::WRL::ComPtr<ID3DBlob> d3dUtil::CompileShader(
     const std::string& entrypoint,
     const std::string& target)
 {
+#if defined(_WIN32)
     UINT compileFlags = 0;
 #if defined(DEBUG) || defined(_DEBUG)  
     compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
@@ -84,6 +99,11 @@ Microsoft::WRL::ComPtr<ID3DBlob> d3dUtil::CompileShader(
     ThrowIfFailed(hr);
 
     return byteCode;
+#else
+    //d3dcompiler only exists on windows,headless runs on the null device do not create passes.
+    ThrowIfFailed(E_NOTIMPL);
+    return nullptr;
+#endif
 }
 
 std::vector<D3D12_STATIC_SAMPLER_DESC> d3dUtil::GetStaticSamplers()